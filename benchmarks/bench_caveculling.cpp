@@ -0,0 +1,57 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/camera.h"
+#include "engine/world.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <vector>
+
+/**
+ * Measures how many chunks cave culling rejects when the camera is
+ * underground, and how long the per frame search takes. Runs headless using
+ * the null renderer.
+ */
+BENCHMARK(CaveCulling)
+{
+    NullRenderer renderer;
+    WorldView * pView = new WorldView( &renderer, 0 );
+    std::vector<Point> cameraSpots;
+
+    World * pWorld = BenchWorlds::createCaveWorld( pView, &cameraSpots );
+
+    // Builds the chunk meshes and their connectivity
+    BenchmarkTimer buildTimer;
+    pView->update();
+    Benchmark::report( "connectivity build (ms/chunk)",
+                       buildTimer.elapsedSeconds() * 1000.0 /
+                           pWorld->chunkCount() );
+
+    const int FRAMES_PER_SPOT = 50;
+    unsigned long considered = 0, occluded = 0;
+    BenchmarkTimer drawTimer;
+
+    for ( size_t i = 0; i < cameraSpots.size(); ++i )
+    {
+        const Point& p = cameraSpots[i];
+        pView->setCamera( Camera( Vec3( p.x + 0.5f, p.y + 0.5f, p.z + 0.5f ) ) );
+
+        for ( int frame = 0; frame < FRAMES_PER_SPOT; ++frame )
+        {
+            pView->draw();
+        }
+
+        considered += pView->frameStats().chunksConsidered;
+        occluded   += pView->frameStats().chunksOccluded;
+    }
+
+    double frames = static_cast<double>( cameraSpots.size() * FRAMES_PER_SPOT );
+
+    Benchmark::report( "chunks per frame", considered / (double) cameraSpots.size() );
+    Benchmark::report( "culled chunk rate (%)", 100.0 * occluded / considered );
+    Benchmark::report( "cull + draw (ms/frame)",
+                       drawTimer.elapsedSeconds() * 1000.0 / frames );
+
+    delete pWorld;
+}
@@ -0,0 +1,102 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "engine/constants.h"
+#include "graphics/worldview.h"
+#include "graphics/worldchunkmesh.h"
+#include "graphics/irenderer.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    /**
+     * Keeps a running total of the triangles in every uploaded mesh
+     */
+    class TriangleCountingRenderer : public IRenderer
+    {
+    public:
+        TriangleCountingRenderer()
+            : triangles( 0 ),
+              mNextId( 1 )
+        {
+        }
+
+        virtual void clear() { }
+        virtual void present() { }
+        virtual void renderChunks( const std::vector<ChunkRenderId>& ) { }
+        virtual void renderTranslucentChunks( const std::vector<ChunkRenderId>& ) { }
+
+        virtual ChunkRenderId uploadChunkSection( const Point&,
+                                                  unsigned int,
+                                                  const WorldChunkMesh& mesh )
+        {
+            mTriangles[mNextId] = mesh.indices.size() / 3;
+            triangles += mesh.indices.size() / 3;
+
+            return mNextId++;
+        }
+
+        virtual void releaseChunk( ChunkRenderId id )
+        {
+            triangles -= mTriangles[id];
+            mTriangles.erase( id );
+        }
+
+        size_t triangles;
+
+    private:
+        std::map<ChunkRenderId, size_t> mTriangles;
+        ChunkRenderId mNextId;
+    };
+
+    void benchmarkViewDistance( float distance, float lodDistance )
+    {
+        std::ostringstream ss;
+        ss << "view " << distance << ( lodDistance > 0.0f ? " lod" : " full" );
+        const std::string name = ss.str();
+
+        TriangleCountingRenderer renderer;
+        WorldView * pView = new WorldView( &renderer, 0 );
+        World * pWorld = BenchWorlds::createFlatWorld( pView );
+
+        // Stand in a corner so the view distance decides what is loaded
+        pView->setCamera( Camera( Vec3( 1.0f, 16.0f, 1.0f ) ) );
+        pView->setUnloadDistance( distance );
+        pView->setLodDistance( lodDistance );
+        pView->setMeshCacheCapacity( 0 );
+
+        BenchmarkTimer timer;
+
+        pView->update();
+        pView->finishMeshing();
+
+        const double elapsed = timer.elapsedSeconds();
+
+        Benchmark::report( name + " chunks", pView->loadedChunkCount() );
+        Benchmark::report( name + " triangles (k)", renderer.triangles / 1000.0 );
+        Benchmark::report( name + " mesh time (ms)", elapsed * 1000.0 );
+
+        delete pWorld;
+    }
+}
+
+/**
+ * Triangles on screen as the view distance grows, with every chunk in full
+ * detail and with distant chunks downsampled
+ */
+BENCHMARK(ChunkLod)
+{
+    const float DEPTH = static_cast<float>( Constants::CHUNK_DEPTH );
+
+    for ( int step = 2; step <= 8; step *= 2 )
+    {
+        const float distance = step * 1.5f * DEPTH;
+
+        benchmarkViewDistance( distance, 0.0f );
+        benchmarkViewDistance( distance, 2.0f * DEPTH );
+    }
+}
@@ -0,0 +1,74 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "engine/constants.h"
+#include "graphics/worldview.h"
+#include "graphics/chunkmeshcache.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <string>
+
+namespace
+{
+    /**
+     * Walks the camera back and forth across the cave world with chunk
+     * unloading turned on, so chunks keep being released and reloaded
+     */
+    void benchmarkReloads( const std::string& name, size_t capacity )
+    {
+        NullRenderer renderer;
+        WorldView * pView = new WorldView( &renderer, 0 );
+        World * pWorld = BenchWorlds::createCaveWorld( pView );
+
+        const float depth = static_cast<float>( Constants::CHUNK_DEPTH );
+        const float x = 0.5f * pWorld->cols(), y = 0.5f * pWorld->rows();
+
+        pView->setMeshCacheCapacity( capacity );
+        pView->setUnloadDistance( 2.5f * depth );
+        pView->setCamera( Camera( Vec3( x, y, 0.5f * depth ) ) );
+        pView->update();
+        pView->finishMeshing();
+
+        // Only count what happens while walking around
+        const ChunkMeshCacheStats before = pView->meshCacheStats();
+        const int TRIPS = 4;
+        BenchmarkTimer timer;
+
+        for ( int trip = 0; trip < TRIPS; ++trip )
+        {
+            const bool isForward = ( trip % 2 == 0 );
+
+            for ( int step = 1; step < 8; ++step )
+            {
+                const int z = isForward ? step : 7 - step;
+
+                pView->setCamera( Camera( Vec3( x, y, ( z + 0.5f ) * depth ) ) );
+                pView->update();
+                pView->finishMeshing();
+            }
+        }
+
+        const double elapsed = timer.elapsedSeconds();
+        ChunkMeshCacheStats stats = pView->meshCacheStats();
+
+        stats.hits   -= before.hits;
+        stats.misses -= before.misses;
+
+        Benchmark::report( name + " reload time (ms)", elapsed * 1000.0 );
+        Benchmark::report( name + " hit rate", stats.hitRate() );
+        Benchmark::report( name + " cache size (KB)", stats.byteCount / 1024.0 );
+
+        delete pWorld;
+    }
+}
+
+/**
+ * Time spent reloading chunks that were meshed before, with and without the
+ * mesh cache
+ */
+BENCHMARK(MeshCache)
+{
+    benchmarkReloads( "no cache", 0 );
+    benchmarkReloads( "64MB cache", 64 * 1024 * 1024 );
+}
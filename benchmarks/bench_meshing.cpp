@@ -0,0 +1,105 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/cubeface.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/cubevertex.h"
+#include "graphics/packedcubevertex.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <string>
+
+namespace
+{
+    /**
+     * Meshes every chunk in the world several times over and reports the
+     * throughput along with the size of the generated geometry.
+     */
+    void benchmarkMeshing( const std::string& name,
+                           const World& world,
+                           EMeshingMode mode )
+    {
+        const int PASSES = 4;
+
+        WorldChunkBuilder builder;
+        unsigned long chunks = 0, vertices = 0, indices = 0;
+        unsigned long faces = 0, hiddenFaces = 0, quads = 0;
+
+        BenchmarkTimer timer;
+
+        for ( int pass = 0; pass < PASSES; ++pass )
+        {
+            for ( unsigned int z = 0; z < world.chunkDepth(); ++z )
+            {
+                for ( unsigned int y = 0; y < world.chunkRows(); ++y )
+                {
+                    for ( unsigned int x = 0; x < world.chunkCols(); ++x )
+                    {
+                        Point coord( x, y, z );
+                        const WorldChunk * pChunk = world.chunkAt( coord );
+
+                        if ( pChunk == NULL )
+                        {
+                            continue;
+                        }
+
+                        ChunkNeighborhood neighborhood( *pChunk );
+
+                        for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+                        {
+                            neighborhood.pNeighbors[f] =
+                                world.neighborOf( coord, static_cast<ECubeFace>( f ) );
+                        }
+
+                        builder.build( neighborhood, mode );
+
+                        chunks      += 1;
+                        vertices    += builder.stats().vertexCount;
+                        indices     += builder.stats().indexCount;
+                        faces       += builder.stats().faceCount;
+                        hiddenFaces += builder.stats().hiddenFaces;
+                        quads       += builder.stats().quadCount;
+                    }
+                }
+            }
+        }
+
+        double seconds = timer.elapsedSeconds();
+
+        Benchmark::report( name + " meshing (chunks/s)", chunks / seconds );
+        Benchmark::report( name + " vertices per chunk", vertices / (double) chunks );
+        Benchmark::report( name + " indices per chunk", indices / (double) chunks );
+        Benchmark::report( name + " quads per chunk", quads / (double) chunks );
+        Benchmark::report( name + " float mesh (KB/chunk)",
+                           ( vertices * sizeof(CubeVertex) +
+                             indices * sizeof(unsigned int) ) / 1024.0 / chunks );
+        Benchmark::report( name + " packed mesh (KB/chunk)",
+                           ( vertices * sizeof(PackedCubeVertex) +
+                             indices * sizeof(unsigned int) ) / 1024.0 / chunks );
+        Benchmark::report( name + " hidden faces (%)", 100.0 * hiddenFaces / faces );
+    }
+}
+
+/**
+ * Mesher throughput over the standard benchmark worlds, comparing plain face
+ * culling with greedy merging
+ */
+BENCHMARK(Meshing)
+{
+    NullRenderer renderer;
+
+    World * pFlat = BenchWorlds::createFlatWorld( new WorldView( &renderer, 0 ) );
+    benchmarkMeshing( "flat culled", *pFlat, EMESHING_CULLED );
+    benchmarkMeshing( "flat greedy", *pFlat, EMESHING_GREEDY );
+    benchmarkMeshing( "flat binary", *pFlat, EMESHING_BINARY );
+    delete pFlat;
+
+    World * pCave = BenchWorlds::createCaveWorld( new WorldView( &renderer, 0 ) );
+    benchmarkMeshing( "cave culled", *pCave, EMESHING_CULLED );
+    benchmarkMeshing( "cave greedy", *pCave, EMESHING_GREEDY );
+    benchmarkMeshing( "cave binary", *pCave, EMESHING_BINARY );
+    delete pCave;
+}
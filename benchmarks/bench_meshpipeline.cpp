@@ -0,0 +1,112 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/cubedata.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    /**
+     * Tracks the average and worst time spent in WorldView::update
+     */
+    struct FrameTimes
+    {
+        FrameTimes()
+            : frames( 0 ),
+              totalMs( 0.0 ),
+              worstMs( 0.0 )
+        {
+        }
+
+        void add( double ms )
+        {
+            frames  += 1;
+            totalMs += ms;
+            worstMs  = std::max( worstMs, ms );
+        }
+
+        unsigned int frames;
+        double totalMs;
+        double worstMs;
+    };
+
+    void benchmarkPipeline( unsigned int threadCount )
+    {
+        std::ostringstream ss;
+        ss << threadCount << " threads ";
+        const std::string name = ss.str();
+
+        NullRenderer renderer;
+        WorldView * pView = new WorldView( &renderer, threadCount );
+        World * pWorld = BenchWorlds::createCaveWorld( pView );
+
+        // Loading: every chunk is dirty. Keep ticking frames until all of
+        // the meshes have made it to the renderer
+        FrameTimes load;
+        BenchmarkTimer loadTimer;
+
+        do
+        {
+            BenchmarkTimer frameTimer;
+            pView->update();
+            load.add( frameTimer.elapsedSeconds() * 1000.0 );
+
+            if ( pView->updateStats().meshesInFlight > 0 )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            }
+        }
+        while ( pView->updateStats().meshesInFlight > 0 );
+
+        Benchmark::report( name + "load worst frame (ms)", load.worstMs );
+        Benchmark::report( name + "load until meshed (ms)",
+                           loadTimer.elapsedSeconds() * 1000.0 );
+
+        // Editing: dig a handful of holes scattered through the world every
+        // frame, each of which dirties a chunk (and maybe its neighbors)
+        const int FRAMES = 60, EDITS_PER_FRAME = 8;
+        unsigned int seed = 4242;
+        FrameTimes edits;
+
+        for ( int frame = 0; frame < FRAMES; ++frame )
+        {
+            for ( int i = 0; i < EDITS_PER_FRAME; ++i )
+            {
+                seed = seed * 1103515245u + 12345u;
+                Point p( ( seed >> 4 ) % pWorld->cols(),
+                         ( seed >> 12 ) % pWorld->rows(),
+                         ( seed >> 20 ) % pWorld->depth() );
+
+                pWorld->put( CubeData(), p );
+            }
+
+            BenchmarkTimer frameTimer;
+            pView->update();
+            edits.add( frameTimer.elapsedSeconds() * 1000.0 );
+        }
+
+        pView->finishMeshing();
+
+        Benchmark::report( name + "edit avg frame (ms)", edits.totalMs / edits.frames );
+        Benchmark::report( name + "edit worst frame (ms)", edits.worstMs );
+
+        delete pWorld;
+    }
+}
+
+/**
+ * Time spent on the main thread in WorldView::update while the world loads
+ * and while it is being edited, with meshes built inline versus on workers
+ */
+BENCHMARK(MeshPipeline)
+{
+    benchmarkPipeline( 0 );
+    benchmarkPipeline( std::max( 1u, std::thread::hardware_concurrency() - 1 ) );
+}
@@ -0,0 +1,107 @@
+#include "benchmark.h"
+#include "math/perlin.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    const unsigned int GRID_SIZE = 32;
+    const float STEP = 1.0f / 64.0f;
+
+    /// Keeps the compiler from throwing away noise that is never used
+    volatile float gNoiseSink = 0.0f;
+
+    /**
+     * Samples a 32x32 (2d) or 32x32x32 (3d) grid of noise for every chunk
+     * sized tile in a 16x16 area, first one point at a time and then with
+     * the batched grid fill. Reports samples per second for each, and how
+     * much faster the batched path is
+     */
+    void benchmarkNoise( const std::string& name,
+                         bool is3d,
+                         unsigned int octaves )
+    {
+        PerlinNoise perlin( 1337 );
+
+        const unsigned int TILES = 16;
+        const unsigned int depth = ( is3d ? GRID_SIZE : 1 );
+        const double samples =
+            static_cast<double>( TILES * TILES ) * GRID_SIZE * GRID_SIZE * depth;
+
+        std::vector<float> grid( GRID_SIZE * GRID_SIZE * depth );
+
+        // One sample at a time
+        BenchmarkTimer scalarTimer;
+        float sum = 0.0f;
+
+        for ( unsigned int tile = 0; tile < TILES * TILES; ++tile )
+        {
+            const float tx = static_cast<float>( tile % TILES ) * GRID_SIZE * STEP;
+            const float ty = static_cast<float>( tile / TILES ) * GRID_SIZE * STEP;
+
+            for ( unsigned int z = 0; z < depth; ++z )
+            {
+                for ( unsigned int y = 0; y < GRID_SIZE; ++y )
+                {
+                    for ( unsigned int x = 0; x < GRID_SIZE; ++x )
+                    {
+                        float px = tx + static_cast<float>( x ) * STEP;
+                        float py = ty + static_cast<float>( y ) * STEP;
+                        float pz = static_cast<float>( z ) * STEP;
+
+                        sum += ( is3d ? perlin.fbm( px, py, pz, octaves )
+                                      : perlin.fbm( px, py, octaves ) );
+                    }
+                }
+            }
+        }
+
+        const double scalarSeconds = scalarTimer.elapsedSeconds();
+
+        // Whole grids at once
+        BenchmarkTimer batchTimer;
+
+        for ( unsigned int tile = 0; tile < TILES * TILES; ++tile )
+        {
+            const float tx = static_cast<float>( tile % TILES ) * GRID_SIZE * STEP;
+            const float ty = static_cast<float>( tile / TILES ) * GRID_SIZE * STEP;
+
+            if ( is3d )
+            {
+                perlin.fillFbm( &grid[0], GRID_SIZE, GRID_SIZE, GRID_SIZE,
+                                tx, ty, 0.0f, STEP, octaves );
+            }
+            else
+            {
+                perlin.fillFbm( &grid[0], GRID_SIZE, GRID_SIZE,
+                                tx, ty, STEP, octaves );
+            }
+
+            sum += grid[tile % grid.size()];
+        }
+
+        const double batchSeconds = batchTimer.elapsedSeconds();
+        gNoiseSink = sum;
+
+        Benchmark::report( name + "scalar samples/s (M)",
+                           samples / scalarSeconds / 1000000.0 );
+        Benchmark::report( name + "batch samples/s (M)",
+                           samples / batchSeconds / 1000000.0 );
+        Benchmark::report( name + "batch speedup", scalarSeconds / batchSeconds );
+    }
+}
+
+/**
+ * Perlin noise throughput over chunk sized grids, sampling each point with
+ * noise() / fbm() compared to filling the whole grid with fill() / fillFbm().
+ * Single octave noise shows the raw cost of an evaluation, and five
+ * octave fbm is closer to what terrain generation asks for.
+ */
+BENCHMARK(Noise)
+{
+    benchmarkNoise( "2d 1 octave ", false, 1 );
+    benchmarkNoise( "2d 5 octaves ", false, 5 );
+    benchmarkNoise( "3d 1 octave ", true, 1 );
+    benchmarkNoise( "3d 5 octaves ", true, 5 );
+}
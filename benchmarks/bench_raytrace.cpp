@@ -0,0 +1,114 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+#include "graphics/software/voxelraytracer.h"
+#include "math/vector.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /**
+     * Ray traces a frame from each of the cameras and reports how quickly
+     * rays were cast, and how much of their walk empty space skipping took
+     * care of
+     */
+    void benchmarkRayTrace( const std::string& worldName,
+                            const World& world,
+                            const std::vector<Camera>& cameras,
+                            unsigned int threadCount,
+                            bool isSavingFrame = false )
+    {
+        std::ostringstream ss;
+        ss << worldName << " " << threadCount
+           << ( threadCount == 1 ? " thread " : " threads " );
+
+        const std::string name = ss.str();
+        const unsigned int SIZE = 512;
+
+        VoxelRayTracer tracer( SIZE, SIZE, threadCount );
+
+        double seconds = 0.0, rays = 0.0, hits = 0.0;
+        double chunksSkipped = 0.0, bricksSkipped = 0.0, voxelsVisited = 0.0;
+
+        for ( size_t i = 0; i < cameras.size(); ++i )
+        {
+            BenchmarkTimer timer;
+            tracer.render( world, cameras[i] );
+            seconds += timer.elapsedSeconds();
+
+            const VoxelRayStats& stats = tracer.stats();
+            rays          += stats.rays;
+            hits          += stats.hits;
+            chunksSkipped += stats.chunksSkipped;
+            bricksSkipped += stats.bricksSkipped;
+            voxelsVisited += stats.voxelsVisited;
+        }
+
+        Benchmark::report( name + "ms/frame", seconds * 1000.0 / cameras.size() );
+        Benchmark::report( name + "rays/s (M)", rays / seconds / 1000000.0 );
+        Benchmark::report( name + "hit rays (%)", 100.0 * hits / rays );
+        Benchmark::report( name + "chunks skipped/ray", chunksSkipped / rays );
+        Benchmark::report( name + "bricks skipped/ray", bricksSkipped / rays );
+        Benchmark::report( name + "cubes visited/ray", voxelsVisited / rays );
+
+        // Last frame as an image, if asked for
+        const char * pPath = std::getenv( "CUBEWORLD_TRACE_FRAME" );
+
+        if ( pPath != NULL && isSavingFrame )
+        {
+            tracer.saveFrame( pPath );
+        }
+    }
+}
+
+/**
+ * Voxel ray tracer throughput at 512x512, single threaded and with four
+ * worker threads. The flat world is flown across like the SoftwareRender
+ * benchmark, which is mostly sky and open air for the tracer to skip. The
+ * cave world is seen from inside each of its tunnels, where rays are short
+ * but there is little empty space to skip. Set CUBEWORLD_TRACE_FRAME to a
+ * path to also save the last flat world frame as a TGA image.
+ */
+BENCHMARK(RayTrace)
+{
+    const int FRAMES = 32;
+
+    NullRenderer renderer;
+    World * pFlatWorld = BenchWorlds::createFlatWorld( new WorldView( &renderer, 0 ) );
+    std::vector<Camera> flatCameras;
+
+    for ( int frame = 0; frame < FRAMES; ++frame )
+    {
+        const float x = frame * pFlatWorld->cols() / static_cast<float>( FRAMES );
+        Camera camera( Vec3( x, 40.0f, pFlatWorld->depth() / 2.0f ) );
+        camera.addMouseLookDelta( 0.0f, frame * 360.0f / FRAMES );
+        flatCameras.push_back( camera );
+    }
+
+    std::vector<Point> openCubes;
+    World * pCaveWorld = BenchWorlds::createCaveWorld( new WorldView( &renderer, 0 ),
+                                                       &openCubes );
+    std::vector<Camera> caveCameras;
+
+    for ( size_t i = 0; i < openCubes.size(); ++i )
+    {
+        const Point& p = openCubes[i];
+        caveCameras.push_back( Camera( Vec3( p.x + 0.5f, p.y + 0.5f, p.z + 0.5f ) ) );
+    }
+
+    benchmarkRayTrace( "flat", *pFlatWorld, flatCameras, 1, true );
+    benchmarkRayTrace( "flat", *pFlatWorld, flatCameras, 4 );
+    benchmarkRayTrace( "cave", *pCaveWorld, caveCameras, 1 );
+    benchmarkRayTrace( "cave", *pCaveWorld, caveCameras, 4 );
+
+    delete pFlatWorld;
+    delete pCaveWorld;
+}
@@ -0,0 +1,146 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "graphics/worldview.h"
+#include "graphics/recording/recordingrenderer.h"
+#include "math/vector.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /**
+     * Flies the camera across the flat world with a limited view distance,
+     * so chunks are streamed in ahead of the camera and dropped behind it,
+     * and reports the load the renderer was put under
+     */
+    void benchmarkRenderLoad( size_t bandwidth,
+                              size_t arenaBytes = 0,
+                              bool isSortingDraws = true )
+    {
+        std::ostringstream ss;
+
+        if ( arenaBytes > 0 )
+        {
+            ss << ( isSortingDraws ? "heap " : "heap unsorted " );
+        }
+
+        if ( bandwidth > 0 )
+        {
+            ss << bandwidth / 1024 << "KB/frame ";
+        }
+        else
+        {
+            ss << "unlimited ";
+        }
+
+        const std::string name = ss.str();
+        const int FRAMES = 64;
+
+        RecordingRenderer renderer;
+        renderer.setUploadBandwidth( bandwidth );
+
+        if ( arenaBytes > 0 )
+        {
+            renderer.enableGeometryHeap( arenaBytes );
+        }
+
+        renderer.setDrawSortingEnabled( isSortingDraws );
+
+        WorldView * pView = new WorldView( &renderer, 0 );
+        World * pWorld = BenchWorlds::createFlatWorld( pView );
+
+        pView->setUnloadDistance( 96.0f );
+        pView->setMeshCacheCapacity( 0 );
+
+        for ( int frame = 0; frame < FRAMES; ++frame )
+        {
+            const float x = frame * pWorld->cols() / static_cast<float>( FRAMES );
+            pView->setCamera( Camera( Vec3( x, 40.0f, pWorld->depth() / 2.0f ) ) );
+
+            pView->update();
+            pView->finishMeshing();
+            pView->draw();
+            renderer.present();
+        }
+
+        const std::vector<RecordingFrameStats>& frames = renderer.frames();
+        double drawCalls = 0.0, batches = 0.0, binds = 0.0, stateChanges = 0.0;
+        double triangles = 0.0, uploaded = 0.0;
+        size_t peakUpload = 0, peakLive = 0, peakBacklog = 0, skipped = 0;
+
+        for ( size_t i = 0; i < frames.size(); ++i )
+        {
+            drawCalls  += frames[i].drawCalls;
+            batches    += frames[i].batches;
+            binds      += frames[i].bufferBinds;
+            stateChanges += frames[i].stateChanges;
+            triangles  += frames[i].triangles;
+            uploaded   += frames[i].uploadedBytes;
+            skipped    += frames[i].skippedDraws;
+            peakUpload  = std::max( peakUpload,  frames[i].uploadedBytes );
+            peakLive    = std::max( peakLive,    frames[i].liveBytes );
+            peakBacklog = std::max( peakBacklog, frames[i].backlogBytes );
+        }
+
+        Benchmark::report( name + "draw calls/frame", drawCalls / FRAMES );
+        Benchmark::report( name + "batches/frame", batches / FRAMES );
+        Benchmark::report( name + "buffer binds/frame", binds / FRAMES );
+        Benchmark::report( name + "state changes/frame", stateChanges / FRAMES );
+        Benchmark::report( name + "triangles/frame (k)", triangles / FRAMES / 1000.0 );
+        Benchmark::report( name + "uploaded (MB)", uploaded / ( 1024.0 * 1024.0 ) );
+        Benchmark::report( name + "peak upload (KB)", peakUpload / 1024.0 );
+        Benchmark::report( name + "peak live (MB)", peakLive / ( 1024.0 * 1024.0 ) );
+        Benchmark::report( name + "peak backlog (KB)", peakBacklog / 1024.0 );
+        Benchmark::report( name + "skipped draws", static_cast<double>( skipped ) );
+
+        if ( arenaBytes > 0 )
+        {
+            // The view uploads packed vertices
+            const GeometryHeapStats vertices = renderer.packedVertexHeap().stats();
+            const GeometryHeapStats indices  = renderer.indexHeap().stats();
+
+            Benchmark::report( name + "vertex arenas", vertices.arenas );
+            Benchmark::report( name + "vertex heap utilization (%)",
+                               100.0 * vertices.utilization() );
+            Benchmark::report( name + "vertex heap fragmentation (%)",
+                               100.0 * vertices.fragmentation() );
+            Benchmark::report( name + "index arenas", indices.arenas );
+            Benchmark::report( name + "index heap utilization (%)",
+                               100.0 * indices.utilization() );
+        }
+
+        // Per frame stats for comparing runs, if asked for
+        const char * pPath = std::getenv( "CUBEWORLD_RENDER_STATS" );
+
+        if ( pPath != NULL && bandwidth > 0 )
+        {
+            std::ofstream stream( pPath );
+            renderer.writeJson( stream );
+        }
+
+        delete pWorld;
+    }
+}
+
+/**
+ * Render side load of streaming the world in while the camera moves, with
+ * unlimited upload bandwidth and with uploads throttled, and then with
+ * sections suballocated from 4MB geometry heap arenas, drawn in the order
+ * given and sorted by arena. Set
+ * CUBEWORLD_RENDER_STATS to a path to also get the throttled run's frames
+ * as JSON.
+ */
+BENCHMARK(RenderLoad)
+{
+    benchmarkRenderLoad( 0 );
+    benchmarkRenderLoad( 256 * 1024 );
+    benchmarkRenderLoad( 0, 4 * 1024 * 1024, false );
+    benchmarkRenderLoad( 0, 4 * 1024 * 1024 );
+}
@@ -0,0 +1,77 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <algorithm>
+#include <string>
+
+namespace
+{
+    /**
+     * Times how long it takes from placing cubes until the new mesh is
+     * uploaded. With wholeChunk set, one cube is placed in every section of
+     * the chunk, which costs as much as the unsectioned mesher did for a
+     * single edit.
+     */
+    void benchmarkEdits( const std::string& name, bool wholeChunk )
+    {
+        NullRenderer renderer;
+        WorldView * pView = new WorldView( &renderer, 0 );
+        World * pWorld = BenchWorlds::createCaveWorld( pView );
+
+        pView->finishMeshing();
+
+        const int EDITS = 200;
+        const unsigned int size = WorldChunk::TOTAL_DEPTH;
+        unsigned int seed = 4242;
+        double totalMs = 0.0, worstMs = 0.0;
+
+        for ( int i = 0; i < EDITS; ++i )
+        {
+            seed = seed * 1103515245u + 12345u;
+
+            // Keep well inside a section so neighbors are left alone
+            Point base( ( seed >> 4 )  % pWorld->cols(),
+                        ( seed >> 12 ) % pWorld->rows(),
+                        ( ( seed >> 20 ) % pWorld->depth() ) / size * size + 3 );
+
+            BenchmarkTimer timer;
+
+            for ( unsigned int s = 0; s < WorldChunk::SECTION_COUNT; ++s )
+            {
+                if ( wholeChunk || s == 0 )
+                {
+                    Point pos( base.x, base.y,
+                               base.z + static_cast<int>( s * WorldChunk::SECTION_DEPTH ) );
+                    pWorld->put( CubeData( EMATERIAL_ROCK ), pos );
+                }
+            }
+
+            pView->update();
+
+            const double ms = timer.elapsedSeconds() * 1000.0;
+            totalMs += ms;
+            worstMs  = std::max( worstMs, ms );
+        }
+
+        Benchmark::report( name + " mean latency (ms)", totalMs / EDITS );
+        Benchmark::report( name + " worst latency (ms)", worstMs );
+
+        delete pWorld;
+    }
+}
+
+/**
+ * Edit to visible latency of a single cube edit, meshing only its section
+ * versus every section of the chunk
+ */
+BENCHMARK(SectionEdits)
+{
+    benchmarkEdits( "one section", false );
+    benchmarkEdits( "whole chunk", true );
+}
@@ -0,0 +1,93 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "graphics/worldview.h"
+#include "graphics/software/softwarerenderer.h"
+#include "math/vector.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    /**
+     * Renders the flat world from a camera flying across it and turning as
+     * it goes, and reports how quickly the software renderer got through
+     * the frames. Meshing is done up front so only rasterization is timed.
+     */
+    void benchmarkSoftwareRender( unsigned int threadCount )
+    {
+        std::ostringstream ss;
+        ss << threadCount << ( threadCount == 1 ? " thread " : " threads " );
+
+        const std::string name = ss.str();
+        const unsigned int SIZE = 512;
+        const int FRAMES = 32;
+
+        SoftwareRenderer renderer( SIZE, SIZE, threadCount );
+
+        WorldView * pView = new WorldView( &renderer, 0 );
+        World * pWorld = BenchWorlds::createFlatWorld( pView );
+
+        pView->update();
+        pView->finishMeshing();
+
+        double seconds = 0.0, triangles = 0.0;
+        double blocksDrawn = 0.0, blocksRejected = 0.0;
+
+        for ( int frame = 0; frame < FRAMES; ++frame )
+        {
+            const float x = frame * pWorld->cols() / static_cast<float>( FRAMES );
+            Camera camera( Vec3( x, 40.0f, pWorld->depth() / 2.0f ) );
+            camera.addMouseLookDelta( 0.0f, frame * 360.0f / FRAMES );
+
+            pView->setCamera( camera );
+            renderer.setCamera( camera );
+            pView->update();
+            pView->finishMeshing();
+
+            BenchmarkTimer timer;
+
+            renderer.clear();
+            pView->draw();
+            renderer.present();
+
+            seconds += timer.elapsedSeconds();
+
+            const SoftwareRasterStats& stats = renderer.rasterizer().stats();
+            triangles      += stats.triangles;
+            blocksDrawn    += stats.blocksDrawn;
+            blocksRejected += stats.blocksRejected;
+        }
+
+        Benchmark::report( name + "ms/frame", seconds * 1000.0 / FRAMES );
+        Benchmark::report( name + "frames/s", FRAMES / seconds );
+        Benchmark::report( name + "triangles/frame (k)", triangles / FRAMES / 1000.0 );
+        Benchmark::report( name + "triangles/s (M)", triangles / seconds / 1000000.0 );
+        Benchmark::report( name + "blocks rejected by Hi-Z (%)",
+                           100.0 * blocksRejected / ( blocksDrawn + blocksRejected ) );
+
+        // Last frame as an image, if asked for
+        const char * pPath = std::getenv( "CUBEWORLD_RENDER_FRAME" );
+
+        if ( pPath != NULL )
+        {
+            renderer.saveFrame( pPath );
+        }
+
+        delete pWorld;
+    }
+}
+
+/**
+ * Software rasterizer throughput on the flat world at 512x512, single
+ * threaded and with four worker threads. Set CUBEWORLD_RENDER_FRAME to a
+ * path to also save the last frame as a TGA image.
+ */
+BENCHMARK(SoftwareRender)
+{
+    benchmarkSoftwareRender( 1 );
+    benchmarkSoftwareRender( 4 );
+}
@@ -0,0 +1,57 @@
+#include "benchmark.h"
+#include "engine/world.h"
+#include "engine/constants.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+#include "generation/terrainworldgenerator.h"
+
+#include <string>
+
+namespace
+{
+    /**
+     * Generates a 16x16 chunk column terrain world and reports how many
+     * chunks were generated per second
+     */
+    void benchmarkTerrain( const std::string& name, bool isUsingBulkWrites )
+    {
+        const unsigned int RUNS = 3;
+
+        double seconds = 0.0, chunks = 0.0, cubes = 0.0;
+
+        for ( unsigned int run = 0; run < RUNS; ++run )
+        {
+            NullRenderer renderer;
+            TerrainWorldGenerator generator( 1337, 1 );
+            generator.setBulkWritesEnabled( isUsingBulkWrites );
+
+            BenchmarkTimer timer;
+            World * pWorld = generator.generate( Constants::CHUNK_COLS  * 16,
+                                                 Constants::CHUNK_ROWS  * 4,
+                                                 Constants::CHUNK_DEPTH * 16,
+                                                 new WorldView( &renderer, 0 ) );
+            seconds += timer.elapsedSeconds();
+
+            chunks += pWorld->chunkCount();
+            cubes  += pWorld->cubeCount();
+
+            delete pWorld;
+        }
+
+        Benchmark::report( name + "ms/world", seconds * 1000.0 / RUNS );
+        Benchmark::report( name + "chunks/s", chunks / seconds );
+        Benchmark::report( name + "cubes/s (M)", cubes / seconds / 1000000.0 );
+    }
+}
+
+/**
+ * Noise heightmap terrain generation throughput, for a 512x128x512 world.
+ * Chunks are written out with a single bulk copy each, compared to placing
+ * every generated cube with World::put. Runs on a single thread, see
+ * WorldGeneration for scaling across threads.
+ */
+BENCHMARK(TerrainGeneration)
+{
+    benchmarkTerrain( "bulk chunk writes ", true );
+    benchmarkTerrain( "per cube writes ", false );
+}
@@ -0,0 +1,71 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/cubedata.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    void benchmarkBudget( float budget )
+    {
+        std::ostringstream ss;
+        ss << "budget " << budget << "ms ";
+        const std::string name = ss.str();
+
+        NullRenderer renderer;
+        WorldView * pView = new WorldView( &renderer, 0 );
+        World * pWorld = BenchWorlds::createCaveWorld( pView );
+
+        pView->finishMeshing();
+        pView->setUpdateBudget( budget );
+
+        // A burst of edits that dirties most of the world at once, followed
+        // by quiet frames while the view catches up
+        const int EDIT_FRAMES = 5, EDITS_PER_FRAME = 64;
+        unsigned int seed = 777;
+        double worstMs = 0.0;
+        int frames = 0;
+
+        do
+        {
+            if ( frames < EDIT_FRAMES )
+            {
+                for ( int i = 0; i < EDITS_PER_FRAME; ++i )
+                {
+                    seed = seed * 1103515245u + 12345u;
+                    pWorld->put( CubeData(), Point( ( seed >> 4 ) % pWorld->cols(),
+                                                    ( seed >> 12 ) % pWorld->rows(),
+                                                    ( seed >> 20 ) % pWorld->depth() ) );
+                }
+            }
+
+            BenchmarkTimer frameTimer;
+            pView->update();
+            worstMs = std::max( worstMs, frameTimer.elapsedSeconds() * 1000.0 );
+
+            frames++;
+        }
+        while ( frames < EDIT_FRAMES || pView->updateStats().chunksDeferred > 0 );
+
+        Benchmark::report( name + "worst frame (ms)", worstMs );
+        Benchmark::report( name + "frames to catch up", frames );
+
+        delete pWorld;
+    }
+}
+
+/**
+ * Worst frame time while meshing inline after a mass edit, with and without
+ * a per frame update budget
+ */
+BENCHMARK(UpdateBudget)
+{
+    benchmarkBudget( 0.0f );
+    benchmarkBudget( 8.0f );
+}
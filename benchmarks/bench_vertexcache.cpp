@@ -0,0 +1,125 @@
+#include "benchmark.h"
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/cubeface.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+#include "graphics/vertexcacheoptimizer.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <string>
+
+namespace
+{
+    /**
+     * Index buffer size and simulated vertex cache behavior of every section
+     * in the world, built plainly and with the vertex cache optimization
+     */
+    void benchmarkVertexCache( const std::string& name,
+                               const World& world,
+                               EMeshingMode mode )
+    {
+        WorldChunkBuilder builder;
+        WorldChunkMesh plain, optimized;
+
+        unsigned long sections = 0, wideSections = 0, triangles = 0;
+        unsigned long plainVertices = 0, optimizedVertices = 0;
+        unsigned long wideBytes = 0, plainBytes = 0;
+        double plainMisses = 0.0, optimizedMisses = 0.0;
+        double plainSeconds = 0.0, optimizedSeconds = 0.0;
+
+        for ( unsigned int z = 0; z < world.chunkDepth(); ++z )
+        {
+            for ( unsigned int y = 0; y < world.chunkRows(); ++y )
+            {
+                for ( unsigned int x = 0; x < world.chunkCols(); ++x )
+                {
+                    Point coord( x, y, z );
+                    const WorldChunk * pChunk = world.chunkAt( coord );
+
+                    if ( pChunk == NULL )
+                    {
+                        continue;
+                    }
+
+                    ChunkNeighborhood neighborhood( *pChunk );
+
+                    for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+                    {
+                        neighborhood.pNeighbors[f] =
+                            world.neighborOf( coord, static_cast<ECubeFace>( f ) );
+                    }
+
+                    for ( unsigned int s = 0; s < WorldChunk::SECTION_COUNT; ++s )
+                    {
+                        builder.buildSection( neighborhood, s, mode );
+
+                        BenchmarkTimer plainTimer;
+                        builder.generateMesh( plain );
+                        plainSeconds += plainTimer.elapsedSeconds();
+
+                        BenchmarkTimer optimizedTimer;
+                        builder.generateOptimizedMesh( optimized );
+                        optimizedSeconds += optimizedTimer.elapsedSeconds();
+
+                        const size_t count = plain.indices.size() / 3;
+
+                        sections          += 1;
+                        wideSections      += plain.indices.is16Bit() ? 0 : 1;
+                        triangles         += count;
+                        plainVertices     += plain.vertices.size();
+                        optimizedVertices += optimized.vertices.size();
+                        wideBytes         += plain.indices.size() * sizeof(unsigned int);
+                        plainBytes        += plain.indices.byteSize();
+
+                        plainMisses += count *
+                            VertexCacheOptimizer::simulateAcmr( plain.indices,
+                                                                plain.vertices.size() );
+                        optimizedMisses += count *
+                            VertexCacheOptimizer::simulateAcmr( optimized.indices,
+                                                                optimized.vertices.size() );
+                    }
+                }
+            }
+        }
+
+        Benchmark::report( name + " 32 bit sections", wideSections );
+        Benchmark::report( name + " 32 bit index KB/section",
+                           wideBytes / 1024.0 / sections );
+        Benchmark::report( name + " 16 bit index KB/section",
+                           plainBytes / 1024.0 / sections );
+        Benchmark::report( name + " index bytes saved (%)",
+                           100.0 * ( wideBytes - plainBytes ) / wideBytes );
+        Benchmark::report( name + " vertices/section", plainVertices / (double) sections );
+        Benchmark::report( name + " welded vertices/section",
+                           optimizedVertices / (double) sections );
+        Benchmark::report( name + " ACMR", plainMisses / triangles );
+        Benchmark::report( name + " optimized ACMR", optimizedMisses / triangles );
+        Benchmark::report( name + " generate (sections/s)", sections / plainSeconds );
+        Benchmark::report( name + " optimize (sections/s)",
+                           sections / optimizedSeconds );
+    }
+}
+
+/**
+ * Index memory and simulated post-transform cache misses (ACMR, vertices
+ * transformed per triangle through a 16 entry FIFO) of opaque section
+ * meshes, with and without the vertex cache optimization
+ */
+BENCHMARK(VertexCache)
+{
+    NullRenderer renderer;
+
+    World * pFlat = BenchWorlds::createFlatWorld( new WorldView( &renderer, 0 ) );
+    benchmarkVertexCache( "flat culled", *pFlat, EMESHING_CULLED );
+    benchmarkVertexCache( "flat greedy", *pFlat, EMESHING_GREEDY );
+    delete pFlat;
+
+    World * pCave = BenchWorlds::createCaveWorld( new WorldView( &renderer, 0 ) );
+    benchmarkVertexCache( "cave culled", *pCave, EMESHING_CULLED );
+    benchmarkVertexCache( "cave greedy", *pCave, EMESHING_GREEDY );
+    delete pCave;
+}
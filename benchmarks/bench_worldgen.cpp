@@ -0,0 +1,88 @@
+#include "benchmark.h"
+#include "engine/world.h"
+#include "engine/constants.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+#include "generation/flatworldgenerator.h"
+#include "generation/terrainworldgenerator.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    /**
+     * Generates a 1024x128x1024 world with the generator and reports how
+     * many chunks per second were generated, and how much faster that is
+     * than the first run's rate
+     */
+    void benchmarkGenerator( const std::string& name,
+                             ColumnWorldGenerator& generator,
+                             double& baseRate )
+    {
+        const unsigned int RUNS = 3;
+        double seconds = 0.0, chunks = 0.0;
+
+        for ( unsigned int run = 0; run < RUNS; ++run )
+        {
+            NullRenderer renderer;
+
+            BenchmarkTimer timer;
+            World * pWorld = generator.generate( Constants::CHUNK_COLS  * 32,
+                                                 Constants::CHUNK_ROWS  * 4,
+                                                 Constants::CHUNK_DEPTH * 32,
+                                                 new WorldView( &renderer, 0 ) );
+            seconds += timer.elapsedSeconds();
+            chunks  += pWorld->chunkCount();
+
+            delete pWorld;
+        }
+
+        std::ostringstream ss;
+        ss << name << " " << generator.threadCount()
+           << ( generator.threadCount() == 1 ? " thread " : " threads " );
+
+        Benchmark::report( ss.str() + "ms/world", seconds * 1000.0 / RUNS );
+        const double rate = chunks / seconds;
+        baseRate = ( baseRate > 0.0 ? baseRate : rate );
+
+        Benchmark::report( ss.str() + "chunks/s", rate );
+        Benchmark::report( ss.str() + "speedup", rate / baseRate );
+    }
+}
+
+/**
+ * How world generation scales with the number of threads generating chunk
+ * columns, from one thread up to one per core (and at least four). Both
+ * generators produce the same world on any number of threads, so only the
+ * time taken should change.
+ */
+BENCHMARK(WorldGeneration)
+{
+    const unsigned int cores = std::max( 1u, std::thread::hardware_concurrency() );
+    std::vector<unsigned int> threadCounts;
+
+    for ( unsigned int threads = 1; threads <= std::max( 4u, cores ); threads *= 2 )
+    {
+        threadCounts.push_back( threads );
+    }
+
+    Benchmark::report( "hardware threads", cores );
+
+    double flatBase = 0.0, terrainBase = 0.0;
+
+    for ( size_t i = 0; i < threadCounts.size(); ++i )
+    {
+        FlatWorldGenerator flat( 1337, threadCounts[i] );
+        benchmarkGenerator( "flat", flat, flatBase );
+    }
+
+    for ( size_t i = 0; i < threadCounts.size(); ++i )
+    {
+        TerrainWorldGenerator terrain( 1337, threadCounts[i] );
+        benchmarkGenerator( "terrain", terrain, terrainBase );
+    }
+}
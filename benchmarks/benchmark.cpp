@@ -0,0 +1,86 @@
+#include "benchmark.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct RegisteredBenchmark
+    {
+        const char * pName;
+        Benchmark::BenchmarkFunction pFunction;
+    };
+
+    // Function local static so registration order doesn't matter
+    std::vector<RegisteredBenchmark>& registry()
+    {
+        static std::vector<RegisteredBenchmark> benchmarks;
+        return benchmarks;
+    }
+
+    const char * GCurrentBenchmark = "";
+}
+
+namespace Benchmark
+{
+
+bool add( const char * pName, BenchmarkFunction pFunction )
+{
+    RegisteredBenchmark benchmark = { pName, pFunction };
+    registry().push_back( benchmark );
+
+    return true;
+}
+
+int runAll( const std::string& filter )
+{
+    int count = 0;
+
+    for ( size_t i = 0; i < registry().size(); ++i )
+    {
+        const RegisteredBenchmark& benchmark = registry()[i];
+
+        if ( std::string( benchmark.pName ).compare( 0, filter.size(), filter ) != 0 )
+        {
+            continue;
+        }
+
+        std::cout << "[ RUN      ] " << benchmark.pName << std::endl;
+        GCurrentBenchmark = benchmark.pName;
+
+        BenchmarkTimer timer;
+        benchmark.pFunction();
+
+        std::cout << "[     DONE ] " << benchmark.pName << " ("
+                  << static_cast<int>( timer.elapsedSeconds() * 1000.0 )
+                  << " ms)" << std::endl;
+        count++;
+    }
+
+    return count;
+}
+
+void report( const std::string& what, double value )
+{
+    std::cout << "    " << GCurrentBenchmark << ": "
+              << std::left << std::setw( 36 ) << what
+              << std::right << std::fixed << std::setprecision( 3 )
+              << value << std::endl;
+}
+
+}
+
+int main( int argc, char * argv[] )
+{
+    std::string filter = ( argc > 1 ? argv[1] : "" );
+
+    if ( Benchmark::runAll( filter ) == 0 )
+    {
+        std::cerr << "No benchmarks matched '" << filter << "'" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
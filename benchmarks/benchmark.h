@@ -0,0 +1,80 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_BENCHMARK_H
+#define SCOTT_CUBEWORLD_BENCHMARK_H
+
+#include <chrono>
+#include <string>
+
+/**
+ * Minimal benchmark registration. Each benchmark is a function that is
+ * registered under a name at static initialization time, in the same spirit
+ * as google test's TEST macro:
+ *
+ *   BENCHMARK(MyBenchmark)
+ *   {
+ *       BenchmarkTimer timer;
+ *       ...
+ *       Benchmark::report( "things/s", count / timer.elapsedSeconds() );
+ *   }
+ */
+namespace Benchmark
+{
+    typedef void (*BenchmarkFunction)();
+
+    // Add a benchmark to the list of benchmarks to run
+    bool add( const char * pName, BenchmarkFunction pFunction );
+
+    // Run all benchmarks whose name starts with the filter string
+    int runAll( const std::string& filter );
+
+    // Print a named measurement for the currently running benchmark
+    void report( const std::string& what, double value );
+}
+
+/**
+ * Wall clock stopwatch used to time benchmarks
+ */
+class BenchmarkTimer
+{
+public:
+    BenchmarkTimer()
+        : mStart( std::chrono::steady_clock::now() )
+    {
+    }
+
+    void restart()
+    {
+        mStart = std::chrono::steady_clock::now();
+    }
+
+    double elapsedSeconds() const
+    {
+        return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - mStart ).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point mStart;
+};
+
+#define BENCHMARK(name)                                                 \
+    static void benchmark_##name();                                     \
+    static const bool benchmark_registered_##name =                     \
+        Benchmark::add( #name, &benchmark_##name );                     \
+    static void benchmark_##name()
+
+#endif
@@ -0,0 +1,98 @@
+#include "benchworlds.h"
+#include "engine/world.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "engine/point.h"
+#include "generation/flatworldgenerator.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace BenchWorlds
+{
+
+/**
+ * Creates an 8x4x8 chunk world of solid rock, and then carves winding
+ * worm tunnels through it.
+ */
+World * createCaveWorld( WorldView * pView, std::vector<Point> * pOpenCubes )
+{
+    const int COLS  = Constants::CHUNK_COLS  * 8;
+    const int ROWS  = Constants::CHUNK_ROWS  * 4;
+    const int DEPTH = Constants::CHUNK_DEPTH * 8;
+
+    const int WORM_COUNT  = 24;
+    const int WORM_LENGTH = 160;
+    const int WORM_RADIUS = 2;
+
+    World * pWorld = new World( COLS, ROWS, DEPTH, pView );
+
+    for ( int z = 0; z < DEPTH; ++z )
+    {
+        for ( int y = 0; y < ROWS; ++y )
+        {
+            for ( int x = 0; x < COLS; ++x )
+            {
+                pWorld->put( CubeData( EMATERIAL_ROCK ), Point( x, y, z ) );
+            }
+        }
+    }
+
+    // Fixed seed, every run should carve the same caves
+    std::mt19937 rng( 1337 );
+    std::uniform_int_distribution<> stepDice( -1, 1 );
+
+    for ( int worm = 0; worm < WORM_COUNT; ++worm )
+    {
+        Point p( std::uniform_int_distribution<>( 8, COLS  - 9 )( rng ),
+                 std::uniform_int_distribution<>( 8, ROWS  - 9 )( rng ),
+                 std::uniform_int_distribution<>( 8, DEPTH - 9 )( rng ) );
+
+        if ( pOpenCubes != 0 )
+        {
+            pOpenCubes->push_back( p );
+        }
+
+        for ( int step = 0; step < WORM_LENGTH; ++step )
+        {
+            // Hollow out a small box around the worm's head
+            for ( int dz = -WORM_RADIUS; dz <= WORM_RADIUS; ++dz )
+            {
+                for ( int dy = -WORM_RADIUS; dy <= WORM_RADIUS; ++dy )
+                {
+                    for ( int dx = -WORM_RADIUS; dx <= WORM_RADIUS; ++dx )
+                    {
+                        Point c( p.x + dx, p.y + dy, p.z + dz );
+
+                        if ( c.x >= 0 && c.x < COLS &&
+                             c.y >= 0 && c.y < ROWS &&
+                             c.z >= 0 && c.z < DEPTH )
+                        {
+                            pWorld->put( CubeData(), c );
+                        }
+                    }
+                }
+            }
+
+            // Wander, but keep the head inside of the world
+            p = Point( std::max( 2, std::min( COLS  - 3, p.x + 2 * stepDice( rng ) ) ),
+                       std::max( 2, std::min( ROWS  - 3, p.y + stepDice( rng ) ) ),
+                       std::max( 2, std::min( DEPTH - 3, p.z + 2 * stepDice( rng ) ) ) );
+        }
+    }
+
+    return pWorld;
+}
+
+World * createFlatWorld( WorldView * pView )
+{
+    FlatWorldGenerator generator;
+
+    return generator.generate( Constants::CHUNK_COLS  * 8,
+                               Constants::CHUNK_ROWS  * 2,
+                               Constants::CHUNK_DEPTH * 8,
+                               pView );
+}
+
+}
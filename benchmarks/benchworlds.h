@@ -0,0 +1,40 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_BENCH_WORLDS_H
+#define SCOTT_CUBEWORLD_BENCH_WORLDS_H
+
+#include <vector>
+#include "engine/point.h"
+
+class World;
+class WorldView;
+
+/**
+ * Standard worlds that the benchmarks are run against. All of them are
+ * deterministic, so numbers from different runs can be compared.
+ */
+namespace BenchWorlds
+{
+    // Solid rock riddled with winding tunnels. Returns a list of cubes that
+    // lie inside of the tunnels, which are handy camera positions
+    World * createCaveWorld( WorldView * pView,
+                             std::vector<Point> * pOpenCubes = 0 );
+
+    // FlatWorldGenerator's world (bedrock, dirt/rock layers and grass)
+    World * createFlatWorld( WorldView * pView );
+}
+
+#endif
@@ -13,216 +13,628 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#ifndef SCOTT_MATH_PERLIN_H
-#define SCOTT_MATH_PERLIN_H
+#include <math/perlin.h>
 
-#include <cstdlib>
-#include <boost/random.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#   define PERLIN_USE_SSE2
+#   include <emmintrin.h>
+#endif
 
 namespace
 {
-    inline float p_ease( float a )
+    // Gradient directions for 2d noise, indexed by the low three bits of a
+    // corner's hash
+    const float GRADIENT_2D_X[8] = { 1, -1,  1, -1,  1, -1,  0,  0 };
+    const float GRADIENT_2D_Y[8] = { 1,  1, -1, -1,  0,  0,  1, -1 };
+
+    // Gradient directions for 3d noise, indexed by the low four bits of a
+    // corner's hash. These are the twelve cube edge directions from Perlin's
+    // improved noise, with four of them repeated to fill out the table
+    const float GRADIENT_3D_X[16] =
+        { 1, -1,  1, -1,  1, -1,  1, -1,  0,  0,  0,  0,  1,  0, -1,  0 };
+    const float GRADIENT_3D_Y[16] =
+        { 1,  1, -1, -1,  0,  0,  0,  0,  1, -1,  1, -1,  1, -1,  1, -1 };
+    const float GRADIENT_3D_Z[16] =
+        { 0,  0,  0,  0,  1,  1, -1, -1,  1,  1, -1, -1,  0,  1,  0, -1 };
+
+    /**
+     * Where a coordinate falls on the noise lattice
+     */
+    struct LatticeSample
+    {
+        /// Lattice cell containing the coordinate, wrapped to [0, 255]
+        unsigned int cell;
+
+        /// Distance from the start of the cell, in [0, 1)
+        float offset;
+
+        /// Offset run through the fade curve
+        float weight;
+    };
+
+    inline float fade( float t )
     {
-        return ((( a * 6 - 15 ) * a + 10 ) * a * a * a);
+        return t * t * t * ( t * ( t * 6.0f - 15.0f ) + 10.0f );
+    }
+
+    inline float lerp( float a, float b, float t )
+    {
+        return a + t * ( b - a );
+    }
+
+    inline LatticeSample sampleLattice( float v )
+    {
+        int cell = static_cast<int>( v );
+
+        if ( v < static_cast<float>( cell ) )
+        {
+            cell -= 1;
+        }
+
+        LatticeSample sample;
+        sample.cell   = static_cast<unsigned int>( cell ) & 255u;
+        sample.offset = v - static_cast<float>( cell );
+        sample.weight = fade( sample.offset );
+
+        return sample;
     }
+
+    inline float gradient2( unsigned int hash, float x, float y )
+    {
+        hash &= 7;
+        return GRADIENT_2D_X[hash] * x + GRADIENT_2D_Y[hash] * y;
+    }
+
+    inline float gradient3( unsigned int hash, float x, float y, float z )
+    {
+        hash &= 15;
+        return GRADIENT_3D_X[hash] * x +
+               GRADIENT_3D_Y[hash] * y +
+               GRADIENT_3D_Z[hash] * z;
+    }
+
+    /**
+     * Evaluates 2d noise at a point that has already been placed on the
+     * lattice
+     */
+    inline float noise2( const unsigned char * p,
+                         const LatticeSample& sx,
+                         const LatticeSample& sy )
+    {
+        const unsigned int a = p[sx.cell]     + sy.cell;
+        const unsigned int b = p[sx.cell + 1] + sy.cell;
+
+        const float x0 = sx.offset, x1 = sx.offset - 1.0f;
+        const float y0 = sy.offset, y1 = sy.offset - 1.0f;
+
+        const float n00 = gradient2( p[a],     x0, y0 );
+        const float n10 = gradient2( p[b],     x1, y0 );
+        const float n01 = gradient2( p[a + 1], x0, y1 );
+        const float n11 = gradient2( p[b + 1], x1, y1 );
+
+        return lerp( lerp( n00, n10, sx.weight ),
+                     lerp( n01, n11, sx.weight ),
+                     sy.weight );
+    }
+
+    /**
+     * Evaluates 3d noise at a point that has already been placed on the
+     * lattice
+     */
+    inline float noise3( const unsigned char * p,
+                         const LatticeSample& sx,
+                         const LatticeSample& sy,
+                         const LatticeSample& sz )
+    {
+        const unsigned int a  = p[sx.cell]     + sy.cell;
+        const unsigned int b  = p[sx.cell + 1] + sy.cell;
+        const unsigned int aa = p[a]     + sz.cell;
+        const unsigned int ab = p[a + 1] + sz.cell;
+        const unsigned int ba = p[b]     + sz.cell;
+        const unsigned int bb = p[b + 1] + sz.cell;
+
+        const float x0 = sx.offset, x1 = sx.offset - 1.0f;
+        const float y0 = sy.offset, y1 = sy.offset - 1.0f;
+        const float z0 = sz.offset, z1 = sz.offset - 1.0f;
+
+        const float n000 = gradient3( p[aa],     x0, y0, z0 );
+        const float n100 = gradient3( p[ba],     x1, y0, z0 );
+        const float n010 = gradient3( p[ab],     x0, y1, z0 );
+        const float n110 = gradient3( p[bb],     x1, y1, z0 );
+        const float n001 = gradient3( p[aa + 1], x0, y0, z1 );
+        const float n101 = gradient3( p[ba + 1], x1, y0, z1 );
+        const float n011 = gradient3( p[ab + 1], x0, y1, z1 );
+        const float n111 = gradient3( p[bb + 1], x1, y1, z1 );
+
+        const float nx00 = lerp( n000, n100, sx.weight );
+        const float nx10 = lerp( n010, n110, sx.weight );
+        const float nx01 = lerp( n001, n101, sx.weight );
+        const float nx11 = lerp( n011, n111, sx.weight );
+
+        return lerp( lerp( nx00, nx10, sy.weight ),
+                     lerp( nx01, nx11, sy.weight ),
+                     sz.weight );
+    }
+
+    /**
+     * Places each column of a grid row on the lattice. Columns are shared
+     * by every row of the grid, so this only has to be done once per fill
+     */
+    void sampleColumns( std::vector<LatticeSample>& columns,
+                        unsigned int width,
+                        float x,
+                        float step,
+                        float frequency )
+    {
+        columns.resize( width );
+
+        for ( unsigned int i = 0; i < width; ++i )
+        {
+            float cx  = ( x + static_cast<float>( i ) * step ) * frequency;
+            columns[i] = sampleLattice( cx );
+        }
+    }
+
+    /**
+     * Writes (or adds) a scaled noise value to the output
+     */
+    inline void store( float * pOut, float n, float amplitude, bool isFirst )
+    {
+        *pOut = ( isFirst ? amplitude * n : *pOut + amplitude * n );
+    }
+
+#ifdef PERLIN_USE_SSE2
+    inline __m128 lerp4( __m128 a, __m128 b, __m128 t )
+    {
+        return _mm_add_ps( a, _mm_mul_ps( t, _mm_sub_ps( b, a ) ) );
+    }
+
+    /**
+     * Loads the gradients for four corner hashes and dots them with the
+     * corner offsets
+     */
+    inline __m128 gradient2x4( const unsigned int * hash, __m128 x, __m128 y )
+    {
+        const unsigned int h0 = hash[0] & 7, h1 = hash[1] & 7;
+        const unsigned int h2 = hash[2] & 7, h3 = hash[3] & 7;
+
+        __m128 gx = _mm_setr_ps( GRADIENT_2D_X[h0], GRADIENT_2D_X[h1],
+                                 GRADIENT_2D_X[h2], GRADIENT_2D_X[h3] );
+        __m128 gy = _mm_setr_ps( GRADIENT_2D_Y[h0], GRADIENT_2D_Y[h1],
+                                 GRADIENT_2D_Y[h2], GRADIENT_2D_Y[h3] );
+
+        return _mm_add_ps( _mm_mul_ps( gx, x ), _mm_mul_ps( gy, y ) );
+    }
+
+    inline __m128 gradient3x4( const unsigned int * hash,
+                               __m128 x,
+                               __m128 y,
+                               __m128 z )
+    {
+        const unsigned int h0 = hash[0] & 15, h1 = hash[1] & 15;
+        const unsigned int h2 = hash[2] & 15, h3 = hash[3] & 15;
+
+        __m128 gx = _mm_setr_ps( GRADIENT_3D_X[h0], GRADIENT_3D_X[h1],
+                                 GRADIENT_3D_X[h2], GRADIENT_3D_X[h3] );
+        __m128 gy = _mm_setr_ps( GRADIENT_3D_Y[h0], GRADIENT_3D_Y[h1],
+                                 GRADIENT_3D_Y[h2], GRADIENT_3D_Y[h3] );
+        __m128 gz = _mm_setr_ps( GRADIENT_3D_Z[h0], GRADIENT_3D_Z[h1],
+                                 GRADIENT_3D_Z[h2], GRADIENT_3D_Z[h3] );
+
+        return _mm_add_ps( _mm_add_ps( _mm_mul_ps( gx, x ),
+                                       _mm_mul_ps( gy, y ) ),
+                           _mm_mul_ps( gz, z ) );
+    }
+
+    /**
+     * Writes (or adds) four scaled noise values to the output
+     */
+    inline void store4( float * pOut, __m128 n, float amplitude, bool isFirst )
+    {
+        __m128 scaled = _mm_mul_ps( _mm_set1_ps( amplitude ), n );
+
+        if ( !isFirst )
+        {
+            scaled = _mm_add_ps( _mm_loadu_ps( pOut ), scaled );
+        }
+
+        _mm_storeu_ps( pOut, scaled );
+    }
+#endif
 }
 
+/**
+ * Constructor
+ *
+ * \param  seed  Seed used to shuffle the permutation table
+ */
 PerlinNoise::PerlinNoise( unsigned int seed )
-    : pRandomLUT( new unsigned char[RANDOM_LUT_SIZE] )
+    : mSeed( seed )
 {
     init( seed );
 }
 
-PerlinNoise::PerlinNoise( const PerlinNoise& p )
-    : pRandomLUT( new unsigned char[RANDOM_LUT_SIZE] )
+/**
+ * Returns the seed this noise generator was created with
+ */
+unsigned int PerlinNoise::seed() const
+{
+    return mSeed;
+}
+
+float PerlinNoise::noise( float x, float y ) const
 {
-    std::copy( p.pRandomLUT,
-               p.pRandomLUT + RANDOM_LUT_SIZE,
-               pRandomLut );
+    return noise2( mPermutation, sampleLattice( x ), sampleLattice( y ) );
 }
 
-PerlinNoise::~PerlinNoise()
+float PerlinNoise::noise( float x, float y, float z ) const
 {
-    delete[] pRandomLUT;
+    return noise3( mPermutation,
+                   sampleLattice( x ),
+                   sampleLattice( y ),
+                   sampleLattice( z ) );
 }
 
-PerlinNoise& PerlinNoise::operator = ( const PerlinNoise& rhs )
+float PerlinNoise::noise( const Vec3& pos ) const
 {
-    // Only copy the random lookup table if we are not the same instance
-    if ( this == &p )
-    {
-        // Destroy original random buffer
-        delete[] pRandomLUT;
+    return noise( static_cast<float>( pos.x() ),
+                  static_cast<float>( pos.y() ),
+                  static_cast<float>( pos.z() ) );
+}
 
-        // Now re-create the buffer, and populate it with the contents of
-        // 'rhs'
-        pRandomLUT = new unsigned char[RANDOM_LUT_SIZE];
+float PerlinNoise::fbm( float x,
+                        float y,
+                        unsigned int octaves,
+                        float lacunarity,
+                        float gain ) const
+{
+    float sum = 0.0f, amplitude = 1.0f, frequency = 1.0f, total = 0.0f;
 
-        std::copy( rhs.pRandomLUT,
-                   rhs.pRandomLUT + RANDOM_LUT_SIZE,
-                   pRandomLUT );
+    for ( unsigned int i = 0; i < octaves; ++i )
+    {
+        sum       += amplitude * noise( x * frequency, y * frequency );
+        total     += amplitude;
+        amplitude *= gain;
+        frequency *= lacunarity;
     }
 
-    return *this;
+    return ( octaves > 0 ? sum * ( 1.0f / total ) : 0.0f );
 }
 
-float PerlinNoise::noise3( const Vec3& pos ) const
+float PerlinNoise::fbm( float x,
+                        float y,
+                        float z,
+                        unsigned int octaves,
+                        float lacunarity,
+                        float gain ) const
 {
-    return noise3( pos.x(), pos.y(), pos.z(), 0, 0, 0 );
+    float sum = 0.0f, amplitude = 1.0f, frequency = 1.0f, total = 0.0f;
+
+    for ( unsigned int i = 0; i < octaves; ++i )
+    {
+        sum       += amplitude * noise( x * frequency,
+                                        y * frequency,
+                                        z * frequency );
+        total     += amplitude;
+        amplitude *= gain;
+        frequency *= lacunarity;
+    }
+
+    return ( octaves > 0 ? sum * ( 1.0f / total ) : 0.0f );
 }
 
-float PerlinNoise::noise3( float x, float y, float z ) const
+void PerlinNoise::fill( float * pOut,
+                        unsigned int width,
+                        unsigned int height,
+                        float x,
+                        float y,
+                        float step ) const
 {
-    return noise3( x, y, z, 0, 0, 0 );
+    accumulate2( pOut, width, height, x, y, step, 1.0f, 1.0f, true );
 }
 
-float PerlinNoise::noise3( float x,
-                           float y,
-                           float z,
-                           int xWrap,
-                           int yWrap,
-                           int zWrap ) const
+void PerlinNoise::fill( float * pOut,
+                        unsigned int width,
+                        unsigned int height,
+                        unsigned int depth,
+                        float x,
+                        float y,
+                        float z,
+                        float step ) const
 {
+    accumulate3( pOut, width, height, depth, x, y, z, step, 1.0f, 1.0f, true );
 }
 
-float PerlinNoise::grad( int hash, float x, float y, float z )
+void PerlinNoise::fillFbm( float * pOut,
+                           unsigned int width,
+                           unsigned int height,
+                           float x,
+                           float y,
+                           float step,
+                           unsigned int octaves,
+                           float lacunarity,
+                           float gain ) const
 {
-    // Table of pre-computed gradient vectors
-    const static float BASIS[12][3] =
-    {
-        {  1, 1, 0 },
-        { -1, 1, 0 },
-        {  1,-1, 0 },
-        { -1,-1, 0 },
-        {  1, 0, 1 },
-        { -1, 0, 1 },
-        {  1, 0,-1 },
-        { -1, 0,-1 },
-        {  0, 1, 1 },
-        {  0,-1, 1 },
-        {  0, 1,-1 },
-        {  0,-1,-1 },
-    };
+    const size_t count = static_cast<size_t>( width ) * height;
+    float amplitude = 1.0f, frequency = 1.0f, total = 0.0f;
 
-    // perlin's gradient has 12 cases so some get used 1/16th of the time
-    // and some 2/16ths. We reduce bias by changing those fractions
-    // to 5/16ths and 6/16ths, and the same 4 cases get the extra weight.
-    const static unsigned char INDICES[64] =
-    {
-        0, 1, 2, 3,  4, 5, 6, 7, 8, 9, 10, 11,
-        0, 9, 1, 11,
-        0, 1, 2, 3,  4, 5, 6, 7, 8, 9, 10, 11,
-        0, 1, 2, 3,  4, 5, 6, 7, 8, 9, 10, 11,
-        0, 1, 2, 3,  4, 5, 6, 7, 8, 9, 10, 11,
-        0, 1, 2, 3,  4, 5, 6, 7, 8, 9, 10, 11,
-    };
+    if ( octaves == 0 )
+    {
+        std::fill( pOut, pOut + count, 0.0f );
+        return;
+    }
 
-    // Generate the value using the reference permutation table
-    float *pGrad = BASIS[ INDICES[ hash & 63 ] ];
-    return pGrad[0] * x + pGrad[1] * y + pGrad[2] * z;
-}
+    for ( unsigned int i = 0; i < octaves; ++i )
+    {
+        accumulate2( pOut, width, height, x, y, step,
+                     frequency, amplitude, i == 0 );
 
-float PerlinNoise::noise( float x, float y, float z ) const
-{
-    return noise( x, y, z, 0, 0, 0 );
-}
+        total     += amplitude;
+        amplitude *= gain;
+        frequency *= lacunarity;
+    }
 
-float PerlinNoise::noise( const Vec3& v ) const
-{
-    return noise( v.x(), v.y(), v.z(), 0, 0, 0 );
+    const float scale = 1.0f / total;
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        pOut[i] *= scale;
+    }
 }
 
-float PerlinNoise::noise( float x, float y ) const
+void PerlinNoise::fillFbm( float * pOut,
+                           unsigned int width,
+                           unsigned int height,
+                           unsigned int depth,
+                           float x,
+                           float y,
+                           float z,
+                           float step,
+                           unsigned int octaves,
+                           float lacunarity,
+                           float gain ) const
 {
+    const size_t count = static_cast<size_t>( width ) * height * depth;
+    float amplitude = 1.0f, frequency = 1.0f, total = 0.0f;
+
+    if ( octaves == 0 )
+    {
+        std::fill( pOut, pOut + count, 0.0f );
+        return;
+    }
+
+    for ( unsigned int i = 0; i < octaves; ++i )
+    {
+        accumulate3( pOut, width, height, depth, x, y, z, step,
+                     frequency, amplitude, i == 0 );
+
+        total     += amplitude;
+        amplitude *= gain;
+        frequency *= lacunarity;
+    }
+
+    const float scale = 1.0f / total;
 
+    for ( size_t i = 0; i < count; ++i )
+    {
+        pOut[i] *= scale;
+    }
 }
 
-float PerlinNoise::noise( float x, float y, float z,
-                          int x_wrap,
-                          int y_wrap,
-                          int z_wrap ) const
+/**
+ * Evaluates one octave of 2d noise over a grid, and either writes it to
+ * the output or adds it to what is already there. Columns are placed on
+ * the lattice once up front, and each row is then evaluated four columns
+ * at a time with the lattice hashing done per lane and all of the
+ * gradient and interpolation math done in SSE registers
+ */
+void PerlinNoise::accumulate2( float * pOut,
+                               unsigned int width,
+                               unsigned int height,
+                               float x,
+                               float y,
+                               float step,
+                               float frequency,
+                               float amplitude,
+                               bool isFirstOctave ) const
 {
-    float u, v, w;
-    float n000, n001, n010, n011, n100, n101, n110, n111;
-    float n00, n01, n10, n11;
-    float n0, n1;
-
-    unsigned int x_mask = ( x_wrap - 1 ) & 255;
-    unsigned int y_mask = ( y_wrap - 1 ) & 255;
-    unsigned int z_mask = ( z_wrap - 1 ) & 255;
-
-    // Find the unit cube that contains point. We "cut" the points by
-    // forcing our x/y/z values into a [0,*_wrap] range that will become
-    // the maximums of our unit cube (x0,y0,z0 --> x1,y1,z1)
-    int px = std::floor( x );
-    int py = std::floor( y );
-    int pz = std::floor( z );
-
-    int x0 = px & x_mask, x1 = (px + 1) & x_mask;
-    int y0 = py & y_mask, y1 = (py + 1) & y_mask;
-    int z0 = py & z_mask, z1 = (pz + 1) & z_mask;
-
-    int r0, r1, r00, r01, r10, r11;
-
-    // Find the relative X/Y/Z of point in the unit cube by rounding our
-    // coordinates to the nearest int
-    x -= px;
-    y -= py;
-    z -= pz;
-
-    // Compute the fade curves for x/y/z
-    u  = p_ease( x );
-    v  = p_ease( y );
-    w  = p_ease( z );
-
-    // Hash coordinates of the eight unit cube corners
-    r0 = mpRandomLUT[ x0 ];
-    r1 = mpRandomLUT[ x1 ];
-
-    r00 = mpRandomLUT[ r0 + y0 ];
-    r01 = mpRandomLUT[ r0 + y1 ];
-    r10 = mpRandomLUT[ r1 + y0 ];
-    r11 = mpRandomLUT[ r1 + y1 ];
-
-    // Calculate the results from the eight corners of the unit cube,
-    // and then blend the results into a single returnable value
-    n000 = grad( mpRandomLUT[r00+z0], x  , y  , z   );
-    n001 = grad( mpRandomLUT[r00+z1], x  , y  , z-1 );
-    n010 = grad( mpRandomLUT[r01+z0], x  , y-1, z   );
-    n011 = grad( mpRandomLUT[r01+z1], x  , y-1, z-1 );
-    n100 = grad( mpRandomLUT[r10+z0], x-1, y  , z   );
-    n101 = grad( mpRandomLUT[r10+z1], x-1, y  , z-1 );
-    n110 = grad( mpRandomLUT[r11+z0], x-1, y-1, z   );
-    n111 = grad( mpRandomLUT[r11+z1], x-1, y-1, z-1 );
-
-    n00 = lerp( n000, n001, w );
-    n01 = lerp( n010, n011, w );
-    n10 = lerp( n100, n101, w );
-    n11 = lerp( n110, n111, w );
-
-    n0 = lerp( n00, n01, v );
-    n1 = lerp( n10, n11, v );
-
-    return lerp( n0, n1, u );
+    const unsigned char * p = mPermutation;
+    std::vector<LatticeSample> columns;
+
+    sampleColumns( columns, width, x, step, frequency );
+
+    for ( unsigned int row = 0; row < height; ++row )
+    {
+        const LatticeSample sy =
+            sampleLattice( ( y + static_cast<float>( row ) * step ) * frequency );
+
+        float * pRow = pOut + static_cast<size_t>( row ) * width;
+        unsigned int i = 0;
+
+#ifdef PERLIN_USE_SSE2
+        const __m128 y0 = _mm_set1_ps( sy.offset );
+        const __m128 y1 = _mm_set1_ps( sy.offset - 1.0f );
+        const __m128 v  = _mm_set1_ps( sy.weight );
+        const __m128 one = _mm_set1_ps( 1.0f );
+
+        for ( ; i + 4 <= width; i += 4 )
+        {
+            const LatticeSample * c = &columns[i];
+            unsigned int h00[4], h10[4], h01[4], h11[4];
+
+            for ( unsigned int lane = 0; lane < 4; ++lane )
+            {
+                const unsigned int a = p[c[lane].cell]     + sy.cell;
+                const unsigned int b = p[c[lane].cell + 1] + sy.cell;
+
+                h00[lane] = p[a];
+                h10[lane] = p[b];
+                h01[lane] = p[a + 1];
+                h11[lane] = p[b + 1];
+            }
+
+            const __m128 x0 = _mm_setr_ps( c[0].offset, c[1].offset,
+                                           c[2].offset, c[3].offset );
+            const __m128 u  = _mm_setr_ps( c[0].weight, c[1].weight,
+                                           c[2].weight, c[3].weight );
+            const __m128 x1 = _mm_sub_ps( x0, one );
+
+            const __m128 n00 = gradient2x4( h00, x0, y0 );
+            const __m128 n10 = gradient2x4( h10, x1, y0 );
+            const __m128 n01 = gradient2x4( h01, x0, y1 );
+            const __m128 n11 = gradient2x4( h11, x1, y1 );
+
+            const __m128 n = lerp4( lerp4( n00, n10, u ),
+                                    lerp4( n01, n11, u ),
+                                    v );
+
+            store4( pRow + i, n, amplitude, isFirstOctave );
+        }
+#endif
+
+        for ( ; i < width; ++i )
+        {
+            store( pRow + i, noise2( p, columns[i], sy ), amplitude, isFirstOctave );
+        }
+    }
 }
 
-float PerlinNoise::lerp( float a, float b, float t )
+/**
+ * Evaluates one octave of 3d noise over a grid, and either writes it to
+ * the output or adds it to what is already there. Works the same way as
+ * accumulate2, one row of the grid at a time
+ */
+void PerlinNoise::accumulate3( float * pOut,
+                               unsigned int width,
+                               unsigned int height,
+                               unsigned int depth,
+                               float x,
+                               float y,
+                               float z,
+                               float step,
+                               float frequency,
+                               float amplitude,
+                               bool isFirstOctave ) const
 {
-    return a + ( b - a ) * t;
+    const unsigned char * p = mPermutation;
+    std::vector<LatticeSample> columns;
+
+    sampleColumns( columns, width, x, step, frequency );
+
+    for ( unsigned int slice = 0; slice < depth; ++slice )
+    {
+        const LatticeSample sz =
+            sampleLattice( ( z + static_cast<float>( slice ) * step ) * frequency );
+
+        for ( unsigned int row = 0; row < height; ++row )
+        {
+            const LatticeSample sy =
+                sampleLattice( ( y + static_cast<float>( row ) * step ) * frequency );
+
+            float * pRow =
+                pOut + ( static_cast<size_t>( slice ) * height + row ) * width;
+            unsigned int i = 0;
+
+#ifdef PERLIN_USE_SSE2
+            const __m128 y0 = _mm_set1_ps( sy.offset );
+            const __m128 y1 = _mm_set1_ps( sy.offset - 1.0f );
+            const __m128 z0 = _mm_set1_ps( sz.offset );
+            const __m128 z1 = _mm_set1_ps( sz.offset - 1.0f );
+            const __m128 v  = _mm_set1_ps( sy.weight );
+            const __m128 w  = _mm_set1_ps( sz.weight );
+            const __m128 one = _mm_set1_ps( 1.0f );
+
+            for ( ; i + 4 <= width; i += 4 )
+            {
+                const LatticeSample * c = &columns[i];
+                unsigned int h000[4], h100[4], h010[4], h110[4];
+                unsigned int h001[4], h101[4], h011[4], h111[4];
+
+                for ( unsigned int lane = 0; lane < 4; ++lane )
+                {
+                    const unsigned int a  = p[c[lane].cell]     + sy.cell;
+                    const unsigned int b  = p[c[lane].cell + 1] + sy.cell;
+                    const unsigned int aa = p[a]     + sz.cell;
+                    const unsigned int ab = p[a + 1] + sz.cell;
+                    const unsigned int ba = p[b]     + sz.cell;
+                    const unsigned int bb = p[b + 1] + sz.cell;
+
+                    h000[lane] = p[aa];
+                    h100[lane] = p[ba];
+                    h010[lane] = p[ab];
+                    h110[lane] = p[bb];
+                    h001[lane] = p[aa + 1];
+                    h101[lane] = p[ba + 1];
+                    h011[lane] = p[ab + 1];
+                    h111[lane] = p[bb + 1];
+                }
+
+                const __m128 x0 = _mm_setr_ps( c[0].offset, c[1].offset,
+                                               c[2].offset, c[3].offset );
+                const __m128 u  = _mm_setr_ps( c[0].weight, c[1].weight,
+                                               c[2].weight, c[3].weight );
+                const __m128 x1 = _mm_sub_ps( x0, one );
+
+                const __m128 nx00 = lerp4( gradient3x4( h000, x0, y0, z0 ),
+                                           gradient3x4( h100, x1, y0, z0 ),
+                                           u );
+                const __m128 nx10 = lerp4( gradient3x4( h010, x0, y1, z0 ),
+                                           gradient3x4( h110, x1, y1, z0 ),
+                                           u );
+                const __m128 nx01 = lerp4( gradient3x4( h001, x0, y0, z1 ),
+                                           gradient3x4( h101, x1, y0, z1 ),
+                                           u );
+                const __m128 nx11 = lerp4( gradient3x4( h011, x0, y1, z1 ),
+                                           gradient3x4( h111, x1, y1, z1 ),
+                                           u );
+
+                const __m128 n = lerp4( lerp4( nx00, nx10, v ),
+                                        lerp4( nx01, nx11, v ),
+                                        w );
+
+                store4( pRow + i, n, amplitude, isFirstOctave );
+            }
+#endif
+
+            for ( ; i < width; ++i )
+            {
+                store( pRow + i,
+                       noise3( p, columns[i], sy, sz ),
+                       amplitude,
+                       isFirstOctave );
+            }
+        }
+    }
 }
 
+/**
+ * Shuffles the permutation table using the given seed. The shuffle only
+ * relies on the raw output of the mersenne twister (which the standard
+ * fully specifies) so that the same seed produces the same noise on every
+ * platform
+ */
 void PerlinNoise::init( unsigned int seed )
 {
-    boost::mt19937 rng( seed );
-    boost::uniform_smallint<> randomNumber( 0, 255 );
+    std::mt19937 rng( seed );
 
-    // Generate the look up table. Remember that the look up table contains
-    // 256 unique elements, but each element is duplicated (at pos i and
-    // i+256)
-    for ( unsigned int i = 0; i < RANDOM_LUT_SIZE / 2; ++i )
+    for ( unsigned int i = 0; i < PERMUTATION_SIZE; ++i )
     {
-        unsigned char val   = randomNumber( rng );
-        pRandomLUT[i + 0]   = val;
-        pRandomLUT[i + 256] = val;
+        mPermutation[i] = static_cast<unsigned char>( i );
     }
+
+    for ( unsigned int i = PERMUTATION_SIZE - 1; i > 0; --i )
+    {
+        unsigned int j = static_cast<unsigned int>( rng() % ( i + 1 ) );
+        std::swap( mPermutation[i], mPermutation[j] );
+    }
+
+    // Duplicate the table so lookups can be chained without wrapping
+    std::copy( mPermutation,
+               mPermutation + PERMUTATION_SIZE,
+               mPermutation + PERMUTATION_SIZE );
 }
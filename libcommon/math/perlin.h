@@ -16,42 +16,159 @@
 #ifndef SCOTT_MATH_PERLIN_H
 #define SCOTT_MATH_PERLIN_H
 
-#include <stdlib>
-
-class Random;
+#include <math/vector.h>
 
 /**
- * Random number generator using the mersenne twister algorithm for
- * generating random numbers. This implementation is heavily based on the
- * work of Michael Brundage (which was placed in the public domain).
+ * Seeded gradient noise generator, based on Ken Perlin's improved noise.
+ * Two instances created with the same seed will always generate the same
+ * values, on every platform.
+ *
+ * Noise values fall roughly in the range [-1, 1] and are zero at every
+ * integer lattice point. Besides sampling single points, the noise can
+ * be evaluated over an entire regularly spaced grid at once with fill()
+ * and fillFbm(), which is considerably faster than sampling each point in
+ * turn and produces the same values.
+ *
+ * Grids are stored x first, then y and then z, so that the sample at
+ * (x, y, z) is found at index ( z * height + y ) * width + x.
  */
 class PerlinNoise
 {
 public:
     PerlinNoise( unsigned int seed );
-    ~PerlinNoise();
 
-    float noise( float x ) const;
+    unsigned int seed() const;
+
+    /**
+     * Samples 2d noise at a single point
+     */
     float noise( float x, float y ) const;
+
+    /**
+     * Samples 3d noise at a single point
+     */
     float noise( float x, float y, float z ) const;
-    float noise3( const Vec3& pos ) const;
-    float noise3( float x, float y, float z ) const;
-    float noise3( float x,
+    float noise( const Vec3& pos ) const;
+
+    /**
+     * Samples fractal brownian motion at a single point. Each octave adds
+     * noise at a higher frequency and lower amplitude than the last one,
+     * and the sum is normalized back to the range of a single octave.
+     *
+     * \param  octaves     Number of noise layers to add together
+     * \param  lacunarity  Frequency multiplier between octaves
+     * \param  gain        Amplitude multiplier between octaves
+     */
+    float fbm( float x,
+               float y,
+               unsigned int octaves,
+               float lacunarity = 2.0f,
+               float gain = 0.5f ) const;
+
+    float fbm( float x,
+               float y,
+               float z,
+               unsigned int octaves,
+               float lacunarity = 2.0f,
+               float gain = 0.5f ) const;
+
+    /**
+     * Fills a width x height grid with 2d noise. The grid starts at (x, y)
+     * and its samples are spaced step apart. The result is the same as
+     * calling noise() for each sample.
+     *
+     * \param  pOut   Output buffer, with room for width * height values
+     * \param  width  Number of samples along x
+     * \param  height Number of samples along y
+     * \param  x      X coordinate of the first sample
+     * \param  y      Y coordinate of the first sample
+     * \param  step   Distance between neighbouring samples
+     */
+    void fill( float * pOut,
+               unsigned int width,
+               unsigned int height,
+               float x,
+               float y,
+               float step ) const;
+
+    /**
+     * Fills a width x height x depth grid with 3d noise, in the same way
+     * as the 2d fill
+     */
+    void fill( float * pOut,
+               unsigned int width,
+               unsigned int height,
+               unsigned int depth,
+               float x,
+               float y,
+               float z,
+               float step ) const;
+
+    /**
+     * Fills a 2d grid with fractal brownian motion. The result is the same
+     * as calling fbm() for each sample.
+     */
+    void fillFbm( float * pOut,
+                  unsigned int width,
+                  unsigned int height,
+                  float x,
+                  float y,
+                  float step,
+                  unsigned int octaves,
+                  float lacunarity = 2.0f,
+                  float gain = 0.5f ) const;
+
+    /**
+     * Fills a 3d grid with fractal brownian motion. The result is the same
+     * as calling fbm() for each sample.
+     */
+    void fillFbm( float * pOut,
+                  unsigned int width,
+                  unsigned int height,
+                  unsigned int depth,
+                  float x,
                   float y,
                   float z,
-                  int xWrap,
-                  int yWrap,
-                  int zWrap ) const;
+                  float step,
+                  unsigned int octaves,
+                  float lacunarity = 2.0f,
+                  float gain = 0.5f ) const;
 
 private:
     void init( unsigned int seed );
 
+    void accumulate2( float * pOut,
+                      unsigned int width,
+                      unsigned int height,
+                      float x,
+                      float y,
+                      float step,
+                      float frequency,
+                      float amplitude,
+                      bool isFirstOctave ) const;
+
+    void accumulate3( float * pOut,
+                      unsigned int width,
+                      unsigned int height,
+                      unsigned int depth,
+                      float x,
+                      float y,
+                      float z,
+                      float step,
+                      float frequency,
+                      float amplitude,
+                      bool isFirstOctave ) const;
+
 private:
-    /// Size of the random table
-    const unsigned int RANDOM_LUT_SIZE = 512;
+    /// Number of unique entries in the permutation table
+    static const unsigned int PERMUTATION_SIZE = 256;
+
+    /// Seed the permutation table was generated from
+    unsigned int mSeed;
 
-    /// Buffer of randomly generated values
-    unsigned char * mpRandomLUT;
+    /// Shuffled permutation of [0, 255], stored twice so that hashes can
+    /// be chained without having to wrap the index
+    unsigned char mPermutation[PERMUTATION_SIZE * 2];
 };
 
 #endif
@@ -0,0 +1,137 @@
+/**
+ * Unit tests for common/math/perlin
+ */
+#include <googletest/googletest.h>
+#include <math/perlin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+TEST(Math,Perlin_ZeroOnLatticePoints)
+{
+    PerlinNoise perlin( 42 );
+
+    EXPECT_FLOAT_EQ( 0.0f, perlin.noise( 0.0f, 0.0f ) );
+    EXPECT_FLOAT_EQ( 0.0f, perlin.noise( 3.0f, -7.0f ) );
+    EXPECT_FLOAT_EQ( 0.0f, perlin.noise( 5.0f, 2.0f, -1.0f ) );
+}
+
+TEST(Math,Perlin_SameSeedSameNoise)
+{
+    PerlinNoise a( 1234 ), b( 1234 ), c( 4321 );
+    bool isDifferent = false;
+
+    for ( int i = 0; i < 64; ++i )
+    {
+        const float t = static_cast<float>( i );
+        float x = 0.37f * t, y = -0.21f * t, z = 0.13f * t;
+
+        EXPECT_FLOAT_EQ( a.noise( x, y ), b.noise( x, y ) );
+        EXPECT_FLOAT_EQ( a.noise( x, y, z ), b.noise( x, y, z ) );
+
+        isDifferent = isDifferent ||
+                      std::fabs( a.noise( x, y, z ) - c.noise( x, y, z ) ) > 1e-4f;
+    }
+
+    EXPECT_EQ( 1234u, a.seed() );
+    EXPECT_TRUE( isDifferent );
+}
+
+TEST(Math,Perlin_RangeAndContinuity)
+{
+    PerlinNoise perlin( 7 );
+    float minValue = 0.0f, maxValue = 0.0f;
+
+    for ( int i = 0; i < 4096; ++i )
+    {
+        const float t = static_cast<float>( i );
+        float x = -20.0f + 0.0137f * t, y = 3.1f + 0.0071f * t;
+        float n = perlin.noise( x, y, 0.5f * y );
+
+        minValue = std::min( minValue, n );
+        maxValue = std::max( maxValue, n );
+
+        // Nearby samples only differ by a little
+        EXPECT_NEAR( n, perlin.noise( x + 0.001f, y, 0.5f * y ), 0.01f );
+    }
+
+    EXPECT_GE( minValue, -1.1f );
+    EXPECT_LE( maxValue,  1.1f );
+    EXPECT_LT( minValue, -0.3f );
+    EXPECT_GT( maxValue,  0.3f );
+}
+
+TEST(Math,Perlin_FbmIsNormalized)
+{
+    PerlinNoise perlin( 99 );
+
+    EXPECT_FLOAT_EQ( perlin.noise( 1.3f, 2.7f ), perlin.fbm( 1.3f, 2.7f, 1 ) );
+    EXPECT_FLOAT_EQ( 0.0f, perlin.fbm( 1.3f, 2.7f, 0 ) );
+
+    for ( int i = 0; i < 256; ++i )
+    {
+        const float t = static_cast<float>( i );
+        float n = perlin.fbm( 0.11f * t, 0.07f * t, 0.05f * t, 5 );
+
+        EXPECT_GE( n, -1.1f );
+        EXPECT_LE( n,  1.1f );
+    }
+}
+
+TEST(Math,Perlin_Fill2dMatchesPointSamples)
+{
+    PerlinNoise perlin( 5 );
+
+    // Odd width to cover the columns left over after the SIMD lanes
+    const unsigned int W = 35, H = 32;
+    const float X = -3.25f, Y = 10.5f, STEP = 1.0f / 16.0f;
+
+    std::vector<float> grid( W * H ), fbm( W * H );
+
+    perlin.fill( &grid[0], W, H, X, Y, STEP );
+    perlin.fillFbm( &fbm[0], W, H, X, Y, STEP, 4 );
+
+    for ( unsigned int y = 0; y < H; ++y )
+    {
+        for ( unsigned int x = 0; x < W; ++x )
+        {
+            float px = X + static_cast<float>( x ) * STEP;
+            float py = Y + static_cast<float>( y ) * STEP;
+
+            ASSERT_FLOAT_EQ( perlin.noise( px, py ), grid[y * W + x] );
+            ASSERT_FLOAT_EQ( perlin.fbm( px, py, 4 ), fbm[y * W + x] );
+        }
+    }
+}
+
+TEST(Math,Perlin_Fill3dMatchesPointSamples)
+{
+    PerlinNoise perlin( 6 );
+
+    const unsigned int W = 32, H = 6, D = 5;
+    const float X = 100.0f, Y = -0.75f, Z = 2.0f, STEP = 0.1f;
+
+    std::vector<float> grid( W * H * D ), fbm( W * H * D );
+
+    perlin.fill( &grid[0], W, H, D, X, Y, Z, STEP );
+    perlin.fillFbm( &fbm[0], W, H, D, X, Y, Z, STEP, 3, 2.5f, 0.4f );
+
+    for ( unsigned int z = 0; z < D; ++z )
+    {
+        for ( unsigned int y = 0; y < H; ++y )
+        {
+            for ( unsigned int x = 0; x < W; ++x )
+            {
+                float px = X + static_cast<float>( x ) * STEP;
+                float py = Y + static_cast<float>( y ) * STEP;
+                float pz = Z + static_cast<float>( z ) * STEP;
+                size_t index = ( z * H + y ) * W + x;
+
+                ASSERT_FLOAT_EQ( perlin.noise( px, py, pz ), grid[index] );
+                ASSERT_FLOAT_EQ( perlin.fbm( px, py, pz, 3, 2.5f, 0.4f ),
+                                 fbm[index] );
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_BITS_H
+#define SCOTT_CUBEWORLD_BITS_H
+
+#include <stdint.h>
+#include <cassert>
+
+#ifdef _MSC_VER
+#   include <intrin.h>
+#endif
+
+/**
+ * Bit twiddling helpers used by code that works on cube occupancy masks
+ */
+namespace Bits
+{
+    /**
+     * Returns the index of the lowest set bit. The value must not be zero.
+     */
+    inline unsigned int countTrailingZeros( uint64_t value )
+    {
+        assert( value != 0 );
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanForward64( &index, value );
+        return static_cast<unsigned int>( index );
+#else
+        return static_cast<unsigned int>( __builtin_ctzll( value ) );
+#endif
+    }
+
+    /**
+     * Returns the number of set bits
+     */
+    inline unsigned int popCount( uint64_t value )
+    {
+#ifdef _MSC_VER
+        return static_cast<unsigned int>( __popcnt64( value ) );
+#else
+        return static_cast<unsigned int>( __builtin_popcountll( value ) );
+#endif
+    }
+
+    /**
+     * Returns a mask with bits [first, first + count) set. Count may be 64.
+     */
+    inline uint64_t rangeMask( unsigned int first, unsigned int count )
+    {
+        assert( first + count <= 64 );
+
+        if ( count == 0 )
+        {
+            return 0;
+        }
+
+        return ( ~uint64_t( 0 ) >> ( 64 - count ) ) << first;
+    }
+}
+
+#endif
@@ -41,6 +41,19 @@ Camera::Camera( const Camera& cam )
 {
 }
 
+Camera& Camera::operator = ( const Camera& rhs )
+{
+    mCenter       = rhs.mCenter;
+    mDirection    = rhs.mDirection;
+    mUp           = rhs.mUp;
+    mRight        = rhs.mRight;
+    mRotation     = rhs.mRotation;
+    mViewDistance = rhs.mViewDistance;
+    mBaseSpeed    = rhs.mBaseSpeed;
+
+    return *this;
+}
+
 void Camera::reset()
 {
     resetTo( Vec3( DefaultCameraCenter ) );
@@ -1,4 +1,4 @@
-#ifndef SCOTT_ROGEULIKE_CAMERA_H
+#ifndef SCOTT_ROGUELIKE_CAMERA_H
 #define SCOTT_ROGUELIKE_CAMERA_H
 
 #include "math/vector.h"
@@ -10,6 +10,8 @@ public:
     Camera( const Vec3& center );
     Camera( const Camera& camera );
 
+    Camera& operator = ( const Camera& rhs );
+
     /**
      * Resets the camera to its starting position (usually world center)
      */
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CUBE_FACE_H
+#define SCOTT_CUBEWORLD_CUBE_FACE_H
+
+/**
+ * The six faces of a cube (or chunk), in game space. The ordering matches
+ * the [+x,-x,+y,-y,+z,-z] ordering used by the renderer's cube tables, and
+ * each positive face is immediately followed by its opposite.
+ */
+enum ECubeFace
+{
+    ECUBEFACE_POS_X,        // right
+    ECUBEFACE_NEG_X,        // left
+    ECUBEFACE_POS_Y,        // back
+    ECUBEFACE_NEG_Y,        // front
+    ECUBEFACE_POS_Z,        // top
+    ECUBEFACE_NEG_Z,        // bottom
+    ECUBEFACE_COUNT
+};
+
+namespace CubeFace
+{
+    /**
+     * Returns the face on the other side of the cube
+     */
+    inline ECubeFace opposite( ECubeFace face )
+    {
+        return static_cast<ECubeFace>( face ^ 1 );
+    }
+
+    /**
+     * Returns the axis (0 = x, 1 = y, 2 = z) that the face is perpendicular to
+     */
+    inline int axis( ECubeFace face )
+    {
+        return face / 2;
+    }
+
+    /**
+     * Returns +1 if the face points along the positive axis, -1 otherwise
+     */
+    inline int direction( ECubeFace face )
+    {
+        return ( face & 1 ) ? -1 : 1;
+    }
+}
+
+#endif
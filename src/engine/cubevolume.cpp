@@ -0,0 +1,71 @@
+#include "engine/cubevolume.h"
+#include "engine/point.h"
+#include "math/vector.h"
+
+#include <cassert>
+#include <cmath>
+
+BoxVolume::BoxVolume( const Point& min, const Point& max )
+    : mMin( min ),
+      mMax( max )
+{
+    assert( min.x <= max.x && min.y <= max.y && min.z <= max.z );
+}
+
+void BoxVolume::bounds( Point& min, Point& max ) const
+{
+    min = mMin;
+    max = mMax;
+}
+
+bool BoxVolume::rowExtent( int y, int z, int& xMin, int& xMax ) const
+{
+    xMin = mMin.x;
+    xMax = mMax.x;
+
+    return y >= mMin.y && y < mMax.y &&
+           z >= mMin.z && z < mMax.z &&
+           xMin < xMax;
+}
+
+SphereVolume::SphereVolume( const Vec3& center, float radius )
+    : mCenter( center ),
+      mRadius( radius )
+{
+    assert( radius >= 0.0f );
+}
+
+void SphereVolume::bounds( Point& min, Point& max ) const
+{
+    min = Point( static_cast<int>( std::floor( mCenter.x() - mRadius ) ),
+                 static_cast<int>( std::floor( mCenter.y() - mRadius ) ),
+                 static_cast<int>( std::floor( mCenter.z() - mRadius ) ) );
+
+    max = Point( static_cast<int>( std::ceil( mCenter.x() + mRadius ) ) + 1,
+                 static_cast<int>( std::ceil( mCenter.y() + mRadius ) ) + 1,
+                 static_cast<int>( std::ceil( mCenter.z() + mRadius ) ) + 1 );
+}
+
+/**
+ * A cube is inside the sphere when its center is, so for a given row the
+ * inside cubes are those whose center x lies within the circle formed by
+ * slicing the sphere at the row's y and z.
+ */
+bool SphereVolume::rowExtent( int y, int z, int& xMin, int& xMax ) const
+{
+    float dy = ( y + 0.5f ) - mCenter.y();
+    float dz = ( z + 0.5f ) - mCenter.z();
+    float remaining = mRadius * mRadius - dy * dy - dz * dz;
+
+    if ( remaining < 0.0f )
+    {
+        return false;
+    }
+
+    float halfWidth = std::sqrt( remaining );
+
+    xMin = static_cast<int>( std::ceil(  mCenter.x() - halfWidth - 0.5f ) );
+    xMax = static_cast<int>( std::floor( mCenter.x() + halfWidth - 0.5f ) ) + 1;
+
+    return xMin < xMax;
+}
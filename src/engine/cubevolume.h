@@ -0,0 +1,73 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CUBE_VOLUME_H
+#define SCOTT_CUBEWORLD_CUBE_VOLUME_H
+
+#include "engine/point.h"
+#include "math/vector.h"
+
+/**
+ * A region of space made up of whole cubes, used for bulk world queries.
+ * A volume is described one row of cubes (along the x axis) at a time, which
+ * lets queries clip it against chunks and walk it as contiguous spans.
+ */
+class CubeVolume
+{
+public:
+    virtual ~CubeVolume() { }
+
+    // Smallest box containing the volume. min is inclusive, max exclusive
+    virtual void bounds( Point& min, Point& max ) const = 0;
+
+    // Find the cubes [xMin, xMax) in row (y, z) that lie inside the volume.
+    // Returns false if no cubes in the row are in the volume
+    virtual bool rowExtent( int y, int z, int& xMin, int& xMax ) const = 0;
+};
+
+/**
+ * Axis aligned box of cubes
+ */
+class BoxVolume : public CubeVolume
+{
+public:
+    // Box from min (inclusive) to max (exclusive)
+    BoxVolume( const Point& min, const Point& max );
+
+    virtual void bounds( Point& min, Point& max ) const;
+    virtual bool rowExtent( int y, int z, int& xMin, int& xMax ) const;
+
+private:
+    Point mMin;
+    Point mMax;
+};
+
+/**
+ * Every cube whose center lies within a sphere
+ */
+class SphereVolume : public CubeVolume
+{
+public:
+    SphereVolume( const Vec3& center, float radius );
+
+    virtual void bounds( Point& min, Point& max ) const;
+    virtual bool rowExtent( int y, int z, int& xMin, int& xMax ) const;
+
+private:
+    Vec3 mCenter;
+    float mRadius;
+};
+
+#endif
@@ -1,29 +1,46 @@
 #include "engine/material.h"
 #include "common/assert.h"
 #include <string>
+#include <cassert>
 
 namespace Util
 {
 
-std::string ToString( EMaterialType mat )
+namespace
 {
-    static const std::string NAMES[ EMATERIAL_COUNT ] =
+    const MaterialProperties MATERIALS[ EMATERIAL_COUNT ] =
     {
-        "EMPTY",            // EMATERIAL_EMPTY,
-        "GRASS",            // EMATERIAL_GRASS,
-        "DIRT",             // EMATERIAL_DIRT,
-        "ROCK",             // EMATERIAL_ROCK,
-        "ORE",              // EMATERIAL_ORE,
-        "WATER",            // EMATERIAL_WATER,
-        "LAVA",             // EMATERIAL_LAVA,
-        "SAND",             // EMATERIAL_SAND,
-        "WOOD",             // EMATERIAL_WOOD,
-        "TREE",             // EMATERIAL_TREE,
-        "LEAF",             // EMATERIAL_LEAF,
+        // name             translucent
+        { "EMPTY",          false },    // EMATERIAL_EMPTY
+        { "BEDROCK",        false },    // EMATERIAL_BEDROCK
+        { "GRASS",          false },    // EMATERIAL_GRASS
+        { "DIRT",           false },    // EMATERIAL_DIRT
+        { "ROCK",           false },    // EMATERIAL_ROCK
+        { "ORE",            false },    // EMATERIAL_ORE
+        { "WATER",          true  },    // EMATERIAL_WATER
+        { "LAVA",           false },    // EMATERIAL_LAVA
+        { "SAND",           false },    // EMATERIAL_SAND
+        { "WOOD",           false },    // EMATERIAL_WOOD
+        { "TREE",           false },    // EMATERIAL_TREE
+        { "LEAF",           true  }     // EMATERIAL_LEAF
     };
+}
+
+std::string ToString( EMaterialType mat )
+{
+    return GetMaterialProperties( mat ).name;
+}
 
+const MaterialProperties& GetMaterialProperties( EMaterialType mat )
+{
+    assert( mat < EMATERIAL_COUNT );
+    return MATERIALS[mat];
+}
+
+bool IsTranslucent( EMaterialType mat )
+{
     assert( mat < EMATERIAL_COUNT );
-    return NAMES[mat];
+    return MATERIALS[mat].isTranslucent;
 }
 
 }
@@ -24,9 +24,24 @@ enum EMaterialType
     EMATERIAL_COUNT
 };
 
+/**
+ * Properties shared by every cube made of a material
+ */
+struct MaterialProperties
+{
+    const char * name;
+    bool isTranslucent;     // Cubes behind it show through, drawn last
+};
+
 namespace Util
 {
     std::string ToString( EMaterialType mat );
+
+    // Look up a material in the material property table
+    const MaterialProperties& GetMaterialProperties( EMaterialType mat );
+
+    // Check if cubes of this material can be seen through
+    bool IsTranslucent( EMaterialType mat );
 }
 
 #endif
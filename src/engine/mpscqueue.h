@@ -0,0 +1,116 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_MPSC_QUEUE_H
+#define SCOTT_CUBEWORLD_MPSC_QUEUE_H
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * Unbounded lock-free queue that any number of threads can push onto, but
+ * only a single thread may pop from. Pushing never blocks or spins: the new
+ * node is swapped in as the head and then linked to the previous head.
+ *
+ * The consumer always owns one "stub" node at the tail, whose value has
+ * already been handed out (or is the default value for the very first stub).
+ * This means T must be default constructible.
+ */
+template<typename T>
+class MpscQueue : boost::noncopyable
+{
+public:
+    MpscQueue()
+        : mHead( NULL ),
+          mpTail( new Node() )
+    {
+        mHead.store( mpTail, std::memory_order_relaxed );
+    }
+
+    ~MpscQueue()
+    {
+        T value;
+
+        while ( pop( value ) )
+        {
+        }
+
+        delete mpTail;
+    }
+
+    /**
+     * Adds a value to the queue. Safe to call from any thread
+     */
+    void push( T value )
+    {
+        Node * pNode = new Node( std::move( value ) );
+        Node * pPrev = mHead.exchange( pNode, std::memory_order_acq_rel );
+
+        // Until this store the consumer sees the queue as ending at pPrev,
+        // which is fine, it'll pick the node up on a later pop
+        pPrev->next.store( pNode, std::memory_order_release );
+    }
+
+    /**
+     * Removes the oldest value in the queue. Only one thread may call this.
+     *
+     * \param  value  Receives the removed value
+     * \return True if a value was removed, false if the queue was empty
+     */
+    bool pop( T& value )
+    {
+        Node * pNext = mpTail->next.load( std::memory_order_acquire );
+
+        if ( pNext == NULL )
+        {
+            return false;
+        }
+
+        // The next node becomes the new stub once its value is taken
+        value = std::move( pNext->value );
+        pNext->value = T();
+
+        delete mpTail;
+        mpTail = pNext;
+
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        Node()
+            : next( NULL ),
+              value()
+        {
+        }
+
+        explicit Node( T&& v )
+            : next( NULL ),
+              value( std::move( v ) )
+        {
+        }
+
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    std::atomic<Node*> mHead;   // Most recently pushed node (producers)
+    Node * mpTail;              // Stub node before the oldest value (consumer)
+};
+
+#endif
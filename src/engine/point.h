@@ -108,7 +108,7 @@ public:
         return ( x == 0 && y == 0 && z == 0 );
     }
 
-protected:
+public:
     union 
     {
         struct { int x; int y; int z; };
@@ -18,10 +18,13 @@ World::World( unsigned int cols,
               unsigned int depth,
               WorldView * pView )
     : mpView( pView ),
-      mChunks( rows * cols * depth, 0 ),
+      mChunks(),
       mCols( cols ),
       mRows( rows ),
-      mDepth( depth )
+      mDepth( depth ),
+      mChunkCols( cols / Constants::CHUNK_COLS ),
+      mChunkRows( rows / Constants::CHUNK_ROWS ),
+      mChunkDepth( depth / Constants::CHUNK_DEPTH )
 {
     // Sanity - make sure they are correct multiples
     assert( rows  % Constants::CHUNK_ROWS  == 0 );
@@ -29,6 +32,12 @@ World::World( unsigned int cols,
     assert( depth % Constants::CHUNK_DEPTH == 0 );
 
     assert( pView != NULL );
+
+    // One slot per chunk, chunks are only instantiated when first touched
+    mChunks.resize( mChunkCols * mChunkRows * mChunkDepth, NULL );
+
+    // Let the view know what it is looking at
+    mpView->setWorld( this );
 }
 
 /**
@@ -40,7 +49,7 @@ World::~World()
     delete mpView;
 
     // Clean up teh world
-    for ( unsigned int i = 0; i < mRows * mCols * mDepth; ++i )
+    for ( size_t i = 0; i < mChunks.size(); ++i )
     {
         delete mChunks[i];
     }
@@ -63,6 +72,152 @@ void World::put( const CubeData& cube, const Point& pos, bool createIfNull )
 
     // Inform the view that the chunk has (potentially) changed
     mpView->chunkUpdated( pos, pChunk );
+    notifyNeighborsOfEdit( pos, cubeRelPos );
+}
+
+/**
+ * Replaces all of the cubes in a chunk with a single bulk copy, creating
+ * the chunk if it doesn't exist yet. This is how world generators should
+ * write out the chunks they build, rather than placing each cube with put.
+ *
+ * Generators that write chunks from several threads skip notifying the
+ * view, which leaves the chunk's neighbors and the view untouched, and call
+ * rebuildView once every chunk has been written.
+ *
+ * \param  chunkCoord       Chunk grid position of the chunk to replace
+ * \param  pCubes           The chunk's new cubes, laid out like
+ *                          WorldChunk::cubes
+ * \param  isNotifyingView  Queue the chunk and its neighbors for rebuilding
+ */
+void World::putChunk( const Point& chunkCoord,
+                      const CubeData * pCubes,
+                      bool isNotifyingView )
+{
+    const Point origin( chunkCoord.x * Constants::CHUNK_COLS,
+                        chunkCoord.y * Constants::CHUNK_ROWS,
+                        chunkCoord.z * Constants::CHUNK_DEPTH );
+
+    WorldChunk * pChunk = getChunkForPos( origin, true );
+    pChunk->putAllCubes( pCubes );
+
+    if (! isNotifyingView )
+    {
+        return;
+    }
+
+    mpView->chunkReplaced( origin, pChunk );
+
+    // Every face of the chunk may have changed, so neighbors on all sides
+    // need to rebuild the faces that touch it
+    for ( int face = 0; face < ECUBEFACE_COUNT; ++face )
+    {
+        const ECubeFace cubeFace = static_cast<ECubeFace>( face );
+        const int axis           = CubeFace::axis( cubeFace );
+        Point neighbor           = chunkCoord;
+
+        neighbor[axis] += CubeFace::direction( cubeFace );
+
+        if ( neighbor.x < 0 || neighbor.x >= (int) mChunkCols ||
+             neighbor.y < 0 || neighbor.y >= (int) mChunkRows ||
+             neighbor.z < 0 || neighbor.z >= (int) mChunkDepth )
+        {
+            continue;
+        }
+
+        WorldChunk * pNeighbor = chunkAt( neighbor );
+
+        if ( pNeighbor == NULL )
+        {
+            continue;
+        }
+
+        // Neighbors along z only touch us with one of their sections, the
+        // others touch us with every section
+        if ( axis == 2 )
+        {
+            Point touching = origin;
+            touching.z    += ( CubeFace::direction( cubeFace ) > 0 ?
+                               static_cast<int>( Constants::CHUNK_DEPTH ) : -1 );
+
+            mpView->chunkUpdated( touching, pNeighbor );
+        }
+        else
+        {
+            mpView->chunkReplaced( Point( neighbor.x * Constants::CHUNK_COLS,
+                                          neighbor.y * Constants::CHUNK_ROWS,
+                                          neighbor.z * Constants::CHUNK_DEPTH ),
+                                   pNeighbor );
+        }
+    }
+}
+
+/**
+ * Queues every chunk that has been created to have all of its sections
+ * rebuilt by the view
+ */
+void World::rebuildView()
+{
+    for ( unsigned int z = 0; z < mChunkDepth; ++z )
+    {
+        for ( unsigned int y = 0; y < mChunkRows; ++y )
+        {
+            for ( unsigned int x = 0; x < mChunkCols; ++x )
+            {
+                WorldChunk * pChunk = chunkAt( Point( x, y, z ) );
+
+                if ( pChunk != NULL )
+                {
+                    mpView->chunkReplaced( Point( x * Constants::CHUNK_COLS,
+                                                  y * Constants::CHUNK_ROWS,
+                                                  z * Constants::CHUNK_DEPTH ),
+                                           pChunk );
+                }
+            }
+        }
+    }
+}
+
+/**
+ * A cube on the edge of a chunk decides whether the neighboring chunk's
+ * touching face is visible, so the neighbor needs to be rebuilt as well.
+ *
+ * \param  pos     World position of the cube that was changed
+ * \param  relPos  Position of the cube relative to its chunk
+ */
+void World::notifyNeighborsOfEdit( const Point& pos, const Point& relPos )
+{
+    const int size[3]   = { static_cast<int>( Constants::CHUNK_COLS ),
+                            static_cast<int>( Constants::CHUNK_ROWS ),
+                            static_cast<int>( Constants::CHUNK_DEPTH ) };
+    const int extent[3] = { static_cast<int>( mCols ),
+                            static_cast<int>( mRows ),
+                            static_cast<int>( mDepth ) };
+
+    for ( int axis = 0; axis < 3; ++axis )
+    {
+        Point neighborPos = pos;
+
+        if ( relPos[axis] == 0 && pos[axis] > 0 )
+        {
+            neighborPos[axis] -= 1;
+        }
+        else if ( relPos[axis] == size[axis] - 1 && pos[axis] + 1 < extent[axis] )
+        {
+            neighborPos[axis] += 1;
+        }
+        else
+        {
+            continue;
+        }
+
+        // Neighbors that don't exist yet will be built when created
+        WorldChunk * pNeighbor = getChunkForPos( neighborPos, false );
+
+        if ( pNeighbor != NULL )
+        {
+            mpView->chunkUpdated( neighborPos, pNeighbor );
+        }
+    }
 }
 
 /**
@@ -145,6 +300,52 @@ unsigned int World::cubeCount() const
     return count;
 }
 
+/**
+ * Returns the chunk at the requested chunk grid coordinate, or NULL if that
+ * chunk has not been instantiated yet.
+ *
+ * \param  chunkCoord  Chunk grid position (cube position / chunk size)
+ */
+const WorldChunk* World::chunkAt( const Point& chunkCoord ) const
+{
+    assert( chunkCoord.x >= 0 && chunkCoord.x < (int) mChunkCols );
+    assert( chunkCoord.y >= 0 && chunkCoord.y < (int) mChunkRows );
+    assert( chunkCoord.z >= 0 && chunkCoord.z < (int) mChunkDepth );
+
+    return mChunks[ ( chunkCoord.z * mChunkRows + chunkCoord.y ) * mChunkCols +
+                    chunkCoord.x ];
+}
+
+WorldChunk* World::chunkAt( const Point& chunkCoord )
+{
+    assert( chunkCoord.x >= 0 && chunkCoord.x < (int) mChunkCols );
+    assert( chunkCoord.y >= 0 && chunkCoord.y < (int) mChunkRows );
+    assert( chunkCoord.z >= 0 && chunkCoord.z < (int) mChunkDepth );
+
+    return mChunks[ ( chunkCoord.z * mChunkRows + chunkCoord.y ) * mChunkCols +
+                    chunkCoord.x ];
+}
+
+/**
+ * Returns the chunk on the other side of a chunk's face, or NULL if that
+ * chunk has not been created or lies outside of the world.
+ */
+const WorldChunk* World::neighborOf( const Point& chunkCoord,
+                                     ECubeFace face ) const
+{
+    Point neighbor = chunkCoord;
+    neighbor[ CubeFace::axis( face ) ] += CubeFace::direction( face );
+
+    if ( neighbor.x < 0 || neighbor.x >= (int) mChunkCols ||
+         neighbor.y < 0 || neighbor.y >= (int) mChunkRows ||
+         neighbor.z < 0 || neighbor.z >= (int) mChunkDepth )
+    {
+        return NULL;
+    }
+
+    return chunkAt( neighbor );
+}
+
 CubeIntersection World::firstCubeIntersecting( const Vec3& origin,
                                                const Vec3& dir )
 {
@@ -163,7 +364,7 @@ Point World::makeRelativeToChunk( const Point& pos ) const
 {
     return Point( pos.x % Constants::CHUNK_COLS,
                   pos.y % Constants::CHUNK_ROWS,
-                  pos.z & Constants::CHUNK_DEPTH );
+                  pos.z % Constants::CHUNK_DEPTH );
 }
 
 /**
@@ -200,7 +401,7 @@ unsigned int World::getIndexForChunk( const Point& pos ) const
     unsigned int y = pos.y / Constants::CHUNK_ROWS;
     unsigned int z = pos.z / Constants::CHUNK_DEPTH;
 
-    return ( z * Constants::CHUNK_COLS * Constants::CHUNK_ROWS ) +
-           ( y * Constants::CHUNK_COLS + x );
+    assert( x < mChunkCols && y < mChunkRows && z < mChunkDepth );
+    return ( z * mChunkRows + y ) * mChunkCols + x;
 }
 
@@ -4,6 +4,7 @@
 #include "engine/point.h"
 #include "math/vector.h"
 #include "engine/cubeintersection.h"
+#include "engine/cubeface.h"
 #include <vector>
 
 class WorldView;
@@ -27,6 +28,16 @@ public:
               const Point& position,
               bool createIfNull=true);
 
+    // Replace every cube in a chunk at once, creating the chunk if needed.
+    // Without notifying the view, only the chunk itself is touched and
+    // different chunks can be written from different threads at once
+    void putChunk( const Point& chunkCoord,
+                   const CubeData * pCubes,
+                   bool isNotifyingView=true );
+
+    // Queue every created chunk to have its view rebuilt
+    void rebuildView();
+
     // Retrieve a cube
     CubeData at( const Point& position,
                  bool createIfNull=true );
@@ -51,12 +62,24 @@ public:
     // Finds the number of non-empty cubes
     unsigned int cubeCount() const;
 
+    // Retrieve a chunk by its chunk grid coordinates (may be NULL)
+    const WorldChunk* chunkAt( const Point& chunkCoord ) const;
+    WorldChunk* chunkAt( const Point& chunkCoord );
+
+    // Retrieve the chunk touching the given face of a chunk (may be NULL)
+    const WorldChunk* neighborOf( const Point& chunkCoord, ECubeFace face ) const;
+
+    unsigned int chunkCols() const  { return mChunkCols; }
+    unsigned int chunkRows() const  { return mChunkRows; }
+    unsigned int chunkDepth() const { return mChunkDepth; }
+
 protected:
     WorldChunk* getChunkForPos( const Point& pos,
                                 bool createIfNull=true);
     const WorldChunk* getChunkForPos( const Point& pos ) const;
 
     Point makeRelativeToChunk( const Point& pos ) const;
+    void notifyNeighborsOfEdit( const Point& pos, const Point& relPos );
     inline unsigned int getIndexForChunk( const Point& pos ) const;
 
 protected:
@@ -65,6 +88,9 @@ protected:
     unsigned int mCols;     // x
     unsigned int mRows;     // y
     unsigned int mDepth;    // z
+    unsigned int mChunkCols;
+    unsigned int mChunkRows;
+    unsigned int mChunkDepth;
 };
 
 #endif
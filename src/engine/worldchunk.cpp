@@ -1,6 +1,9 @@
 #include "engine/worldchunk.h"
 #include "engine/constants.h"
 #include "engine/point.h"
+#include "engine/material.h"
+#include <algorithm>
+#include <cassert>
 #include <vector>
 #include <limits>
 #include <iostream>
@@ -10,39 +13,190 @@ const unsigned int WorldChunk::TOTAL_ROWS  = Constants::CHUNK_ROWS;
 const unsigned int WorldChunk::TOTAL_DEPTH = Constants::CHUNK_DEPTH;
 const unsigned int WorldChunk::TOTAL_CUBES = Constants::CHUNK_CUBES;
 
+const unsigned int WorldChunk::SECTION_DEPTH = 8;
+const unsigned int WorldChunk::SECTION_COUNT =
+    Constants::CHUNK_DEPTH / WorldChunk::SECTION_DEPTH;
+const uint32_t WorldChunk::ALL_SECTIONS =
+    ( 1u << WorldChunk::SECTION_COUNT ) - 1u;
+
 WorldChunk::WorldChunk()
-    : mCubes( TOTAL_CUBES ),
-      mIsRebuildingView( false )
+    : mpCubes( new std::vector<CubeData>( TOTAL_CUBES ) ),
+      mIsSharingCubes( false ),
+      mOccupancy( TOTAL_ROWS * TOTAL_DEPTH, 0 ),
+      mOpaqueOccupancy( TOTAL_ROWS * TOTAL_DEPTH, 0 ),
+      mIsRebuildingView( false ),
+      mDirtySections( 0 )
 {
+    // Occupancy rows are packed into 32 bit masks, and sections must tile
+    // the chunk exactly
+    assert( TOTAL_COLS <= 32 );
+    assert( TOTAL_DEPTH % SECTION_DEPTH == 0 && SECTION_COUNT < 32 );
+
+    std::fill( mMaterialCounts, mMaterialCounts + EMATERIAL_COUNT, 0 );
+    mMaterialCounts[EMATERIAL_EMPTY] = TOTAL_CUBES;
+}
+
+/**
+ * Copy constructor. The copy shares the cube array with the original, and
+ * both of them will take a private array before changing any cubes
+ */
+WorldChunk::WorldChunk( const WorldChunk& chunk )
+    : mpCubes( chunk.mpCubes ),
+      mIsSharingCubes( true ),
+      mOccupancy( chunk.mOccupancy ),
+      mOpaqueOccupancy( chunk.mOpaqueOccupancy ),
+      mIsRebuildingView( chunk.mIsRebuildingView ),
+      mDirtySections( chunk.mDirtySections )
+{
+    std::copy( chunk.mMaterialCounts,
+               chunk.mMaterialCounts + EMATERIAL_COUNT,
+               mMaterialCounts );
+
+    chunk.mIsSharingCubes = true;
 }
 
 WorldChunk::~WorldChunk()
 {
 }
 
+WorldChunk& WorldChunk::operator = ( const WorldChunk& rhs )
+{
+    if ( this != &rhs )
+    {
+        mpCubes          = rhs.mpCubes;
+        mIsSharingCubes  = true;
+        mOccupancy       = rhs.mOccupancy;
+        mOpaqueOccupancy = rhs.mOpaqueOccupancy;
+        mIsRebuildingView = rhs.mIsRebuildingView;
+        mDirtySections   = rhs.mDirtySections;
+
+        std::copy( rhs.mMaterialCounts,
+                   rhs.mMaterialCounts + EMATERIAL_COUNT,
+                   mMaterialCounts );
+
+        rhs.mIsSharingCubes = true;
+    }
+
+    return *this;
+}
+
 void WorldChunk::put( const CubeData& cube, const Point& pos )
 {
     // Find the location of the cube...
     unsigned int index = findCubeOffset( pos );
+    detachCubes();
+
+    std::vector<CubeData>& cubes = *mpCubes;
+
+    // Keep the material counts and occupancy masks in sync
+    mMaterialCounts[ cubes[index].materialType() ]--;
+    mMaterialCounts[ cube.materialType() ]++;
+
+    uint32_t& row    = mOccupancy[ index / TOTAL_COLS ];
+    uint32_t& opaque = mOpaqueOccupancy[ index / TOTAL_COLS ];
+    uint32_t bit     = 1u << ( index % TOTAL_COLS );
+
+    const bool isOpaque = !cube.isEmpty() &&
+                          !Util::IsTranslucent( cube.materialType() );
+
+    row    = cube.isEmpty() ? ( row & ~bit )    : ( row | bit );
+    opaque = isOpaque       ? ( opaque | bit )  : ( opaque & ~bit );
 
     // .. and assign it! So simple
-    mCubes[index] = cube;
+    cubes[index] = cube;
+}
+
+/**
+ * Replaces all of the chunk's cubes with a single copy, rebuilding the
+ * occupancy masks and material counts in one pass over the new cubes. This
+ * is a lot cheaper than calling put for every cube when a whole chunk is
+ * being generated.
+ *
+ * \param  pCubes  TOTAL_CUBES cubes, x varying fastest then y and then z
+ */
+void WorldChunk::putAllCubes( const CubeData * pCubes )
+{
+    // Anybody sharing the old cubes keeps them, there's no need to copy
+    // them only to overwrite the copy
+    if ( mIsSharingCubes )
+    {
+        mpCubes.reset( new std::vector<CubeData>( pCubes,
+                                                  pCubes + TOTAL_CUBES ) );
+        mIsSharingCubes = false;
+    }
+    else
+    {
+        std::copy( pCubes, pCubes + TOTAL_CUBES, mpCubes->begin() );
+    }
+
+    std::fill( mMaterialCounts, mMaterialCounts + EMATERIAL_COUNT, 0 );
+
+    for ( unsigned int row = 0; row < TOTAL_ROWS * TOTAL_DEPTH; ++row )
+    {
+        const CubeData * pRow = pCubes + row * TOTAL_COLS;
+        uint32_t occupied = 0, opaque = 0;
+
+        for ( unsigned int x = 0; x < TOTAL_COLS; ++x )
+        {
+            const EMaterialType material = pRow[x].materialType();
+            mMaterialCounts[material]++;
+
+            if ( material != EMATERIAL_EMPTY )
+            {
+                occupied |= 1u << x;
+
+                if (! Util::IsTranslucent( material ) )
+                {
+                    opaque |= 1u << x;
+                }
+            }
+        }
+
+        mOccupancy[row]       = occupied;
+        mOpaqueOccupancy[row] = opaque;
+    }
+}
+
+/**
+ * Gives this chunk its own copy of the cube array if it has been shared
+ * with a copy since the last time it did so. The copy may still be read on
+ * another thread, so the shared array is never written to even if the copy
+ * looks like it has gone away.
+ */
+void WorldChunk::detachCubes()
+{
+    if ( mIsSharingCubes )
+    {
+        mpCubes.reset( new std::vector<CubeData>( *mpCubes ) );
+        mIsSharingCubes = false;
+    }
 }
 
 CubeData WorldChunk::at( const Point& pos ) const
 {
-    return mCubes[ findCubeOffset( pos ) ];
+    return (*mpCubes)[ findCubeOffset( pos ) ];
 }
 
 bool WorldChunk::isEmptyAt( const Point& pos ) const
 {
     unsigned int index = findCubeOffset( pos );
-    return mCubes[ index ].isEmpty();
+    return (*mpCubes)[ index ].isEmpty();
 }
 
 std::vector<CubeData> WorldChunk::getAllCubes() const
 {
-    return std::vector<CubeData>( mCubes );
+    return std::vector<CubeData>( *mpCubes );
+}
+
+/**
+ * Returns a pointer to the chunk's TOTAL_CUBES cubes. Cubes are laid out
+ * with x varying fastest, then y and finally z (the same ordering used by
+ * findCubeOffset). This lets bulk readers such as the mesher walk the chunk
+ * without going through Point lookups for every cube.
+ */
+const CubeData* WorldChunk::cubes() const
+{
+    return &(*mpCubes)[0];
 }
 
 CubeIntersection WorldChunk::firstCubeIntersecting( const Vec3& /*origin*/,
@@ -110,17 +264,38 @@ CubeIntersection WorldChunk::firstCubeIntersecting( const Vec3& /*origin*/,
 
 unsigned int WorldChunk::cubeCount() const
 {
-    unsigned int count = 0;
+    return TOTAL_CUBES - mMaterialCounts[EMATERIAL_EMPTY];
+}
 
-    for ( size_t i = 0; i < mCubes.size(); ++i )
-    {
-        if (! mCubes[i].isEmpty() )
-        {
-            count++;
-        }
-    }
+uint32_t WorldChunk::rowOccupancy( unsigned int y, unsigned int z ) const
+{
+    assert( y < TOTAL_ROWS && z < TOTAL_DEPTH );
+    return mOccupancy[ z * TOTAL_ROWS + y ];
+}
 
-    return count;
+const uint32_t* WorldChunk::occupancy() const
+{
+    return &mOccupancy[0];
+}
+
+const uint32_t* WorldChunk::opaqueOccupancy() const
+{
+    return &mOpaqueOccupancy[0];
+}
+
+/**
+ * Checks if every cube in the chunk is made of the same material. An empty
+ * chunk is uniform, as is a chunk of solid rock.
+ */
+bool WorldChunk::isUniform() const
+{
+    return mMaterialCounts[ (*mpCubes)[0].materialType() ] == TOTAL_CUBES;
+}
+
+EMaterialType WorldChunk::uniformMaterial() const
+{
+    assert( isUniform() );
+    return (*mpCubes)[0].materialType();
 }
 
 /**
@@ -157,3 +332,23 @@ void WorldChunk::setIsRebuildingView( bool isDirty )
 {
     mIsRebuildingView = isDirty;
 }
+
+void WorldChunk::markSectionsDirty( uint32_t sectionMask )
+{
+    mDirtySections |= ( sectionMask & ALL_SECTIONS );
+}
+
+uint32_t WorldChunk::dirtySections() const
+{
+    return mDirtySections;
+}
+
+void WorldChunk::clearDirtySections()
+{
+    mDirtySections = 0;
+}
+
+unsigned int WorldChunk::sectionForDepth( unsigned int z )
+{
+    return ( z % TOTAL_DEPTH ) / SECTION_DEPTH;
+}
@@ -5,6 +5,9 @@
 #include "engine/point.h"
 #include "engine/cubeintersection.h"
 #include "engine/worldcube.h"
+#include "engine/material.h"
+#include <stdint.h>
+#include <memory>
 #include <vector>
 
 class CubeData;
@@ -12,15 +15,32 @@ class CubeData;
 /**
  * A "WorldChunk" is a collection of cubes that exist together
  * [NEED MORE DESCRIPTION]
+ *
+ * Copying a chunk is cheap: the copy shares the original's cube array until
+ * one of them is changed, at which point the changed chunk takes a private
+ * copy. This lets the view hand immutable snapshots to worker threads.
+ *
+ * Once a chunk has been copied it never writes to its cube array in place
+ * again, even after every copy has been destroyed. Checking whether the
+ * copies are gone would mean reading the array's reference count, which
+ * gives no guarantee that another thread has finished reading the cubes.
  */
 class WorldChunk
 {
 public:
     WorldChunk();
+    WorldChunk( const WorldChunk& chunk );
     ~WorldChunk();
 
+    // Assignment operator
+    WorldChunk& operator = ( const WorldChunk& rhs );
+
     // Place a cube
     void put( const CubeData& cube, const Point& pos );
+
+    // Replace every cube in the chunk at once, pCubes holds TOTAL_CUBES
+    // cubes laid out the same way as cubes()
+    void putAllCubes( const CubeData * pCubes );
     
     // Retrieve a cube
     CubeData at( const Point& position ) const;
@@ -35,31 +55,88 @@ public:
     // Return a list of all cubes in this chunk
     std::vector<CubeData> getAllCubes() const;
 
+    // Read only access to the chunk's raw cube array
+    const CubeData* cubes() const;
+
     // Return number of cubes that are populated
     unsigned int cubeCount() const;
 
+    // Bitmask of non-empty cubes in row (y, z), bit x is set if not empty
+    uint32_t rowOccupancy( unsigned int y, unsigned int z ) const;
+
+    // Read only access to all row occupancy masks, indexed by z * ROWS + y
+    const uint32_t* occupancy() const;
+
+    // Same as occupancy, but only the bits of opaque cubes are set
+    const uint32_t* opaqueOccupancy() const;
+
+    // Check if every cube in the chunk has the same material
+    bool isUniform() const;
+
+    // The material shared by every cube (only valid if isUniform is true)
+    EMaterialType uniformMaterial() const;
+
     // Return if the cube's view data needs to be regenerated
     bool isRebuildingView() const;
 
     // Change the view dirty flag
     void setIsRebuildingView( bool isDirty );
 
+    // Flag sections of the chunk as needing their view rebuilt, bit n of the
+    // mask is section n
+    void markSectionsDirty( uint32_t sectionMask );
+
+    // Sections waiting to have their view rebuilt
+    uint32_t dirtySections() const;
+
+    // Forget about all dirty sections
+    void clearDirtySections();
+
+    // Section that a (chunk relative) z coordinate falls in
+    static unsigned int sectionForDepth( unsigned int z );
+
 public:
     const static unsigned int TOTAL_COLS;
     const static unsigned int TOTAL_ROWS;
     const static unsigned int TOTAL_DEPTH;
     const static unsigned int TOTAL_CUBES;
 
+    // Chunks are split along z into sections that are meshed independently
+    const static unsigned int SECTION_DEPTH;
+    const static unsigned int SECTION_COUNT;
+    const static uint32_t     ALL_SECTIONS;
+
 private:
     // Returns the cube offset for a given (RELATIVE!) position
     unsigned int findCubeOffset( const Point& position ) const;
 
 private:
-    // Contains all of the vector's cubes
-    std::vector<CubeData> mCubes;
+    // Makes sure the cube array isn't shared before writing to it
+    void detachCubes();
+
+private:
+    // Contains all of the vector's cubes, shared with copies of this chunk
+    std::shared_ptr< std::vector<CubeData> > mpCubes;
+
+    // Set when the cube array has been handed to a copy of this chunk, and
+    // cleared once this chunk has taken a private array again
+    mutable bool mIsSharingCubes;
+
+    // One bit per cube, set when the cube is not empty. Each row of cubes
+    // along the x axis is packed into a single 32 bit mask
+    std::vector<uint32_t> mOccupancy;
+
+    // Occupancy masks that leave out translucent cubes
+    std::vector<uint32_t> mOpaqueOccupancy;
+
+    // Number of cubes using each material
+    unsigned int mMaterialCounts[EMATERIAL_COUNT];
 
     // Flag specifying if the chunk's view needs to be updated
     bool mIsRebuildingView;
+
+    // One bit per section whose view needs to be updated
+    uint32_t mDirtySections;
 };
 
 #endif
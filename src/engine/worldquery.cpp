@@ -0,0 +1,243 @@
+#include "engine/worldquery.h"
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubevolume.h"
+#include "engine/bits.h"
+#include "engine/point.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Below this many chunks per thread it isn't worth spinning up threads
+    const size_t MIN_CHUNKS_PER_THREAD = 2;
+
+    /**
+     * Work out which chunks overlap the volume and actually contain cubes.
+     * Chunks that were never created, or are completely empty, are skipped.
+     */
+    void findCandidateChunks( const World& world,
+                              const Point& min,
+                              const Point& max,
+                              std::vector<Point>& chunkCoords )
+    {
+        if ( min.x >= max.x || min.y >= max.y || min.z >= max.z )
+        {
+            return;
+        }
+
+        const int cols  = static_cast<int>( WorldChunk::TOTAL_COLS );
+        const int rows  = static_cast<int>( WorldChunk::TOTAL_ROWS );
+        const int depth = static_cast<int>( WorldChunk::TOTAL_DEPTH );
+
+        for ( int cz = min.z / depth; cz <= ( max.z - 1 ) / depth; ++cz )
+        {
+            for ( int cy = min.y / rows; cy <= ( max.y - 1 ) / rows; ++cy )
+            {
+                for ( int cx = min.x / cols; cx <= ( max.x - 1 ) / cols; ++cx )
+                {
+                    const WorldChunk * pChunk = world.chunkAt( Point( cx, cy, cz ) );
+
+                    if ( pChunk != NULL && pChunk->cubeCount() > 0 )
+                    {
+                        chunkCoords.push_back( Point( cx, cy, cz ) );
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Emits the spans of non-empty cubes in a single chunk that also lie
+     * inside of the volume (and the clip box)
+     */
+    void findSpansInChunk( const World& world,
+                           const Point& chunkCoord,
+                           const CubeVolume& volume,
+                           const Point& min,
+                           const Point& max,
+                           std::vector<CubeSpan>& spans )
+    {
+        const int cols  = static_cast<int>( WorldChunk::TOTAL_COLS );
+        const int rows  = static_cast<int>( WorldChunk::TOTAL_ROWS );
+        const int depth = static_cast<int>( WorldChunk::TOTAL_DEPTH );
+
+        const WorldChunk& chunk = *world.chunkAt( chunkCoord );
+        const CubeData * pCubes = chunk.cubes();
+        const Point origin( chunkCoord.x * cols,
+                            chunkCoord.y * rows,
+                            chunkCoord.z * depth );
+
+        // A completely full chunk has no holes, so every row is one span
+        const bool isFull = ( chunk.cubeCount() == WorldChunk::TOTAL_CUBES );
+
+        const int zBegin = std::max( min.z, origin.z );
+        const int zEnd   = std::min( max.z, origin.z + depth );
+        const int yBegin = std::max( min.y, origin.y );
+        const int yEnd   = std::min( max.y, origin.y + rows );
+
+        for ( int z = zBegin; z < zEnd; ++z )
+        {
+            for ( int y = yBegin; y < yEnd; ++y )
+            {
+                int xMin = 0, xMax = 0;
+
+                if (! volume.rowExtent( y, z, xMin, xMax ) )
+                {
+                    continue;
+                }
+
+                xMin = std::max( std::max( xMin, min.x ), origin.x );
+                xMax = std::min( std::min( xMax, max.x ), origin.x + cols );
+
+                if ( xMin >= xMax )
+                {
+                    continue;
+                }
+
+                const unsigned int ly = y - origin.y;
+                const unsigned int lz = z - origin.z;
+
+                uint64_t mask = isFull ? ~uint64_t( 0 ) : chunk.rowOccupancy( ly, lz );
+                mask &= Bits::rangeMask( xMin - origin.x, xMax - xMin );
+
+                // Peel off runs of set bits, each run is one span
+                while ( mask != 0 )
+                {
+                    unsigned int first  = Bits::countTrailingZeros( mask );
+                    unsigned int length = Bits::countTrailingZeros( ~( mask >> first ) );
+
+                    CubeSpan span;
+                    span.start  = Point( origin.x + first, y, z );
+                    span.length = length;
+                    span.pCubes = pCubes + ( lz * rows + ly ) * cols + first;
+
+                    spans.push_back( span );
+                    mask &= ~Bits::rangeMask( first, length );
+                }
+            }
+        }
+    }
+
+    /**
+     * Clip the volume's bounds against the world
+     */
+    void clippedBounds( const World& world,
+                        const CubeVolume& volume,
+                        Point& min,
+                        Point& max )
+    {
+        volume.bounds( min, max );
+
+        min = Point( std::max( min.x, 0 ),
+                     std::max( min.y, 0 ),
+                     std::max( min.z, 0 ) );
+        max = Point( std::min( max.x, static_cast<int>( world.cols() ) ),
+                     std::min( max.y, static_cast<int>( world.rows() ) ),
+                     std::min( max.z, static_cast<int>( world.depth() ) ) );
+    }
+}
+
+namespace WorldQuery
+{
+
+void findSpans( const World& world,
+                const CubeVolume& volume,
+                std::vector<CubeSpan>& spans )
+{
+    Point min, max;
+    std::vector<Point> chunkCoords;
+
+    clippedBounds( world, volume, min, max );
+    findCandidateChunks( world, min, max, chunkCoords );
+
+    for ( size_t i = 0; i < chunkCoords.size(); ++i )
+    {
+        findSpansInChunk( world, chunkCoords[i], volume, min, max, spans );
+    }
+}
+
+/**
+ * Each worker thread grabs the next unclaimed chunk and writes its spans into
+ * that chunk's own output list. The lists are stitched back together in chunk
+ * order afterwards, which keeps the results identical to findSpans.
+ */
+void findSpansParallel( const World& world,
+                        const CubeVolume& volume,
+                        std::vector<CubeSpan>& spans,
+                        unsigned int threadCount )
+{
+    Point min, max;
+    std::vector<Point> chunkCoords;
+
+    clippedBounds( world, volume, min, max );
+    findCandidateChunks( world, min, max, chunkCoords );
+
+    if ( threadCount == 0 )
+    {
+        threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+
+    threadCount = static_cast<unsigned int>(
+        std::min<size_t>( threadCount, chunkCoords.size() / MIN_CHUNKS_PER_THREAD ) );
+
+    // Small volumes are cheaper to do on the calling thread
+    if ( threadCount <= 1 )
+    {
+        for ( size_t i = 0; i < chunkCoords.size(); ++i )
+        {
+            findSpansInChunk( world, chunkCoords[i], volume, min, max, spans );
+        }
+
+        return;
+    }
+
+    std::vector< std::vector<CubeSpan> > chunkSpans( chunkCoords.size() );
+    std::atomic<size_t> nextChunk( 0 );
+    std::vector<std::thread> workers;
+
+    for ( unsigned int t = 0; t < threadCount; ++t )
+    {
+        workers.push_back( std::thread( [&]()
+        {
+            size_t i = 0;
+
+            while ( ( i = nextChunk.fetch_add( 1 ) ) < chunkCoords.size() )
+            {
+                findSpansInChunk( world, chunkCoords[i], volume, min, max,
+                                  chunkSpans[i] );
+            }
+        } ) );
+    }
+
+    for ( size_t t = 0; t < workers.size(); ++t )
+    {
+        workers[t].join();
+    }
+
+    for ( size_t i = 0; i < chunkSpans.size(); ++i )
+    {
+        spans.insert( spans.end(), chunkSpans[i].begin(), chunkSpans[i].end() );
+    }
+}
+
+unsigned int countCubes( const World& world, const CubeVolume& volume )
+{
+    std::vector<CubeSpan> spans;
+    unsigned int count = 0;
+
+    findSpans( world, volume, spans );
+
+    for ( size_t i = 0; i < spans.size(); ++i )
+    {
+        count += spans[i].length;
+    }
+
+    return count;
+}
+
+}
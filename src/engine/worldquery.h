@@ -0,0 +1,63 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_WORLD_QUERY_H
+#define SCOTT_CUBEWORLD_WORLD_QUERY_H
+
+#include <vector>
+#include "engine/point.h"
+
+class World;
+class CubeData;
+class CubeVolume;
+
+/**
+ * A run of consecutive non-empty cubes along the x axis. The cube data is
+ * read straight out of the owning chunk, so a span is only valid until the
+ * world is next modified.
+ */
+struct CubeSpan
+{
+    Point start;                // World position of the first cube
+    unsigned int length;        // Number of cubes in the span
+    const CubeData * pCubes;    // First cube of the span, contiguous in memory
+};
+
+/**
+ * Read only bulk queries over the cubes in a world. Unlike World::at these
+ * never instantiate chunks. Volumes are clipped against each chunk, chunks
+ * that are empty are skipped outright and chunks that are completely full
+ * are walked without looking at their occupancy masks.
+ */
+namespace WorldQuery
+{
+    // Append every span of non-empty cubes inside of the volume
+    void findSpans( const World& world,
+                    const CubeVolume& volume,
+                    std::vector<CubeSpan>& spans );
+
+    // Same as findSpans, but the chunks are split across worker threads.
+    // Results are identical (and in the same order) as findSpans. A thread
+    // count of zero uses one thread per hardware core
+    void findSpansParallel( const World& world,
+                            const CubeVolume& volume,
+                            std::vector<CubeSpan>& spans,
+                            unsigned int threadCount = 0 );
+
+    // Count the non-empty cubes inside of the volume
+    unsigned int countCubes( const World& world, const CubeVolume& volume );
+}
+
+#endif
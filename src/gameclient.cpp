@@ -22,6 +22,7 @@
 #include "engine/gametime.h"
 #include "graphics/iwindow.h"
 #include "graphics/irenderer.h"
+#include "graphics/threadedrenderer.h"
 
 /**
  * Inspiration and help for the game loop came from the following sources:
@@ -46,7 +47,9 @@
 GameClient::GameClient( IWindow *pMainWindow,
                         IRenderer *pRenderer )
     : mpMainWindow( pMainWindow ),
-      mpRenderer( NULL ),
+      mpRenderer( pRenderer ),
+      mpRenderThread( NULL ),
+      mHasStarted( false ),
       mIsGameRunning( false ),
       mIsRunningSlowly( false ),
       mUpdateFrequency( 1.0f / 50.0f ), // 20ms, 50 times per second
@@ -61,6 +64,7 @@ GameClient::GameClient( IWindow *pMainWindow,
  */
 GameClient::~GameClient()
 {
+    Delete( mpRenderThread );
 }
 
 /**
@@ -78,6 +82,46 @@ void GameClient::setUpdateFrequency( int numUpdatesPerSecond )
     LOG_TRACE("GameClient") << "Setting the update frequency to " << mUpdateFrequency;
 }
 
+/**
+ * Moves rendering onto its own thread. Draw calls made through mpRenderer
+ * are recorded into a command buffer, and presenting a frame hands it to the
+ * render thread, which plays it back on the real renderer while the game
+ * goes on simulating and recording the next frame.
+ *
+ * Only mpRenderer is swapped, so this has to be called before run(). Anything
+ * still holding the real renderer, such as a world view created during
+ * initialize(), would otherwise draw on it while the render thread does too.
+ * For the same reason the renderer given to the constructor must not be
+ * handed to anything else.
+ *
+ * \param  bufferCount  Frames that can be in flight at once (two or three)
+ */
+void GameClient::enableRenderThread( unsigned int bufferCount )
+{
+    assert( mpRenderThread == NULL );
+    assert(! mHasStarted && "Enable the render thread before running the game" );
+
+    mpRenderThread = new ThreadedRenderer( mpRenderer, bufferCount );
+    mpRenderer     = mpRenderThread;
+
+    LOG_DEBUG("GameClient") << "Rendering on its own thread with "
+                            << bufferCount << " command buffers";
+}
+
+/**
+ * Returns how long the game thread spent recording and waiting on the render
+ * thread, and how long the render thread took to draw
+ */
+ThreadedRendererStats GameClient::renderThreadStats() const
+{
+    if ( mpRenderThread == NULL )
+    {
+        return ThreadedRendererStats();
+    }
+
+    return mpRenderThread->stats();
+}
+
 /**
  * Starts up and runs the game. This method will not return until after the
  * player has quit the game
@@ -87,6 +131,7 @@ int GameClient::run()
     // Show the main window before we set up our rendering system or load
     // any resources
     mpMainWindow->show();
+    mHasStarted = true;
 
     // Let the game initialize core systems
     if ( initializeClient() == false || initialize() == false )
@@ -23,6 +23,8 @@
 class IWindow;
 class IRenderer;
 class IWorldView;
+class ThreadedRenderer;
+struct ThreadedRendererStats;
 
 /**
  * This is the foundation class for a hailstorm game client. A custom game
@@ -37,6 +39,14 @@ public:
     int run();
     void setUpdateFrequency( int numUpdatesPerSecond );
 
+    // Record draws on the game thread and play them back on a render thread.
+    // Only valid before run(), since the game hands mpRenderer out from
+    // initialize() on and every user has to get the threaded one
+    void enableRenderThread( unsigned int bufferCount = 2 );
+
+    // Timings of the game and render threads, empty without a render thread
+    ThreadedRendererStats renderThreadStats() const;
+
 protected:
     virtual bool initialize() = 0;
     virtual bool loadContent() = 0;
@@ -57,6 +67,12 @@ protected:
     /// Pointer to the graphics renderer
     IRenderer * mpRenderer;
 
+    /// Render thread wrapping the renderer, if enabled (it is mpRenderer then)
+    ThreadedRenderer * mpRenderThread;
+
+    /// Flag if run() has been called, after which the renderer can't change
+    bool mHasStarted;
+
     /// Flag if the game is game loop is running
     bool mIsGameRunning;
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "generation/columnworldgenerator.h"
+#include "engine/constants.h"
+#include "engine/world.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+    /**
+     * Scrambles the bits of a 32 bit value, so that nearby inputs give
+     * unrelated outputs (the finalizer from MurmurHash3)
+     */
+    inline uint32_t mixBits( uint32_t h )
+    {
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+
+        return h;
+    }
+}
+
+/**
+ * Constructor
+ *
+ * \param  seed         Seed the world is generated from
+ * \param  threadCount  Number of threads to generate columns on, zero to
+ *                      use one per core
+ */
+ColumnWorldGenerator::ColumnWorldGenerator( unsigned int seed,
+                                            unsigned int threadCount )
+    : mSeed( seed ),
+      mThreadCount( 0 )
+{
+    setThreadCount( threadCount );
+}
+
+ColumnWorldGenerator::~ColumnWorldGenerator()
+{
+}
+
+unsigned int ColumnWorldGenerator::seed() const
+{
+    return mSeed;
+}
+
+void ColumnWorldGenerator::setThreadCount( unsigned int threadCount )
+{
+    mThreadCount = threadCount;
+
+    if ( mThreadCount == 0 )
+    {
+        mThreadCount = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+}
+
+unsigned int ColumnWorldGenerator::threadCount() const
+{
+    return mThreadCount;
+}
+
+/**
+ * Derives a column's seed from the world seed and the column's chunk
+ * coordinates. Neighboring columns get unrelated seeds, and the same
+ * column of the same world always gets the same seed
+ */
+unsigned int ColumnWorldGenerator::columnSeed( unsigned int chunkX,
+                                               unsigned int chunkZ ) const
+{
+    uint32_t h = mixBits( mSeed );
+    h = mixBits( h ^ ( chunkX * 0x9e3779b9u ) );
+    h = mixBits( h ^ ( chunkZ * 0x7f4a7c15u ) );
+
+    return h;
+}
+
+void ColumnWorldGenerator::prepare( World& /*world*/ )
+{
+}
+
+bool ColumnWorldGenerator::isParallel() const
+{
+    return true;
+}
+
+/**
+ * Creates a new world and generates every column of chunks in it. Each
+ * worker thread takes the next column that hasn't been started until there
+ * are none left. Once every column is done the view is told about all of
+ * the new chunks at once
+ */
+World * ColumnWorldGenerator::generate( unsigned int cols,
+                                        unsigned int rows,
+                                        unsigned int depth,
+                                        WorldView * pWorldView )
+{
+    World * pWorld = new World( cols, rows, depth, pWorldView );
+    prepare( *pWorld );
+
+    const unsigned int chunkCols   = pWorld->chunkCols();
+    const unsigned int columnCount = chunkCols * pWorld->chunkDepth();
+    const unsigned int threadCount =
+        ( isParallel() ? std::min( mThreadCount, columnCount ) : 1 );
+
+    if ( threadCount <= 1 )
+    {
+        std::vector<CubeData> cubes( Constants::CHUNK_CUBES );
+
+        for ( unsigned int column = 0; column < columnCount; ++column )
+        {
+            const unsigned int x = column % chunkCols;
+            const unsigned int z = column / chunkCols;
+
+            generateColumn( *pWorld, x, z, columnSeed( x, z ), cubes );
+        }
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        std::atomic<unsigned int> nextColumn( 0 );
+
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            workers.push_back( std::thread( [&]()
+            {
+                std::vector<CubeData> cubes( Constants::CHUNK_CUBES );
+                unsigned int column = 0;
+
+                while ( ( column = nextColumn.fetch_add( 1 ) ) < columnCount )
+                {
+                    const unsigned int x = column % chunkCols;
+                    const unsigned int z = column / chunkCols;
+
+                    generateColumn( *pWorld, x, z, columnSeed( x, z ), cubes );
+                }
+            } ) );
+        }
+
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            workers[t].join();
+        }
+    }
+
+    pWorld->rebuildView();
+    return pWorld;
+}
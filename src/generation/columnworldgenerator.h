@@ -0,0 +1,80 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_COLUMN_WORLD_GENERATION_H
+#define SCOTT_CUBEWORLD_COLUMN_WORLD_GENERATION_H
+
+#include "generation/iworldgenerator.h"
+#include "engine/cubedata.h"
+
+#include <vector>
+
+class World;
+class WorldView;
+
+/**
+ * Base for world generators that build the world one column of chunks at
+ * a time. Every column is an independent task that is handed its own seed,
+ * derived from the world's seed and the column's chunk coordinates, and
+ * the columns are spread across a number of worker threads.
+ *
+ * Columns must only depend on their coordinates and seed (and on state set
+ * up in prepare), never on the order they are generated in. That way the
+ * generated world is identical no matter how many threads built it.
+ */
+class ColumnWorldGenerator : public IWorldGenerator
+{
+public:
+    ColumnWorldGenerator( unsigned int seed, unsigned int threadCount );
+    virtual ~ColumnWorldGenerator();
+
+    virtual World* generate( unsigned int cols,
+                             unsigned int rows,
+                             unsigned int depth,
+                             WorldView * pWorldView );
+
+    // Seed the world is generated from
+    unsigned int seed() const;
+
+    // Number of threads generating columns (zero uses one per core)
+    void setThreadCount( unsigned int threadCount );
+    unsigned int threadCount() const;
+
+    // Seed handed to the column at the given chunk coordinates
+    unsigned int columnSeed( unsigned int chunkX, unsigned int chunkZ ) const;
+
+protected:
+    // Called on the generating thread before any columns are generated
+    virtual void prepare( World& world );
+
+    // Generate the column of chunks at the given chunk x and z coordinates.
+    // Called from worker threads, so chunks should be written with
+    // World::putChunk without notifying the view. cubes has room for one
+    // chunk's worth of cubes, and belongs to the calling thread
+    virtual void generateColumn( World& world,
+                                 unsigned int chunkX,
+                                 unsigned int chunkZ,
+                                 unsigned int seed,
+                                 std::vector<CubeData>& cubes ) const = 0;
+
+    // Return false if generateColumn can't run on more than one thread
+    virtual bool isParallel() const;
+
+private:
+    unsigned int mSeed;
+    unsigned int mThreadCount;
+};
+
+#endif
@@ -16,11 +16,39 @@
 #include "generation/flatworldgenerator.h"
 #include "engine/material.h"
 #include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "engine/point.h"
 #include "engine/world.h"
 
 #include <random>
 
+namespace
+{
+    // Number of randomized layers between the bedrock and the grass
+    const unsigned int GROUND_LEVELS = 5;
+
+    // Height of the grass that tops off the world
+    const unsigned int GRASS_LEVEL = GROUND_LEVELS + 2;
+}
+
+/**
+ * Creates a flat world generator with a random seed
+ */
 FlatWorldGenerator::FlatWorldGenerator()
+    : ColumnWorldGenerator( std::random_device()(), 0 )
+{
+}
+
+/**
+ * Creates a flat world generator that always generates the same world
+ *
+ * \param  seed         Seed the world is generated from
+ * \param  threadCount  Number of threads to generate on, zero for one per
+ *                      core
+ */
+FlatWorldGenerator::FlatWorldGenerator( unsigned int seed,
+                                        unsigned int threadCount )
+    : ColumnWorldGenerator( seed, threadCount )
 {
 }
 
@@ -29,46 +57,59 @@ FlatWorldGenerator::~FlatWorldGenerator()
 }
 
 /**
- * Generates a flat world. A flat world has a bedrock layer, several
- * layers of dirt and stone topped off with grass
+ * Generates one column of a flat world. A flat world has a bedrock layer,
+ * several layers of dirt and stone topped off with grass
  */
-World * FlatWorldGenerator::generate( unsigned int cols,
-                                      unsigned int rows,
-                                      unsigned int height,
-                                      WorldView * pWorldView )
+void FlatWorldGenerator::generateColumn( World& world,
+                                         unsigned int chunkX,
+                                         unsigned int chunkZ,
+                                         unsigned int seed,
+                                         std::vector<CubeData>& cubes ) const
 {
-    const unsigned int GROUND_LEVELS = 5;
+    const unsigned int COLS  = Constants::CHUNK_COLS;
+    const unsigned int ROWS  = Constants::CHUNK_ROWS;
+    const unsigned int DEPTH = Constants::CHUNK_DEPTH;
 
-    // We need some randomness, now don't we?
-    std::random_device rd;
-    std::mt19937 rng( rd() );
-    std::uniform_int_distribution<> dice( 0, 1 );
+    // We need some randomness, now don't we? Only the raw twister output is
+    // used so every platform rolls the same dice for the same seed
+    std::mt19937 rng( seed );
 
-    // First create a new world object
-    World * pWorld = new World( cols, rows, height, pWorldView );
-    
-    // 
-    for ( unsigned int x = 0; x < cols; ++x )
+    for ( unsigned int chunkY = 0;
+          chunkY < world.chunkRows() && chunkY * ROWS <= GRASS_LEVEL;
+          ++chunkY )
     {
-        for ( unsigned int z = 0; z < rows; ++z )
-        {
-            // bedrock at the bottom
-            pWorld->put( CubeData( EMATERIAL_BEDROCK ), Point( x, 0, z ) );
+        CubeData * pCube = &cubes[0];
 
-            // now multiple in-between layers
-            for ( unsigned int y = 0; y < GROUND_LEVELS; ++y )
+        for ( unsigned int z = 0; z < DEPTH; ++z )
+        {
+            for ( unsigned int y = chunkY * ROWS; y < ( chunkY + 1 ) * ROWS; ++y )
             {
-                EMaterialType m = ( dice(rng) == 0 ? EMATERIAL_GRASS :
-                                                     EMATERIAL_ROCK );
+                for ( unsigned int x = 0; x < COLS; ++x )
+                {
+                    EMaterialType m = EMATERIAL_EMPTY;
 
-                pWorld->put( CubeData( m ), Point( x, 1 + y, z ) );
-            }
+                    if ( y == 0 )
+                    {
+                        // bedrock at the bottom
+                        m = EMATERIAL_BEDROCK;
+                    }
+                    else if ( y <= GROUND_LEVELS )
+                    {
+                        // now multiple in-between layers
+                        m = ( ( rng() & 1 ) == 0 ? EMATERIAL_GRASS :
+                                                   EMATERIAL_ROCK );
+                    }
+                    else if ( y == GRASS_LEVEL )
+                    {
+                        // finally top it off with graaaaaassss
+                        m = EMATERIAL_GRASS;
+                    }
 
-            // finally top it off with graaaaaassss
-            pWorld->put( CubeData( EMATERIAL_GRASS ),
-                         Point( x, 2 + GROUND_LEVELS, z ) );
+                    (pCube++)->setMaterial( m );
+                }
+            }
         }
-    }
 
-    return pWorld;
+        world.putChunk( Point( chunkX, chunkY, chunkZ ), &cubes[0], false );
+    }
 }
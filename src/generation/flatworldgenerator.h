@@ -16,25 +16,26 @@
 #ifndef SCOTT_CUBEWORLD_FLAT_WORLD_GENERATION_H
 #define SCOTT_CUBEWORLD_FLAT_WORLD_GENERATION_H
 
-#include "generation/iworldgenerator.h"
+#include "generation/columnworldgenerator.h"
 class World;
 class WorldView;
 
 /**
  * Creates a flat world
  */
-class FlatWorldGenerator : public IWorldGenerator
+class FlatWorldGenerator : public ColumnWorldGenerator
 {
 public:
     FlatWorldGenerator();
+    FlatWorldGenerator( unsigned int seed, unsigned int threadCount = 0 );
     ~FlatWorldGenerator();
 
-    virtual World* generate( unsigned int cols,
-                             unsigned int rows,
-                             unsigned int height,
-                             WorldView * pWorldView );
-private:
-    unsigned int mLevelHeight;
+protected:
+    virtual void generateColumn( World& world,
+                                 unsigned int chunkX,
+                                 unsigned int chunkZ,
+                                 unsigned int seed,
+                                 std::vector<CubeData>& cubes ) const;
 };
 
 #endif
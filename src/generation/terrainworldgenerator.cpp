@@ -0,0 +1,203 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "generation/terrainworldgenerator.h"
+#include "engine/constants.h"
+#include "engine/material.h"
+#include "engine/point.h"
+#include "engine/world.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Distance between heightmap samples in noise space, a single octave
+    // has hills roughly this many cubes across
+    const float NOISE_STEP = 1.0f / 64.0f;
+
+    // Number of noise octaves layered together for the heightmap
+    const unsigned int NOISE_OCTAVES = 5;
+
+    // Number of dirt (or sand) cubes between the surface and the rock
+    const unsigned int DIRT_DEPTH = 3;
+
+    // Columns whose surface is at most this far above sea level are beach
+    const unsigned int BEACH_HEIGHT = 1;
+}
+
+/**
+ * Constructor
+ *
+ * \param  seed         Seed for the terrain's noise
+ * \param  threadCount  Number of threads to generate on, zero for one per
+ *                      core
+ */
+TerrainWorldGenerator::TerrainWorldGenerator( unsigned int seed,
+                                              unsigned int threadCount )
+    : ColumnWorldGenerator( seed, threadCount ),
+      mNoise( seed ),
+      mSeaLevel( 0 ),
+      mBaseHeight( 0 ),
+      mHillHeight( 0 ),
+      mIsUsingBulkWrites( true )
+{
+}
+
+TerrainWorldGenerator::~TerrainWorldGenerator()
+{
+}
+
+unsigned int TerrainWorldGenerator::seaLevel() const
+{
+    return mSeaLevel;
+}
+
+void TerrainWorldGenerator::setBulkWritesEnabled( bool isEnabled )
+{
+    mIsUsingBulkWrites = isEnabled;
+}
+
+/**
+ * Scales the terrain's heights to the number of rows in the world, with
+ * the sea a little below half way up
+ */
+void TerrainWorldGenerator::prepare( World& world )
+{
+    mSeaLevel   = world.rows() * 3 / 8;
+    mBaseHeight = world.rows() * 7 / 16;
+    mHillHeight = world.rows() * 3 / 8;
+}
+
+/**
+ * Per cube writes tell the view about every cube as they go, which can
+ * only be done from one thread
+ */
+bool TerrainWorldGenerator::isParallel() const
+{
+    return mIsUsingBulkWrites;
+}
+
+/**
+ * Generates the column of chunks stacked on top of each other at the given
+ * chunk x and z coordinates. Chunks that are entirely above the ground and
+ * the sea are left empty and never created. The terrain is entirely
+ * decided by the world's noise, so the column's seed isn't needed
+ */
+void TerrainWorldGenerator::generateColumn( World& world,
+                                            unsigned int chunkX,
+                                            unsigned int chunkZ,
+                                            unsigned int /*seed*/,
+                                            std::vector<CubeData>& cubes ) const
+{
+    const unsigned int COLS  = Constants::CHUNK_COLS;
+    const unsigned int ROWS  = Constants::CHUNK_ROWS;
+    const unsigned int DEPTH = Constants::CHUNK_DEPTH;
+
+    // Heightmap for the whole column, x varying fastest and then z
+    std::vector<float> noise( COLS * DEPTH );
+    std::vector<unsigned int> heights( COLS * DEPTH );
+
+    mNoise.fillFbm( &noise[0],
+                    COLS,
+                    DEPTH,
+                    static_cast<float>( chunkX * COLS ) * NOISE_STEP,
+                    static_cast<float>( chunkZ * DEPTH ) * NOISE_STEP,
+                    NOISE_STEP,
+                    NOISE_OCTAVES );
+
+    const int maxHeight = static_cast<int>( world.rows() ) - 1;
+    unsigned int highest = mSeaLevel;
+
+    for ( size_t i = 0; i < heights.size(); ++i )
+    {
+        const float height = static_cast<float>( mBaseHeight ) +
+                             static_cast<float>( mHillHeight ) * noise[i];
+
+        heights[i] = static_cast<unsigned int>(
+            std::max( 1, std::min( maxHeight,
+                                   static_cast<int>( std::floor( height ) ) ) ) );
+        highest = std::max( highest, heights[i] );
+    }
+
+    // Build each chunk that has something in it and write it out
+    for ( unsigned int chunkY = 0; chunkY * ROWS <= highest; ++chunkY )
+    {
+        const unsigned int baseY = chunkY * ROWS;
+        CubeData * pCube = &cubes[0];
+
+        for ( unsigned int z = 0; z < DEPTH; ++z )
+        {
+            const unsigned int * pHeights = &heights[z * COLS];
+
+            for ( unsigned int y = 0; y < ROWS; ++y )
+            {
+                for ( unsigned int x = 0; x < COLS; ++x )
+                {
+                    (pCube++)->setMaterial( materialAt( baseY + y, pHeights[x] ) );
+                }
+            }
+        }
+
+        if ( mIsUsingBulkWrites )
+        {
+            world.putChunk( Point( chunkX, chunkY, chunkZ ), &cubes[0], false );
+            continue;
+        }
+
+        // The slow way, kept around for comparison
+        for ( unsigned int i = 0; i < cubes.size(); ++i )
+        {
+            if (! cubes[i].isEmpty() )
+            {
+                world.put( cubes[i],
+                           Point( chunkX * COLS  + i % COLS,
+                                  baseY          + ( i / COLS ) % ROWS,
+                                  chunkZ * DEPTH + i / ( COLS * ROWS ) ) );
+            }
+        }
+    }
+}
+
+/**
+ * Picks the material for a cube at height y in a column whose surface is
+ * at the given height
+ */
+EMaterialType TerrainWorldGenerator::materialAt( unsigned int y,
+                                                 unsigned int height ) const
+{
+    const bool isBeach = ( height <= mSeaLevel + BEACH_HEIGHT );
+
+    if ( y == 0 )
+    {
+        return EMATERIAL_BEDROCK;
+    }
+    else if ( y > height )
+    {
+        return ( y <= mSeaLevel ? EMATERIAL_WATER : EMATERIAL_EMPTY );
+    }
+    else if ( y == height )
+    {
+        return ( isBeach ? EMATERIAL_SAND : EMATERIAL_GRASS );
+    }
+    else if ( y + DIRT_DEPTH >= height )
+    {
+        return ( isBeach ? EMATERIAL_SAND : EMATERIAL_DIRT );
+    }
+    else
+    {
+        return EMATERIAL_ROCK;
+    }
+}
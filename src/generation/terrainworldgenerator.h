@@ -0,0 +1,77 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_TERRAIN_WORLD_GENERATION_H
+#define SCOTT_CUBEWORLD_TERRAIN_WORLD_GENERATION_H
+
+#include "generation/columnworldgenerator.h"
+#include "engine/cubedata.h"
+#include "math/perlin.h"
+
+#include <vector>
+
+class World;
+class WorldView;
+
+/**
+ * Creates rolling hills from a noise heightmap. Every column of the world
+ * is bedrock at the bottom, rock up to a few cubes below the surface and
+ * then dirt topped off with grass. Columns near or below sea level are
+ * capped with sand instead of grass, and water fills everything between
+ * the ground and sea level.
+ *
+ * Each column's heightmap is filled in a single batched noise evaluation,
+ * and each chunk in the column is built in a scratch buffer and then
+ * written to the world in one bulk copy.
+ *
+ * The same seed always generates the same world.
+ */
+class TerrainWorldGenerator : public ColumnWorldGenerator
+{
+public:
+    TerrainWorldGenerator( unsigned int seed, unsigned int threadCount = 0 );
+    ~TerrainWorldGenerator();
+
+    // Height (y) of the water's surface, only valid after generate
+    unsigned int seaLevel() const;
+
+    // Write generated chunks with World::put one cube at a time rather
+    // than with World::putChunk. Only useful to measure the difference,
+    // and always generates on a single thread
+    void setBulkWritesEnabled( bool isEnabled );
+
+protected:
+    virtual void prepare( World& world );
+
+    virtual void generateColumn( World& world,
+                                 unsigned int chunkX,
+                                 unsigned int chunkZ,
+                                 unsigned int seed,
+                                 std::vector<CubeData>& cubes ) const;
+
+    virtual bool isParallel() const;
+
+private:
+    EMaterialType materialAt( unsigned int y, unsigned int height ) const;
+
+private:
+    PerlinNoise mNoise;
+    unsigned int mSeaLevel;
+    unsigned int mBaseHeight;
+    unsigned int mHillHeight;
+    bool mIsUsingBulkWrites;
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "graphics/chunkconnectivity.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubeface.h"
+#include "engine/material.h"
+
+#include <cassert>
+#include <vector>
+#include <stdint.h>
+
+namespace
+{
+    // Bit set for all 15 face pairs
+    const uint16_t ALL_FACE_PAIRS = 0x7FFF;
+
+    /**
+     * Maps a pair of faces onto one of the 15 unique face pair bits. Faces
+     * are never connected to themselves, which is marked with a -1.
+     */
+    const int FACE_PAIR_BIT[ECUBEFACE_COUNT][ECUBEFACE_COUNT] =
+    {
+        { -1,  0,  1,  2,  3,  4 },
+        {  0, -1,  5,  6,  7,  8 },
+        {  1,  5, -1,  9, 10, 11 },
+        {  2,  6,  9, -1, 12, 13 },
+        {  3,  7, 10, 12, -1, 14 },
+        {  4,  8, 11, 13, 14, -1 }
+    };
+}
+
+ChunkConnectivity::ChunkConnectivity()
+    : mFacePairs( ALL_FACE_PAIRS )
+{
+}
+
+ChunkConnectivity ChunkConnectivity::closed()
+{
+    ChunkConnectivity c;
+    c.mFacePairs = 0;
+
+    return c;
+}
+
+/**
+ * Computes face connectivity for a chunk by flood filling each pocket of
+ * empty cubes in turn, and connecting every chunk face that the pocket
+ * touches. This is too slow to run per frame, but is cheap enough to run
+ * whenever the chunk is remeshed. Translucent cubes can be seen through, so
+ * they count as empty.
+ *
+ * \param  chunk  The chunk to examine
+ */
+ChunkConnectivity ChunkConnectivity::build( const WorldChunk& chunk )
+{
+    ChunkConnectivityScratch scratch;
+    return build( chunk, scratch );
+}
+
+/**
+ * Computes face connectivity for a chunk, see above. The flood fill's
+ * buffers are kept in scratch, which only allocates the first time it is
+ * used.
+ *
+ * \param  chunk    The chunk to examine
+ * \param  scratch  Memory for the flood fill to work in
+ */
+ChunkConnectivity ChunkConnectivity::build( const WorldChunk& chunk,
+                                            ChunkConnectivityScratch& scratch )
+{
+    const int COLS  = static_cast<int>( WorldChunk::TOTAL_COLS );
+    const int ROWS  = static_cast<int>( WorldChunk::TOTAL_ROWS );
+    const int DEPTH = static_cast<int>( WorldChunk::TOTAL_DEPTH );
+    const int TOTAL = static_cast<int>( WorldChunk::TOTAL_CUBES );
+
+    const CubeData * pCubes = chunk.cubes();
+    ChunkConnectivity result = ChunkConnectivity::closed();
+
+    // Cubes that have already been filled (or are solid). Solid cubes are
+    // marked up front so the fill only needs a single test per neighbor
+    std::vector<uint8_t>& visited = scratch.visited;
+    visited.assign( TOTAL, 0 );
+
+    unsigned int emptyCount = 0;
+
+    for ( int i = 0; i < TOTAL; ++i )
+    {
+        if ( pCubes[i].isEmpty() ||
+             Util::IsTranslucent( pCubes[i].materialType() ) )
+        {
+            emptyCount++;
+        }
+        else
+        {
+            visited[i] = 1;
+        }
+    }
+
+    // Quick outs for the common all air and all rock cases
+    if ( emptyCount == 0 )
+    {
+        return result;
+    }
+    else if ( emptyCount == static_cast<unsigned int>( TOTAL ) )
+    {
+        return ChunkConnectivity();
+    }
+
+    // Offsets to a cube's neighbor, in ECubeFace order
+    const int STEP[ECUBEFACE_COUNT] =
+    {
+        1, -1, COLS, -COLS, COLS * ROWS, -COLS * ROWS
+    };
+
+    std::vector<int>& stack = scratch.stack;
+    stack.clear();
+    stack.reserve( TOTAL );
+
+    for ( int start = 0; start < TOTAL; ++start )
+    {
+        if ( visited[start] )
+        {
+            continue;
+        }
+
+        // Flood fill this pocket of air, keeping track of every chunk face
+        // that it touches
+        unsigned int touchedFaces = 0;
+
+        visited[start] = 1;
+        stack.push_back( start );
+
+        while (! stack.empty() )
+        {
+            int index = stack.back();
+            stack.pop_back();
+
+            int x = index % COLS;
+            int y = ( index / COLS ) % ROWS;
+            int z = index / ( COLS * ROWS );
+
+            // Which directions can we travel in without leaving the chunk?
+            bool inside[ECUBEFACE_COUNT] =
+            {
+                x < COLS - 1,  x > 0,
+                y < ROWS - 1,  y > 0,
+                z < DEPTH - 1, z > 0
+            };
+
+            for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+            {
+                if (! inside[f] )
+                {
+                    touchedFaces |= ( 1u << f );
+                }
+                else if (! visited[ index + STEP[f] ] )
+                {
+                    visited[ index + STEP[f] ] = 1;
+                    stack.push_back( index + STEP[f] );
+                }
+            }
+        }
+
+        result.connectAll( touchedFaces );
+
+        // No need to keep going once everything can see everything
+        if ( result.isFullyOpen() )
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+bool ChunkConnectivity::isConnected( ECubeFace a, ECubeFace b ) const
+{
+    assert( a < ECUBEFACE_COUNT && b < ECUBEFACE_COUNT );
+
+    if ( a == b )
+    {
+        return true;
+    }
+
+    return ( mFacePairs & ( 1u << FACE_PAIR_BIT[a][b] ) ) != 0;
+}
+
+void ChunkConnectivity::connect( ECubeFace a, ECubeFace b )
+{
+    assert( a < ECUBEFACE_COUNT && b < ECUBEFACE_COUNT );
+
+    if ( a != b )
+    {
+        mFacePairs = static_cast<uint16_t>(
+                mFacePairs | ( 1u << FACE_PAIR_BIT[a][b] ) );
+    }
+}
+
+void ChunkConnectivity::connectAll( unsigned int faceMask )
+{
+    for ( int a = 0; a < ECUBEFACE_COUNT; ++a )
+    {
+        if ( ( faceMask & ( 1u << a ) ) == 0 )
+        {
+            continue;
+        }
+
+        for ( int b = a + 1; b < ECUBEFACE_COUNT; ++b )
+        {
+            if ( faceMask & ( 1u << b ) )
+            {
+                connect( static_cast<ECubeFace>( a ),
+                         static_cast<ECubeFace>( b ) );
+            }
+        }
+    }
+}
+
+bool ChunkConnectivity::isFullyOpen() const
+{
+    return mFacePairs == ALL_FACE_PAIRS;
+}
+
+bool ChunkConnectivity::isFullyClosed() const
+{
+    return mFacePairs == 0;
+}
+
+bool ChunkConnectivity::operator == ( const ChunkConnectivity& rhs ) const
+{
+    return mFacePairs == rhs.mFacePairs;
+}
+
+bool ChunkConnectivity::operator != ( const ChunkConnectivity& rhs ) const
+{
+    return mFacePairs != rhs.mFacePairs;
+}
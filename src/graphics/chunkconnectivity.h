@@ -0,0 +1,80 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CHUNK_CONNECTIVITY_H
+#define SCOTT_CUBEWORLD_CHUNK_CONNECTIVITY_H
+
+#include <stdint.h>
+#include <vector>
+#include "engine/cubeface.h"
+
+class WorldChunk;
+
+/**
+ * Working memory for ChunkConnectivity::build. Keeping one around between
+ * builds saves allocating it again for every chunk
+ */
+struct ChunkConnectivityScratch
+{
+    std::vector<uint8_t> visited;
+    std::vector<int> stack;
+};
+
+/**
+ * Records which pairs of a chunk's six faces can see each other through the
+ * chunk's empty cubes. Two faces are connected if a flood fill of empty space
+ * that touches one face also touches the other. The visibility culler walks
+ * these connections to find chunks that can not be seen through solid rock.
+ */
+class ChunkConnectivity
+{
+public:
+    // Creates a connectivity set where every face sees every other face
+    ChunkConnectivity();
+
+    // Flood fills the chunk's empty space to find connected faces
+    static ChunkConnectivity build( const WorldChunk& chunk );
+
+    // Same as above, working in the given scratch memory
+    static ChunkConnectivity build( const WorldChunk& chunk,
+                                    ChunkConnectivityScratch& scratch );
+
+    // Creates a connectivity set where no faces are connected
+    static ChunkConnectivity closed();
+
+    // Check if a ray can enter from face a and leave through face b
+    bool isConnected( ECubeFace a, ECubeFace b ) const;
+
+    // Mark face a and face b as connected
+    void connect( ECubeFace a, ECubeFace b );
+
+    // Mark all of the faces in the bitmask as being connected to each other
+    void connectAll( unsigned int faceMask );
+
+    // Check if every face can see every other face
+    bool isFullyOpen() const;
+
+    // Check if no face can see any other face
+    bool isFullyClosed() const;
+
+    bool operator == ( const ChunkConnectivity& rhs ) const;
+    bool operator != ( const ChunkConnectivity& rhs ) const;
+
+private:
+    // One bit for each of the 15 unique face pairs
+    uint16_t mFacePairs;
+};
+
+#endif
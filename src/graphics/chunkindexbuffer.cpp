@@ -0,0 +1,95 @@
+#include "graphics/chunkindexbuffer.h"
+
+const size_t ChunkIndexBuffer::MAX_16BIT_VERTICES = 65536;
+
+ChunkIndexBuffer::ChunkIndexBuffer()
+    : mShortIndices(),
+      mLongIndices(),
+      mIs16Bit( true )
+{
+}
+
+/**
+ * Empties the buffer without giving up its memory
+ */
+void ChunkIndexBuffer::clear()
+{
+    mShortIndices.clear();
+    mLongIndices.clear();
+    mIs16Bit = true;
+}
+
+size_t ChunkIndexBuffer::size() const
+{
+    return mIs16Bit ? mShortIndices.size() : mLongIndices.size();
+}
+
+bool ChunkIndexBuffer::empty() const
+{
+    return size() == 0;
+}
+
+unsigned int ChunkIndexBuffer::operator [] ( size_t index ) const
+{
+    return mIs16Bit ? mShortIndices[index] : mLongIndices[index];
+}
+
+bool ChunkIndexBuffer::is16Bit() const
+{
+    return mIs16Bit;
+}
+
+size_t ChunkIndexBuffer::indexSize() const
+{
+    return mIs16Bit ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+size_t ChunkIndexBuffer::byteSize() const
+{
+    return size() * indexSize();
+}
+
+size_t ChunkIndexBuffer::capacityBytes() const
+{
+    return mShortIndices.capacity() * sizeof(uint16_t) +
+           mLongIndices.capacity()  * sizeof(uint32_t);
+}
+
+const void * ChunkIndexBuffer::data() const
+{
+    if ( mIs16Bit )
+    {
+        return mShortIndices.data();
+    }
+    else
+    {
+        return mLongIndices.data();
+    }
+}
+
+/**
+ * Buffers are equal when they hold the same indices, regardless of how wide
+ * each one is stored
+ */
+bool ChunkIndexBuffer::operator == ( const ChunkIndexBuffer& other ) const
+{
+    if ( size() != other.size() )
+    {
+        return false;
+    }
+
+    for ( size_t i = 0; i < size(); ++i )
+    {
+        if ( (*this)[i] != other[i] )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ChunkIndexBuffer::operator != ( const ChunkIndexBuffer& other ) const
+{
+    return !( *this == other );
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CHUNK_INDEX_BUFFER_H
+#define SCOTT_CUBEWORLD_CHUNK_INDEX_BUFFER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Triangle indices for a chunk mesh, stored as 16 bit values whenever every
+ * vertex they refer to can be addressed that way and as 32 bit values
+ * otherwise. Almost every section fits in 16 bits, halving the memory taken
+ * by its indices and the bandwidth spent fetching them when drawn.
+ *
+ * Both of the underlying vectors keep their capacity when the buffer is
+ * cleared or reassigned, so reusing a buffer stops allocating once it has
+ * grown to fit.
+ */
+class ChunkIndexBuffer
+{
+public:
+    ChunkIndexBuffer();
+
+    // Largest vertex count that can be indexed with 16 bits
+    const static size_t MAX_16BIT_VERTICES;
+
+    // Replace the contents with count indices into a vertex list holding
+    // vertexCount vertices
+    template<typename T>
+    void assign( const T * pIndices, size_t count, size_t vertexCount );
+
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+
+    unsigned int operator [] ( size_t index ) const;
+
+    // Check if the indices are stored using 16 bits each
+    bool is16Bit() const;
+
+    // Bytes taken by each index, either two or four
+    size_t indexSize() const;
+
+    // Bytes taken by all of the indices
+    size_t byteSize() const;
+
+    // Bytes both vectors have room for, including what they aren't using
+    size_t capacityBytes() const;
+
+    // Raw index data, indexSize() bytes per index
+    const void * data() const;
+
+    bool operator == ( const ChunkIndexBuffer& other ) const;
+    bool operator != ( const ChunkIndexBuffer& other ) const;
+
+private:
+    std::vector<uint16_t> mShortIndices;
+    std::vector<uint32_t> mLongIndices;
+    bool mIs16Bit;
+};
+
+/**
+ * Copies the indices in, narrowing them to 16 bits when the vertex count
+ * allows it.
+ *
+ * \param  pIndices     Indices to copy
+ * \param  count        Number of indices
+ * \param  vertexCount  Size of the vertex list the indices refer to
+ */
+template<typename T>
+void ChunkIndexBuffer::assign( const T * pIndices,
+                               size_t count,
+                               size_t vertexCount )
+{
+    mShortIndices.clear();
+    mLongIndices.clear();
+    mIs16Bit = ( vertexCount <= MAX_16BIT_VERTICES );
+
+    if ( mIs16Bit )
+    {
+        mShortIndices.resize( count );
+
+        for ( size_t i = 0; i < count; ++i )
+        {
+            mShortIndices[i] = static_cast<uint16_t>( pIndices[i] );
+        }
+    }
+    else
+    {
+        mLongIndices.assign( pIndices, pIndices + count );
+    }
+}
+
+#endif
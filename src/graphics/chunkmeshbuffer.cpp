@@ -0,0 +1,205 @@
+#include "graphics/chunkmeshbuffer.h"
+#include "graphics/worldchunkmesh.h"
+
+#include <cassert>
+#include <mutex>
+#include <utility>
+
+const size_t ChunkMeshBufferPool::DEFAULT_MAX_FREE_COUNT = 4;
+const size_t ChunkMeshBufferPool::DEFAULT_MAX_MESH_BYTES = 512 * 1024;
+
+namespace
+{
+    /**
+     * Memory held by a mesh, whether or not it is in use
+     */
+    size_t capacityBytes( const WorldChunkMesh& mesh )
+    {
+        return mesh.vertices.capacity() * sizeof(CubeVertex) +
+               mesh.packedVertices.capacity() * sizeof(PackedCubeVertex) +
+               mesh.indices.capacityBytes() +
+               mesh.translucentIndices.capacityBytes();
+    }
+}
+
+ChunkMeshBuffer::ChunkMeshBuffer()
+    : mpMesh( NULL ),
+      mpPool( NULL )
+{
+}
+
+ChunkMeshBuffer::ChunkMeshBuffer( WorldChunkMesh * pMesh,
+                                  ChunkMeshBufferPool * pPool )
+    : mpMesh( pMesh ),
+      mpPool( pPool )
+{
+}
+
+ChunkMeshBuffer::ChunkMeshBuffer( ChunkMeshBuffer&& other )
+    : mpMesh( other.mpMesh ),
+      mpPool( other.mpPool )
+{
+    other.mpMesh = NULL;
+    other.mpPool = NULL;
+}
+
+ChunkMeshBuffer& ChunkMeshBuffer::operator = ( ChunkMeshBuffer&& other )
+{
+    if ( this != &other )
+    {
+        reset();
+
+        mpMesh = other.mpMesh;
+        mpPool = other.mpPool;
+
+        other.mpMesh = NULL;
+        other.mpPool = NULL;
+    }
+
+    return *this;
+}
+
+ChunkMeshBuffer::~ChunkMeshBuffer()
+{
+    reset();
+}
+
+void ChunkMeshBuffer::reset()
+{
+    if ( mpMesh == NULL )
+    {
+        return;
+    }
+    else if ( mpPool != NULL )
+    {
+        mpPool->release( mpMesh );
+    }
+    else
+    {
+        delete mpMesh;
+    }
+
+    mpMesh = NULL;
+    mpPool = NULL;
+}
+
+bool ChunkMeshBuffer::isEmpty() const
+{
+    return mpMesh == NULL;
+}
+
+WorldChunkMesh& ChunkMeshBuffer::operator * () const
+{
+    assert( mpMesh != NULL );
+    return *mpMesh;
+}
+
+WorldChunkMesh * ChunkMeshBuffer::operator -> () const
+{
+    assert( mpMesh != NULL );
+    return mpMesh;
+}
+
+WorldChunkMesh * ChunkMeshBuffer::get() const
+{
+    return mpMesh;
+}
+
+ChunkMeshBufferPool::ChunkMeshBufferPool( size_t maxFreeCount,
+                                          size_t maxMeshBytes )
+    : mLock(),
+      mFree(),
+      mMaxFreeCount( maxFreeCount ),
+      mMaxMeshBytes( maxMeshBytes ),
+      mCreatedCount( 0 ),
+      mDeletedCount( 0 )
+{
+    mFree.reserve( maxFreeCount );
+}
+
+ChunkMeshBufferPool::~ChunkMeshBufferPool()
+{
+    // Every buffer should have come back by now
+    assert( mFree.size() + mDeletedCount == mCreatedCount );
+
+    for ( size_t i = 0; i < mFree.size(); ++i )
+    {
+        delete mFree[i];
+    }
+}
+
+/**
+ * Hands out a mesh with no geometry in it. Meshes that have been used before
+ * are preferred, since their vectors have already grown
+ */
+ChunkMeshBuffer ChunkMeshBufferPool::acquire()
+{
+    WorldChunkMesh * pMesh = NULL;
+
+    {
+        std::lock_guard<std::mutex> lock( mLock );
+
+        if (! mFree.empty() )
+        {
+            pMesh = mFree.back();
+            mFree.pop_back();
+        }
+        else
+        {
+            mCreatedCount++;
+        }
+    }
+
+    if ( pMesh == NULL )
+    {
+        pMesh = new WorldChunkMesh();
+    }
+
+    pMesh->vertices.clear();
+    pMesh->packedVertices.clear();
+    pMesh->indices.clear();
+    pMesh->translucentIndices.clear();
+
+    return ChunkMeshBuffer( pMesh, this );
+}
+
+/**
+ * Takes a mesh back, keeping it for reuse unless the pool is full or the
+ * mesh has grown too large to be worth holding on to
+ */
+void ChunkMeshBufferPool::release( WorldChunkMesh * pMesh )
+{
+    const bool isTooLarge = capacityBytes( *pMesh ) > mMaxMeshBytes;
+
+    {
+        std::lock_guard<std::mutex> lock( mLock );
+
+        if (! isTooLarge && mFree.size() < mMaxFreeCount )
+        {
+            mFree.push_back( pMesh );
+            return;
+        }
+
+        mDeletedCount++;
+    }
+
+    delete pMesh;
+}
+
+size_t ChunkMeshBufferPool::freeCount() const
+{
+    std::lock_guard<std::mutex> lock( mLock );
+    return mFree.size();
+}
+
+size_t ChunkMeshBufferPool::createdCount() const
+{
+    std::lock_guard<std::mutex> lock( mLock );
+    return mCreatedCount;
+}
+
+size_t ChunkMeshBufferPool::deletedCount() const
+{
+    std::lock_guard<std::mutex> lock( mLock );
+    return mDeletedCount;
+}
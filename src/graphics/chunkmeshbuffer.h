@@ -0,0 +1,114 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CHUNK_MESH_BUFFER_H
+#define SCOTT_CUBEWORLD_CHUNK_MESH_BUFFER_H
+
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+struct WorldChunkMesh;
+class ChunkMeshBufferPool;
+
+/**
+ * Move only handle to a chunk mesh. Handing a buffer on moves the pointer,
+ * never the vertices, so a finished mesh travels from the worker that built
+ * it to the renderer without being copied.
+ *
+ * Buffers taken from a ChunkMeshBufferPool go back to the pool when the
+ * handle is destroyed, keeping the memory their vectors have grown into if
+ * the pool holds on to them.
+ */
+class ChunkMeshBuffer
+{
+public:
+    // Creates an empty handle
+    ChunkMeshBuffer();
+
+    // Takes ownership of a mesh, which is returned to the pool if given one
+    // and deleted otherwise
+    explicit ChunkMeshBuffer( WorldChunkMesh * pMesh,
+                              ChunkMeshBufferPool * pPool = NULL );
+
+    ChunkMeshBuffer( ChunkMeshBuffer&& other );
+    ChunkMeshBuffer& operator = ( ChunkMeshBuffer&& other );
+    ~ChunkMeshBuffer();
+
+    // Give the mesh back (to the pool, if it came from one) and become empty
+    void reset();
+
+    // Check if the handle holds a mesh
+    bool isEmpty() const;
+
+    WorldChunkMesh& operator * () const;
+    WorldChunkMesh * operator -> () const;
+    WorldChunkMesh * get() const;
+
+private:
+    WorldChunkMesh * mpMesh;
+    ChunkMeshBufferPool * mpPool;   // Not owned, NULL if the mesh isn't pooled
+};
+
+/**
+ * Recycles chunk meshes between builds. Meshes are cleared when they are
+ * handed out but their vectors keep their capacity, so once every pooled
+ * mesh has grown to fit the sections being meshed no more memory is
+ * allocated. Safe to use from any thread, and must outlive its buffers.
+ *
+ * Only a few meshes are kept for reuse, enough for the ones being built at
+ * once. Meshes given back past that, or whose vectors have grown past a
+ * size limit, are deleted so that a burst of loading doesn't leave every
+ * section's peak memory held by the pool.
+ */
+class ChunkMeshBufferPool : boost::noncopyable
+{
+public:
+    // Meshes kept for reuse and the memory each may hold, unless told
+    // otherwise
+    const static size_t DEFAULT_MAX_FREE_COUNT;
+    const static size_t DEFAULT_MAX_MESH_BYTES;
+
+    explicit ChunkMeshBufferPool( size_t maxFreeCount = DEFAULT_MAX_FREE_COUNT,
+                                  size_t maxMeshBytes = DEFAULT_MAX_MESH_BYTES );
+    ~ChunkMeshBufferPool();
+
+    // Take an empty mesh from the pool, or create one if none are free
+    ChunkMeshBuffer acquire();
+
+    // Number of meshes waiting in the pool
+    size_t freeCount() const;
+
+    // Number of meshes the pool has created
+    size_t createdCount() const;
+
+    // Number of meshes deleted when given back instead of kept
+    size_t deletedCount() const;
+
+private:
+    friend class ChunkMeshBuffer;
+    void release( WorldChunkMesh * pMesh );
+
+private:
+    mutable std::mutex mLock;
+    std::vector<WorldChunkMesh*> mFree;
+    size_t mMaxFreeCount;
+    size_t mMaxMeshBytes;   // Capacity of all of a mesh's vectors together
+    size_t mCreatedCount;
+    size_t mDeletedCount;
+};
+
+#endif
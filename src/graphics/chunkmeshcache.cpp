@@ -0,0 +1,386 @@
+#include "graphics/chunkmeshcache.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubeface.h"
+#include <string/crc.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    const uint64_t HASH_PRIME  = 0x100000001b3ULL;
+    const uint64_t CHECK_PRIME = 0x9e3779b97f4a7c15ULL;
+
+    /**
+     * Two independent hashes of the same input. The main hash runs the
+     * cubes through crc32, the check hash reads them eight bytes at a time
+     * with a multiply and rotate, so a collision in one is very unlikely
+     * to also be a collision in the other
+     */
+    struct KeyHash
+    {
+        KeyHash()
+            : hash( 0xcbf29ce484222325ULL ),
+              check( 0x84222325cbf29ce4ULL )
+        {
+        }
+
+        /**
+         * Folds a 32 bit value into both hashes
+         */
+        void addValue( uint32_t value )
+        {
+            hash  = ( hash ^ value ) * HASH_PRIME;
+            check = mixCheck( check, value );
+        }
+
+        /**
+         * Folds a run of cubes into both hashes
+         */
+        void addCubes( const CubeData * pCubes, size_t count )
+        {
+            const uint8_t * pBytes = reinterpret_cast<const uint8_t*>( pCubes );
+            const size_t byteCount = count * sizeof(CubeData);
+
+            hash = ( hash ^ crc32( pBytes, byteCount ) ) * HASH_PRIME;
+
+            size_t i = 0;
+
+            for ( ; i + sizeof(uint64_t) <= byteCount; i += sizeof(uint64_t) )
+            {
+                uint64_t word = 0;
+                std::memcpy( &word, pBytes + i, sizeof(uint64_t) );
+
+                check = mixCheck( check, word );
+            }
+
+            uint64_t tail = byteCount;
+
+            for ( ; i < byteCount; ++i )
+            {
+                tail = ( tail << 8 ) | pBytes[i];
+            }
+
+            check = mixCheck( check, tail );
+        }
+
+        static uint64_t mixCheck( uint64_t check, uint64_t value )
+        {
+            check ^= value * CHECK_PRIME;
+            check  = ( check << 27 ) | ( check >> 37 );
+            return check * 5 + 0x52dce729;
+        }
+
+        uint64_t hash;
+        uint64_t check;
+    };
+
+    /**
+     * Hashes the layer of a neighboring chunk that touches the given face of
+     * the section running from zBegin to zEnd. Each row of the layer is
+     * hashed where it lies in the chunk, so nothing needs to be copied
+     */
+    void hashBorder( KeyHash& hash,
+                     const WorldChunk& neighbor,
+                     ECubeFace face,
+                     unsigned int zBegin,
+                     unsigned int zEnd,
+                     unsigned int thickness )
+    {
+        const unsigned int COLS  = WorldChunk::TOTAL_COLS;
+        const unsigned int ROWS  = WorldChunk::TOTAL_ROWS;
+        const unsigned int DEPTH = WorldChunk::TOTAL_DEPTH;
+        const CubeData * pCubes  = neighbor.cubes();
+
+        unsigned int first[3] = { 0, 0, zBegin };
+        unsigned int last[3]  = { COLS, ROWS, zEnd };
+        const unsigned int size[3] = { COLS, ROWS, DEPTH };
+        const int axis = CubeFace::axis( face );
+
+        // The neighbor on the positive side shows its first slices
+        first[axis] = CubeFace::direction( face ) > 0 ? 0 : size[axis] - thickness;
+        last[axis]  = first[axis] + thickness;
+
+        for ( unsigned int z = first[2]; z < last[2]; ++z )
+        {
+            for ( unsigned int y = first[1]; y < last[1]; ++y )
+            {
+                hash.addCubes( pCubes + ( z * ROWS + y ) * COLS + first[0],
+                               last[0] - first[0] );
+            }
+        }
+    }
+}
+
+bool ChunkMeshKey::operator == ( const ChunkMeshKey& rhs ) const
+{
+    return hash == rhs.hash && check == rhs.check && section == rhs.section &&
+           mode == rhs.mode && lod == rhs.lod &&
+           isOptimized == rhs.isOptimized && isPacked == rhs.isPacked;
+}
+
+bool ChunkMeshKey::operator < ( const ChunkMeshKey& rhs ) const
+{
+    if ( hash != rhs.hash )
+    {
+        return hash < rhs.hash;
+    }
+    else if ( check != rhs.check )
+    {
+        return check < rhs.check;
+    }
+    else if ( section != rhs.section )
+    {
+        return section < rhs.section;
+    }
+    else if ( mode != rhs.mode )
+    {
+        return mode < rhs.mode;
+    }
+    else if ( lod != rhs.lod )
+    {
+        return lod < rhs.lod;
+    }
+    else if ( isOptimized != rhs.isOptimized )
+    {
+        return isOptimized < rhs.isOptimized;
+    }
+    else
+    {
+        return isPacked < rhs.isPacked;
+    }
+}
+
+float ChunkMeshCacheStats::hitRate() const
+{
+    const size_t lookups = hits + misses;
+    return lookups > 0 ? static_cast<float>( hits ) / lookups : 0.0f;
+}
+
+ChunkMeshCache::ChunkMeshCache( size_t capacity )
+    : mLock(),
+      mEntries(),
+      mLookup(),
+      mStats()
+{
+    mStats.capacity = capacity;
+}
+
+/**
+ * Hashes everything the mesher reads when building a section: the section's
+ * own cubes, the slice on either side of it, and the border slices of the
+ * neighboring chunks, reaching a slice past the section along z for ambient
+ * occlusion. Missing neighbors hash differently from empty ones.
+ *
+ * Only hashes are kept, not the cubes themselves, so two different inputs
+ * that hash the same will share a mesh. To make that unlikely enough to
+ * ignore the key holds two independent 64 bit hashes of everything, one
+ * built on crc32 and one on a word at a time multiply, and both have to
+ * match for a hit. A collision can't be ruled out, only made very rare.
+ *
+ * Downsampled sections read a whole layer of cells around them instead of a
+ * single slice, so the layers hashed are as thick as a cell.
+ *
+ * \param  chunk        Chunk and neighbors to hash
+ * \param  section      Section of the chunk that will be meshed
+ * \param  mode         Meshing mode, different modes produce different meshes
+ * \param  lod          Level of detail the section is meshed at
+ * \param  isOptimized  Mesh is welded and ordered for the vertex cache
+ * \param  isPacked     Mesh keeps its vertices packed
+ * \return Key for the section mesh
+ */
+ChunkMeshKey ChunkMeshCache::makeKey( const ChunkNeighborhood& chunk,
+                                      unsigned int section,
+                                      EMeshingMode mode,
+                                      unsigned int lod,
+                                      bool isOptimized,
+                                      bool isPacked )
+{
+    assert( chunk.pChunk != NULL );
+    assert( section < WorldChunk::SECTION_COUNT );
+
+    const unsigned int SLICE  = WorldChunk::TOTAL_COLS * WorldChunk::TOTAL_ROWS;
+    const unsigned int DEPTH  = WorldChunk::TOTAL_DEPTH;
+    const unsigned int zBegin = section * WorldChunk::SECTION_DEPTH;
+    const unsigned int zEnd   = zBegin + WorldChunk::SECTION_DEPTH;
+    const unsigned int layer  = 1u << lod;
+
+    // The section, plus the layers just outside of it when they are in
+    // this chunk
+    const unsigned int first = zBegin > 0 ? zBegin - layer : 0;
+    const unsigned int last  = zEnd < DEPTH ? zEnd + layer : zEnd;
+
+    KeyHash hash;
+    hash.addCubes( chunk.pChunk->cubes() + first * SLICE, ( last - first ) * SLICE );
+
+    const uint32_t * pRows = chunk.pChunk->occupancy() +
+                             first * WorldChunk::TOTAL_ROWS;
+    const unsigned int rowCount = ( last - first ) * WorldChunk::TOTAL_ROWS;
+
+    for ( unsigned int i = 0; i < rowCount; ++i )
+    {
+        hash.addValue( pRows[i] );
+    }
+
+    // Ambient occlusion of faces on the section's first and last slices
+    // looks one slice further along z, which in the neighbors along x and y
+    // is outside of the section's own depth. Downsampled sections don't
+    // have ambient occlusion
+    const unsigned int margin = ( lod == 0 ? 1 : 0 );
+    const unsigned int borderBegin = zBegin > margin ? zBegin - margin : 0;
+    const unsigned int borderEnd   = std::min( zEnd + margin, DEPTH );
+
+    // Border slices of the neighboring chunks. Along z only the sections at
+    // either end of the chunk touch a neighbor
+    for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+    {
+        const ECubeFace face = static_cast<ECubeFace>( f );
+        const WorldChunk * pNeighbor = chunk.pNeighbors[f];
+
+        if ( face == ECUBEFACE_POS_Z && zEnd != DEPTH )
+        {
+            continue;
+        }
+        else if ( face == ECUBEFACE_NEG_Z && zBegin != 0 )
+        {
+            continue;
+        }
+        else if ( pNeighbor == NULL )
+        {
+            hash.addValue( 0xffffffffu - f );
+            continue;
+        }
+
+        const bool isZ = ( CubeFace::axis( face ) == 2 );
+
+        hashBorder( hash,
+                    *pNeighbor,
+                    face,
+                    isZ ? 0 : borderBegin,
+                    isZ ? DEPTH : borderEnd,
+                    layer );
+    }
+
+    ChunkMeshKey key;
+    key.hash    = hash.hash;
+    key.check   = hash.check;
+    key.section = section;
+    key.mode    = mode;
+    key.lod     = lod;
+    key.isOptimized = isOptimized;
+    key.isPacked    = isPacked;
+
+    return key;
+}
+
+/**
+ * Looks up a mesh, marking it as the most recently used one. Both of the
+ * key's hashes must match, see makeKey for how likely a false hit is
+ */
+std::shared_ptr<const WorldChunkMesh> ChunkMeshCache::find( const ChunkMeshKey& key )
+{
+    std::lock_guard<std::mutex> lock( mLock );
+    std::map<ChunkMeshKey, EntryList::iterator>::iterator itr = mLookup.find( key );
+
+    if ( itr == mLookup.end() )
+    {
+        mStats.misses++;
+        return std::shared_ptr<const WorldChunkMesh>();
+    }
+
+    mEntries.splice( mEntries.begin(), mEntries, itr->second );
+    mStats.hits++;
+
+    return itr->second->pMesh;
+}
+
+/**
+ * Stores a copy of a mesh. Meshes that are larger than the whole cache are
+ * not stored
+ */
+void ChunkMeshCache::insert( const ChunkMeshKey& key, const WorldChunkMesh& mesh )
+{
+    const size_t bytes = meshBytes( mesh );
+    std::lock_guard<std::mutex> lock( mLock );
+
+    if ( bytes > mStats.capacity || mLookup.find( key ) != mLookup.end() )
+    {
+        return;
+    }
+
+    evict( mStats.capacity - bytes );
+
+    Entry entry;
+    entry.key   = key;
+    entry.pMesh = std::make_shared<WorldChunkMesh>( mesh );
+    entry.bytes = bytes;
+
+    mEntries.push_front( entry );
+    mLookup[key] = mEntries.begin();
+
+    mStats.entryCount++;
+    mStats.byteCount += bytes;
+}
+
+void ChunkMeshCache::setCapacity( size_t capacity )
+{
+    std::lock_guard<std::mutex> lock( mLock );
+
+    mStats.capacity = capacity;
+    evict( capacity );
+}
+
+void ChunkMeshCache::clear()
+{
+    std::lock_guard<std::mutex> lock( mLock );
+
+    mEntries.clear();
+    mLookup.clear();
+
+    mStats.entryCount = 0;
+    mStats.byteCount  = 0;
+}
+
+ChunkMeshCacheStats ChunkMeshCache::stats() const
+{
+    std::lock_guard<std::mutex> lock( mLock );
+    return mStats;
+}
+
+/**
+ * Memory charged to the cache for holding a mesh. Includes the mesh itself so
+ * that empty meshes still take up room and get evicted
+ */
+size_t ChunkMeshCache::meshBytes( const WorldChunkMesh& mesh )
+{
+    return sizeof(WorldChunkMesh) +
+           mesh.vertexCount() * mesh.vertexSize() +
+           mesh.indices.byteSize() +
+           mesh.translucentIndices.byteSize();
+}
+
+/**
+ * Throws away the least recently used meshes until the cache holds no more
+ * than the given number of bytes. The lock must be held
+ */
+void ChunkMeshCache::evict( size_t capacity )
+{
+    while ( mStats.byteCount > capacity )
+    {
+        assert( !mEntries.empty() );
+        const Entry& oldest = mEntries.back();
+
+        mStats.byteCount -= oldest.bytes;
+        mStats.entryCount--;
+        mStats.evictions++;
+
+        mLookup.erase( oldest.key );
+        mEntries.pop_back();
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CHUNK_MESH_CACHE_H
+#define SCOTT_CUBEWORLD_CHUNK_MESH_CACHE_H
+
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+
+/**
+ * Identifies the input of a section mesh: the cubes of the section, the
+ * slices around it that decide which of its faces are hidden, the section
+ * index, the meshing mode, the level of detail, whether the mesh is
+ * optimized for the vertex cache and whether its vertices are packed. The cubes are only hashed, by two
+ * independent 64 bit hashes, so different sections could in principle share
+ * a key, but the odds of both hashes colliding are negligible.
+ */
+struct ChunkMeshKey
+{
+    ChunkMeshKey()
+        : hash( 0 ),
+          check( 0 ),
+          section( 0 ),
+          mode( EMESHING_CULLED ),
+          lod( 0 ),
+          isOptimized( false ),
+          isPacked( false )
+    {
+    }
+
+    bool operator == ( const ChunkMeshKey& rhs ) const;
+    bool operator <  ( const ChunkMeshKey& rhs ) const;
+
+    uint64_t hash;      // crc32 based
+    uint64_t check;     // Independent of hash, see ChunkMeshCache::makeKey
+    unsigned int section;
+    EMeshingMode mode;
+    unsigned int lod;
+    bool isOptimized;
+    bool isPacked;
+};
+
+/**
+ * Mesh cache counters
+ */
+struct ChunkMeshCacheStats
+{
+    ChunkMeshCacheStats()
+        : hits( 0 ),
+          misses( 0 ),
+          evictions( 0 ),
+          entryCount( 0 ),
+          byteCount( 0 ),
+          capacity( 0 )
+    {
+    }
+
+    // Fraction of lookups that found a mesh, zero if there were none
+    float hitRate() const;
+
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t entryCount;
+    size_t byteCount;   // Memory held by cached meshes
+    size_t capacity;    // Largest byteCount allowed
+};
+
+/**
+ * Least recently used cache of built section meshes, keyed by the content
+ * they were built from. Chunks that are reloaded, regenerated or edited back
+ * to an earlier state can reuse a mesh instead of meshing it again.
+ *
+ * The cache is locked internally so every mesh worker can share one.
+ */
+class ChunkMeshCache : boost::noncopyable
+{
+public:
+    explicit ChunkMeshCache( size_t capacity );
+
+    // Hash the input of a section mesh
+    static ChunkMeshKey makeKey( const ChunkNeighborhood& chunk,
+                                 unsigned int section,
+                                 EMeshingMode mode,
+                                 unsigned int lod = 0,
+                                 bool isOptimized = false,
+                                 bool isPacked = false );
+
+    // Look up a mesh, returns null if it isn't cached
+    std::shared_ptr<const WorldChunkMesh> find( const ChunkMeshKey& key );
+
+    // Add a freshly built mesh, evicting old ones to make room
+    void insert( const ChunkMeshKey& key, const WorldChunkMesh& mesh );
+
+    // Change the memory limit, zero turns the cache off
+    void setCapacity( size_t capacity );
+
+    // Drop every mesh
+    void clear();
+
+    // Snapshot of the counters
+    ChunkMeshCacheStats stats() const;
+
+    // Memory a mesh takes up in the cache
+    static size_t meshBytes( const WorldChunkMesh& mesh );
+
+private:
+    void evict( size_t capacity );
+
+private:
+    struct Entry
+    {
+        ChunkMeshKey key;
+        std::shared_ptr<const WorldChunkMesh> pMesh;
+        size_t bytes;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    mutable std::mutex mLock;
+    EntryList mEntries;                             // Most recent first
+    std::map<ChunkMeshKey, EntryList::iterator> mLookup;
+    ChunkMeshCacheStats mStats;
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "graphics/chunkmeshpipeline.h"
+#include "graphics/chunkmeshcache.h"
+#include "graphics/chunkconnectivity.h"
+#include "graphics/worldchunkbuilder.h"
+#include "engine/worldchunk.h"
+#include "engine/cubeface.h"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    // Meshes the buffer pool keeps for reuse per worker, one being built and
+    // one waiting to be uploaded
+    const size_t FREE_MESHES_PER_WORKER = 2;
+}
+
+ChunkMeshPipeline::ChunkMeshPipeline( unsigned int threadCount,
+                                      ChunkMeshCache * pCache )
+    : mThreads(),
+      mJobLock(),
+      mJobReady(),
+      mJobs(),
+      mIsStopping( false ),
+      mBuffers( FREE_MESHES_PER_WORKER * std::max( threadCount, 1u ) ),
+      mCompleted(),
+      mInFlight( 0 ),
+      mpCache( pCache ),
+      mArena()
+{
+    for ( unsigned int i = 0; i < threadCount; ++i )
+    {
+        mThreads.push_back( std::thread( &ChunkMeshPipeline::workerMain, this ) );
+    }
+}
+
+/**
+ * Stops the workers. Jobs that haven't been started are thrown away
+ */
+ChunkMeshPipeline::~ChunkMeshPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock( mJobLock );
+        mIsStopping = true;
+        mJobs.clear();
+    }
+
+    mJobReady.notify_all();
+
+    for ( size_t i = 0; i < mThreads.size(); ++i )
+    {
+        mThreads[i].join();
+    }
+}
+
+/**
+ * Queues a chunk to be meshed. Without worker threads the mesh is built
+ * right away and will be returned by the next call to popCompleted
+ */
+void ChunkMeshPipeline::submit( const ChunkMeshJob& job )
+{
+    assert( job.pChunk );
+    mInFlight++;
+
+    if ( mThreads.empty() )
+    {
+        ChunkMeshResult result;
+        result.mesh = mBuffers.acquire();
+        build( job, mArena, result, mpCache );
+
+        mCompleted.push( std::move( result ) );
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mJobLock );
+        mJobs.push_back( job );
+    }
+
+    mJobReady.notify_one();
+}
+
+/**
+ * Takes the oldest finished mesh. Must only be called from one thread
+ */
+bool ChunkMeshPipeline::popCompleted( ChunkMeshResult& result )
+{
+    if (! mCompleted.pop( result ) )
+    {
+        return false;
+    }
+
+    mInFlight--;
+    return true;
+}
+
+size_t ChunkMeshPipeline::inFlight() const
+{
+    return mInFlight.load();
+}
+
+unsigned int ChunkMeshPipeline::threadCount() const
+{
+    return static_cast<unsigned int>( mThreads.size() );
+}
+
+/**
+ * Builds the mesh for a section of a chunk snapshot, and optionally the face
+ * connectivity for the whole chunk
+ *
+ * \param  job      Section to mesh
+ * \param  arena    Scratch memory to mesh in
+ * \param  result   Receives the mesh
+ * \param  pCache   Cache to look the mesh up in and add it to (optional)
+ */
+void ChunkMeshPipeline::build( const ChunkMeshJob& job,
+                               ChunkMeshArena& arena,
+                               ChunkMeshResult& result,
+                               ChunkMeshCache * pCache )
+{
+    if ( result.mesh.isEmpty() )
+    {
+        result.mesh = ChunkMeshBuffer( new WorldChunkMesh() );
+    }
+
+    ChunkNeighborhood neighborhood( *job.pChunk );
+
+    for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+    {
+        neighborhood.pNeighbors[f] = job.pNeighbors[f].get();
+    }
+
+    result.chunkCoord      = job.chunkCoord;
+    result.position        = job.position;
+    result.section         = job.section;
+    result.version         = job.version;
+    result.hasConnectivity = job.isBuildingConnectivity;
+    result.connectivityVersion = job.connectivityVersion;
+
+    ChunkMeshKey key;
+    std::shared_ptr<const WorldChunkMesh> pCached;
+
+    if ( pCache != NULL )
+    {
+        key     = ChunkMeshCache::makeKey( neighborhood,
+                                           job.section,
+                                           job.mode,
+                                           job.lod,
+                                           job.isOptimizingVertexCache,
+                                           job.isPacked );
+        pCached = pCache->find( key );
+    }
+
+    if ( pCached )
+    {
+        // Assigning into the buffer reuses whatever memory it already has
+        *result.mesh       = *pCached;
+        result.isFromCache = true;
+    }
+    else
+    {
+        arena.builder.buildSection( neighborhood, job.section, job.mode, job.lod );
+
+        if ( job.isOptimizingVertexCache )
+        {
+            arena.builder.generateOptimizedMesh( *result.mesh, job.isPacked );
+        }
+        else
+        {
+            arena.builder.generateMesh( *result.mesh, job.isPacked );
+        }
+
+        result.stats = arena.builder.stats();
+
+        if ( pCache != NULL )
+        {
+            pCache->insert( key, *result.mesh );
+        }
+    }
+
+    if ( job.isBuildingConnectivity )
+    {
+        result.connectivity = ChunkConnectivity::build( *job.pChunk,
+                                                        arena.connectivity );
+    }
+}
+
+void ChunkMeshPipeline::workerMain()
+{
+    // Each worker keeps its own arena so the scratch buffers are reused
+    ChunkMeshArena arena;
+
+    for (;;)
+    {
+        ChunkMeshJob job;
+
+        {
+            std::unique_lock<std::mutex> lock( mJobLock );
+
+            while ( mJobs.empty() && !mIsStopping )
+            {
+                mJobReady.wait( lock );
+            }
+
+            if ( mIsStopping )
+            {
+                return;
+            }
+
+            job = std::move( mJobs.front() );
+            mJobs.pop_front();
+        }
+
+        ChunkMeshResult result;
+        result.mesh = mBuffers.acquire();
+        build( job, arena, result, mpCache );
+
+        mCompleted.push( std::move( result ) );
+    }
+}
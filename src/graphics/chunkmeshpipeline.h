@@ -0,0 +1,183 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CHUNK_MESH_PIPELINE_H
+#define SCOTT_CUBEWORLD_CHUNK_MESH_PIPELINE_H
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "engine/point.h"
+#include "engine/cubeface.h"
+#include "engine/mpscqueue.h"
+#include "graphics/chunkconnectivity.h"
+#include "graphics/chunkmeshbuffer.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+
+class WorldChunk;
+class ChunkMeshCache;
+
+/**
+ * A request to mesh one section of a chunk. The chunk and its neighbors are
+ * immutable snapshots, so a worker can read them while the world keeps being
+ * edited.
+ */
+struct ChunkMeshJob
+{
+    ChunkMeshJob()
+        : chunkCoord(),
+          position(),
+          section( 0 ),
+          version( 0 ),
+          mode( EMESHING_CULLED ),
+          lod( 0 ),
+          isBuildingConnectivity( false ),
+          connectivityVersion( 0 ),
+          isOptimizingVertexCache( false ),
+          isPacked( false ),
+          pChunk()
+    {
+    }
+
+    Point chunkCoord;       // Chunk grid coordinate
+    Point position;         // World space origin of the chunk
+    unsigned int section;   // Section of the chunk to mesh
+    unsigned int version;   // Incremented every time the section is resubmitted
+    EMeshingMode mode;
+    unsigned int lod;       // Level of detail, zero for every cube
+    bool isBuildingConnectivity;    // Also flood fill the whole chunk
+    unsigned int connectivityVersion;   // Incremented for each flood fill
+    bool isOptimizingVertexCache;   // Weld and reorder for the vertex cache
+    bool isPacked;                  // Leave the vertices packed
+
+    std::shared_ptr<const WorldChunk> pChunk;
+    std::shared_ptr<const WorldChunk> pNeighbors[ECUBEFACE_COUNT];
+};
+
+/**
+ * Scratch memory that a mesh worker reuses from job to job. Everything in
+ * it is reset rather than freed between builds, so once it has grown to fit
+ * the busiest section seen, building a mesh doesn't touch the heap.
+ */
+struct ChunkMeshArena
+{
+    WorldChunkBuilder builder;
+    ChunkConnectivityScratch connectivity;
+};
+
+/**
+ * A finished chunk mesh, ready to be uploaded. The result owns its mesh
+ * buffer, and can be moved but not copied
+ */
+struct ChunkMeshResult
+{
+    ChunkMeshResult()
+        : chunkCoord(),
+          position(),
+          section( 0 ),
+          version( 0 ),
+          mesh(),
+          isFromCache( false ),
+          hasConnectivity( false ),
+          connectivityVersion( 0 ),
+          connectivity(),
+          stats()
+    {
+    }
+
+    Point chunkCoord;
+    Point position;
+    unsigned int section;
+    unsigned int version;   // Copied from the job that produced this mesh
+    ChunkMeshBuffer mesh;
+    bool isFromCache;       // Mesh was found in the cache instead of built
+    bool hasConnectivity;   // Set if the job asked for connectivity
+    unsigned int connectivityVersion;   // Copied from the job
+    ChunkConnectivity connectivity;
+    WorldChunkMeshStats stats;
+};
+
+/**
+ * Builds chunk meshes on a pool of worker threads. Jobs are handed to the
+ * workers through a locked queue, and finished meshes come back through a
+ * lock free queue that the main thread drains once a frame, so the main
+ * thread never waits on a worker.
+ *
+ * With zero worker threads every job is built as soon as it is submitted,
+ * on the calling thread.
+ *
+ * When given a mesh cache, sections whose content was meshed before are
+ * copied out of the cache rather than built again.
+ *
+ * Meshes are built into buffers from a pool owned by the pipeline. Popping a
+ * result moves its buffer to the caller, and the buffer goes back to the
+ * pool once the caller drops the result.
+ */
+class ChunkMeshPipeline : boost::noncopyable
+{
+public:
+    explicit ChunkMeshPipeline( unsigned int threadCount,
+                                ChunkMeshCache * pCache = NULL );
+    ~ChunkMeshPipeline();
+
+    // Queue a chunk to be meshed
+    void submit( const ChunkMeshJob& job );
+
+    // Take a finished mesh, returns false if none are waiting
+    bool popCompleted( ChunkMeshResult& result );
+
+    // Number of jobs that were submitted but not popped yet
+    size_t inFlight() const;
+
+    // Number of worker threads (zero if jobs are built on submit)
+    unsigned int threadCount() const;
+
+    // Mesh a job on the calling thread. The mesh is built into the result's
+    // buffer, which is allocated if the result doesn't have one
+    static void build( const ChunkMeshJob& job,
+                       ChunkMeshArena& arena,
+                       ChunkMeshResult& result,
+                       ChunkMeshCache * pCache = NULL );
+
+private:
+    void workerMain();
+
+private:
+    std::vector<std::thread> mThreads;
+    std::mutex mJobLock;
+    std::condition_variable mJobReady;
+    std::deque<ChunkMeshJob> mJobs;
+    bool mIsStopping;
+
+    // Must be created before (and destroyed after) the completed queue,
+    // which holds buffers from it
+    ChunkMeshBufferPool mBuffers;
+    MpscQueue<ChunkMeshResult> mCompleted;
+    std::atomic<size_t> mInFlight;
+
+    ChunkMeshCache * mpCache;   // Optional, not owned
+
+    // Only used when there aren't any worker threads
+    ChunkMeshArena mArena;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "graphics/chunkviewregistry.h"
+#include "engine/point.h"
+
+#include <cassert>
+#include <vector>
+
+ChunkViewRegistry::ChunkViewRegistry()
+    : mCols( 0 ),
+      mRows( 0 ),
+      mDepth( 0 ),
+      mSlots(),
+      mRenderIds(),
+      mChunkCoords()
+{
+}
+
+void ChunkViewRegistry::resize( unsigned int cols,
+                                unsigned int rows,
+                                unsigned int depth )
+{
+    mCols  = cols;
+    mRows  = rows;
+    mDepth = depth;
+
+    mSlots.assign( cols * rows * depth, -1 );
+    mRenderIds.clear();
+    mChunkCoords.clear();
+}
+
+/**
+ * Registers the render id for a chunk, taking the place of any id that was
+ * already registered for it. The caller is responsible for releasing the
+ * old id.
+ *
+ * \param  chunkCoord  Chunk grid coordinate
+ * \param  id          New render id
+ * \param  pOldId      Receives the replaced id (optional)
+ * \return True if an old id was replaced
+ */
+bool ChunkViewRegistry::replace( const Point& chunkCoord,
+                                 ChunkRenderId id,
+                                 ChunkRenderId * pOldId )
+{
+    int slot = slotIndex( chunkCoord );
+    assert( slot >= 0 && "Chunk is outside of the grid" );
+
+    int dense = mSlots[slot];
+
+    if ( dense >= 0 )
+    {
+        if ( pOldId != NULL )
+        {
+            *pOldId = mRenderIds[dense];
+        }
+
+        mRenderIds[dense] = id;
+        return true;
+    }
+
+    mSlots[slot] = static_cast<int>( mRenderIds.size() );
+    mRenderIds.push_back( id );
+    mChunkCoords.push_back( chunkCoord );
+
+    return false;
+}
+
+/**
+ * Removes a chunk from the registry. The last registered chunk is moved into
+ * the hole so that the dense arrays stay packed.
+ *
+ * \param  chunkCoord  Chunk grid coordinate
+ * \param  pOldId      Receives the removed id (optional)
+ * \return True if the chunk was registered
+ */
+bool ChunkViewRegistry::remove( const Point& chunkCoord, ChunkRenderId * pOldId )
+{
+    int slot = slotIndex( chunkCoord );
+
+    if ( slot < 0 || mSlots[slot] < 0 )
+    {
+        return false;
+    }
+
+    int dense = mSlots[slot];
+    int last  = static_cast<int>( mRenderIds.size() ) - 1;
+
+    if ( pOldId != NULL )
+    {
+        *pOldId = mRenderIds[dense];
+    }
+
+    if ( dense != last )
+    {
+        mRenderIds[dense]   = mRenderIds[last];
+        mChunkCoords[dense] = mChunkCoords[last];
+        mSlots[ slotIndex( mChunkCoords[dense] ) ] = dense;
+    }
+
+    mRenderIds.pop_back();
+    mChunkCoords.pop_back();
+    mSlots[slot] = -1;
+
+    return true;
+}
+
+bool ChunkViewRegistry::contains( const Point& chunkCoord ) const
+{
+    int slot = slotIndex( chunkCoord );
+    return slot >= 0 && mSlots[slot] >= 0;
+}
+
+bool ChunkViewRegistry::isInGrid( const Point& chunkCoord ) const
+{
+    return slotIndex( chunkCoord ) >= 0;
+}
+
+size_t ChunkViewRegistry::size() const
+{
+    return mRenderIds.size();
+}
+
+const std::vector<ChunkRenderId>& ChunkViewRegistry::renderIds() const
+{
+    return mRenderIds;
+}
+
+const std::vector<Point>& ChunkViewRegistry::chunkCoords() const
+{
+    return mChunkCoords;
+}
+
+/**
+ * Returns the slot for a chunk coordinate, or -1 if it is outside the grid
+ */
+int ChunkViewRegistry::slotIndex( const Point& chunkCoord ) const
+{
+    if ( chunkCoord.x < 0 || chunkCoord.x >= static_cast<int>( mCols ) ||
+         chunkCoord.y < 0 || chunkCoord.y >= static_cast<int>( mRows ) ||
+         chunkCoord.z < 0 || chunkCoord.z >= static_cast<int>( mDepth ) )
+    {
+        return -1;
+    }
+
+    return ( chunkCoord.z * static_cast<int>( mRows ) + chunkCoord.y ) *
+             static_cast<int>( mCols ) + chunkCoord.x;
+}
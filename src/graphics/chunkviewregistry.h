@@ -0,0 +1,75 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_CHUNK_VIEW_REGISTRY_H
+#define SCOTT_CUBEWORLD_CHUNK_VIEW_REGISTRY_H
+
+#include <vector>
+#include "engine/point.h"
+#include "graphics/renderprimitives.h"
+
+/**
+ * Keeps track of the render id that is currently uploaded for each chunk in
+ * the world. Lookups go through a table with one slot per chunk in the grid,
+ * while the ids themselves are stored densely so the whole set can be handed
+ * to the renderer as a single array. Removing a chunk moves the last entry
+ * into its place, so the order of the dense arrays is not stable.
+ */
+class ChunkViewRegistry
+{
+public:
+    ChunkViewRegistry();
+
+    // Set the size of the chunk grid, which forgets every registered chunk
+    void resize( unsigned int cols, unsigned int rows, unsigned int depth );
+
+    // Set the render id for a chunk. Returns true and the id it replaced if
+    // the chunk already had one
+    bool replace( const Point& chunkCoord,
+                  ChunkRenderId id,
+                  ChunkRenderId * pOldId );
+
+    // Forget a chunk. Returns true and its render id if it was registered
+    bool remove( const Point& chunkCoord, ChunkRenderId * pOldId );
+
+    // Check if a chunk has a render id
+    bool contains( const Point& chunkCoord ) const;
+
+    // Check if the chunk coordinate is inside of the grid
+    bool isInGrid( const Point& chunkCoord ) const;
+
+    // Number of registered chunks
+    size_t size() const;
+
+    // Render ids of every registered chunk, in no particular order
+    const std::vector<ChunkRenderId>& renderIds() const;
+
+    // Chunk coordinates, matching renderIds() entry for entry
+    const std::vector<Point>& chunkCoords() const;
+
+private:
+    int slotIndex( const Point& chunkCoord ) const;
+
+private:
+    unsigned int mCols;
+    unsigned int mRows;
+    unsigned int mDepth;
+
+    std::vector<int> mSlots;                // Dense index per chunk, or -1
+    std::vector<ChunkRenderId> mRenderIds;
+    std::vector<Point> mChunkCoords;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "graphics/drawlistbuilder.h"
+
+#include <algorithm>
+
+namespace
+{
+    /**
+     * Orders items by the cost of switching away from their state
+     */
+    bool isDrawnBefore( const DrawListItem& a, const DrawListItem& b )
+    {
+        if ( a.vertexBuffer != b.vertexBuffer )
+        {
+            return a.vertexBuffer < b.vertexBuffer;
+        }
+        else if ( a.indexBuffer != b.indexBuffer )
+        {
+            return a.indexBuffer < b.indexBuffer;
+        }
+
+        return a.indexSize < b.indexSize;
+    }
+
+    bool isSameState( const DrawListItem& item, const DrawListBatch& batch )
+    {
+        return item.vertexBuffer == batch.vertexBuffer &&
+               item.indexBuffer  == batch.indexBuffer &&
+               item.indexSize    == batch.indexSize;
+    }
+}
+
+DrawListBuilder::DrawListBuilder()
+    : mPass( EDRAWPASS_OPAQUE ),
+      mIsSortingEnabled( true ),
+      mItems(),
+      mBatches()
+{
+}
+
+void DrawListBuilder::begin( EDrawPass pass )
+{
+    mPass = pass;
+    mItems.clear();
+    mBatches.clear();
+}
+
+void DrawListBuilder::add( const DrawListItem& item )
+{
+    mItems.push_back( item );
+}
+
+void DrawListBuilder::build()
+{
+    if ( mIsSortingEnabled && mPass == EDRAWPASS_OPAQUE )
+    {
+        std::stable_sort( mItems.begin(), mItems.end(), isDrawnBefore );
+    }
+
+    mBatches.clear();
+
+    for ( size_t i = 0; i < mItems.size(); ++i )
+    {
+        const DrawListItem& item = mItems[i];
+
+        if ( mBatches.empty() || !isSameState( item, mBatches.back() ) )
+        {
+            DrawListBatch batch = { mPass, item.vertexBuffer, item.indexBuffer,
+                                    item.indexSize, i, 0 };
+            mBatches.push_back( batch );
+        }
+
+        mBatches.back().count++;
+    }
+}
+
+EDrawPass DrawListBuilder::pass() const
+{
+    return mPass;
+}
+
+const std::vector<DrawListItem>& DrawListBuilder::items() const
+{
+    return mItems;
+}
+
+const std::vector<DrawListBatch>& DrawListBuilder::batches() const
+{
+    return mBatches;
+}
+
+void DrawListBuilder::setSortingEnabled( bool isEnabled )
+{
+    mIsSortingEnabled = isEnabled;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_DRAW_LIST_BUILDER_H
+#define SCOTT_CUBEWORLD_DRAW_LIST_BUILDER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "graphics/renderprimitives.h"
+
+/**
+ * Render passes, in the order a frame draws them. Each pass has its own
+ * fixed state (translucent faces are blended and don't write depth)
+ */
+enum EDrawPass
+{
+    EDRAWPASS_OPAQUE,
+    EDRAWPASS_TRANSLUCENT,
+    EDRAWPASS_COUNT
+};
+
+/**
+ * One chunk section to draw, and the state it needs bound. Buffers are
+ * whatever numbers the renderer uses to tell its buffers apart, either an
+ * arena of a geometry heap or a section's own buffer
+ */
+struct DrawListItem
+{
+    ChunkRenderId id;
+    unsigned int vertexBuffer;
+    unsigned int indexBuffer;
+    unsigned int indexSize;     // Bytes per index, a draw can only use one
+};
+
+/**
+ * A run of items that share all of their state, drawn with one multi-draw
+ * call
+ */
+struct DrawListBatch
+{
+    EDrawPass pass;
+    unsigned int vertexBuffer;
+    unsigned int indexBuffer;
+    unsigned int indexSize;
+    size_t first;               // First item of the batch
+    size_t count;               // Number of items in the batch
+};
+
+/**
+ * Turns the list of chunk sections a renderer was asked to draw into as few
+ * draw calls and state changes as possible.
+ *
+ * Opaque sections may be drawn in any order, so they are sorted by the state
+ * that is most expensive to change: vertex buffer first, then index buffer
+ * and index format. The sort is stable, so sections that share state keep
+ * the order they were given in. Translucent sections have to be blended
+ * back to front and keep their order. Either way runs of sections with the
+ * same state are then merged into batches.
+ *
+ * The builder keeps its memory between frames.
+ */
+class DrawListBuilder
+{
+public:
+    DrawListBuilder();
+
+    // Start a new list for a pass
+    void begin( EDrawPass pass );
+
+    void add( const DrawListItem& item );
+
+    // Sort (when the pass allows it) and batch the items added since begin
+    void build();
+
+    EDrawPass pass() const;
+
+    // Items in the order they are to be drawn, valid after build
+    const std::vector<DrawListItem>& items() const;
+
+    // Batches of items, valid after build
+    const std::vector<DrawListBatch>& batches() const;
+
+    // Turn sorting off, which leaves only batching of neighboring items
+    void setSortingEnabled( bool isEnabled );
+
+private:
+    EDrawPass mPass;
+    bool mIsSortingEnabled;
+    std::vector<DrawListItem> mItems;
+    std::vector<DrawListBatch> mBatches;
+};
+
+#endif
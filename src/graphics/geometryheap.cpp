@@ -0,0 +1,206 @@
+#include "graphics/geometryheap.h"
+
+#include <algorithm>
+#include <cassert>
+
+double GeometryHeapStats::utilization() const
+{
+    if ( capacityBytes == 0 )
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>( usedBytes ) / capacityBytes;
+}
+
+double GeometryHeapStats::fragmentation() const
+{
+    const size_t freeBytes = capacityBytes - usedBytes;
+
+    if ( freeBytes == 0 )
+    {
+        return 0.0;
+    }
+
+    return 1.0 - static_cast<double>( largestFreeBlock ) / freeBytes;
+}
+
+/**
+ * \param  arenaBytes   Usual size of an arena
+ * \param  granularity  Every offset and size is a multiple of this
+ */
+GeometryHeap::GeometryHeap( size_t arenaBytes, size_t granularity )
+    : mArenaBytes( arenaBytes ),
+      mGranularity( granularity ),
+      mArenas(),
+      mFreeBySize()
+{
+    assert( granularity > 0 );
+    assert( arenaBytes >= granularity );
+}
+
+/**
+ * Finds the smallest free block that fits, adding an arena if none does, and
+ * carves the range off of the front of it
+ */
+GeometryRange GeometryHeap::allocate( size_t bytes )
+{
+    GeometryRange range;
+
+    if ( bytes == 0 )
+    {
+        return range;
+    }
+
+    const size_t size = ( bytes + mGranularity - 1 ) / mGranularity * mGranularity;
+    SizeIndex::iterator best = mFreeBySize.lower_bound( size );
+
+    if ( best == mFreeBySize.end() )
+    {
+        Arena arena;
+        arena.capacity    = std::max( mArenaBytes / mGranularity * mGranularity, size );
+        arena.used        = 0;
+        arena.allocations = 0;
+
+        mArenas.push_back( arena );
+        addFreeBlock( static_cast<unsigned int>( mArenas.size() - 1 ), 0, arena.capacity );
+
+        best = mFreeBySize.lower_bound( size );
+        assert( best != mFreeBySize.end() );
+    }
+
+    const size_t blockSize    = best->first;
+    const unsigned int arena  = best->second.first;
+    const size_t blockOffset  = best->second.second;
+
+    removeFreeBlock( arena, blockOffset, blockSize );
+
+    if ( blockSize > size )
+    {
+        addFreeBlock( arena, blockOffset + size, blockSize - size );
+    }
+
+    mArenas[arena].used += size;
+    mArenas[arena].allocations++;
+
+    range.arena  = arena;
+    range.offset = blockOffset;
+    range.size   = size;
+
+    return range;
+}
+
+/**
+ * Gives the range back, merged with the free blocks on either side of it
+ */
+void GeometryHeap::free( const GeometryRange& range )
+{
+    if ( range.size == 0 )
+    {
+        return;
+    }
+
+    assert( range.arena < mArenas.size() );
+    Arena& arena = mArenas[range.arena];
+    assert( range.offset + range.size <= arena.capacity );
+
+    size_t offset = range.offset;
+    size_t size   = range.size;
+
+    std::map<size_t, size_t>::iterator next = arena.freeBlocks.lower_bound( offset );
+    assert( next == arena.freeBlocks.end() || next->first >= offset + size );
+
+    if ( next != arena.freeBlocks.end() && next->first == offset + size )
+    {
+        const size_t nextSize = next->second;
+        removeFreeBlock( range.arena, next->first, nextSize );
+        size += nextSize;
+    }
+
+    next = arena.freeBlocks.lower_bound( offset );
+
+    if ( next != arena.freeBlocks.begin() )
+    {
+        std::map<size_t, size_t>::iterator previous = next;
+        --previous;
+        assert( previous->first + previous->second <= offset );
+
+        if ( previous->first + previous->second == offset )
+        {
+            const size_t previousOffset = previous->first;
+            const size_t previousSize   = previous->second;
+
+            removeFreeBlock( range.arena, previousOffset, previousSize );
+            offset = previousOffset;
+            size  += previousSize;
+        }
+    }
+
+    addFreeBlock( range.arena, offset, size );
+
+    assert( arena.used >= range.size && arena.allocations > 0 );
+    arena.used -= range.size;
+    arena.allocations--;
+}
+
+size_t GeometryHeap::arenaSize( unsigned int arena ) const
+{
+    assert( arena < mArenas.size() );
+    return mArenas[arena].capacity;
+}
+
+unsigned int GeometryHeap::arenaCount() const
+{
+    return static_cast<unsigned int>( mArenas.size() );
+}
+
+size_t GeometryHeap::granularity() const
+{
+    return mGranularity;
+}
+
+GeometryHeapStats GeometryHeap::stats() const
+{
+    GeometryHeapStats stats;
+    stats.arenas     = arenaCount();
+    stats.freeBlocks = mFreeBySize.size();
+
+    if (! mFreeBySize.empty() )
+    {
+        stats.largestFreeBlock = mFreeBySize.rbegin()->first;
+    }
+
+    for ( size_t i = 0; i < mArenas.size(); ++i )
+    {
+        stats.allocations   += mArenas[i].allocations;
+        stats.capacityBytes += mArenas[i].capacity;
+        stats.usedBytes     += mArenas[i].used;
+    }
+
+    return stats;
+}
+
+void GeometryHeap::addFreeBlock( unsigned int arena, size_t offset, size_t size )
+{
+    mArenas[arena].freeBlocks[offset] = size;
+    mFreeBySize.insert( std::make_pair( size, std::make_pair( arena, offset ) ) );
+}
+
+void GeometryHeap::removeFreeBlock( unsigned int arena, size_t offset, size_t size )
+{
+    mArenas[arena].freeBlocks.erase( offset );
+
+    std::pair<SizeIndex::iterator, SizeIndex::iterator> matches =
+        mFreeBySize.equal_range( size );
+
+    for ( SizeIndex::iterator i = matches.first; i != matches.second; ++i )
+    {
+        if ( i->second.first == arena && i->second.second == offset )
+        {
+            mFreeBySize.erase( i );
+            return;
+        }
+    }
+
+    assert( false && "Free block missing from the size index" );
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_GEOMETRY_HEAP_H
+#define SCOTT_CUBEWORLD_GEOMETRY_HEAP_H
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * A range of bytes handed out by a GeometryHeap. Ranges of zero bytes don't
+ * live in any arena
+ */
+struct GeometryRange
+{
+    GeometryRange()
+        : arena( 0 ),
+          offset( 0 ),
+          size( 0 )
+    {
+    }
+
+    unsigned int arena;     // Arena the range was carved out of
+    size_t offset;          // Start of the range, in bytes from the arena's
+    size_t size;            // Length in bytes, rounded up to the granularity
+};
+
+/**
+ * Snapshot of how full a GeometryHeap is
+ */
+struct GeometryHeapStats
+{
+    GeometryHeapStats()
+        : arenas( 0 ),
+          allocations( 0 ),
+          capacityBytes( 0 ),
+          usedBytes( 0 ),
+          freeBlocks( 0 ),
+          largestFreeBlock( 0 )
+    {
+    }
+
+    // Fraction of the arenas' capacity that is handed out
+    double utilization() const;
+
+    // Fraction of the free bytes that are outside of the largest free block,
+    // zero when the free space is all in one piece
+    double fragmentation() const;
+
+    unsigned int arenas;
+    size_t allocations;         // Ranges handed out and not freed
+    size_t capacityBytes;       // Combined size of every arena
+    size_t usedBytes;
+    size_t freeBlocks;          // Separate runs of free bytes
+    size_t largestFreeBlock;
+};
+
+/**
+ * Suballocates ranges out of a few large arenas, so that chunk meshes can
+ * share a handful of big vertex and index buffers rather than owning one of
+ * each. Uploading a rebuilt chunk then writes into an existing buffer instead
+ * of creating a new one, and chunks in the same arena can be drawn without
+ * binding anything in between.
+ *
+ * The heap only does the bookkeeping; it is up to the renderer to create a
+ * buffer for each arena. Allocation is best fit over the free blocks of all
+ * arenas, and freed ranges are merged with the free blocks around them. A
+ * new arena is added when nothing fits, sized to hold the allocation if it
+ * is bigger than the usual arena size.
+ *
+ * Offsets and sizes are multiples of the granularity, which lets a vertex
+ * range be addressed by vertex number (with a granularity of the vertex size)
+ * or an index range stay aligned.
+ */
+class GeometryHeap
+{
+public:
+    GeometryHeap( size_t arenaBytes, size_t granularity );
+
+    // Hand out a range of at least this many bytes
+    GeometryRange allocate( size_t bytes );
+
+    // Return a range to the heap
+    void free( const GeometryRange& range );
+
+    // Size in bytes of an arena
+    size_t arenaSize( unsigned int arena ) const;
+
+    unsigned int arenaCount() const;
+    size_t granularity() const;
+
+    GeometryHeapStats stats() const;
+
+private:
+    struct Arena
+    {
+        size_t capacity;
+        size_t used;
+        size_t allocations;
+        std::map<size_t, size_t> freeBlocks;    // Offset to size
+    };
+
+    typedef std::multimap< size_t, std::pair<unsigned int, size_t> > SizeIndex;
+
+    void addFreeBlock( unsigned int arena, size_t offset, size_t size );
+    void removeFreeBlock( unsigned int arena, size_t offset, size_t size );
+
+private:
+    size_t mArenaBytes;
+    size_t mGranularity;
+    std::vector<Arena> mArenas;
+
+    // Every free block of every arena, by size then (arena, offset)
+    SizeIndex mFreeBySize;
+};
+
+#endif
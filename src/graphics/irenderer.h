@@ -7,6 +7,8 @@
 #include "graphics/renderprimitives.h"
 
 class WorldChunk;
+struct WorldChunkMesh;
+class Point;
 
 /**
  * Vendor neutral rendering interface
@@ -22,12 +24,24 @@ public:
     // Draws the scene onto the front buffer
     virtual void present() = 0;
 
-    // Draw a list of chunks as the world's background
+    // Draw the opaque faces of a list of chunks as the world's background
     virtual void renderChunks(
             const std::vector<ChunkRenderId>& chunks ) = 0;
 
-    // Upload a world chunk
-    virtual ChunkRenderId uploadChunk( const WorldChunk& pChunk ) = 0;
+    // Draw the translucent faces of a list of chunks, blended over what has
+    // already been drawn. Called after renderChunks with the chunks sorted
+    // back to front, which is the order they must be drawn in
+    virtual void renderTranslucentChunks(
+            const std::vector<ChunkRenderId>& chunks ) = 0;
+
+    // Upload the mesh for one section of a chunk. Vertices are relative to
+    // the chunk's origin (not the section's)
+    virtual ChunkRenderId uploadChunkSection( const Point& origin,
+                                              unsigned int section,
+                                              const WorldChunkMesh& mesh ) = 0;
+
+    // Free an uploaded chunk section, the id must not be rendered afterwards
+    virtual void releaseChunk( ChunkRenderId id ) = 0;
 
 private:
 };
@@ -43,7 +43,19 @@ void NullRenderer::renderChunks( const std::vector<ChunkRenderId>& )
 
 }
 
-ChunkRenderId NullRenderer::uploadChunk( const WorldChunk& )
+void NullRenderer::renderTranslucentChunks( const std::vector<ChunkRenderId>& )
+{
+
+}
+
+ChunkRenderId NullRenderer::uploadChunkSection( const Point&,
+                                                unsigned int,
+                                                const WorldChunkMesh& )
 {
     return 0u;
 }
+
+void NullRenderer::releaseChunk( ChunkRenderId )
+{
+
+}
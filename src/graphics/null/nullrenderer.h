@@ -21,6 +21,8 @@
 #include <vector>
 
 class WorldChunk;
+class Point;
+struct WorldChunkMesh;
 
 class NullRenderer : public IRenderer
 {
@@ -31,7 +33,11 @@ public:
     virtual void clear();
     virtual void present();
     virtual void renderChunks( const std::vector<ChunkRenderId>& );
-    ChunkRenderId uploadChunk( const WorldChunk& );
+    virtual void renderTranslucentChunks( const std::vector<ChunkRenderId>& );
+    ChunkRenderId uploadChunkSection( const Point&,
+                                      unsigned int,
+                                      const WorldChunkMesh& );
+    void releaseChunk( ChunkRenderId );
 
 private:
 };
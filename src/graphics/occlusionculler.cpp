@@ -0,0 +1,167 @@
+#include "graphics/occlusionculler.h"
+#include "graphics/chunkconnectivity.h"
+#include "engine/cubeface.h"
+#include "engine/point.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace
+{
+    // Chunk grid offset to travel through each face, in ECubeFace order
+    const Point FACE_OFFSET[ECUBEFACE_COUNT] =
+    {
+        Point(  1,  0,  0 ),
+        Point( -1,  0,  0 ),
+        Point(  0,  1,  0 ),
+        Point(  0, -1,  0 ),
+        Point(  0,  0,  1 ),
+        Point(  0,  0, -1 )
+    };
+}
+
+OcclusionCuller::OcclusionCuller()
+    : mCols( 0 ),
+      mRows( 0 ),
+      mDepth( 0 ),
+      mConnectivity(),
+      mVisible(),
+      mQueue()
+{
+}
+
+/**
+ * Resizes the chunk grid. Every chunk starts out fully open (chunks that have
+ * never been populated are nothing but air) until their connectivity is set.
+ */
+void OcclusionCuller::resize( unsigned int cols,
+                              unsigned int rows,
+                              unsigned int depth )
+{
+    mCols  = cols;
+    mRows  = rows;
+    mDepth = depth;
+
+    mConnectivity.assign( cols * rows * depth, ChunkConnectivity() );
+    mVisible.assign( cols * rows * depth, 0 );
+    mQueue.reserve( cols * rows * depth );
+}
+
+void OcclusionCuller::setConnectivity( const Point& chunkCoord,
+                                       const ChunkConnectivity& connectivity )
+{
+    mConnectivity[ indexOf( chunkCoord ) ] = connectivity;
+}
+
+ChunkConnectivity OcclusionCuller::connectivity( const Point& chunkCoord ) const
+{
+    return mConnectivity[ indexOf( chunkCoord ) ];
+}
+
+/**
+ * Walks the chunk connectivity graph outward from the camera's chunk and
+ * marks every chunk that it reaches as visible. A camera outside of the world
+ * is clamped to the nearest chunk.
+ *
+ * \param  cameraChunk  Chunk grid coordinate that the camera is in
+ * \return              Number of chunks that were marked visible
+ */
+unsigned int OcclusionCuller::cull( const Point& cameraChunk )
+{
+    std::fill( mVisible.begin(), mVisible.end(), 0 );
+    mQueue.clear();
+
+    if ( mVisible.empty() )
+    {
+        return 0;
+    }
+
+    SearchStep start;
+    start.position   = Point( std::max( 0, std::min( cameraChunk.x, (int) mCols  - 1 ) ),
+                              std::max( 0, std::min( cameraChunk.y, (int) mRows  - 1 ) ),
+                              std::max( 0, std::min( cameraChunk.z, (int) mDepth - 1 ) ) );
+    start.entryFace  = -1;
+    start.directions = 0;
+
+    mVisible[ indexOf( start.position ) ] = 1;
+    mQueue.push_back( start );
+
+    unsigned int visibleCount = 1;
+
+    // Breadth first search, mQueue is never popped from the front so we
+    // can reuse its storage from frame to frame
+    for ( size_t next = 0; next < mQueue.size(); ++next )
+    {
+        const SearchStep step = mQueue[next];
+        const ChunkConnectivity& here = mConnectivity[ indexOf( step.position ) ];
+
+        for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+        {
+            ECubeFace exitFace = static_cast<ECubeFace>( f );
+
+            // Never double back against a direction already traveled
+            if ( step.directions & ( 1u << CubeFace::opposite( exitFace ) ) )
+            {
+                continue;
+            }
+
+            // Can we see from the face we came in through to this face?
+            if ( step.entryFace >= 0 &&
+                 !here.isConnected( static_cast<ECubeFace>( step.entryFace ),
+                                    exitFace ) )
+            {
+                continue;
+            }
+
+            Point neighbor = step.position + FACE_OFFSET[f];
+
+            if (! contains( neighbor ) )
+            {
+                continue;
+            }
+
+            unsigned int index = indexOf( neighbor );
+
+            if ( mVisible[index] )
+            {
+                continue;
+            }
+
+            mVisible[index] = 1;
+            visibleCount++;
+
+            SearchStep nextStep;
+            nextStep.position   = neighbor;
+            nextStep.entryFace  = CubeFace::opposite( exitFace );
+            nextStep.directions = step.directions | ( 1u << f );
+
+            mQueue.push_back( nextStep );
+        }
+    }
+
+    return visibleCount;
+}
+
+bool OcclusionCuller::isVisible( const Point& chunkCoord ) const
+{
+    return contains( chunkCoord ) && mVisible[ indexOf( chunkCoord ) ] != 0;
+}
+
+bool OcclusionCuller::contains( const Point& c ) const
+{
+    return c.x >= 0 && c.x < static_cast<int>( mCols ) &&
+           c.y >= 0 && c.y < static_cast<int>( mRows ) &&
+           c.z >= 0 && c.z < static_cast<int>( mDepth );
+}
+
+unsigned int OcclusionCuller::chunkCount() const
+{
+    return mCols * mRows * mDepth;
+}
+
+unsigned int OcclusionCuller::indexOf( const Point& c ) const
+{
+    assert( contains( c ) );
+    return ( c.z * mRows + c.y ) * mCols + c.x;
+}
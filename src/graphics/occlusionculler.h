@@ -0,0 +1,80 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_OCCLUSION_CULLER_H
+#define SCOTT_CUBEWORLD_OCCLUSION_CULLER_H
+
+#include <stdint.h>
+#include <vector>
+#include "engine/point.h"
+#include "graphics/chunkconnectivity.h"
+
+/**
+ * Rejects chunks that can not be seen from the camera's chunk because they
+ * are sealed off by solid cubes. Each chunk stores which of its faces see
+ * each other (see ChunkConnectivity), and once per frame the culler runs a
+ * breadth first search over that graph starting at the camera's chunk.
+ *
+ * A chunk is potentially visible if the search reaches it. The search never
+ * travels back in a direction opposite to one it has already moved in, which
+ * keeps it from wrapping around solid walls into chunks the camera can't see.
+ */
+class OcclusionCuller
+{
+public:
+    OcclusionCuller();
+
+    // Set the size of the chunk grid, which resets all connectivity
+    void resize( unsigned int cols, unsigned int rows, unsigned int depth );
+
+    // Update the stored connectivity for a chunk
+    void setConnectivity( const Point& chunkCoord,
+                          const ChunkConnectivity& connectivity );
+
+    // Get the stored connectivity for a chunk
+    ChunkConnectivity connectivity( const Point& chunkCoord ) const;
+
+    // Find all chunks visible from the camera's chunk, returns visible count
+    unsigned int cull( const Point& cameraChunk );
+
+    // Check if the chunk was reached by the last call to cull
+    bool isVisible( const Point& chunkCoord ) const;
+
+    // Check if the chunk coordinate lies inside of the chunk grid
+    bool contains( const Point& chunkCoord ) const;
+
+    // Number of chunks in the chunk grid
+    unsigned int chunkCount() const;
+
+private:
+    unsigned int indexOf( const Point& chunkCoord ) const;
+
+private:
+    struct SearchStep
+    {
+        Point position;
+        int entryFace;              // face we entered through, -1 at start
+        unsigned int directions;    // ECubeFace bits we've traveled along
+    };
+
+    unsigned int mCols;
+    unsigned int mRows;
+    unsigned int mDepth;
+    std::vector<ChunkConnectivity> mConnectivity;
+    std::vector<uint8_t> mVisible;
+    std::vector<SearchStep> mQueue;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_PACKED_CUBE_VERTEX_H
+#define SCOTT_CUBEWORLD_PACKED_CUBE_VERTEX_H
+
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * Compact vertex for chunk meshes. Every vertex of a cube face sits on an
+ * integer position inside of its chunk and has one of six normals, so the
+ * whole thing fits in eight bytes instead of CubeVertex's thirty two:
+ *
+ *   byte 0-2   chunk local x, y, z (0 to chunk size inclusive)
+ *   byte 3     face (ECubeFace, low three bits) and corner (next two bits)
+ *   byte 4     material (EMaterialType)
+ *   byte 5     ambient occlusion, 0 (none) to 3 (fully occluded)
+ *   byte 6-7   reserved, zero
+ *
+ * The normal comes from the face and texture coordinates are derived from
+ * the position projected onto the face, so neither is stored.
+ */
+struct PackedCubeVertex
+{
+    enum
+    {
+        FACE_BITS   = 3,
+        FACE_MASK   = 0x07,
+        CORNER_MASK = 0x03
+    };
+
+    PackedCubeVertex()
+    {
+        pos[0] = pos[1] = pos[2] = 0;
+        faceCorner  = 0;
+        material    = 0;
+        ao          = 0;
+        reserved[0] = reserved[1] = 0;
+    }
+
+    PackedCubeVertex( const int p[3],
+                      int face,
+                      int corner,
+                      int materialType,
+                      int occlusion )
+    {
+        pos[0]      = static_cast<uint8_t>( p[0] );
+        pos[1]      = static_cast<uint8_t>( p[1] );
+        pos[2]      = static_cast<uint8_t>( p[2] );
+        faceCorner  = static_cast<uint8_t>(
+                ( face & FACE_MASK ) | ( ( corner & CORNER_MASK ) << FACE_BITS ) );
+        material    = static_cast<uint8_t>( materialType );
+        ao          = static_cast<uint8_t>( occlusion );
+        reserved[0] = reserved[1] = 0;
+    }
+
+    int face() const   { return faceCorner & FACE_MASK; }
+    int corner() const { return ( faceCorner >> FACE_BITS ) & CORNER_MASK; }
+
+    uint8_t pos[3];         // 1x3 --> 3 / 3
+    uint8_t faceCorner;     // 1x1 --> 1 / 4
+    uint8_t material;       // 1x1 --> 1 / 5
+    uint8_t ao;             // 1x1 --> 1 / 6
+    uint8_t reserved[2];    // 1x2 --> 2 / 8
+};
+
+static_assert( sizeof(PackedCubeVertex) == 8, "Packed vertex must be 8 bytes" );
+
+#endif
@@ -0,0 +1,369 @@
+#include "graphics/recording/recordingrenderer.h"
+#include "graphics/worldchunkmesh.h"
+#include "graphics/cubevertex.h"
+
+#include <stdint.h>
+#include <algorithm>
+#include <cassert>
+#include <ostream>
+#include <sstream>
+
+namespace
+{
+    // Arena size used until the heap is enabled with a size of its own
+    const size_t DEFAULT_ARENA_BYTES = 4 * 1024 * 1024;
+}
+
+std::string RecordingFrameStats::toJson() const
+{
+    std::ostringstream ss;
+
+    ss << "{\"frame\":"                << frame
+       << ",\"drawCalls\":"            << drawCalls
+       << ",\"translucentDrawCalls\":" << translucentDrawCalls
+       << ",\"batches\":"              << batches
+       << ",\"bufferBinds\":"          << bufferBinds
+       << ",\"stateChanges\":"         << stateChanges
+       << ",\"triangles\":"            << triangles
+       << ",\"skippedDraws\":"         << skippedDraws
+       << ",\"uploads\":"              << uploads
+       << ",\"releases\":"             << releases
+       << ",\"uploadedBytes\":"        << uploadedBytes
+       << ",\"transferredBytes\":"     << transferredBytes
+       << ",\"backlogBytes\":"         << backlogBytes
+       << ",\"liveBuffers\":"          << liveBuffers
+       << ",\"liveBytes\":"            << liveBytes
+       << "}";
+
+    return ss.str();
+}
+
+RecordingRenderer::RecordingRenderer()
+    : mSections(),
+      mFreeIds(),
+      mUploadQueue(),
+      mUploadBandwidth( 0 ),
+      mBandwidthLeft( 0 ),
+      mFrame(),
+      mFrames(),
+      mIsUsingGeometryHeap( false ),
+      mVertexHeap( DEFAULT_ARENA_BYTES, sizeof(CubeVertex) ),
+      mPackedVertexHeap( DEFAULT_ARENA_BYTES, sizeof(PackedCubeVertex) ),
+      mIndexHeap( DEFAULT_ARENA_BYTES, sizeof(uint32_t) ),
+      mDrawList(),
+      mBoundPass( EDRAWPASS_COUNT ),
+      mBoundVertexBuffer( 0 ),
+      mBoundIndexBuffer( 0 )
+{
+}
+
+RecordingRenderer::~RecordingRenderer()
+{
+}
+
+void RecordingRenderer::clear()
+{
+}
+
+/**
+ * Finishes recording the current frame. Sections still in the upload queue
+ * carry on transferring with the next frame's bandwidth
+ */
+void RecordingRenderer::present()
+{
+    mFrames.push_back( mFrame );
+
+    RecordingFrameStats next;
+    next.frame        = mFrame.frame + 1;
+    next.backlogBytes = mFrame.backlogBytes;
+    next.liveBuffers  = mFrame.liveBuffers;
+    next.liveBytes    = mFrame.liveBytes;
+
+    mFrame         = next;
+    mBandwidthLeft = mUploadBandwidth;
+
+    // A new frame starts with nothing bound
+    mBoundPass         = EDRAWPASS_COUNT;
+    mBoundVertexBuffer = 0;
+    mBoundIndexBuffer  = 0;
+
+    transfer();
+}
+
+void RecordingRenderer::renderChunks( const std::vector<ChunkRenderId>& chunks )
+{
+    draw( chunks, false );
+}
+
+void RecordingRenderer::renderTranslucentChunks( const std::vector<ChunkRenderId>& chunks )
+{
+    draw( chunks, true );
+}
+
+ChunkRenderId RecordingRenderer::uploadChunkSection( const Point&,
+                                                     unsigned int,
+                                                     const WorldChunkMesh& mesh )
+{
+    ChunkRenderId id;
+
+    if (! mFreeIds.empty() )
+    {
+        id = mFreeIds.back();
+        mFreeIds.pop_back();
+    }
+    else
+    {
+        mSections.push_back( Section() );
+        id = static_cast<ChunkRenderId>( mSections.size() );
+    }
+
+    Section& section = mSections[id - 1];
+    section.isLive       = true;
+    section.isPacked     = mesh.isPacked;
+    section.bytes        = meshBytes( mesh );
+    section.pendingBytes = section.bytes;
+    section.triangles    = static_cast<unsigned int>( mesh.indices.size() / 3 );
+    section.translucentTriangles =
+        static_cast<unsigned int>( mesh.translucentIndices.size() / 3 );
+    section.indexSize   = mesh.indices.empty() ? mesh.translucentIndices.indexSize() :
+                                                 mesh.indices.indexSize();
+    section.vertexRange = GeometryRange();
+    section.indexRange  = GeometryRange();
+
+    if ( mIsUsingGeometryHeap )
+    {
+        GeometryHeap& vertexHeap = mesh.isPacked ? mPackedVertexHeap : mVertexHeap;
+
+        section.vertexRange = vertexHeap.allocate( mesh.vertexCount() * mesh.vertexSize() );
+        section.indexRange  = mIndexHeap.allocate( mesh.indices.byteSize() +
+                                                   mesh.translucentIndices.byteSize() );
+    }
+
+    mFrame.uploads++;
+    mFrame.uploadedBytes += section.bytes;
+    mFrame.backlogBytes  += section.bytes;
+    mFrame.liveBuffers++;
+    mFrame.liveBytes += section.bytes;
+
+    mUploadQueue.push_back( id );
+    transfer();
+
+    return id;
+}
+
+void RecordingRenderer::releaseChunk( ChunkRenderId id )
+{
+    assert( id > 0 && id <= mSections.size() );
+    Section& section = mSections[id - 1];
+    assert( section.isLive );
+
+    // Whatever hadn't been transferred yet never will be
+    mFrame.backlogBytes -= section.pendingBytes;
+    mFrame.liveBuffers--;
+    mFrame.liveBytes -= section.bytes;
+    mFrame.releases++;
+
+    ( section.isPacked ? mPackedVertexHeap : mVertexHeap ).free( section.vertexRange );
+    mIndexHeap.free( section.indexRange );
+
+    section.isLive       = false;
+    section.pendingBytes = 0;
+    mFreeIds.push_back( id );
+}
+
+void RecordingRenderer::setUploadBandwidth( size_t bytesPerFrame )
+{
+    mUploadBandwidth = bytesPerFrame;
+    mBandwidthLeft   = bytesPerFrame;
+
+    transfer();
+}
+
+/**
+ * Switches uploads over to suballocating from shared arenas. Vertex ranges
+ * are whole vertices, so a draw can address them by base vertex. The two
+ * vertex formats have different layouts, and are kept in arenas of their own
+ */
+void RecordingRenderer::enableGeometryHeap( size_t arenaBytes )
+{
+    assert( mFrame.liveBuffers == 0 && "Enable the heap before uploading" );
+
+    mIsUsingGeometryHeap = true;
+    mVertexHeap       = GeometryHeap( arenaBytes, sizeof(CubeVertex) );
+    mPackedVertexHeap = GeometryHeap( arenaBytes, sizeof(PackedCubeVertex) );
+    mIndexHeap        = GeometryHeap( arenaBytes, sizeof(uint32_t) );
+}
+
+void RecordingRenderer::setDrawSortingEnabled( bool isEnabled )
+{
+    mDrawList.setSortingEnabled( isEnabled );
+}
+
+bool RecordingRenderer::isUsingGeometryHeap() const
+{
+    return mIsUsingGeometryHeap;
+}
+
+const GeometryHeap& RecordingRenderer::vertexHeap() const
+{
+    return mVertexHeap;
+}
+
+const GeometryHeap& RecordingRenderer::packedVertexHeap() const
+{
+    return mPackedVertexHeap;
+}
+
+const GeometryHeap& RecordingRenderer::indexHeap() const
+{
+    return mIndexHeap;
+}
+
+const RecordingFrameStats& RecordingRenderer::currentFrame() const
+{
+    return mFrame;
+}
+
+const std::vector<RecordingFrameStats>& RecordingRenderer::frames() const
+{
+    return mFrames;
+}
+
+void RecordingRenderer::writeJson( std::ostream& stream ) const
+{
+    stream << "[";
+
+    for ( size_t i = 0; i < mFrames.size(); ++i )
+    {
+        stream << ( i > 0 ? ",\n  " : "\n  " ) << mFrames[i].toJson();
+    }
+
+    stream << "\n]\n";
+}
+
+size_t RecordingRenderer::meshBytes( const WorldChunkMesh& mesh )
+{
+    return mesh.vertexCount() * mesh.vertexSize() +
+           mesh.indices.byteSize() +
+           mesh.translucentIndices.byteSize();
+}
+
+/**
+ * Moves queued sections across the simulated bus, oldest first, until the
+ * queue is empty or this frame's bandwidth is used up
+ */
+void RecordingRenderer::transfer()
+{
+    while (! mUploadQueue.empty() )
+    {
+        Section& section = mSections[ mUploadQueue.front() - 1 ];
+        size_t bytes = section.pendingBytes;
+
+        if ( mUploadBandwidth > 0 )
+        {
+            bytes = std::min( bytes, mBandwidthLeft );
+            mBandwidthLeft -= bytes;
+        }
+
+        section.pendingBytes   -= bytes;
+        mFrame.transferredBytes += bytes;
+        mFrame.backlogBytes     -= bytes;
+
+        if ( section.pendingBytes > 0 )
+        {
+            break;
+        }
+
+        mUploadQueue.pop_front();
+    }
+}
+
+/**
+ * Counts one draw call per section that has something to draw in the pass.
+ * The sections are run through the draw list builder, and each batch it
+ * makes is one submission. State changes are counted as the pass, vertex
+ * buffer and index buffer switch, carrying over from one list to the next
+ */
+void RecordingRenderer::draw( const std::vector<ChunkRenderId>& chunks,
+                              bool isTranslucent )
+{
+    mDrawList.begin( isTranslucent ? EDRAWPASS_TRANSLUCENT : EDRAWPASS_OPAQUE );
+
+    for ( size_t i = 0; i < chunks.size(); ++i )
+    {
+        assert( chunks[i] > 0 && chunks[i] <= mSections.size() );
+        const Section& section = mSections[ chunks[i] - 1 ];
+        assert( section.isLive );
+
+        const unsigned int triangles = isTranslucent ?
+                                       section.translucentTriangles :
+                                       section.triangles;
+
+        if ( triangles == 0 )
+        {
+            continue;
+        }
+        else if ( section.pendingBytes > 0 )
+        {
+            mFrame.skippedDraws++;
+            continue;
+        }
+
+        // Buffers are numbered from one, zero means nothing is bound. Float
+        // and packed vertex arenas take turns so their numbers don't clash
+        DrawListItem item;
+        item.id           = chunks[i];
+        item.vertexBuffer = mIsUsingGeometryHeap ?
+                            section.vertexRange.arena * 2 + ( section.isPacked ? 2 : 1 ) :
+                            chunks[i];
+        item.indexBuffer  = mIsUsingGeometryHeap ? section.indexRange.arena + 1  : chunks[i];
+        item.indexSize    = static_cast<unsigned int>( section.indexSize );
+
+        mDrawList.add( item );
+
+        mFrame.drawCalls++;
+        mFrame.triangles += triangles;
+
+        if ( isTranslucent )
+        {
+            mFrame.translucentDrawCalls++;
+        }
+    }
+
+    mDrawList.build();
+
+    const std::vector<DrawListBatch>& batches = mDrawList.batches();
+
+    for ( size_t i = 0; i < batches.size(); ++i )
+    {
+        const DrawListBatch& batch = batches[i];
+        bool isBinding = false;
+
+        if ( batch.pass != mBoundPass )
+        {
+            mFrame.stateChanges++;
+            mBoundPass = batch.pass;
+        }
+
+        if ( batch.vertexBuffer != mBoundVertexBuffer )
+        {
+            mFrame.stateChanges++;
+            mBoundVertexBuffer = batch.vertexBuffer;
+            isBinding = true;
+        }
+
+        if ( batch.indexBuffer != mBoundIndexBuffer )
+        {
+            mFrame.stateChanges++;
+            mBoundIndexBuffer = batch.indexBuffer;
+            isBinding = true;
+        }
+
+        if ( isBinding )
+        {
+            mFrame.bufferBinds++;
+        }
+
+        mFrame.batches++;
+    }
+}
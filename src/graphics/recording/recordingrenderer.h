@@ -0,0 +1,182 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_RECORDING_RENDERER_H
+#define SCOTT_CUBEWORLD_RECORDING_RENDERER_H
+
+#include <cstddef>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "graphics/drawlistbuilder.h"
+#include "graphics/geometryheap.h"
+#include "graphics/irenderer.h"
+#include "graphics/renderprimitives.h"
+
+class Point;
+struct WorldChunkMesh;
+
+/**
+ * What a RecordingRenderer saw over one frame. A frame ends when present is
+ * called
+ */
+struct RecordingFrameStats
+{
+    RecordingFrameStats()
+        : frame( 0 ),
+          drawCalls( 0 ),
+          translucentDrawCalls( 0 ),
+          batches( 0 ),
+          bufferBinds( 0 ),
+          stateChanges( 0 ),
+          triangles( 0 ),
+          skippedDraws( 0 ),
+          uploads( 0 ),
+          releases( 0 ),
+          uploadedBytes( 0 ),
+          transferredBytes( 0 ),
+          backlogBytes( 0 ),
+          liveBuffers( 0 ),
+          liveBytes( 0 )
+    {
+    }
+
+    // Single line JSON object holding every field
+    std::string toJson() const;
+
+    unsigned int frame;             // Frames presented before this one
+    unsigned int drawCalls;         // Opaque and translucent draws issued
+    unsigned int translucentDrawCalls;
+    unsigned int batches;           // Draw submissions, each covering one or
+                                    // more draws sharing the same buffers
+    unsigned int bufferBinds;       // Vertex and index buffer pairs bound
+    unsigned int stateChanges;      // Passes, vertex and index buffers switched
+    size_t triangles;               // Triangles drawn, in both passes
+    unsigned int skippedDraws;      // Sections whose upload hadn't finished
+    unsigned int uploads;           // Sections uploaded
+    unsigned int releases;          // Sections released
+    size_t uploadedBytes;           // Size of the sections uploaded
+    size_t transferredBytes;        // Bytes that made it across the bus
+    size_t backlogBytes;            // Bytes still waiting to be transferred
+    size_t liveBuffers;             // Sections uploaded and not released
+    size_t liveBytes;               // Memory held by the live sections
+};
+
+/**
+ * Headless renderer that draws nothing but keeps track of the load that a
+ * real one would be under: bytes uploaded and held, and draw calls and
+ * triangles per frame. Lets the render side of WorldView be measured on
+ * machines without a GPU.
+ *
+ * Uploads can be throttled to a fixed number of bytes per frame to simulate
+ * limited bus bandwidth. Sections wait in a queue until their bytes have
+ * been transferred, and drawing one before then is counted as a skipped
+ * draw rather than a draw call.
+ *
+ * By default each section gets buffers of its own, so every draw binds new
+ * buffers and is submitted on its own. With the geometry heap enabled
+ * sections are suballocated from shared vertex and index arenas instead, and
+ * draws from the same arenas are submitted as one multi-draw batch without
+ * binding anything in between. Opaque draws are sorted by arena first so
+ * that they share as few batches as possible (see DrawListBuilder).
+ */
+class RecordingRenderer : public IRenderer
+{
+public:
+    RecordingRenderer();
+    virtual ~RecordingRenderer();
+
+    virtual void clear();
+    virtual void present();
+    virtual void renderChunks( const std::vector<ChunkRenderId>& chunks );
+    virtual void renderTranslucentChunks( const std::vector<ChunkRenderId>& chunks );
+    virtual ChunkRenderId uploadChunkSection( const Point& origin,
+                                              unsigned int section,
+                                              const WorldChunkMesh& mesh );
+    virtual void releaseChunk( ChunkRenderId id );
+
+    // Limit uploads to this many bytes per frame, zero if unlimited
+    void setUploadBandwidth( size_t bytesPerFrame );
+
+    // Suballocate sections from shared arenas of this many bytes. Must be
+    // called before anything is uploaded
+    void enableGeometryHeap( size_t arenaBytes );
+
+    bool isUsingGeometryHeap() const;
+
+    // Sort opaque draws by the buffers they use, on by default
+    void setDrawSortingEnabled( bool isEnabled );
+
+    // Arenas holding section vertices and indices when the heap is enabled,
+    // float and packed vertices are kept apart
+    const GeometryHeap& vertexHeap() const;
+    const GeometryHeap& packedVertexHeap() const;
+    const GeometryHeap& indexHeap() const;
+
+    // Stats for the frame that is being recorded
+    const RecordingFrameStats& currentFrame() const;
+
+    // Stats for every frame that has been presented, oldest first
+    const std::vector<RecordingFrameStats>& frames() const;
+
+    // Write the presented frames out as a JSON array, one frame per line
+    void writeJson( std::ostream& stream ) const;
+
+    // GPU memory needed to hold a mesh's vertices and indices
+    static size_t meshBytes( const WorldChunkMesh& mesh );
+
+private:
+    struct Section
+    {
+        bool isLive;
+        bool isPacked;              // Vertices are in the packed format
+        size_t bytes;
+        size_t pendingBytes;        // Not transferred yet
+        unsigned int triangles;
+        unsigned int translucentTriangles;
+        size_t indexSize;                   // Bytes per index
+        GeometryRange vertexRange;          // Heap ranges, if enabled
+        GeometryRange indexRange;           // Opaque then translucent
+    };
+
+    void transfer();
+    void draw( const std::vector<ChunkRenderId>& chunks, bool isTranslucent );
+
+private:
+    std::vector<Section> mSections;         // Indexed by id - 1
+    std::vector<ChunkRenderId> mFreeIds;
+    std::deque<ChunkRenderId> mUploadQueue;
+    size_t mUploadBandwidth;
+    size_t mBandwidthLeft;
+    RecordingFrameStats mFrame;
+    std::vector<RecordingFrameStats> mFrames;
+
+    bool mIsUsingGeometryHeap;
+    GeometryHeap mVertexHeap;
+    GeometryHeap mPackedVertexHeap;
+    GeometryHeap mIndexHeap;
+
+    DrawListBuilder mDrawList;
+
+    // State left behind by the last batch of the frame. Buffers are numbered
+    // by arena + 1 with the heap and by section id without, zero if unbound
+    EDrawPass mBoundPass;
+    unsigned int mBoundVertexBuffer;
+    unsigned int mBoundIndexBuffer;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "graphics/rendercommandbuffer.h"
+#include "graphics/irenderer.h"
+
+#include <cassert>
+
+const size_t RenderCommandBuffer::MAX_RETAINED_MESHES = 32;
+
+RenderCommandBuffer::RenderCommandBuffer()
+    : mCommands(),
+      mChunkIds(),
+      mMeshes(),
+      mMeshCount( 0 ),
+      mTargetChunks()
+{
+}
+
+void RenderCommandBuffer::recordClear()
+{
+    Command command = { ERENDERCOMMAND_CLEAR, 0, Point(), 0, 0, 0 };
+    mCommands.push_back( command );
+}
+
+void RenderCommandBuffer::recordRenderChunks( const std::vector<ChunkRenderId>& chunks )
+{
+    recordChunks( ERENDERCOMMAND_RENDER_CHUNKS, chunks );
+}
+
+void RenderCommandBuffer::recordRenderTranslucentChunks(
+        const std::vector<ChunkRenderId>& chunks )
+{
+    recordChunks( ERENDERCOMMAND_RENDER_TRANSLUCENT_CHUNKS, chunks );
+}
+
+/**
+ * Copies the mesh into the next free mesh slot. Slots that were used by an
+ * earlier frame already have storage, which the copy reuses
+ */
+void RenderCommandBuffer::recordUploadChunkSection( ChunkRenderId id,
+                                                    const Point& origin,
+                                                    unsigned int section,
+                                                    const WorldChunkMesh& mesh )
+{
+    assert( id > 0 );
+
+    if ( mMeshCount == mMeshes.size() )
+    {
+        mMeshes.push_back( WorldChunkMesh() );
+    }
+
+    mMeshes[mMeshCount] = mesh;
+
+    Command command = { ERENDERCOMMAND_UPLOAD_CHUNK_SECTION, id, origin, section,
+                        mMeshCount, 0 };
+    mCommands.push_back( command );
+    mMeshCount++;
+}
+
+void RenderCommandBuffer::recordReleaseChunk( ChunkRenderId id )
+{
+    assert( id > 0 );
+
+    Command command = { ERENDERCOMMAND_RELEASE_CHUNK, id, Point(), 0, 0, 0 };
+    mCommands.push_back( command );
+}
+
+/**
+ * Plays the recorded calls back. Uploads add the target's id for the chunk
+ * to the id table, and releases clear it again
+ *
+ * \param  target     Renderer to make the calls on
+ * \param  targetIds  Target id of each proxy id, indexed by proxy id - 1
+ */
+void RenderCommandBuffer::execute( IRenderer& target,
+                                   std::vector<ChunkRenderId>& targetIds )
+{
+    for ( size_t i = 0; i < mCommands.size(); ++i )
+    {
+        const Command& command = mCommands[i];
+
+        switch ( command.type )
+        {
+            case ERENDERCOMMAND_CLEAR:
+                target.clear();
+                break;
+
+            case ERENDERCOMMAND_RENDER_CHUNKS:
+            case ERENDERCOMMAND_RENDER_TRANSLUCENT_CHUNKS:
+                mTargetChunks.clear();
+
+                for ( size_t c = 0; c < command.count; ++c )
+                {
+                    const ChunkRenderId id = mChunkIds[ command.first + c ];
+                    assert( id > 0 && id <= targetIds.size() && targetIds[id - 1] > 0 );
+
+                    mTargetChunks.push_back( targetIds[id - 1] );
+                }
+
+                if ( command.type == ERENDERCOMMAND_RENDER_CHUNKS )
+                {
+                    target.renderChunks( mTargetChunks );
+                }
+                else
+                {
+                    target.renderTranslucentChunks( mTargetChunks );
+                }
+                break;
+
+            case ERENDERCOMMAND_UPLOAD_CHUNK_SECTION:
+                if ( command.id > targetIds.size() )
+                {
+                    targetIds.resize( command.id, 0 );
+                }
+
+                targetIds[command.id - 1] =
+                    target.uploadChunkSection( command.origin,
+                                               command.section,
+                                               mMeshes[command.first] );
+                break;
+
+            case ERENDERCOMMAND_RELEASE_CHUNK:
+                assert( command.id <= targetIds.size() && targetIds[command.id - 1] > 0 );
+
+                target.releaseChunk( targetIds[command.id - 1] );
+                targetIds[command.id - 1] = 0;
+                break;
+        }
+    }
+}
+
+/**
+ * Forgets the recorded calls. Mesh slots past MAX_RETAINED_MESHES are freed
+ */
+void RenderCommandBuffer::reset()
+{
+    mCommands.clear();
+    mChunkIds.clear();
+    mMeshCount = 0;
+
+    if ( mMeshes.size() > MAX_RETAINED_MESHES )
+    {
+        mMeshes.resize( MAX_RETAINED_MESHES );
+    }
+}
+
+size_t RenderCommandBuffer::commandCount() const
+{
+    return mCommands.size();
+}
+
+bool RenderCommandBuffer::empty() const
+{
+    return mCommands.empty();
+}
+
+ERenderCommand RenderCommandBuffer::commandAt( size_t index ) const
+{
+    assert( index < mCommands.size() );
+    return mCommands[index].type;
+}
+
+size_t RenderCommandBuffer::retainedMeshCount() const
+{
+    return mMeshes.size();
+}
+
+void RenderCommandBuffer::recordChunks( ERenderCommand type,
+                                        const std::vector<ChunkRenderId>& chunks )
+{
+    Command command = { type, 0, Point(), 0, mChunkIds.size(), chunks.size() };
+    mCommands.push_back( command );
+    mChunkIds.insert( mChunkIds.end(), chunks.begin(), chunks.end() );
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_RENDER_COMMAND_BUFFER_H
+#define SCOTT_CUBEWORLD_RENDER_COMMAND_BUFFER_H
+
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "engine/point.h"
+#include "graphics/renderprimitives.h"
+#include "graphics/worldchunkmesh.h"
+
+class IRenderer;
+
+/**
+ * Types of calls that a RenderCommandBuffer can record
+ */
+enum ERenderCommand
+{
+    ERENDERCOMMAND_CLEAR,
+    ERENDERCOMMAND_RENDER_CHUNKS,
+    ERENDERCOMMAND_RENDER_TRANSLUCENT_CHUNKS,
+    ERENDERCOMMAND_UPLOAD_CHUNK_SECTION,
+    ERENDERCOMMAND_RELEASE_CHUNK
+};
+
+/**
+ * A frame's worth of IRenderer calls, recorded on one thread to be played
+ * back against a renderer on another. Uploaded meshes are copied in, since
+ * the caller is free to reuse its mesh as soon as the upload call returns.
+ *
+ * Chunks are named by proxy ids that the recording side hands out, because
+ * the real id only exists once the upload has been played back. Playback
+ * keeps a table from proxy ids to the target renderer's ids, which has to
+ * be carried from one frame's playback to the next.
+ *
+ * Resetting a buffer keeps its memory, including the vertex and index
+ * storage of up to MAX_RETAINED_MESHES of the meshes it held, so recording
+ * stops allocating once the buffer has grown to fit a typical frame. Mesh
+ * slots past that are freed, so a frame that uploads a whole world while
+ * loading doesn't leave every mesh's storage behind.
+ */
+class RenderCommandBuffer : boost::noncopyable
+{
+public:
+    // Mesh slots kept across a reset
+    const static size_t MAX_RETAINED_MESHES;
+
+    RenderCommandBuffer();
+
+    void recordClear();
+    void recordRenderChunks( const std::vector<ChunkRenderId>& chunks );
+    void recordRenderTranslucentChunks( const std::vector<ChunkRenderId>& chunks );
+    void recordUploadChunkSection( ChunkRenderId id,
+                                   const Point& origin,
+                                   unsigned int section,
+                                   const WorldChunkMesh& mesh );
+    void recordReleaseChunk( ChunkRenderId id );
+
+    // Play the recorded calls back against a renderer, in the order they were
+    // recorded. targetIds maps proxy id - 1 to the target's id for that chunk
+    void execute( IRenderer& target, std::vector<ChunkRenderId>& targetIds );
+
+    // Forget every recorded call
+    void reset();
+
+    // Number of calls recorded since the last reset
+    size_t commandCount() const;
+
+    bool empty() const;
+
+    // Type of a recorded call
+    ERenderCommand commandAt( size_t index ) const;
+
+    // Number of mesh slots holding storage, in use or not
+    size_t retainedMeshCount() const;
+
+private:
+    struct Command
+    {
+        ERenderCommand type;
+        ChunkRenderId id;           // Upload and release
+        Point origin;               // Upload
+        unsigned int section;       // Upload
+        size_t first;               // Index of a mesh, or the first chunk id
+        size_t count;               // Number of chunk ids
+    };
+
+    void recordChunks( ERenderCommand type,
+                       const std::vector<ChunkRenderId>& chunks );
+
+private:
+    std::vector<Command> mCommands;
+    std::vector<ChunkRenderId> mChunkIds;   // Id lists of every draw command
+
+    // Meshes of the uploads, only the first mMeshCount are in use
+    std::vector<WorldChunkMesh> mMeshes;
+    size_t mMeshCount;
+
+    // Draw list translated to the target's ids during playback
+    std::vector<ChunkRenderId> mTargetChunks;
+};
+
+#endif
@@ -0,0 +1,397 @@
+#include "graphics/software/softwarerasterizer.h"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+const unsigned int SoftwareRasterizer::TILE_SIZE  = 64;
+const unsigned int SoftwareRasterizer::BLOCK_SIZE = 8;
+
+SoftwareRasterizer::SoftwareRasterizer( unsigned int width,
+                                        unsigned int height,
+                                        unsigned int threadCount )
+    : mWidth( width ),
+      mHeight( height ),
+      mPitch( ( width + BLOCK_SIZE - 1 ) / BLOCK_SIZE * BLOCK_SIZE ),
+      mPaddedHeight( ( height + BLOCK_SIZE - 1 ) / BLOCK_SIZE * BLOCK_SIZE ),
+      mThreadCount( threadCount ),
+      mTileCols( ( width + TILE_SIZE - 1 ) / TILE_SIZE ),
+      mTileRows( ( height + TILE_SIZE - 1 ) / TILE_SIZE ),
+      mColor( mPitch * mPaddedHeight, 0 ),
+      mDepth( mPitch * mPaddedHeight, 1.0f ),
+      mBlockMaxDepth( ( mPitch / BLOCK_SIZE ) * ( mPaddedHeight / BLOCK_SIZE ), 1.0f ),
+      mTriangles(),
+      mBins( mTileCols * mTileRows ),
+      mQueuedStats(),
+      mStats()
+{
+    assert( width > 0 && height > 0 );
+
+    if ( mThreadCount == 0 )
+    {
+        mThreadCount = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+}
+
+void SoftwareRasterizer::clear( uint32_t color )
+{
+    std::fill( mColor.begin(), mColor.end(), color );
+    std::fill( mDepth.begin(), mDepth.end(), 1.0f );
+    std::fill( mBlockMaxDepth.begin(), mBlockMaxDepth.end(), 1.0f );
+}
+
+/**
+ * Sets up a triangle's edge functions and interpolation planes, and adds it
+ * to the bin of every tile its bounding box touches. Triangles that are
+ * degenerate, wound the wrong way or off screen are dropped.
+ */
+void SoftwareRasterizer::addTriangle( const ScreenVertex& a,
+                                      const ScreenVertex& b,
+                                      const ScreenVertex& c,
+                                      uint32_t color,
+                                      bool isTranslucent )
+{
+    const float area = ( b.x - a.x ) * ( c.y - a.y ) - ( c.x - a.x ) * ( b.y - a.y );
+
+    if (!( area > 0.0f ) )
+    {
+        return;
+    }
+
+    Triangle t;
+    t.minX = std::max( 0, static_cast<int>( std::floor( std::min( a.x, std::min( b.x, c.x ) ) ) ) );
+    t.minY = std::max( 0, static_cast<int>( std::floor( std::min( a.y, std::min( b.y, c.y ) ) ) ) );
+    t.maxX = std::min( static_cast<int>( mWidth ) - 1,
+                       static_cast<int>( std::ceil( std::max( a.x, std::max( b.x, c.x ) ) ) ) );
+    t.maxY = std::min( static_cast<int>( mHeight ) - 1,
+                       static_cast<int>( std::ceil( std::max( a.y, std::max( b.y, c.y ) ) ) ) );
+
+    if ( t.minX > t.maxX || t.minY > t.maxY )
+    {
+        return;
+    }
+
+    const ScreenVertex * corners[3] = { &a, &b, &c };
+
+    for ( int e = 0; e < 3; ++e )
+    {
+        const ScreenVertex& p = *corners[e];
+        const ScreenVertex& q = *corners[( e + 1 ) % 3];
+
+        t.a[e] = p.y - q.y;
+        t.b[e] = q.x - p.x;
+        t.c[e] = -( t.a[e] * p.x + t.b[e] * p.y );
+
+        // Top left rule, so pixels on an edge shared by two triangles are
+        // only drawn once
+        t.ownsEdge[e] = ( t.a[e] > 0.0f || ( t.a[e] == 0.0f && t.b[e] < 0.0f ) );
+    }
+
+    // Depth and shade vary linearly over the screen
+    const float dx1 = b.x - a.x, dy1 = b.y - a.y;
+    const float dx2 = c.x - a.x, dy2 = c.y - a.y;
+    const float inverseArea = 1.0f / area;
+
+    const float dz1 = b.z - a.z, dz2 = c.z - a.z;
+    t.depth[0] = ( dz1 * dy2 - dz2 * dy1 ) * inverseArea;
+    t.depth[1] = ( dz2 * dx1 - dz1 * dx2 ) * inverseArea;
+    t.depth[2] = a.z - t.depth[0] * a.x - t.depth[1] * a.y;
+
+    const float ds1 = b.shade - a.shade, ds2 = c.shade - a.shade;
+    t.shade[0] = ( ds1 * dy2 - ds2 * dy1 ) * inverseArea;
+    t.shade[1] = ( ds2 * dx1 - ds1 * dx2 ) * inverseArea;
+    t.shade[2] = a.shade - t.shade[0] * a.x - t.shade[1] * a.y;
+
+    t.minDepth      = std::min( a.z, std::min( b.z, c.z ) );
+    t.color         = color;
+    t.isTranslucent = isTranslucent;
+
+    const uint32_t index = static_cast<uint32_t>( mTriangles.size() );
+    mTriangles.push_back( t );
+    mQueuedStats.triangles++;
+
+    for ( int ty = t.minY / TILE_SIZE; ty <= t.maxY / static_cast<int>( TILE_SIZE ); ++ty )
+    {
+        for ( int tx = t.minX / TILE_SIZE; tx <= t.maxX / static_cast<int>( TILE_SIZE ); ++tx )
+        {
+            mBins[ty * mTileCols + tx].push_back( index );
+            mQueuedStats.binnedTriangles++;
+        }
+    }
+}
+
+/**
+ * Rasterizes every queued triangle. Tiles are independent of each other, so
+ * each worker takes the next undrawn tile until there are none left
+ */
+void SoftwareRasterizer::draw()
+{
+    const unsigned int tileCount = mTileCols * mTileRows;
+    const unsigned int threadCount = std::min( mThreadCount, tileCount );
+
+    mStats = mQueuedStats;
+
+    if ( threadCount <= 1 )
+    {
+        for ( unsigned int tile = 0; tile < tileCount; ++tile )
+        {
+            drawTile( tile, mStats );
+        }
+    }
+    else
+    {
+        std::vector<SoftwareRasterStats> workerStats( threadCount );
+        std::vector<std::thread> workers;
+        std::atomic<unsigned int> nextTile( 0 );
+
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            SoftwareRasterStats * pStats = &workerStats[t];
+
+            workers.push_back( std::thread( [&, pStats]()
+            {
+                unsigned int tile = 0;
+
+                while ( ( tile = nextTile.fetch_add( 1 ) ) < tileCount )
+                {
+                    drawTile( tile, *pStats );
+                }
+            } ) );
+        }
+
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            workers[t].join();
+
+            mStats.blocksDrawn    += workerStats[t].blocksDrawn;
+            mStats.blocksRejected += workerStats[t].blocksRejected;
+        }
+    }
+
+    mTriangles.clear();
+    mQueuedStats = SoftwareRasterStats();
+
+    for ( size_t i = 0; i < mBins.size(); ++i )
+    {
+        mBins[i].clear();
+    }
+}
+
+unsigned int SoftwareRasterizer::width() const
+{
+    return mWidth;
+}
+
+unsigned int SoftwareRasterizer::height() const
+{
+    return mHeight;
+}
+
+unsigned int SoftwareRasterizer::pitch() const
+{
+    return mPitch;
+}
+
+const uint32_t * SoftwareRasterizer::pixels() const
+{
+    return &mColor[0];
+}
+
+uint32_t SoftwareRasterizer::pixel( unsigned int x, unsigned int y ) const
+{
+    assert( x < mWidth && y < mHeight );
+    return mColor[y * mPitch + x];
+}
+
+float SoftwareRasterizer::depth( unsigned int x, unsigned int y ) const
+{
+    assert( x < mWidth && y < mHeight );
+    return mDepth[y * mPitch + x];
+}
+
+const SoftwareRasterStats& SoftwareRasterizer::stats() const
+{
+    return mStats;
+}
+
+/**
+ * Draws the triangles binned to one tile, in the order they were added.
+ * Blocks that lie outside of any edge, or behind everything already drawn
+ * in them, are skipped without looking at their pixels.
+ */
+void SoftwareRasterizer::drawTile( unsigned int tile, SoftwareRasterStats& stats )
+{
+    const std::vector<uint32_t>& bin = mBins[tile];
+    const int tileX = static_cast<int>( ( tile % mTileCols ) * TILE_SIZE );
+    const int tileY = static_cast<int>( ( tile / mTileCols ) * TILE_SIZE );
+    const int tileMaxX = std::min( tileX + TILE_SIZE, mWidth ) - 1;
+    const int tileMaxY = std::min( tileY + TILE_SIZE, mHeight ) - 1;
+    const int blockMask = ~( static_cast<int>( BLOCK_SIZE ) - 1 );
+    const int blocksPerRow = static_cast<int>( mPitch / BLOCK_SIZE );
+
+    for ( size_t i = 0; i < bin.size(); ++i )
+    {
+        const Triangle& t = mTriangles[ bin[i] ];
+
+        const int minX = std::max( t.minX, tileX ) & blockMask;
+        const int minY = std::max( t.minY, tileY ) & blockMask;
+        const int maxX = std::min( t.maxX, tileMaxX );
+        const int maxY = std::min( t.maxY, tileMaxY );
+
+        for ( int blockY = minY; blockY <= maxY; blockY += BLOCK_SIZE )
+        {
+            for ( int blockX = minX; blockX <= maxX; blockX += BLOCK_SIZE )
+            {
+                // If the block corner that is furthest inside an edge is
+                // still outside of it, so is the rest of the block
+                bool isOutside = false;
+
+                for ( int e = 0; e < 3 && !isOutside; ++e )
+                {
+                    const float x = blockX + ( t.a[e] >= 0.0f ? BLOCK_SIZE - 0.5f : 0.5f );
+                    const float y = blockY + ( t.b[e] >= 0.0f ? BLOCK_SIZE - 0.5f : 0.5f );
+
+                    isOutside = ( t.a[e] * x + t.b[e] * y + t.c[e] < 0.0f );
+                }
+
+                if ( isOutside )
+                {
+                    continue;
+                }
+
+                const int block = ( blockY / BLOCK_SIZE ) * blocksPerRow +
+                                  blockX / BLOCK_SIZE;
+
+                if ( t.minDepth >= mBlockMaxDepth[block] )
+                {
+                    stats.blocksRejected++;
+                    continue;
+                }
+
+                drawBlock( t, blockX, blockY );
+                stats.blocksDrawn++;
+            }
+        }
+    }
+}
+
+/**
+ * Rasterizes the part of a triangle that falls in one 8x8 block, four
+ * pixels at a time. Blocks on the right and bottom edges of an image whose
+ * size isn't a multiple of eight spill into the padding around it. Opaque triangles then refresh the block's farthest
+ * depth for the hierarchical test.
+ */
+void SoftwareRasterizer::drawBlock( const Triangle& t, int blockX, int blockY )
+{
+    const __m128 zero   = _mm_setzero_ps();
+    const __m128 one    = _mm_set1_ps( 1.0f );
+    const __m128 offset = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+
+    const __m128 red   = _mm_set1_ps( static_cast<float>( ( t.color >> 16 ) & 0xff ) );
+    const __m128 green = _mm_set1_ps( static_cast<float>( ( t.color >> 8 ) & 0xff ) );
+    const __m128 blue  = _mm_set1_ps( static_cast<float>( t.color & 0xff ) );
+    const __m128i alpha    = _mm_set1_epi32( static_cast<int>( 0xff000000u ) );
+    const __m128i halfMask = _mm_set1_epi32( 0x007f7f7f );
+
+    bool isWritten = false;
+
+    for ( unsigned int row = 0; row < BLOCK_SIZE; ++row )
+    {
+        const int y = blockY + static_cast<int>( row );
+        const float pixelY = y + 0.5f;
+
+        for ( unsigned int column = 0; column < BLOCK_SIZE; column += 4 )
+        {
+            const int x = blockX + static_cast<int>( column );
+            const __m128 pixelX = _mm_add_ps( _mm_set1_ps( static_cast<float>( x ) ), offset );
+
+            // Coverage from the three edge functions
+            __m128 mask = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+
+            for ( int e = 0; e < 3; ++e )
+            {
+                const __m128 edge = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( t.a[e] ), pixelX ),
+                                                _mm_set1_ps( t.b[e] * pixelY + t.c[e] ) );
+
+                mask = _mm_and_ps( mask, t.ownsEdge[e] ? _mm_cmpge_ps( edge, zero )
+                                                       : _mm_cmpgt_ps( edge, zero ) );
+            }
+
+            if ( _mm_movemask_ps( mask ) == 0 )
+            {
+                continue;
+            }
+
+            // Depth test
+            float * pDepth = &mDepth[y * mPitch + x];
+            const __m128 oldDepth = _mm_loadu_ps( pDepth );
+            const __m128 depth = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( t.depth[0] ), pixelX ),
+                                             _mm_set1_ps( t.depth[1] * pixelY + t.depth[2] ) );
+
+            mask = _mm_and_ps( mask, _mm_cmplt_ps( depth, oldDepth ) );
+
+            if ( _mm_movemask_ps( mask ) == 0 )
+            {
+                continue;
+            }
+
+            // Shade the triangle's color and pack it as 0xAARRGGBB
+            __m128 shade = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( t.shade[0] ), pixelX ),
+                                       _mm_set1_ps( t.shade[1] * pixelY + t.shade[2] ) );
+            shade = _mm_min_ps( _mm_max_ps( shade, zero ), one );
+
+            __m128i color = _mm_or_si128(
+                _mm_or_si128( _mm_slli_epi32( _mm_cvtps_epi32( _mm_mul_ps( shade, red ) ), 16 ),
+                              _mm_slli_epi32( _mm_cvtps_epi32( _mm_mul_ps( shade, green ) ), 8 ) ),
+                _mm_cvtps_epi32( _mm_mul_ps( shade, blue ) ) );
+
+            uint32_t * pColor = &mColor[y * mPitch + x];
+            const __m128i oldColor = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pColor ) );
+
+            if ( t.isTranslucent )
+            {
+                // Average with what is behind, a channel at a time
+                color = _mm_add_epi32( _mm_and_si128( _mm_srli_epi32( color, 1 ), halfMask ),
+                                       _mm_and_si128( _mm_srli_epi32( oldColor, 1 ), halfMask ) );
+            }
+            else
+            {
+                _mm_storeu_ps( pDepth, _mm_or_ps( _mm_and_ps( mask, depth ),
+                                                  _mm_andnot_ps( mask, oldDepth ) ) );
+                isWritten = true;
+            }
+
+            const __m128i colorMask = _mm_castps_si128( mask );
+            color = _mm_or_si128( color, alpha );
+
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( pColor ),
+                              _mm_or_si128( _mm_and_si128( colorMask, color ),
+                                            _mm_andnot_si128( colorMask, oldColor ) ) );
+        }
+    }
+
+    if ( isWritten )
+    {
+        __m128 farthest = _mm_setzero_ps();
+
+        for ( unsigned int row = 0; row < BLOCK_SIZE; ++row )
+        {
+            const float * pDepth = &mDepth[( blockY + row ) * mPitch + blockX];
+            farthest = _mm_max_ps( farthest, _mm_loadu_ps( pDepth ) );
+            farthest = _mm_max_ps( farthest, _mm_loadu_ps( pDepth + 4 ) );
+        }
+
+        float values[4];
+        _mm_storeu_ps( values, farthest );
+
+        const int block = ( blockY / BLOCK_SIZE ) * ( mPitch / BLOCK_SIZE ) +
+                          blockX / BLOCK_SIZE;
+        mBlockMaxDepth[block] = std::max( std::max( values[0], values[1] ),
+                                          std::max( values[2], values[3] ) );
+    }
+}
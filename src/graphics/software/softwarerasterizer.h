@@ -0,0 +1,159 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_SOFTWARE_RASTERIZER_H
+#define SCOTT_CUBEWORLD_SOFTWARE_RASTERIZER_H
+
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Corner of a triangle that has been projected onto the screen. x and y are
+ * in pixels with y pointing down, z is depth from 0 (near) to 1 (far) and
+ * shade is the brightness of the corner
+ */
+struct ScreenVertex
+{
+    float x;
+    float y;
+    float z;
+    float shade;
+};
+
+/**
+ * Counters for the last frame a SoftwareRasterizer drew
+ */
+struct SoftwareRasterStats
+{
+    SoftwareRasterStats()
+        : triangles( 0 ),
+          binnedTriangles( 0 ),
+          blocksDrawn( 0 ),
+          blocksRejected( 0 )
+    {
+    }
+
+    size_t triangles;           // Triangles set up for drawing
+    size_t binnedTriangles;     // Triangles times the tiles each one touches
+    size_t blocksDrawn;         // 8x8 pixel blocks rasterized
+    size_t blocksRejected;      // Blocks skipped by the hierarchical depth test
+};
+
+/**
+ * Draws screen space triangles into a 32 bit color buffer on the CPU.
+ *
+ * Triangles are set up as they are added, and binned into 64x64 pixel tiles
+ * by their bounding boxes. Drawing then hands whole tiles to worker threads,
+ * so no two threads ever touch the same pixel and no locking is needed.
+ * Within a tile triangles are drawn in the order they were added, 8x8 block
+ * by block, four pixels at a time using SSE2 edge functions.
+ *
+ * Each block also keeps the farthest depth stored in it. A triangle whose
+ * nearest point is behind that is skipped for the whole block without
+ * testing a single pixel, which removes most of the hidden surfaces in a
+ * cave world cheaply.
+ *
+ * Translucent triangles are depth tested but don't write depth, and are
+ * blended half and half with what is already in the color buffer.
+ */
+class SoftwareRasterizer : boost::noncopyable
+{
+public:
+    // Any size works, the buffers are padded to whole 8x8 blocks. With zero
+    // threads one is used per hardware thread
+    SoftwareRasterizer( unsigned int width,
+                        unsigned int height,
+                        unsigned int threadCount = 0 );
+
+    const static unsigned int TILE_SIZE;
+    const static unsigned int BLOCK_SIZE;
+
+    // Fill the color buffer and reset the depth buffer
+    void clear( uint32_t color );
+
+    // Queue a triangle, whose corners must be clockwise on screen
+    void addTriangle( const ScreenVertex& a,
+                      const ScreenVertex& b,
+                      const ScreenVertex& c,
+                      uint32_t color,
+                      bool isTranslucent );
+
+    // Draw every queued triangle, then forget them
+    void draw();
+
+    unsigned int width() const;
+    unsigned int height() const;
+
+    // Pixels between the start of one row and the next, the width rounded
+    // up to a multiple of eight
+    unsigned int pitch() const;
+
+    // Pixels as 0xAARRGGBB, one row after another starting at the top. Rows
+    // are pitch() pixels apart, the ones past the width are padding
+    const uint32_t * pixels() const;
+    uint32_t pixel( unsigned int x, unsigned int y ) const;
+
+    // Depth of a pixel, 1 if nothing has been drawn there
+    float depth( unsigned int x, unsigned int y ) const;
+
+    // Counters for the last call to draw
+    const SoftwareRasterStats& stats() const;
+
+private:
+    struct Triangle
+    {
+        // Edge functions a * x + b * y + c, positive inside the triangle.
+        // Pixels exactly on an edge belong to it if ownsEdge is set
+        float a[3];
+        float b[3];
+        float c[3];
+        bool ownsEdge[3];
+
+        // Depth and shade as planes over the screen, p[0] * x + p[1] * y + p[2]
+        float depth[3];
+        float shade[3];
+
+        float minDepth;
+        int minX, minY, maxX, maxY;     // Pixel bounds, inclusive
+        uint32_t color;
+        bool isTranslucent;
+    };
+
+    void drawTile( unsigned int tile, SoftwareRasterStats& stats );
+    void drawBlock( const Triangle& triangle, int blockX, int blockY );
+
+private:
+    unsigned int mWidth;
+    unsigned int mHeight;
+    unsigned int mPitch;            // Width rounded up to whole blocks
+    unsigned int mPaddedHeight;     // Height rounded up to whole blocks
+    unsigned int mThreadCount;
+    unsigned int mTileCols;
+    unsigned int mTileRows;
+
+    std::vector<uint32_t> mColor;
+    std::vector<float>    mDepth;
+    std::vector<float>    mBlockMaxDepth;   // Farthest depth in each block
+
+    std::vector<Triangle> mTriangles;
+    std::vector< std::vector<uint32_t> > mBins;    // Triangles per tile
+
+    SoftwareRasterStats mQueuedStats;   // Triangles added since the last draw
+    SoftwareRasterStats mStats;
+};
+
+#endif
@@ -0,0 +1,347 @@
+#include "graphics/software/softwarerenderer.h"
+#include "graphics/worldchunkmesh.h"
+#include "engine/cubeface.h"
+#include "engine/point.h"
+#include "math/vector.h"
+
+#include <tga.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+const uint32_t SoftwareRenderer::SKY_COLOR = 0xff87b4e6;
+
+namespace
+{
+    const uint32_t STONE_COLOR = 0xffc8bea5;
+    const uint32_t WATER_COLOR = 0xff3c78d2;
+
+    const float NEAR_PLANE = 0.1f;
+
+    /**
+     * Brightness of a vertex: a fixed sun plus some ambient light, dimmed
+     * where the corner is occluded
+     */
+    float shadeVertex( const float normal[3], float occlusion )
+    {
+        const float sun[3] = { 0.32f, 0.48f, 0.82f };
+        const float diffuse = std::max( 0.0f, normal[0] * sun[0] +
+                                              normal[1] * sun[1] +
+                                              normal[2] * sun[2] );
+
+        return ( 0.45f + 0.55f * diffuse ) * ( 1.0f - 0.5f * occlusion );
+    }
+
+    /**
+     * Float vertices don't carry ambient occlusion, so they are only lit
+     */
+    float shadeVertex( const CubeVertex& v )
+    {
+        return shadeVertex( v.normal, 0.0f );
+    }
+
+    /**
+     * Packed vertices only know their face, which gives the normal, and
+     * their occlusion from 0 to 3
+     */
+    float shadeVertex( const PackedCubeVertex& v )
+    {
+        const ECubeFace face = static_cast<ECubeFace>( v.face() );
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        normal[ CubeFace::axis( face ) ] = static_cast<float>( CubeFace::direction( face ) );
+
+        return shadeVertex( normal, v.ao / 3.0f );
+    }
+
+    struct ClipVertex
+    {
+        Vec3 position;      // Camera space, z is the distance in front
+        float shade;
+    };
+
+    ClipVertex lerp( const ClipVertex& a, const ClipVertex& b, float t )
+    {
+        ClipVertex v;
+        v.position = a.position + ( b.position - a.position ) * t;
+        v.shade    = a.shade + ( b.shade - a.shade ) * t;
+        return v;
+    }
+
+    /**
+     * Clips a triangle to the part in front of the near plane, which is
+     * either nothing, a triangle or a quad
+     */
+    int clipNear( const ClipVertex input[3], ClipVertex output[4] )
+    {
+        int count = 0;
+
+        for ( int i = 0; i < 3; ++i )
+        {
+            const ClipVertex& a = input[i];
+            const ClipVertex& b = input[( i + 1 ) % 3];
+            const bool isAInside = a.position.z() >= NEAR_PLANE;
+            const bool isBInside = b.position.z() >= NEAR_PLANE;
+
+            if ( isAInside )
+            {
+                output[count++] = a;
+            }
+
+            if ( isAInside != isBInside )
+            {
+                const float t = ( NEAR_PLANE - a.position.z() ) /
+                                ( b.position.z() - a.position.z() );
+                output[count++] = lerp( a, b, t );
+            }
+        }
+
+        return count;
+    }
+}
+
+SoftwareRenderer::SoftwareRenderer( unsigned int width,
+                                    unsigned int height,
+                                    unsigned int threadCount )
+    : mSections(),
+      mFreeIds(),
+      mRasterizer( width, height, threadCount ),
+      mCamera(),
+      mFieldOfView( 60.0f ),
+      mViewPositions()
+{
+    mRasterizer.clear( SKY_COLOR );
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+}
+
+void SoftwareRenderer::clear()
+{
+    mRasterizer.clear( SKY_COLOR );
+}
+
+void SoftwareRenderer::present()
+{
+    mRasterizer.draw();
+}
+
+void SoftwareRenderer::renderChunks( const std::vector<ChunkRenderId>& chunks )
+{
+    drawSections( chunks, false );
+}
+
+void SoftwareRenderer::renderTranslucentChunks( const std::vector<ChunkRenderId>& chunks )
+{
+    drawSections( chunks, true );
+}
+
+/**
+ * Keeps a world space copy of the mesh, with each vertex's lighting worked
+ * out up front. Takes meshes with either vertex format
+ */
+ChunkRenderId SoftwareRenderer::uploadChunkSection( const Point& origin,
+                                                    unsigned int,
+                                                    const WorldChunkMesh& mesh )
+{
+    ChunkRenderId id;
+
+    if (! mFreeIds.empty() )
+    {
+        id = mFreeIds.back();
+        mFreeIds.pop_back();
+    }
+    else
+    {
+        mSections.push_back( Section() );
+        id = static_cast<ChunkRenderId>( mSections.size() );
+    }
+
+    Section& section = mSections[id - 1];
+    section.isLive = true;
+    section.positions.resize( mesh.vertexCount() );
+    section.shades.resize( mesh.vertexCount() );
+
+    for ( size_t i = 0; i < mesh.vertices.size(); ++i )
+    {
+        const CubeVertex& v = mesh.vertices[i];
+
+        section.positions[i] = Vec3( origin.x + v.pos[0],
+                                     origin.y + v.pos[1],
+                                     origin.z + v.pos[2] );
+        section.shades[i] = shadeVertex( v );
+    }
+
+    for ( size_t i = 0; i < mesh.packedVertices.size(); ++i )
+    {
+        const PackedCubeVertex& v = mesh.packedVertices[i];
+
+        section.positions[i] = Vec3( static_cast<float>( origin.x + v.pos[0] ),
+                                     static_cast<float>( origin.y + v.pos[1] ),
+                                     static_cast<float>( origin.z + v.pos[2] ) );
+        section.shades[i] = shadeVertex( v );
+    }
+
+    section.indices.resize( mesh.indices.size() );
+    section.translucentIndices.resize( mesh.translucentIndices.size() );
+
+    for ( size_t i = 0; i < mesh.indices.size(); ++i )
+    {
+        section.indices[i] = mesh.indices[i];
+    }
+
+    for ( size_t i = 0; i < mesh.translucentIndices.size(); ++i )
+    {
+        section.translucentIndices[i] = mesh.translucentIndices[i];
+    }
+
+    return id;
+}
+
+void SoftwareRenderer::releaseChunk( ChunkRenderId id )
+{
+    assert( id > 0 && id <= mSections.size() );
+    Section& section = mSections[id - 1];
+    assert( section.isLive );
+
+    section.isLive = false;
+    section.positions.clear();
+    section.shades.clear();
+    section.indices.clear();
+    section.translucentIndices.clear();
+
+    mFreeIds.push_back( id );
+}
+
+void SoftwareRenderer::setCamera( const Camera& camera )
+{
+    mCamera = camera;
+}
+
+void SoftwareRenderer::setFieldOfView( float degrees )
+{
+    mFieldOfView = degrees;
+}
+
+/**
+ * TGA images are stored bottom row first, in BGRA order, which is how the
+ * 0xAARRGGBB pixels are laid out in memory on a little endian machine
+ */
+bool SoftwareRenderer::saveFrame( const char * pFilename ) const
+{
+    const unsigned int width  = mRasterizer.width();
+    const unsigned int height = mRasterizer.height();
+    const size_t rowBytes = width * sizeof(uint32_t);
+
+    uint8_t * pPixels = new uint8_t[height * rowBytes];
+
+    for ( unsigned int y = 0; y < height; ++y )
+    {
+        std::memcpy( pPixels + ( height - 1 - y ) * rowBytes,
+                     mRasterizer.pixels() + y * mRasterizer.pitch(),
+                     rowBytes );
+    }
+
+    // The image owns the pixels from here on
+    TGA::TgaImage image( width, height, 32, pPixels );
+    return TGA::saveTGA( pFilename, image );
+}
+
+const SoftwareRasterizer& SoftwareRenderer::rasterizer() const
+{
+    return mRasterizer;
+}
+
+/**
+ * Transforms the sections into camera space, clips their triangles against
+ * the near plane, projects them and queues the ones that face the camera
+ */
+void SoftwareRenderer::drawSections( const std::vector<ChunkRenderId>& chunks,
+                                     bool isTranslucent )
+{
+    const Vec3 center    = mCamera.center();
+    const Vec3 forward   = normalized( mCamera.direction() );
+    const Vec3 right     = normalized( cross( forward, mCamera.up() ) );
+    const Vec3 up        = cross( right, forward );
+    const float farPlane = mCamera.viewDistance();
+
+    const float width  = static_cast<float>( mRasterizer.width() );
+    const float height = static_cast<float>( mRasterizer.height() );
+    const float focal  = 1.0f / std::tan( mFieldOfView * 0.5f * 3.14159265f / 180.0f );
+
+    // Screen space scale of x / z and y / z, and depth as a / z + b
+    const float scaleX = 0.5f * width * focal * height / width;
+    const float scaleY = 0.5f * height * focal;
+    const float depthA = -NEAR_PLANE * farPlane / ( farPlane - NEAR_PLANE );
+    const float depthB = farPlane / ( farPlane - NEAR_PLANE );
+
+    const uint32_t color = isTranslucent ? WATER_COLOR : STONE_COLOR;
+
+    for ( size_t c = 0; c < chunks.size(); ++c )
+    {
+        assert( chunks[c] > 0 && chunks[c] <= mSections.size() );
+        const Section& section = mSections[ chunks[c] - 1 ];
+        const std::vector<uint32_t>& indices = isTranslucent ?
+                                               section.translucentIndices :
+                                               section.indices;
+
+        if ( indices.empty() )
+        {
+            continue;
+        }
+
+        mViewPositions.resize( section.positions.size() );
+
+        for ( size_t i = 0; i < section.positions.size(); ++i )
+        {
+            const Vec3 d = section.positions[i] - center;
+            mViewPositions[i] = Vec3( dot( d, right ), dot( d, up ), dot( d, forward ) );
+        }
+
+        for ( size_t i = 0; i + 2 < indices.size(); i += 3 )
+        {
+            ClipVertex corners[3];
+
+            for ( int k = 0; k < 3; ++k )
+            {
+                corners[k].position = mViewPositions[ indices[i + k] ];
+                corners[k].shade    = section.shades[ indices[i + k] ];
+            }
+
+            if ( corners[0].position.z() > farPlane &&
+                 corners[1].position.z() > farPlane &&
+                 corners[2].position.z() > farPlane )
+            {
+                continue;
+            }
+
+            ClipVertex clipped[4];
+            const int count = clipNear( corners, clipped );
+
+            ScreenVertex screen[4];
+
+            for ( int k = 0; k < count; ++k )
+            {
+                const Vec3& p = clipped[k].position;
+                const float inverseZ = 1.0f / p.z();
+
+                screen[k].x     = 0.5f * width  + p.x() * inverseZ * scaleX;
+                screen[k].y     = 0.5f * height - p.y() * inverseZ * scaleY;
+                screen[k].z     = depthA * inverseZ + depthB;
+                screen[k].shade = clipped[k].shade;
+            }
+
+            // Mesh triangles wind counter clockwise seen from the front,
+            // which is clockwise once y points down the screen. Swapping two
+            // corners gives the rasterizer the winding it wants, and leaves
+            // back faces wound the wrong way for it to drop
+            for ( int k = 1; k + 1 < count; ++k )
+            {
+                mRasterizer.addTriangle( screen[0], screen[k + 1], screen[k],
+                                         color, isTranslucent );
+            }
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_SOFTWARE_RENDERER_H
+#define SCOTT_CUBEWORLD_SOFTWARE_RENDERER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "engine/camera.h"
+#include "graphics/irenderer.h"
+#include "graphics/renderprimitives.h"
+#include "graphics/software/softwarerasterizer.h"
+#include "math/vector.h"
+
+class Point;
+struct WorldChunkMesh;
+
+/**
+ * Renders chunk meshes on the CPU, for machines without a GPU. Sections are
+ * kept in world space when uploaded, and each draw call transforms them by
+ * the camera, clips them against the near plane and hands the front facing
+ * triangles to a SoftwareRasterizer. The frame is rasterized across worker
+ * threads when it is presented, and can then be saved as a TGA image.
+ *
+ * Faces are lit by a fixed sun, and packed ones are darkened by their
+ * ambient occlusion. Meshes don't carry materials, so every opaque face is
+ * drawn in the same stone color and every translucent face in water blue.
+ */
+class SoftwareRenderer : public IRenderer
+{
+public:
+    // With zero threads one is used per hardware thread
+    SoftwareRenderer( unsigned int width,
+                      unsigned int height,
+                      unsigned int threadCount = 0 );
+    virtual ~SoftwareRenderer();
+
+    virtual void clear();
+    virtual void present();
+    virtual void renderChunks( const std::vector<ChunkRenderId>& chunks );
+    virtual void renderTranslucentChunks( const std::vector<ChunkRenderId>& chunks );
+    virtual ChunkRenderId uploadChunkSection( const Point& origin,
+                                              unsigned int section,
+                                              const WorldChunkMesh& mesh );
+    virtual void releaseChunk( ChunkRenderId id );
+
+    // Set the camera that following draws are seen from
+    void setCamera( const Camera& camera );
+
+    // Vertical field of view, in degrees
+    void setFieldOfView( float degrees );
+
+    // Write the last presented frame out as a 32 bit TGA image
+    bool saveFrame( const char * pFilename ) const;
+
+    // Pixels and counters of the last presented frame
+    const SoftwareRasterizer& rasterizer() const;
+
+    // Color the screen is cleared to
+    const static uint32_t SKY_COLOR;
+
+private:
+    struct Section
+    {
+        bool isLive;
+        std::vector<Vec3>     positions;    // World space
+        std::vector<float>    shades;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> translucentIndices;
+    };
+
+    void drawSections( const std::vector<ChunkRenderId>& chunks,
+                       bool isTranslucent );
+
+private:
+    std::vector<Section> mSections;         // Indexed by id - 1
+    std::vector<ChunkRenderId> mFreeIds;
+    SoftwareRasterizer mRasterizer;
+    Camera mCamera;
+    float mFieldOfView;
+
+    // Camera space position of each vertex of the section being drawn
+    std::vector<Vec3> mViewPositions;
+};
+
+#endif
@@ -0,0 +1,534 @@
+#include "graphics/software/voxelraytracer.h"
+#include "engine/camera.h"
+#include "engine/constants.h"
+#include "engine/cubedata.h"
+#include "engine/material.h"
+#include "engine/point.h"
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "math/vector.h"
+
+#include <tga.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+const unsigned int VoxelRayTracer::TILE_SIZE  = 16;
+const unsigned int VoxelRayTracer::BRICK_SIZE = 4;
+const uint32_t VoxelRayTracer::SKY_COLOR = 0xff87b4e6;
+
+namespace
+{
+    // Base color of each material, indexed by EMaterialType
+    const uint32_t MATERIAL_COLORS[EMATERIAL_COUNT] =
+    {
+        0xff000000,     // empty, never drawn
+        0xff3c3c3c,     // bedrock
+        0xff5aa03c,     // grass
+        0xff8c6441,     // dirt
+        0xff8c8c8c,     // rock
+        0xffb4a078,     // ore
+        0xff3c78d2,     // water
+        0xffe6641e,     // lava
+        0xffdccd96,     // sand
+        0xffa07846,     // wood
+        0xff644628,     // tree
+        0xff3c8232      // leaf
+    };
+
+    /**
+     * Lights a cube's face by the same fixed sun as the software rasterizer.
+     * The face is the one the ray crossed into the cube through, on the
+     * given axis while stepping in the given direction
+     */
+    uint32_t shadeFace( uint32_t color, int axis, int step )
+    {
+        const float sun[3] = { 0.32f, 0.48f, 0.82f };
+        float shade = 1.0f;
+
+        if ( axis >= 0 )
+        {
+            shade = 0.45f + 0.55f * std::max( 0.0f, -step * sun[axis] );
+        }
+
+        const uint32_t r = static_cast<uint32_t>( ( ( color >> 16 ) & 0xff ) * shade );
+        const uint32_t g = static_cast<uint32_t>( ( ( color >> 8 )  & 0xff ) * shade );
+        const uint32_t b = static_cast<uint32_t>( (   color         & 0xff ) * shade );
+
+        return 0xff000000 | ( r << 16 ) | ( g << 8 ) | b;
+    }
+
+    uint32_t blend( uint32_t a, uint32_t b )
+    {
+        return 0xff000000 + ( ( a >> 1 ) & 0x7f7f7f ) + ( ( b >> 1 ) & 0x7f7f7f );
+    }
+}
+
+VoxelRayTracer::VoxelRayTracer( unsigned int width,
+                                unsigned int height,
+                                unsigned int threadCount )
+    : mWidth( width ),
+      mHeight( height ),
+      mThreadCount( threadCount ),
+      mTileCols( ( width  + TILE_SIZE - 1 ) / TILE_SIZE ),
+      mTileRows( ( height + TILE_SIZE - 1 ) / TILE_SIZE ),
+      mFieldOfView( 60.0f ),
+      mColor( width * height, SKY_COLOR ),
+      mStats(),
+      mChunks(),
+      mBricks()
+{
+    if ( mThreadCount == 0 )
+    {
+        mThreadCount = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+
+    std::fill( mSize, mSize + 3, 0 );
+    std::fill( mChunkSize, mChunkSize + 3, 0 );
+    std::fill( mBrickSize, mBrickSize + 3, 0 );
+}
+
+void VoxelRayTracer::setFieldOfView( float degrees )
+{
+    mFieldOfView = degrees;
+}
+
+/**
+ * Casts a ray for every pixel. Tiles are independent of each other, so each
+ * worker takes the next unrendered tile until there are none left
+ */
+void VoxelRayTracer::render( const World& world, const Camera& camera )
+{
+    buildBricks( world );
+
+    const Vec3 forward = normalized( camera.direction() );
+    const Vec3 right   = normalized( cross( forward, camera.up() ) );
+    const Vec3 up      = cross( right, forward );
+
+    View view;
+
+    for ( int a = 0; a < 3; ++a )
+    {
+        view.center[a]  = camera.center()[a];
+        view.forward[a] = forward[a];
+        view.right[a]   = right[a];
+        view.up[a]      = up[a];
+    }
+
+    view.tanHalfFov  = std::tan( mFieldOfView * 0.5f * 3.14159265f / 180.0f );
+    view.maxDistance = camera.viewDistance();
+
+    const unsigned int tileCount = mTileCols * mTileRows;
+    const unsigned int threadCount = std::min( mThreadCount, tileCount );
+
+    mStats = VoxelRayStats();
+
+    if ( threadCount <= 1 )
+    {
+        for ( unsigned int tile = 0; tile < tileCount; ++tile )
+        {
+            renderTile( tile, view, mStats );
+        }
+    }
+    else
+    {
+        std::vector<VoxelRayStats> workerStats( threadCount );
+        std::vector<std::thread> workers;
+        std::atomic<unsigned int> nextTile( 0 );
+
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            VoxelRayStats * pStats = &workerStats[t];
+
+            workers.push_back( std::thread( [&, pStats]()
+            {
+                unsigned int tile = 0;
+
+                while ( ( tile = nextTile.fetch_add( 1 ) ) < tileCount )
+                {
+                    renderTile( tile, view, *pStats );
+                }
+            } ) );
+        }
+
+        for ( unsigned int t = 0; t < threadCount; ++t )
+        {
+            workers[t].join();
+
+            mStats.rays          += workerStats[t].rays;
+            mStats.hits          += workerStats[t].hits;
+            mStats.chunksSkipped += workerStats[t].chunksSkipped;
+            mStats.bricksSkipped += workerStats[t].bricksSkipped;
+            mStats.voxelsVisited += workerStats[t].voxelsVisited;
+        }
+    }
+}
+
+unsigned int VoxelRayTracer::width() const
+{
+    return mWidth;
+}
+
+unsigned int VoxelRayTracer::height() const
+{
+    return mHeight;
+}
+
+const uint32_t * VoxelRayTracer::pixels() const
+{
+    return &mColor[0];
+}
+
+uint32_t VoxelRayTracer::pixel( unsigned int x, unsigned int y ) const
+{
+    assert( x < mWidth && y < mHeight );
+    return mColor[ y * mWidth + x ];
+}
+
+const VoxelRayStats& VoxelRayTracer::stats() const
+{
+    return mStats;
+}
+
+/**
+ * TGA images are stored bottom row first, in BGRA order, which is how the
+ * 0xAARRGGBB pixels are laid out in memory on a little endian machine
+ */
+bool VoxelRayTracer::saveFrame( const char * pFilename ) const
+{
+    const size_t rowBytes = mWidth * sizeof(uint32_t);
+    uint8_t * pPixels = new uint8_t[mHeight * rowBytes];
+
+    for ( unsigned int y = 0; y < mHeight; ++y )
+    {
+        std::memcpy( pPixels + ( mHeight - 1 - y ) * rowBytes,
+                     &mColor[ y * mWidth ],
+                     rowBytes );
+    }
+
+    // The image owns the pixels from here on
+    TGA::TgaImage image( mWidth, mHeight, 32, pPixels );
+    return TGA::saveTGA( pFilename, image );
+}
+
+/**
+ * Looks up the world's chunks and marks every brick that has a cube in it.
+ * Each brick row of a chunk is a nibble of the chunk's occupancy masks
+ */
+void VoxelRayTracer::buildBricks( const World& world )
+{
+    const int chunkDims[3] = { static_cast<int>( Constants::CHUNK_COLS ),
+                               static_cast<int>( Constants::CHUNK_ROWS ),
+                               static_cast<int>( Constants::CHUNK_DEPTH ) };
+    const int brick = static_cast<int>( BRICK_SIZE );
+
+    mSize[0] = world.cols();
+    mSize[1] = world.rows();
+    mSize[2] = world.depth();
+    mChunkSize[0] = world.chunkCols();
+    mChunkSize[1] = world.chunkRows();
+    mChunkSize[2] = world.chunkDepth();
+
+    for ( int a = 0; a < 3; ++a )
+    {
+        mBrickSize[a] = ( mChunkSize[a] * chunkDims[a] + brick - 1 ) / brick;
+    }
+
+    mChunks.assign( mChunkSize[0] * mChunkSize[1] * mChunkSize[2], NULL );
+    mBricks.assign( mBrickSize[0] * mBrickSize[1] * mBrickSize[2], 0 );
+
+    for ( int cz = 0; cz < mChunkSize[2]; ++cz )
+    {
+        for ( int cy = 0; cy < mChunkSize[1]; ++cy )
+        {
+            for ( int cx = 0; cx < mChunkSize[0]; ++cx )
+            {
+                const WorldChunk * pChunk = world.chunkAt( Point( cx, cy, cz ) );
+
+                if ( pChunk == NULL || pChunk->cubeCount() == 0 )
+                {
+                    continue;
+                }
+
+                mChunks[ ( cz * mChunkSize[1] + cy ) * mChunkSize[0] + cx ] = pChunk;
+
+                const uint32_t * pOccupancy = pChunk->occupancy();
+
+                for ( int z = 0; z < chunkDims[2]; ++z )
+                {
+                    for ( int y = 0; y < chunkDims[1]; ++y )
+                    {
+                        const uint32_t mask = pOccupancy[ z * chunkDims[1] + y ];
+
+                        if ( mask == 0 )
+                        {
+                            continue;
+                        }
+
+                        const int by = ( cy * chunkDims[1] + y ) / brick;
+                        const int bz = ( cz * chunkDims[2] + z ) / brick;
+                        uint8_t * pRow = &mBricks[ ( bz * mBrickSize[1] + by ) * mBrickSize[0] ];
+
+                        for ( int x = 0; x < chunkDims[0]; x += brick )
+                        {
+                            if ( ( mask >> x ) & ( ( 1u << brick ) - 1 ) )
+                            {
+                                pRow[ ( cx * chunkDims[0] + x ) / brick ] = 1;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void VoxelRayTracer::renderTile( unsigned int tile,
+                                 const View& view,
+                                 VoxelRayStats& stats )
+{
+    const unsigned int x0 = ( tile % mTileCols ) * TILE_SIZE;
+    const unsigned int y0 = ( tile / mTileCols ) * TILE_SIZE;
+    const unsigned int x1 = std::min( x0 + TILE_SIZE, mWidth );
+    const unsigned int y1 = std::min( y0 + TILE_SIZE, mHeight );
+
+    // Pixels are square, so both axes are scaled by the height
+    const float scale = 2.0f * view.tanHalfFov / mHeight;
+
+    for ( unsigned int y = y0; y < y1; ++y )
+    {
+        const float sy = ( 0.5f * mHeight - ( y + 0.5f ) ) * scale;
+
+        for ( unsigned int x = x0; x < x1; ++x )
+        {
+            const float sx = ( ( x + 0.5f ) - 0.5f * mWidth ) * scale;
+            float direction[3];
+
+            for ( int a = 0; a < 3; ++a )
+            {
+                direction[a] = view.forward[a] + view.right[a] * sx + view.up[a] * sy;
+            }
+
+            // Normalized, so ray distances are world distances
+            const float length = std::sqrt( direction[0] * direction[0] +
+                                            direction[1] * direction[1] +
+                                            direction[2] * direction[2] );
+
+            for ( int a = 0; a < 3; ++a )
+            {
+                direction[a] /= length;
+            }
+
+            mColor[ y * mWidth + x ] = trace( view.center, direction,
+                                              view.maxDistance, stats );
+        }
+    }
+
+    stats.rays += ( x1 - x0 ) * ( y1 - y0 );
+}
+
+/**
+ * Walks the ray through the world from the cell it starts in. Each step
+ * moves to the far side of the largest empty cell around the ray, which is
+ * either a whole chunk, a brick or a single cube, and lands in the cube on
+ * the other side of the face the ray left through
+ */
+uint32_t VoxelRayTracer::trace( const float origin[3],
+                                const float direction[3],
+                                float maxDistance,
+                                VoxelRayStats& stats ) const
+{
+    const int chunkDims[3] = { static_cast<int>( Constants::CHUNK_COLS ),
+                               static_cast<int>( Constants::CHUNK_ROWS ),
+                               static_cast<int>( Constants::CHUNK_DEPTH ) };
+    const int brickDims[3] = { static_cast<int>( BRICK_SIZE ),
+                               static_cast<int>( BRICK_SIZE ),
+                               static_cast<int>( BRICK_SIZE ) };
+    const int cubeDims[3]  = { 1, 1, 1 };
+    const float FAR = 1e30f;
+
+    // Clip the ray against the world's bounds
+    float inverse[3];
+    int step[3];
+    float t = 0.0f;
+    float tEnd = maxDistance;
+    int axis = -1;
+
+    for ( int a = 0; a < 3; ++a )
+    {
+        step[a] = direction[a] < 0.0f ? -1 : 1;
+
+        if ( direction[a] == 0.0f )
+        {
+            if ( origin[a] < 0.0f || origin[a] >= mSize[a] )
+            {
+                return SKY_COLOR;
+            }
+
+            inverse[a] = FAR;
+            continue;
+        }
+
+        inverse[a] = 1.0f / direction[a];
+
+        float tNear = ( 0.0f     - origin[a] ) * inverse[a];
+        float tFar  = ( mSize[a] - origin[a] ) * inverse[a];
+
+        if ( tNear > tFar )
+        {
+            std::swap( tNear, tFar );
+        }
+
+        if ( tNear > t )
+        {
+            t = tNear;
+            axis = a;
+        }
+
+        tEnd = std::min( tEnd, tFar );
+    }
+
+    if ( t >= tEnd )
+    {
+        return SKY_COLOR;
+    }
+
+    int cube[3];
+
+    for ( int a = 0; a < 3; ++a )
+    {
+        const int c = static_cast<int>( std::floor( origin[a] + direction[a] * t ) );
+        cube[a] = std::min( std::max( c, 0 ), mSize[a] - 1 );
+    }
+
+    if ( axis >= 0 )
+    {
+        cube[axis] = step[axis] > 0 ? 0 : mSize[axis] - 1;
+    }
+
+    uint32_t translucentColor = 0;
+    bool isBehindTranslucent = false;
+
+    for (;;)
+    {
+        const WorldChunk * pChunk = chunkAt( cube );
+        const int * pCell = cubeDims;
+
+        if ( pChunk == NULL )
+        {
+            pCell = chunkDims;
+            stats.chunksSkipped++;
+        }
+        else if ( isBrickEmpty( cube ) )
+        {
+            pCell = brickDims;
+            stats.bricksSkipped++;
+        }
+        else
+        {
+            const int x = cube[0] % chunkDims[0];
+            const int y = cube[1] % chunkDims[1];
+            const int z = cube[2] % chunkDims[2];
+            const int row = z * chunkDims[1] + y;
+
+            stats.voxelsVisited++;
+
+            if ( ( pChunk->occupancy()[row] >> x ) & 1 )
+            {
+                const EMaterialType material =
+                    pChunk->cubes()[ row * chunkDims[0] + x ].materialType();
+                const uint32_t color = shadeFace( MATERIAL_COLORS[material],
+                                                  axis,
+                                                  axis >= 0 ? step[axis] : 0 );
+
+                if ( !Util::IsTranslucent( material ) )
+                {
+                    stats.hits++;
+                    return isBehindTranslucent ? blend( translucentColor, color ) : color;
+                }
+
+                // Only the first translucent cube shows, the ones right
+                // behind it are seen through
+                if ( !isBehindTranslucent )
+                {
+                    translucentColor = color;
+                    isBehindTranslucent = true;
+                }
+            }
+        }
+
+        // Leave the cell through the nearest of its faces
+        int cellStart[3];
+        float tExit = FAR;
+        int exitAxis = 0;
+
+        for ( int a = 0; a < 3; ++a )
+        {
+            cellStart[a] = cube[a] - cube[a] % pCell[a];
+
+            const int boundary = step[a] > 0 ? cellStart[a] + pCell[a] : cellStart[a];
+            const float tAxis = inverse[a] == FAR ? FAR :
+                                ( boundary - origin[a] ) * inverse[a];
+
+            if ( tAxis < tExit )
+            {
+                tExit = tAxis;
+                exitAxis = a;
+            }
+        }
+
+        if ( tExit >= tEnd )
+        {
+            break;
+        }
+
+        t = std::max( t, tExit );
+        axis = exitAxis;
+
+        // The ray is still inside the cell along the other axes, which the
+        // clamp makes sure of when rounding says otherwise
+        for ( int a = 0; a < 3; ++a )
+        {
+            if ( a == exitAxis )
+            {
+                cube[a] = step[a] > 0 ? cellStart[a] + pCell[a] : cellStart[a] - 1;
+            }
+            else
+            {
+                const int c = static_cast<int>( std::floor( origin[a] + direction[a] * t ) );
+                cube[a] = std::min( std::max( c, cellStart[a] ), cellStart[a] + pCell[a] - 1 );
+                cube[a] = std::min( cube[a], mSize[a] - 1 );
+            }
+        }
+
+        if ( cube[exitAxis] < 0 || cube[exitAxis] >= mSize[exitAxis] )
+        {
+            break;
+        }
+    }
+
+    return isBehindTranslucent ? blend( translucentColor, SKY_COLOR ) : SKY_COLOR;
+}
+
+const WorldChunk * VoxelRayTracer::chunkAt( const int cube[3] ) const
+{
+    const int x = cube[0] / static_cast<int>( Constants::CHUNK_COLS );
+    const int y = cube[1] / static_cast<int>( Constants::CHUNK_ROWS );
+    const int z = cube[2] / static_cast<int>( Constants::CHUNK_DEPTH );
+
+    return mChunks[ ( z * mChunkSize[1] + y ) * mChunkSize[0] + x ];
+}
+
+bool VoxelRayTracer::isBrickEmpty( const int cube[3] ) const
+{
+    const int brick = static_cast<int>( BRICK_SIZE );
+    const int x = cube[0] / brick;
+    const int y = cube[1] / brick;
+    const int z = cube[2] / brick;
+
+    return mBricks[ ( z * mBrickSize[1] + y ) * mBrickSize[0] + x ] == 0;
+}
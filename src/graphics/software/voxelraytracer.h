@@ -0,0 +1,145 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_VOXEL_RAY_TRACER_H
+#define SCOTT_CUBEWORLD_VOXEL_RAY_TRACER_H
+
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+class World;
+class WorldChunk;
+class Camera;
+
+/**
+ * Counters for the last frame a VoxelRayTracer rendered
+ */
+struct VoxelRayStats
+{
+    VoxelRayStats()
+        : rays( 0 ),
+          hits( 0 ),
+          chunksSkipped( 0 ),
+          bricksSkipped( 0 ),
+          voxelsVisited( 0 )
+    {
+    }
+
+    size_t rays;            // One per pixel
+    size_t hits;            // Rays that ended on an opaque cube
+    size_t chunksSkipped;   // Empty chunks crossed in a single step
+    size_t bricksSkipped;   // Empty 4x4x4 bricks crossed in a single step
+    size_t voxelsVisited;   // Cubes looked at one by one
+};
+
+/**
+ * Renders a world straight from its cube data on the CPU, without meshing
+ * it first. Meant for map previews and screenshots taken where there is no
+ * GPU, such as on a server.
+ *
+ * Every pixel casts a ray that walks the cube grid cell by cell. Empty
+ * space is skipped hierarchically: chunks without cubes are crossed in one
+ * step, then empty 4x4x4 bricks, and only occupied bricks are walked cube
+ * by cube using the chunks' occupancy masks. The brick map is rebuilt from
+ * those masks at the start of each frame.
+ *
+ * The screen is split into 16x16 pixel tiles which worker threads take one
+ * at a time. Cubes are colored by material and lit by a fixed sun. Rays
+ * pass through the first translucent cube they meet and blend it half and
+ * half with whatever is behind it.
+ */
+class VoxelRayTracer : boost::noncopyable
+{
+public:
+    // With zero threads one is used per hardware thread
+    VoxelRayTracer( unsigned int width,
+                    unsigned int height,
+                    unsigned int threadCount = 0 );
+
+    const static unsigned int TILE_SIZE;
+    const static unsigned int BRICK_SIZE;
+
+    // Vertical field of view, in degrees
+    void setFieldOfView( float degrees );
+
+    // Render the world as seen from the camera
+    void render( const World& world, const Camera& camera );
+
+    unsigned int width() const;
+    unsigned int height() const;
+
+    // Pixels as 0xAARRGGBB, one row after another starting at the top
+    const uint32_t * pixels() const;
+    uint32_t pixel( unsigned int x, unsigned int y ) const;
+
+    // Counters for the last call to render
+    const VoxelRayStats& stats() const;
+
+    // Write the last rendered frame out as a 32 bit TGA image
+    bool saveFrame( const char * pFilename ) const;
+
+    // Color of pixels whose ray leaves the world without hitting anything
+    const static uint32_t SKY_COLOR;
+
+private:
+    // Camera the frame is seen from, as plain floats
+    struct View
+    {
+        float center[3];
+        float forward[3];
+        float right[3];
+        float up[3];
+        float tanHalfFov;
+        float maxDistance;
+    };
+
+    void buildBricks( const World& world );
+    void renderTile( unsigned int tile,
+                     const View& view,
+                     VoxelRayStats& stats );
+    uint32_t trace( const float origin[3],
+                    const float direction[3],
+                    float maxDistance,
+                    VoxelRayStats& stats ) const;
+
+    const WorldChunk * chunkAt( const int cube[3] ) const;
+    bool isBrickEmpty( const int cube[3] ) const;
+
+private:
+    unsigned int mWidth;
+    unsigned int mHeight;
+    unsigned int mThreadCount;
+    unsigned int mTileCols;
+    unsigned int mTileRows;
+    float mFieldOfView;
+
+    std::vector<uint32_t> mColor;
+    VoxelRayStats mStats;
+
+    // Size of the world being rendered in cubes, chunks and bricks
+    int mSize[3];
+    int mChunkSize[3];
+    int mBrickSize[3];
+
+    // Each chunk of the world, NULL when it has no cubes
+    std::vector<const WorldChunk*> mChunks;
+
+    // One byte per brick, set if any cube in it isn't empty
+    std::vector<uint8_t> mBricks;
+};
+
+#endif
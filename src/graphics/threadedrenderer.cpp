@@ -0,0 +1,222 @@
+#include "graphics/threadedrenderer.h"
+#include "graphics/rendercommandbuffer.h"
+
+#include <cassert>
+#include <chrono>
+
+namespace
+{
+    double secondsNow()
+    {
+        return std::chrono::duration<double>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+}
+
+/**
+ * Creates the command buffers and starts the render thread
+ *
+ * \param  pTarget      Renderer that the recorded frames are played back on
+ * \param  bufferCount  Command buffers to rotate through, at least two
+ */
+ThreadedRenderer::ThreadedRenderer( IRenderer * pTarget, unsigned int bufferCount )
+    : mpTarget( pTarget ),
+      mBuffers(),
+      mpRecording( NULL ),
+      mIsProxyLive(),
+      mFreeProxyIds(),
+      mTargetIds(),
+      mLock(),
+      mFrameSubmitted(),
+      mFrameExecuted(),
+      mSubmitted(),
+      mFree(),
+      mIsStopping( false ),
+      mStats(),
+      mRecordStartSeconds( secondsNow() ),
+      mThread()
+{
+    assert( pTarget != NULL );
+    assert( bufferCount >= 2 );
+
+    for ( unsigned int i = 0; i < bufferCount; ++i )
+    {
+        mBuffers.push_back( new RenderCommandBuffer() );
+    }
+
+    mpRecording = mBuffers[0];
+    mFree.assign( mBuffers.begin() + 1, mBuffers.end() );
+
+    mThread = std::thread( &ThreadedRenderer::renderMain, this );
+}
+
+/**
+ * Plays back the frames that were already presented, then stops the render
+ * thread
+ */
+ThreadedRenderer::~ThreadedRenderer()
+{
+    finish();
+
+    {
+        std::lock_guard<std::mutex> lock( mLock );
+        mIsStopping = true;
+    }
+
+    mFrameSubmitted.notify_one();
+    mThread.join();
+
+    for ( size_t i = 0; i < mBuffers.size(); ++i )
+    {
+        delete mBuffers[i];
+    }
+}
+
+void ThreadedRenderer::clear()
+{
+    mpRecording->recordClear();
+}
+
+/**
+ * Hands the recorded frame to the render thread, and takes a free command
+ * buffer to record the next frame into, waiting for one if there are none
+ */
+void ThreadedRenderer::present()
+{
+    const double presentSeconds = secondsNow();
+    std::unique_lock<std::mutex> lock( mLock );
+
+    mSubmitted.push_back( mpRecording );
+    mStats.framesSubmitted++;
+    mFrameSubmitted.notify_one();
+
+    while ( mFree.empty() )
+    {
+        mFrameExecuted.wait( lock );
+    }
+
+    mpRecording = mFree.back();
+    mFree.pop_back();
+
+    const double now = secondsNow();
+
+    mStats.lastRecordMilliseconds   = ( presentSeconds - mRecordStartSeconds ) * 1000.0;
+    mStats.lastWaitMilliseconds     = ( now - presentSeconds ) * 1000.0;
+    mStats.totalRecordMilliseconds += mStats.lastRecordMilliseconds;
+    mStats.totalWaitMilliseconds   += mStats.lastWaitMilliseconds;
+
+    mRecordStartSeconds = now;
+}
+
+void ThreadedRenderer::renderChunks( const std::vector<ChunkRenderId>& chunks )
+{
+    mpRecording->recordRenderChunks( chunks );
+}
+
+void ThreadedRenderer::renderTranslucentChunks( const std::vector<ChunkRenderId>& chunks )
+{
+    mpRecording->recordRenderTranslucentChunks( chunks );
+}
+
+/**
+ * Returns a proxy id straight away. The section is really uploaded when the
+ * frame is played back, and the proxy id is translated from then on
+ */
+ChunkRenderId ThreadedRenderer::uploadChunkSection( const Point& origin,
+                                                    unsigned int section,
+                                                    const WorldChunkMesh& mesh )
+{
+    ChunkRenderId id = 0;
+
+    if ( mFreeProxyIds.empty() )
+    {
+        mIsProxyLive.push_back( true );
+        id = static_cast<ChunkRenderId>( mIsProxyLive.size() );
+    }
+    else
+    {
+        id = mFreeProxyIds.back();
+        mFreeProxyIds.pop_back();
+        mIsProxyLive[id - 1] = true;
+    }
+
+    mpRecording->recordUploadChunkSection( id, origin, section, mesh );
+    return id;
+}
+
+/**
+ * The proxy id can be handed out again right away, since the release is
+ * played back before any upload recorded after it
+ */
+void ThreadedRenderer::releaseChunk( ChunkRenderId id )
+{
+    assert( id > 0 && id <= mIsProxyLive.size() && mIsProxyLive[id - 1] );
+
+    mIsProxyLive[id - 1] = false;
+    mFreeProxyIds.push_back( id );
+
+    mpRecording->recordReleaseChunk( id );
+}
+
+void ThreadedRenderer::finish()
+{
+    std::unique_lock<std::mutex> lock( mLock );
+
+    while ( mStats.framesExecuted < mStats.framesSubmitted )
+    {
+        mFrameExecuted.wait( lock );
+    }
+}
+
+unsigned int ThreadedRenderer::bufferCount() const
+{
+    return static_cast<unsigned int>( mBuffers.size() );
+}
+
+ThreadedRendererStats ThreadedRenderer::stats() const
+{
+    std::lock_guard<std::mutex> lock( mLock );
+    return mStats;
+}
+
+/**
+ * Render thread. Plays back presented frames oldest first, and hands their
+ * buffers back for recording once they're done
+ */
+void ThreadedRenderer::renderMain()
+{
+    std::unique_lock<std::mutex> lock( mLock );
+
+    for (;;)
+    {
+        while ( mSubmitted.empty() && !mIsStopping )
+        {
+            mFrameSubmitted.wait( lock );
+        }
+
+        if ( mSubmitted.empty() )
+        {
+            break;
+        }
+
+        RenderCommandBuffer * pFrame = mSubmitted.front();
+        mSubmitted.pop_front();
+        lock.unlock();
+
+        const double startSeconds = secondsNow();
+
+        pFrame->execute( *mpTarget, mTargetIds );
+        mpTarget->present();
+        pFrame->reset();
+
+        const double executeMilliseconds = ( secondsNow() - startSeconds ) * 1000.0;
+
+        lock.lock();
+        mFree.push_back( pFrame );
+        mStats.framesExecuted++;
+        mStats.lastExecuteMilliseconds   = executeMilliseconds;
+        mStats.totalExecuteMilliseconds += executeMilliseconds;
+
+        mFrameExecuted.notify_all();
+    }
+}
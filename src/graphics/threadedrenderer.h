@@ -0,0 +1,139 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_THREADED_RENDERER_H
+#define SCOTT_CUBEWORLD_THREADED_RENDERER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "graphics/irenderer.h"
+#include "graphics/renderprimitives.h"
+#include "graphics/rendercommandbuffer.h"
+
+class Point;
+struct WorldChunkMesh;
+
+/**
+ * Timings of the two sides of a ThreadedRenderer. "Last" values are for the
+ * most recent frame the side finished, totals cover every frame
+ */
+struct ThreadedRendererStats
+{
+    ThreadedRendererStats()
+        : framesSubmitted( 0 ),
+          framesExecuted( 0 ),
+          lastRecordMilliseconds( 0.0 ),
+          lastWaitMilliseconds( 0.0 ),
+          lastExecuteMilliseconds( 0.0 ),
+          totalRecordMilliseconds( 0.0 ),
+          totalWaitMilliseconds( 0.0 ),
+          totalExecuteMilliseconds( 0.0 )
+    {
+    }
+
+    size_t framesSubmitted;     // Frames presented by the simulation thread
+    size_t framesExecuted;      // Frames played back by the render thread
+
+    // Simulation thread: time from the end of one present to the next, and
+    // time spent inside present waiting for a free command buffer
+    double lastRecordMilliseconds;
+    double lastWaitMilliseconds;
+
+    // Render thread: time to play a frame back, including the target's present
+    double lastExecuteMilliseconds;
+
+    double totalRecordMilliseconds;
+    double totalWaitMilliseconds;
+    double totalExecuteMilliseconds;
+};
+
+/**
+ * Puts a render thread between the game and a renderer, so that slow draws
+ * stop eating into the simulation's time. Calls made on the ThreadedRenderer
+ * are recorded into a command buffer, and presenting hands the buffer to the
+ * render thread, which plays it back against the target renderer while the
+ * next frame is recorded.
+ *
+ * Frames are double buffered by default, one being recorded while the other
+ * is played back. With three buffers a finished frame can also wait in line,
+ * which smooths out uneven frames at the cost of a frame of latency. When
+ * every buffer is in use present blocks until the render thread frees one.
+ *
+ * The target is only ever called from the render thread, so it must not need
+ * to be called from the thread that created it (an OpenGL context has to be
+ * made current on the render thread, for example). Calls that were recorded
+ * but never presented are dropped when the ThreadedRenderer is destroyed.
+ */
+class ThreadedRenderer : public IRenderer
+{
+public:
+    // The target isn't owned, and must outlive the threaded renderer
+    explicit ThreadedRenderer( IRenderer * pTarget, unsigned int bufferCount = 2 );
+    virtual ~ThreadedRenderer();
+
+    virtual void clear();
+    virtual void present();
+    virtual void renderChunks( const std::vector<ChunkRenderId>& chunks );
+    virtual void renderTranslucentChunks( const std::vector<ChunkRenderId>& chunks );
+    virtual ChunkRenderId uploadChunkSection( const Point& origin,
+                                              unsigned int section,
+                                              const WorldChunkMesh& mesh );
+    virtual void releaseChunk( ChunkRenderId id );
+
+    // Block until every presented frame has been played back
+    void finish();
+
+    // Number of command buffers frames rotate through
+    unsigned int bufferCount() const;
+
+    // Timings of both threads so far
+    ThreadedRendererStats stats() const;
+
+private:
+    void renderMain();
+
+private:
+    IRenderer * mpTarget;
+    std::vector<RenderCommandBuffer*> mBuffers;
+    RenderCommandBuffer * mpRecording;      // Only touched by the simulation thread
+
+    // Proxy ids handed out to callers, indexed by id - 1
+    std::vector<bool> mIsProxyLive;
+    std::vector<ChunkRenderId> mFreeProxyIds;
+
+    // Target id of each proxy id, only touched by the render thread
+    std::vector<ChunkRenderId> mTargetIds;
+
+    // Everything below is guarded by the lock
+    mutable std::mutex mLock;
+    std::condition_variable mFrameSubmitted;
+    std::condition_variable mFrameExecuted;
+    std::deque<RenderCommandBuffer*> mSubmitted;
+    std::vector<RenderCommandBuffer*> mFree;
+    bool mIsStopping;
+    ThreadedRendererStats mStats;
+
+    // When the simulation thread last returned from present
+    double mRecordStartSeconds;
+
+    std::thread mThread;
+};
+
+#endif
@@ -0,0 +1,281 @@
+#include "graphics/vertexcacheoptimizer.h"
+#include "graphics/chunkindexbuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+const unsigned int VertexCacheOptimizer::CACHE_SIZE;
+
+namespace
+{
+    // Weights from Forsyth's paper. The three vertices of the last triangle
+    // get a fixed score so that the next triangle doesn't simply reuse the
+    // same edge, and vertices with few triangles left are favored so they
+    // are finished off and stop taking up room in the cache
+    const float CACHE_DECAY_POWER   = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    const unsigned int NO_TRIANGLE = ~0u;
+}
+
+VertexCacheOptimizer::VertexCacheOptimizer()
+    : mTriangleOffsets(),
+      mVertexTriangles(),
+      mRemaining(),
+      mCachePosition(),
+      mVertexScores(),
+      mTriangleScores(),
+      mIsEmitted(),
+      mOutput(),
+      mCacheCount( 0 )
+{
+}
+
+/**
+ * Reorders the triangles in place. Runs in time linear to the number of
+ * triangles, apart from falling back to the next unemitted triangle whenever
+ * nothing in the cache is left to draw.
+ *
+ * \param  pIndices     Triangle list to reorder
+ * \param  count        Number of indices, a multiple of three
+ * \param  vertexCount  Number of vertices the indices refer to
+ */
+void VertexCacheOptimizer::optimize( unsigned int * pIndices,
+                                     size_t count,
+                                     size_t vertexCount )
+{
+    assert( count % 3 == 0 );
+    const size_t triangleCount = count / 3;
+
+    if ( triangleCount < 2 )
+    {
+        return;
+    }
+
+    // Bucket the triangles by the vertices they use
+    mRemaining.assign( vertexCount, 0 );
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        assert( pIndices[i] < vertexCount );
+        mRemaining[ pIndices[i] ]++;
+    }
+
+    mTriangleOffsets.resize( vertexCount + 1 );
+    mTriangleOffsets[0] = 0;
+
+    for ( size_t v = 0; v < vertexCount; ++v )
+    {
+        mTriangleOffsets[v + 1] = mTriangleOffsets[v] + mRemaining[v];
+        mRemaining[v] = 0;
+    }
+
+    mVertexTriangles.resize( count );
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const unsigned int v = pIndices[i];
+        mVertexTriangles[ mTriangleOffsets[v] + mRemaining[v]++ ] =
+            static_cast<unsigned int>( i / 3 );
+    }
+
+    // Nothing is cached yet, so the scores only reflect the valences
+    mCachePosition.assign( vertexCount, -1 );
+    mVertexScores.resize( vertexCount );
+    mCacheCount = 0;
+
+    for ( size_t v = 0; v < vertexCount; ++v )
+    {
+        mVertexScores[v] = vertexScore( static_cast<unsigned int>( v ) );
+    }
+
+    mTriangleScores.resize( triangleCount );
+    mIsEmitted.assign( triangleCount, 0 );
+    unsigned int best = 0;
+
+    for ( size_t t = 0; t < triangleCount; ++t )
+    {
+        const unsigned int * pTriangle = &pIndices[t * 3];
+        mTriangleScores[t] = mVertexScores[ pTriangle[0] ] +
+                             mVertexScores[ pTriangle[1] ] +
+                             mVertexScores[ pTriangle[2] ];
+
+        if ( mTriangleScores[t] > mTriangleScores[best] )
+        {
+            best = static_cast<unsigned int>( t );
+        }
+    }
+
+    mOutput.resize( count );
+    size_t nextUnemitted = 0;
+
+    for ( size_t emitted = 0; emitted < triangleCount; ++emitted )
+    {
+        if ( best == NO_TRIANGLE )
+        {
+            // Nothing in the cache has triangles left, start somewhere new
+            while ( mIsEmitted[nextUnemitted] )
+            {
+                nextUnemitted++;
+            }
+
+            best = static_cast<unsigned int>( nextUnemitted );
+        }
+
+        const unsigned int * pTriangle = &pIndices[best * 3];
+        mIsEmitted[best] = 1;
+
+        mOutput[emitted * 3 + 0] = pTriangle[0];
+        mOutput[emitted * 3 + 1] = pTriangle[1];
+        mOutput[emitted * 3 + 2] = pTriangle[2];
+
+        // Take the triangle out of its vertices' lists of remaining triangles
+        for ( int c = 0; c < 3; ++c )
+        {
+            const unsigned int v = pTriangle[c];
+            unsigned int * pList = &mVertexTriangles[ mTriangleOffsets[v] ];
+            unsigned int last    = --mRemaining[v];
+
+            for ( unsigned int i = 0; i < last; ++i )
+            {
+                if ( pList[i] == best )
+                {
+                    pList[i] = pList[last];
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the cache, pushing the
+        // rest of the cache back
+        unsigned int cache[CACHE_SIZE + 3];
+        unsigned int cacheCount = 0;
+
+        for ( int c = 0; c < 3; ++c )
+        {
+            cache[cacheCount++] = pTriangle[c];
+        }
+
+        for ( unsigned int i = 0; i < mCacheCount; ++i )
+        {
+            const unsigned int v = mCache[i];
+
+            if ( v != pTriangle[0] && v != pTriangle[1] && v != pTriangle[2] )
+            {
+                cache[cacheCount++] = v;
+            }
+        }
+
+        for ( unsigned int i = 0; i < cacheCount; ++i )
+        {
+            mCache[i] = cache[i];
+            mCachePosition[ cache[i] ] =
+                ( i < CACHE_SIZE ) ? static_cast<int>( i ) : -1;
+            mVertexScores[ cache[i] ] = vertexScore( cache[i] );
+        }
+
+        // Rescore the triangles touching the cache, including those of the
+        // vertices that just fell out of it, and draw the best one next
+        float bestScore = -1.0f;
+        best = NO_TRIANGLE;
+
+        for ( unsigned int i = 0; i < cacheCount; ++i )
+        {
+            const unsigned int v = cache[i];
+            const unsigned int * pList = &mVertexTriangles[ mTriangleOffsets[v] ];
+
+            for ( unsigned int j = 0; j < mRemaining[v]; ++j )
+            {
+                const unsigned int t = pList[j];
+                const unsigned int * pCorners = &pIndices[t * 3];
+
+                mTriangleScores[t] = mVertexScores[ pCorners[0] ] +
+                                     mVertexScores[ pCorners[1] ] +
+                                     mVertexScores[ pCorners[2] ];
+
+                if ( mTriangleScores[t] > bestScore )
+                {
+                    bestScore = mTriangleScores[t];
+                    best      = t;
+                }
+            }
+        }
+
+        mCacheCount = ( cacheCount < CACHE_SIZE ) ? cacheCount : CACHE_SIZE;
+    }
+
+    std::copy( mOutput.begin(), mOutput.end(), pIndices );
+}
+
+/**
+ * Simulates drawing the indices through a FIFO post-transform cache and
+ * returns the average cache miss ratio: vertices transformed per triangle.
+ * Ranges from 3 when no vertex is reused down to about 0.5 for a large,
+ * perfectly ordered grid.
+ *
+ * \param  indices      Triangle list to draw
+ * \param  vertexCount  Number of vertices the indices refer to
+ * \param  cacheSize    Number of vertices the cache holds
+ */
+float VertexCacheOptimizer::simulateAcmr( const ChunkIndexBuffer& indices,
+                                          size_t vertexCount,
+                                          unsigned int cacheSize )
+{
+    if ( indices.size() < 3 )
+    {
+        return 0.0f;
+    }
+
+    // A vertex is cached if fewer than cacheSize misses have happened since
+    // it was last loaded
+    std::vector<size_t> loadedAt( vertexCount, 0 );
+    size_t misses = 0;
+
+    for ( size_t i = 0; i < indices.size(); ++i )
+    {
+        const unsigned int v = indices[i];
+
+        if ( loadedAt[v] == 0 || misses - loadedAt[v] + 1 > cacheSize )
+        {
+            misses++;
+            loadedAt[v] = misses;
+        }
+    }
+
+    return static_cast<float>( misses ) / ( indices.size() / 3 );
+}
+
+float VertexCacheOptimizer::vertexScore( unsigned int vertex ) const
+{
+    const unsigned int remaining = mRemaining[vertex];
+
+    if ( remaining == 0 )
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    const int position = mCachePosition[vertex];
+
+    if ( position >= 0 )
+    {
+        if ( position < 3 )
+        {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            const float scale = 1.0f / ( CACHE_SIZE - 3 );
+            score = std::pow( 1.0f - ( position - 3 ) * scale,
+                              CACHE_DECAY_POWER );
+        }
+    }
+
+    return score + VALENCE_BOOST_SCALE *
+                   std::pow( static_cast<float>( remaining ),
+                             -VALENCE_BOOST_POWER );
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2012 Scott MacDonald
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SCOTT_CUBEWORLD_VERTEX_CACHE_OPTIMIZER_H
+#define SCOTT_CUBEWORLD_VERTEX_CACHE_OPTIMIZER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+class ChunkIndexBuffer;
+
+/**
+ * Reorders triangles so that vertices the GPU has just transformed are
+ * reused while they are still in its post-transform cache, using Tom
+ * Forsyth's linear-speed vertex cache optimization. Each vertex is scored by
+ * its position in a simulated LRU cache and by how many triangles still
+ * need it, and the triangle with the best total score is emitted next.
+ *
+ * The optimizer's working buffers are kept between calls so that one
+ * optimizer per mesh worker stops allocating once it has seen the largest
+ * mesh.
+ */
+class VertexCacheOptimizer
+{
+public:
+    VertexCacheOptimizer();
+
+    // Size of the LRU cache the scores are tuned for
+    const static unsigned int CACHE_SIZE = 32;
+
+    // Reorder the triangles in pIndices, which holds count indices into a
+    // list of vertexCount vertices. Each triangle keeps its winding
+    void optimize( unsigned int * pIndices, size_t count, size_t vertexCount );
+
+    // Average number of vertices transformed per triangle when the indices
+    // are drawn through a FIFO cache holding cacheSize vertices
+    static float simulateAcmr( const ChunkIndexBuffer& indices,
+                               size_t vertexCount,
+                               unsigned int cacheSize = 16 );
+
+private:
+    float vertexScore( unsigned int vertex ) const;
+
+private:
+    // Triangles using each vertex, mTriangleOffsets[v] is where vertex v's
+    // list starts in mVertexTriangles. The first mRemaining[v] entries are
+    // the triangles that haven't been emitted yet
+    std::vector<unsigned int> mTriangleOffsets;
+    std::vector<unsigned int> mVertexTriangles;
+    std::vector<unsigned int> mRemaining;
+
+    // Position of each vertex in the simulated cache, or -1
+    std::vector<int>          mCachePosition;
+    std::vector<float>        mVertexScores;
+    std::vector<float>        mTriangleScores;
+    std::vector<uint8_t>      mIsEmitted;
+    std::vector<unsigned int> mOutput;
+
+    // Cache contents, with room for the three vertices pushed in before the
+    // oldest ones are evicted
+    unsigned int mCache[CACHE_SIZE + 3];
+    unsigned int mCacheCount;
+};
+
+#endif
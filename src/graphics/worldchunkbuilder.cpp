@@ -1,235 +1,1349 @@
 #include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubeface.h"
+#include "engine/material.h"
+#include "engine/bits.h"
 #include "math/vector.h"
 
+#include <algorithm>
+#include <cassert>
 #include <stdint.h>
 #include <vector>
 
+namespace
+{
+    /**
+     * Each face is drawn as a quad in the plane spanned by two of the cube's
+     * axes, u and v, picked so that u x v points out of the cube. Corners
+     * are laid out like so when looking at the face from outside:
+     *
+     *   A - D        v
+     *   | / |        |
+     *   B - C        +-- u
+     */
+    const int FACE_U_AXIS[ECUBEFACE_COUNT] = { 1, 2, 2, 0, 0, 1 };
+    const int FACE_V_AXIS[ECUBEFACE_COUNT] = { 2, 1, 0, 2, 1, 0 };
+
+    const float FACE_NORMAL[ECUBEFACE_COUNT][3] =
+    {
+        {  1.0f,  0.0f,  0.0f },
+        { -1.0f,  0.0f,  0.0f },
+        {  0.0f,  1.0f,  0.0f },
+        {  0.0f, -1.0f,  0.0f },
+        {  0.0f,  0.0f,  1.0f },
+        {  0.0f,  0.0f, -1.0f }
+    };
+
+    enum ECorner
+    {
+        ECORNER_A,
+        ECORNER_B,
+        ECORNER_C,
+        ECORNER_D
+    };
+
+    /**
+     * Returns one corner of a quad lying on a cube's face, in chunk space.
+     * The quad starts at the cube given by origin and extends du cubes along
+     * the face's u axis and dv cubes along its v axis. Thickness is the size
+     * of the cube the face belongs to, which is more than one for downsampled
+     * cells.
+     */
+    PackedCubeVertex faceCorner( ECubeFace face,
+                                 ECorner corner,
+                                 const int origin[3],
+                                 int du,
+                                 int dv,
+                                 int material,
+                                 unsigned int occlusion,
+                                 int thickness )
+    {
+        int p[3] = { origin[0], origin[1], origin[2] };
+
+        // Positive faces sit on the far side of the cube
+        if ( CubeFace::direction( face ) > 0 )
+        {
+            p[ CubeFace::axis( face ) ] += thickness;
+        }
+
+        p[ FACE_U_AXIS[face] ] += du;
+        p[ FACE_V_AXIS[face] ] += dv;
+
+        const int ao = ( occlusion >> ( 2 * corner ) ) & 0x03;
+        return PackedCubeVertex( p, face, corner, material, ao );
+    }
+
+    /**
+     * Expands a packed vertex into the full vertex format. Texture
+     * coordinates are projected from the position onto the face's u and v
+     * axes, so the texture repeats once per cube across merged quads and a
+     * corner shared by neighboring quads gets the same coordinates in each.
+     * This only differs from measuring from the quad's corner by whole
+     * cubes, which a repeating texture can't tell apart.
+     */
+    CubeVertex unpackVertex( const PackedCubeVertex& v )
+    {
+        const int face = v.face();
+
+        const Vec3 p( v.pos[0], v.pos[1], v.pos[2] );
+        const Vec3 n( FACE_NORMAL[face][0],
+                      FACE_NORMAL[face][1],
+                      FACE_NORMAL[face][2] );
+        const Vec3 t( static_cast<float>(  v.pos[ FACE_U_AXIS[face] ] ),
+                      static_cast<float>( -v.pos[ FACE_V_AXIS[face] ] ),
+                      0.0f );
+
+        return CubeVertex( p, n, t );
+    }
+
+    /**
+     * Everything a packed vertex is drawn with, squeezed into 23 bits.
+     * Vertices with the same key unpack identically, and keep the same
+     * ambient occlusion when left packed
+     */
+    uint32_t weldKey( const PackedCubeVertex& v )
+    {
+        return static_cast<uint32_t>( v.pos[0] )         |
+               static_cast<uint32_t>( v.pos[1] )  << 6   |
+               static_cast<uint32_t>( v.pos[2] )  << 12  |
+               static_cast<uint32_t>( v.face() )  << 18  |
+               static_cast<uint32_t>( v.ao )      << 21;
+    }
+
+    /**
+     * Checks if a cube's face can be seen past the cube in front of it. Any
+     * opaque cube hides the face, as does a translucent cube of the same
+     * material so that the inside of a lake or a tree's canopy isn't meshed.
+     */
+    bool isFaceVisible( EMaterialType material, EMaterialType other )
+    {
+        return other == EMATERIAL_EMPTY ||
+               ( other != material && Util::IsTranslucent( other ) );
+    }
+
+    /**
+     * Returns the material of the cube in front of a cube's face, which is
+     * in a neighbor chunk when the face is on the chunk's edge. Missing
+     * neighbors are treated as empty.
+     */
+    EMaterialType materialInFront( const ChunkNeighborhood& neighborhood,
+                                   const int cube[3],
+                                   ECubeFace face )
+    {
+        const int size[3] = { static_cast<int>( WorldChunk::TOTAL_COLS ),
+                              static_cast<int>( WorldChunk::TOTAL_ROWS ),
+                              static_cast<int>( WorldChunk::TOTAL_DEPTH ) };
+
+        const int axis = CubeFace::axis( face );
+        const WorldChunk * pChunk = neighborhood.pChunk;
+
+        int p[3] = { cube[0], cube[1], cube[2] };
+        p[axis] += CubeFace::direction( face );
+
+        if ( p[axis] < 0 || p[axis] >= size[axis] )
+        {
+            pChunk  = neighborhood.pNeighbors[face];
+            p[axis] = ( p[axis] + size[axis] ) % size[axis];
+        }
+
+        if ( pChunk == NULL )
+        {
+            return EMATERIAL_EMPTY;
+        }
+
+        return pChunk->cubes()[ ( p[2] * size[1] + p[1] ) * size[0] + p[0] ].materialType();
+    }
+
+    /**
+     * Checks if the cube at a chunk relative position is opaque, using the
+     * opaque occupancy masks. Positions just outside of the chunk are looked
+     * up in the neighbor on that side. Positions outside along two or more
+     * axes belong to chunks that aren't in the neighborhood, and count as
+     * empty.
+     */
+    bool isOpaqueAt( const ChunkNeighborhood& neighborhood, const int pos[3] )
+    {
+        const int size[3] = { static_cast<int>( WorldChunk::TOTAL_COLS ),
+                              static_cast<int>( WorldChunk::TOTAL_ROWS ),
+                              static_cast<int>( WorldChunk::TOTAL_DEPTH ) };
+
+        const WorldChunk * pChunk = neighborhood.pChunk;
+        int p[3] = { pos[0], pos[1], pos[2] };
+        bool isOutside = false;
+
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            if ( p[axis] >= 0 && p[axis] < size[axis] )
+            {
+                continue;
+            }
+            else if ( isOutside )
+            {
+                return false;
+            }
+
+            // Faces are ordered +x, -x, +y, -y, +z, -z
+            const int face = axis * 2 + ( p[axis] < 0 ? 1 : 0 );
+
+            pChunk    = neighborhood.pNeighbors[face];
+            p[axis]   = ( p[axis] + size[axis] ) % size[axis];
+            isOutside = true;
+        }
+
+        return pChunk != NULL &&
+               ( ( pChunk->opaqueOccupancy()[ p[2] * size[1] + p[1] ] >> p[0] ) & 1 ) != 0;
+    }
+
+    /**
+     * Works out the ambient occlusion of a cube face's corners from the
+     * eight cubes around the cube in front of the face. A corner is darkened
+     * by the two cubes along its edges and the one diagonal to it, and is
+     * fully occluded when both edges are blocked. Only opaque cubes cast
+     * occlusion.
+     *
+     * \return Occlusion of each corner (0 to 3), two bits per corner with A
+     *         in the lowest bits
+     */
+    unsigned int faceOcclusion( const ChunkNeighborhood& neighborhood,
+                                const int cube[3],
+                                ECubeFace face )
+    {
+        const int size[3] = { static_cast<int>( WorldChunk::TOTAL_COLS ),
+                              static_cast<int>( WorldChunk::TOTAL_ROWS ),
+                              static_cast<int>( WorldChunk::TOTAL_DEPTH ) };
+
+        const int axis  = CubeFace::axis( face );
+        const int uAxis = FACE_U_AXIS[face];
+        const int vAxis = FACE_V_AXIS[face];
+
+        int front[3] = { cube[0], cube[1], cube[2] };
+        front[axis] += CubeFace::direction( face );
+
+        // Most faces are well inside of the chunk, where the occupancy rows
+        // can be read directly
+        const bool isInterior =
+            front[axis]  >= 0 && front[axis]  < size[axis] &&
+            front[uAxis] >= 1 && front[uAxis] < size[uAxis] - 1 &&
+            front[vAxis] >= 1 && front[vAxis] < size[vAxis] - 1;
+
+        const uint32_t * pRows = neighborhood.pChunk->opaqueOccupancy();
+        bool isFilled[3][3];
+
+        for ( int dv = -1; dv <= 1; ++dv )
+        {
+            for ( int du = -1; du <= 1; ++du )
+            {
+                int p[3] = { front[0], front[1], front[2] };
+                p[uAxis] += du;
+                p[vAxis] += dv;
+
+                if ( du == 0 && dv == 0 )
+                {
+                    isFilled[1][1] = false;
+                }
+                else if ( isInterior )
+                {
+                    isFilled[dv + 1][du + 1] =
+                        ( ( pRows[ p[2] * size[1] + p[1] ] >> p[0] ) & 1 ) != 0;
+                }
+                else
+                {
+                    isFilled[dv + 1][du + 1] = isOpaqueAt( neighborhood, p );
+                }
+            }
+        }
+
+        // Direction of each corner along u and v, see ECorner
+        const int CORNER_U[4] = { -1, -1,  1, 1 };
+        const int CORNER_V[4] = {  1, -1, -1, 1 };
+        unsigned int occlusion = 0;
+
+        for ( int c = 0; c < 4; ++c )
+        {
+            const int u = CORNER_U[c] + 1;
+            const int v = CORNER_V[c] + 1;
+
+            const bool uSide  = isFilled[1][u];
+            const bool vSide  = isFilled[v][1];
+            const bool corner = isFilled[v][u];
+
+            const unsigned int ao = ( uSide && vSide ) ? 3 : uSide + vSide + corner;
+            occlusion |= ao << ( 2 * c );
+        }
+
+        return occlusion;
+    }
+
+    /**
+     * Checks if every corner of a face has the same occlusion, which is the
+     * only time neighboring faces can be merged without changing how they
+     * are shaded
+     */
+    bool isOcclusionUniform( unsigned int occlusion )
+    {
+        return occlusion == ( occlusion & 0x03 ) * 0x55;
+    }
+}
+
+const unsigned int WorldChunkBuilder::MAX_LOD = 3;
+
 WorldChunkBuilder::WorldChunkBuilder()
-    : m_offset(0)
-{
-    faces.reserve( 150000 );
-    vertices.reserve( 35000 );
-}
-
-
-// TODO remove this from worldchunk, use a visitAllCubes()
-// visitor pattern to build the mesh
-/*
-WorldChunkMesh WorldChunkBuilder::createMesh() const
-{
-    
-    //
-    // Cube positions
-    //   TODO: rearrange these to fit correct builder pattern
-    //      (ABCD, not ADCB)
-    // [AB        
-    //  DC]    -->  ADCB    
-    //
-    //   xyz
-    //   1. right
-    //   2. left
-    //   3. back
-    //   4. front
-    //   5. top
-    //   6. bottom
-    Vec3 CubePos[6][4] = 
-    {
-        {   // right
-            Vec3( 1.0f, 1.0f, 0.0f ),
-            Vec3( 1.0f, 0.0f, 0.0f ),
-            Vec3( 1.0f, 0.0f,-1.0f ),
-            Vec3( 1.0f, 1.0f,-1.0f )
-        },
-        {   // left
-            Vec3( 0.0f, 1.0f,-1.0f ),
-            Vec3( 0.0f, 0.0f,-1.0f ),
-            Vec3( 0.0f, 0.0f, 0.0f ),
-            Vec3( 0.0f, 1.0f, 0.0f )
-        },
-        {   // back
-            Vec3( 1.0f, 1.0f,-1.0f ),
-            Vec3( 1.0f, 0.0f,-1.0f ),
-            Vec3( 0.0f, 0.0f,-1.0f ),
-            Vec3( 0.0f, 1.0f,-1.0f )
-        },
-        {   // front
-            Vec3( 0.0f, 1.0f, 0.0f ),
-            Vec3( 0.0f, 0.0f, 0.0f ),
-            Vec3( 1.0f, 0.0f, 0.0f ),
-            Vec3( 1.0f, 1.0f, 0.0f )
-        },
-        {   // top
-            Vec3( 1.0f, 1.0f, 0.0f ),
-            Vec3( 1.0f, 1.0f,-1.0f ),
-            Vec3( 0.0f, 1.0f,-1.0f ),
-            Vec3( 0.0f, 1.0f, 0.0f )
-        },
-        {   // bottom
-            Vec3( 0.0f, 0.0f, 0.0f ),
-            Vec3( 0.0f, 0.0f,-1.0f ),
-            Vec3( 1.0f, 0.0f,-1.0f ),
-            Vec3( 1.0f, 0.0f, 0.0f )
+    : m_offset(0),
+      mStats(),
+      mZBegin( 0 ),
+      mZEnd( 0 )
+{
+}
+
+/**
+ * Walks every cube in the chunk and emits the faces that border empty space.
+ * Faces on the edge of the chunk look into the matching neighbor chunk, so a
+ * solid wall that spans two chunks doesn't get a hidden seam down the middle.
+ *
+ * When greedy meshing, visible faces are first recorded per face direction
+ * and then merged into the largest rectangles that share a material.
+ *
+ * \param  neighborhood  The chunk to mesh and its six neighbors
+ * \param  mode          How visible faces are turned into quads
+ */
+void WorldChunkBuilder::build( const ChunkNeighborhood& neighborhood,
+                               EMeshingMode mode )
+{
+    buildRange( neighborhood, mode, 0, WorldChunk::TOTAL_DEPTH );
+}
+
+/**
+ * Meshes a single section of the chunk (see WorldChunk::SECTION_DEPTH). The
+ * section's faces are still culled against the cubes around it, including
+ * those in neighboring sections, and vertex positions stay relative to the
+ * chunk's origin.
+ *
+ * \param  neighborhood  The chunk to mesh and its six neighbors
+ * \param  section       Index of the section to mesh
+ * \param  mode          How visible faces are turned into quads
+ */
+void WorldChunkBuilder::buildSection( const ChunkNeighborhood& neighborhood,
+                                      unsigned int section,
+                                      EMeshingMode mode,
+                                      unsigned int lod )
+{
+    assert( section < WorldChunk::SECTION_COUNT );
+    assert( lod <= MAX_LOD );
+
+    const unsigned int zBegin = section * WorldChunk::SECTION_DEPTH;
+    const unsigned int zEnd   = zBegin + WorldChunk::SECTION_DEPTH;
+
+    if ( lod > 0 )
+    {
+        buildDownsampled( neighborhood, lod, zBegin, zEnd );
+    }
+    else
+    {
+        buildRange( neighborhood, mode, zBegin, zEnd );
+    }
+}
+
+/**
+ * Picks the material for a cell of a downsampled chunk. The cell is filled
+ * when at least half of its cubes are, using whichever material the most
+ * cubes have (the lowest material wins a tie).
+ *
+ * \param  chunk  Chunk to sample
+ * \param  size   Width of a cell in cubes
+ * \param  cell   Cell coordinate, in cells
+ * \return Material of the cell, EMATERIAL_EMPTY if it is empty
+ */
+EMaterialType WorldChunkBuilder::downsample( const WorldChunk& chunk,
+                                             unsigned int size,
+                                             const int cell[3] )
+{
+    const unsigned int COLS = WorldChunk::TOTAL_COLS;
+    const unsigned int ROWS = WorldChunk::TOTAL_ROWS;
+    const CubeData * pCubes = chunk.cubes();
+
+    unsigned int counts[EMATERIAL_COUNT] = { 0 };
+    unsigned int filled = 0;
+
+    for ( unsigned int z = cell[2] * size; z < ( cell[2] + 1 ) * size; ++z )
+    {
+        for ( unsigned int y = cell[1] * size; y < ( cell[1] + 1 ) * size; ++y )
+        {
+            // Rows of air don't count towards anything
+            if ( chunk.rowOccupancy( y, z ) == 0 )
+            {
+                continue;
+            }
+
+            for ( unsigned int x = cell[0] * size; x < ( cell[0] + 1 ) * size; ++x )
+            {
+                const CubeData& cube = pCubes[ ( z * ROWS + y ) * COLS + x ];
+
+                if (! cube.isEmpty() )
+                {
+                    counts[ cube.materialType() ]++;
+                    filled++;
+                }
+            }
+        }
+    }
+
+    if ( filled * 2 < size * size * size )
+    {
+        return EMATERIAL_EMPTY;
+    }
+
+    int best = EMATERIAL_EMPTY;
+
+    for ( int m = 0; m < EMATERIAL_COUNT; ++m )
+    {
+        if ( m != EMATERIAL_EMPTY && ( best == EMATERIAL_EMPTY || counts[m] > counts[best] ) )
+        {
+            best = m;
+        }
+    }
+
+    return static_cast<EMaterialType>( best );
+}
+
+/**
+ * Meshes the cubes with z in [zBegin, zEnd) from a copy of the chunk that has
+ * been downsampled by 2^lod along each axis, emitting one quad per visible
+ * cell face.
+ *
+ * Cells on the edge of the chunk are tested against the same cells of the
+ * neighboring chunks. A missing neighbor is treated as empty, which closes
+ * off the chunk with a skirt of faces along that side. WorldView leaves out
+ * neighbors that are drawn at a different level of detail to get skirts that
+ * hide the seam between the two.
+ */
+void WorldChunkBuilder::buildDownsampled( const ChunkNeighborhood& neighborhood,
+                                          unsigned int lod,
+                                          unsigned int zBegin,
+                                          unsigned int zEnd )
+{
+    assert( neighborhood.pChunk != NULL );
+    reset();
+
+    const int size  = 1 << lod;
+    const int cells = static_cast<int>( WorldChunk::TOTAL_COLS ) / size;
+
+    assert( zBegin % size == 0 && zEnd % size == 0 );
+
+    mZBegin = static_cast<int>( zBegin );
+    mZEnd   = static_cast<int>( zEnd );
+
+    // Downsample the section and the layer of cells on either side of it
+    const WorldChunk& chunk = *neighborhood.pChunk;
+    const int cellBegin = std::max( mZBegin / size - 1, 0 );
+    const int cellEnd   = std::min( mZEnd / size + 1, cells );
+
+    mCells.assign( cells * cells * cells, EMATERIAL_EMPTY );
+
+    for ( int z = cellBegin; z < cellEnd; ++z )
+    {
+        for ( int y = 0; y < cells; ++y )
+        {
+            for ( int x = 0; x < cells; ++x )
+            {
+                const int cell[3] = { x, y, z };
+                mCells[ ( z * cells + y ) * cells + x ] =
+                    static_cast<uint8_t>( downsample( chunk, size, cell ) );
+            }
+        }
+    }
+
+    for ( int z = mZBegin / size; z < mZEnd / size; ++z )
+    {
+        for ( int y = 0; y < cells; ++y )
+        {
+            for ( int x = 0; x < cells; ++x )
+            {
+                const uint8_t material = mCells[ ( z * cells + y ) * cells + x ];
+
+                if ( material == EMATERIAL_EMPTY )
+                {
+                    continue;
+                }
+
+                unsigned int hidden = 0;
+
+                for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+                {
+                    const ECubeFace face = static_cast<ECubeFace>( f );
+                    const int axis = CubeFace::axis( face );
+
+                    int other[3] = { x, y, z };
+                    other[axis] += CubeFace::direction( face );
+
+                    EMaterialType neighbor = EMATERIAL_EMPTY;
+
+                    if ( other[axis] >= 0 && other[axis] < cells )
+                    {
+                        neighbor = static_cast<EMaterialType>(
+                            mCells[ ( other[2] * cells + other[1] ) * cells + other[0] ] );
+                    }
+                    else if ( neighborhood.pNeighbors[f] != NULL )
+                    {
+                        // Wrap around to the far side of the neighbor
+                        other[axis] = ( other[axis] + cells ) % cells;
+                        neighbor = downsample( *neighborhood.pNeighbors[f], size, other );
+                    }
+
+                    if (! isFaceVisible( static_cast<EMaterialType>( material ), neighbor ) )
+                    {
+                        hidden++;
+                        continue;
+                    }
+
+                    const int origin[3] = { x * size, y * size, z * size };
+                    addQuad( face, origin, size, size, material, 0, size );
+                }
+
+                mStats.cubeCount   += 1;
+                mStats.faceCount   += ECUBEFACE_COUNT;
+                mStats.hiddenFaces += hidden;
+
+                if ( hidden == ECUBEFACE_COUNT )
+                {
+                    mStats.hiddenCubes++;
+                }
+            }
+        }
+    }
+
+    mStats.quadCount   = static_cast<unsigned int>( vertices.size() / 4 );
+    mStats.vertexCount = static_cast<unsigned int>( vertices.size() );
+    mStats.indexCount  = static_cast<unsigned int>( numIndices() );
+    mStats.translucentIndexCount = static_cast<unsigned int>( mTranslucentFaces.size() );
+}
+
+/**
+ * Meshes the cubes with z in [zBegin, zEnd)
+ */
+void WorldChunkBuilder::buildRange( const ChunkNeighborhood& neighborhood,
+                                    EMeshingMode mode,
+                                    unsigned int zBegin,
+                                    unsigned int zEnd )
+{
+    assert( neighborhood.pChunk != NULL );
+    assert( zBegin < zEnd && zEnd <= WorldChunk::TOTAL_DEPTH );
+    reset();
+
+    mZBegin = static_cast<int>( zBegin );
+    mZEnd   = static_cast<int>( zEnd );
+
+    if ( mode == EMESHING_BINARY )
+    {
+        buildBinary( neighborhood );
+        return;
+    }
+
+    const bool isGreedy = ( mode == EMESHING_GREEDY );
+
+    const int COLS  = static_cast<int>( WorldChunk::TOTAL_COLS );
+    const int ROWS  = static_cast<int>( WorldChunk::TOTAL_ROWS );
+    const int DEPTH = static_cast<int>( WorldChunk::TOTAL_DEPTH );
+
+    const WorldChunk& chunk = *neighborhood.pChunk;
+    const CubeData * pCubes = chunk.cubes();
+
+    // Offset to the neighboring cube through each face, and the offset to
+    // the matching cube in the neighbor chunk when crossing the chunk edge
+    const int STEP[ECUBEFACE_COUNT] =
+    {
+        1, -1, COLS, -COLS, COLS * ROWS, -COLS * ROWS
+    };
+
+    const int WRAP[ECUBEFACE_COUNT] =
+    {
+        -( COLS - 1 ),                  COLS - 1,
+        -( ROWS - 1 ) * COLS,           ( ROWS - 1 ) * COLS,
+        -( DEPTH - 1 ) * COLS * ROWS,   ( DEPTH - 1 ) * COLS * ROWS
+    };
+
+    if ( isGreedy )
+    {
+        const size_t SLICE = COLS * ROWS;
+
+        for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+        {
+            mFaceMaterials[f].resize( SLICE * DEPTH );
+            std::fill( mFaceMaterials[f].begin() + mZBegin * SLICE,
+                       mFaceMaterials[f].begin() + mZEnd * SLICE,
+                       static_cast<uint16_t>( EMATERIAL_EMPTY ) );
+        }
+    }
+
+    for ( int z = mZBegin; z < mZEnd; ++z )
+    {
+        for ( int y = 0; y < ROWS; ++y )
+        {
+            // Skip rows of air without looking at them
+            if ( chunk.rowOccupancy( y, z ) == 0 )
+            {
+                continue;
+            }
+
+            for ( int x = 0; x < COLS; ++x )
+            {
+                const int index = ( z * ROWS + y ) * COLS + x;
+
+                const EMaterialType material = pCubes[index].materialType();
+
+                if ( material == EMATERIAL_EMPTY )
+                {
+                    continue;
+                }
+
+                const bool onEdge[ECUBEFACE_COUNT] =
+                {
+                    x == COLS - 1,  x == 0,
+                    y == ROWS - 1,  y == 0,
+                    z == DEPTH - 1, z == 0
+                };
+
+                unsigned int hidden = 0;
+
+                for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+                {
+                    EMaterialType neighbor = EMATERIAL_EMPTY;
+
+                    if (! onEdge[f] )
+                    {
+                        neighbor = pCubes[ index + STEP[f] ].materialType();
+                    }
+                    else if ( neighborhood.pNeighbors[f] != NULL )
+                    {
+                        const CubeData * pOther = neighborhood.pNeighbors[f]->cubes();
+                        neighbor = pOther[ index + WRAP[f] ].materialType();
+                    }
+
+                    if (! isFaceVisible( material, neighbor ) )
+                    {
+                        hidden++;
+                        continue;
+                    }
+
+                    const int origin[3] = { x, y, z };
+                    const unsigned int occlusion =
+                        faceOcclusion( neighborhood, origin, static_cast<ECubeFace>( f ) );
+
+                    if ( isGreedy )
+                    {
+                        mFaceMaterials[f][index] = static_cast<uint16_t>(
+                            material | ( occlusion << 8 ) );
+                    }
+                    else
+                    {
+                        addQuad( static_cast<ECubeFace>( f ), origin, 1, 1,
+                                 material, occlusion );
+                    }
+                }
+
+                mStats.cubeCount   += 1;
+                mStats.faceCount   += ECUBEFACE_COUNT;
+                mStats.hiddenFaces += hidden;
+
+                if ( hidden == ECUBEFACE_COUNT )
+                {
+                    mStats.hiddenCubes++;
+                }
+            }
         }
+    }
+
+    if ( isGreedy )
+    {
+        for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+        {
+            mergeFaces( static_cast<ECubeFace>( f ) );
+        }
+    }
+
+    mStats.quadCount   = static_cast<unsigned int>( vertices.size() / 4 );
+    mStats.vertexCount = static_cast<unsigned int>( vertices.size() );
+    mStats.indexCount  = static_cast<unsigned int>( numIndices() );
+    mStats.translucentIndexCount = static_cast<unsigned int>( mTranslucentFaces.size() );
+}
+
+/**
+ * Builds exactly the same quads as greedy meshing, in the same order, but
+ * without testing every cube against its neighbors.
+ *
+ * Each row of cubes along x is already stored as a bit mask. Visible faces of
+ * a whole row are found at once by masking the row with the opaque cubes in
+ * front of it: along x by shifting the neighboring rows (padded with the
+ * neighbor chunks' edge cubes into a 64 bit word), and along y and z by
+ * reading the row next to it. Only the rare translucent faces looking into
+ * another translucent cube compare materials one at a time. The visible
+ * faces of each direction are then laid out as slices of bit planes, and
+ * merged by scanning the set bits of each plane. Materials and occlusion are
+ * only looked up for faces that turn out to be visible.
+ */
+void WorldChunkBuilder::buildBinary( const ChunkNeighborhood& neighborhood )
+{
+    const int COLS  = static_cast<int>( WorldChunk::TOTAL_COLS );
+    const int ROWS  = static_cast<int>( WorldChunk::TOTAL_ROWS );
+    const int DEPTH = static_cast<int>( WorldChunk::TOTAL_DEPTH );
+
+    assert( COLS <= 32 && ROWS <= 32 && DEPTH <= 32 );
+
+    const WorldChunk& chunk = *neighborhood.pChunk;
+    const CubeData * pCubes  = chunk.cubes();
+    const uint32_t * pRows   = chunk.occupancy();
+    const uint32_t * pOpaque = chunk.opaqueOccupancy();
+    const uint32_t * pOther[ECUBEFACE_COUNT];
+    const uint32_t * pOtherOpaque[ECUBEFACE_COUNT];
+
+    for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+    {
+        const WorldChunk * pNeighbor = neighborhood.pNeighbors[f];
+        pOther[f]       = ( pNeighbor != NULL ? pNeighbor->occupancy() : NULL );
+        pOtherOpaque[f] = ( pNeighbor != NULL ? pNeighbor->opaqueOccupancy() : NULL );
+        mVisibleRows[f].resize( ROWS * DEPTH );
+    }
+
+    // Offset to the row in front of a row along y and z, and the offset to
+    // the matching row of the neighbor chunk when crossing the chunk edge
+    const int STEP[ECUBEFACE_COUNT] =
+    {
+        0, 0, 1, -1, ROWS, -ROWS
     };
 
-    Vec3 CubeNormals[6] =
+    const int WRAP[ECUBEFACE_COUNT] =
     {
-        Vec3( 1.0f,  0.0f,  0.0f ),
-        Vec3(-1.0f,  0.0f,  0.0f ),
-        Vec3( 0.0f,  0.0f, -1.0f ),
-        Vec3( 0.0f,  0.0f,  1.0f ),
-        Vec3( 0.0f,  1.0f,  0.0f ),
-        Vec3( 0.0f, -1.0f,  0.0f )
+        0,                      0,
+        -( ROWS - 1 ),          ROWS - 1,
+        -( DEPTH - 1 ) * ROWS,  ( DEPTH - 1 ) * ROWS
     };
 
-    //
-    // Directional mapper
-    //   (in game space)
-    //  1. +x   -->   right
-    //  2. -x   -->   left
-    //  3. +y   -->   back
-    //  4. -y   -->   front
-    //  5. +z   -->   top
-    //  6. -z   -->   bottom
-    //
-    Vec3 axes[6] = { Vec3( 1.0f, 0.0f, 0.0f ),
-                     Vec3(-1.0f, 0.0f, 0.0f ),
-                     Vec3( 0.0f, 1.0f, 0.0f ),
-                     Vec3( 0.0f,-1.0f, 0.0f ),
-                     Vec3( 0.0f, 0.0f, 1.0f ),
-                     Vec3( 0.0f, 0.0f,-1.0f ) };
+    // Find the visible faces of every row being built
+    unsigned int visibleFaces = 0;
 
-    //
-    // Okay, walk through each cube
-    //
-    std::vector<WorldCube>::const_iterator itr;
-    int hiddenCubes = 0;
-    int hiddenFaces = 0;
-    int totalFaces  = 0;
+    for ( int z = mZBegin; z < mZEnd; ++z )
+    {
+        for ( int y = 0; y < ROWS; ++y )
+        {
+            const int row = z * ROWS + y;
+            const uint32_t cubes = pRows[row];
 
-    std::cout << "Starting compile" << std::endl;
+            if ( cubes == 0 )
+            {
+                for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+                {
+                    mVisibleRows[f][row] = 0;
+                }
+
+                continue;
+            }
+
+            // Filled and opaque cubes in front of each cube of the row. Bit 0
+            // of the padded words is the last cube of the -x neighbor, bits 1
+            // to COLS are this row and the bit after that is the first cube
+            // of +x
+            uint32_t filled[ECUBEFACE_COUNT];
+            uint32_t opaque[ECUBEFACE_COUNT];
+            uint64_t paddedFilled = uint64_t( cubes ) << 1;
+            uint64_t paddedOpaque = uint64_t( pOpaque[row] ) << 1;
+
+            if ( pOther[ECUBEFACE_NEG_X] != NULL )
+            {
+                paddedFilled |= ( pOther[ECUBEFACE_NEG_X][row] >> ( COLS - 1 ) ) & 1;
+                paddedOpaque |= ( pOtherOpaque[ECUBEFACE_NEG_X][row] >> ( COLS - 1 ) ) & 1;
+            }
+
+            if ( pOther[ECUBEFACE_POS_X] != NULL )
+            {
+                paddedFilled |= uint64_t( pOther[ECUBEFACE_POS_X][row] & 1 ) << ( COLS + 1 );
+                paddedOpaque |= uint64_t( pOtherOpaque[ECUBEFACE_POS_X][row] & 1 ) << ( COLS + 1 );
+            }
+
+            filled[ECUBEFACE_POS_X] = static_cast<uint32_t>( paddedFilled >> 2 );
+            filled[ECUBEFACE_NEG_X] = static_cast<uint32_t>( paddedFilled );
+            opaque[ECUBEFACE_POS_X] = static_cast<uint32_t>( paddedOpaque >> 2 );
+            opaque[ECUBEFACE_NEG_X] = static_cast<uint32_t>( paddedOpaque );
+
+            const bool onEdge[ECUBEFACE_COUNT] =
+            {
+                false,          false,
+                y == ROWS - 1,  y == 0,
+                z == DEPTH - 1, z == 0
+            };
+
+            for ( int f = ECUBEFACE_POS_Y; f < ECUBEFACE_COUNT; ++f )
+            {
+                if (! onEdge[f] )
+                {
+                    filled[f] = pRows[ row + STEP[f] ];
+                    opaque[f] = pOpaque[ row + STEP[f] ];
+                }
+                else if ( pOther[f] != NULL )
+                {
+                    filled[f] = pOther[f][ row + WRAP[f] ];
+                    opaque[f] = pOtherOpaque[f][ row + WRAP[f] ];
+                }
+                else
+                {
+                    filled[f] = opaque[f] = 0;
+                }
+            }
+
+            const uint32_t translucent = cubes & ~pOpaque[row];
+            uint32_t anyVisible = 0;
+
+            for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+            {
+                uint32_t visible = cubes & ~opaque[f];
+
+                // Translucent cubes are hidden by their own material
+                uint32_t pairs = visible & translucent & filled[f];
+
+                while ( pairs != 0 )
+                {
+                    const int x = static_cast<int>( Bits::countTrailingZeros( pairs ) );
+                    pairs &= pairs - 1;
+
+                    const int cube[3] = { x, y, z };
+                    const EMaterialType material =
+                        pCubes[ row * COLS + x ].materialType();
+
+                    if ( materialInFront( neighborhood, cube, static_cast<ECubeFace>( f ) ) ==
+                         material )
+                    {
+                        visible &= ~( 1u << x );
+                    }
+                }
+
+                mVisibleRows[f][row] = visible;
+                anyVisible   |= visible;
+                visibleFaces += Bits::popCount( visible );
+            }
 
-    for ( itr = m_cubes.begin(); itr != m_cubes.end(); ++itr )
+            mStats.cubeCount   += Bits::popCount( cubes );
+            mStats.hiddenCubes += Bits::popCount( cubes & ~anyVisible );
+        }
+    }
+
+    mStats.faceCount   = mStats.cubeCount * ECUBEFACE_COUNT;
+    mStats.hiddenFaces = mStats.faceCount - visibleFaces;
+
+    // Only the cubes being built, which may be a single section
+    const int lower[3] = { 0, 0, mZBegin };
+    const int upper[3] = { COLS, ROWS, mZEnd };
+
+    for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
     {
-        Point p = itr->position();
+        const ECubeFace face = static_cast<ECubeFace>( f );
+        const int axis  = CubeFace::axis( face );
+        const int uAxis = FACE_U_AXIS[face];
+        const int vAxis = FACE_V_AXIS[face];
+        const int uSize = upper[uAxis] - lower[uAxis];
+        const int vSize = upper[vAxis] - lower[vAxis];
+        const int dSize = upper[axis]  - lower[axis];
+
+        // Scatter the visible rows into planes, one per slice along the axis
+        mFacePlanes.assign( dSize * vSize, 0 );
+
+        for ( int z = mZBegin; z < mZEnd; ++z )
+        {
+            for ( int y = 0; y < ROWS; ++y )
+            {
+                uint32_t bits = mVisibleRows[f][z * ROWS + y];
+
+                while ( bits != 0 )
+                {
+                    const int x = static_cast<int>( Bits::countTrailingZeros( bits ) );
+                    bits &= bits - 1;
+
+                    const int p[3] = { x, y, z };
+                    mFacePlanes[ ( p[axis] - lower[axis] ) * vSize +
+                                 p[vAxis] - lower[vAxis] ] |= 1u << ( p[uAxis] - lower[uAxis] );
+                }
+            }
+        }
 
-        //
-        // Check each side of the cube to see if it has a neighbor
-        //
-        int hidden = 0;
+        mSliceMask.resize( uSize * vSize );
 
-        for ( int k = 0; k < 6; ++k )
+        for ( int d = 0; d < dSize; ++d )
         {
-            totalFaces++;
+            uint32_t * pPlane = &mFacePlanes[ d * vSize ];
 
-            Point n = Point( static_cast<int>(p[0] + axes[k][0]),
-                             static_cast<int>(p[1] + axes[k][1]),
-                             static_cast<int>(p[2] + axes[k][2]) );
-            Vec3  b = Vec3(  static_cast<float>(p[0]),
-				             static_cast<float>(p[2]),
-							 static_cast<float>(-p[1]) );
+            // Look up the material and occlusion of each visible face. The
+            // rest of the slice mask is left stale, the plane says which
+            // entries are valid
+            bool isSliceEmpty = true;
 
-            if ( isEmptyAt( n ) )
+            for ( int v = 0; v < vSize; ++v )
             {
-                // ADCB
-                builder.addFace( b + CubePos[k][0], CubeNormals[k],
-                                 b + CubePos[k][1], CubeNormals[k],
-                                 b + CubePos[k][2], CubeNormals[k],
-                                 b + CubePos[k][3], CubeNormals[k] );
+                uint32_t bits = pPlane[v];
+                isSliceEmpty = isSliceEmpty && bits == 0;
+
+                while ( bits != 0 )
+                {
+                    const int u = static_cast<int>( Bits::countTrailingZeros( bits ) );
+                    bits &= bits - 1;
+
+                    int p[3];
+                    p[axis]  = d + lower[axis];
+                    p[uAxis] = u + lower[uAxis];
+                    p[vAxis] = v + lower[vAxis];
+
+                    const int index = ( p[2] * ROWS + p[1] ) * COLS + p[0];
+                    const unsigned int occlusion = faceOcclusion( neighborhood, p, face );
+
+                    mSliceMask[ v * uSize + u ] = static_cast<uint16_t>(
+                        pCubes[index].materialType() | ( occlusion << 8 ) );
+                }
+            }
+
+            if ( isSliceEmpty )
+            {
+                continue;
+            }
+
+            // Same sweep as mergeFaces, skipping straight to the set bits
+            for ( int v = 0; v < vSize; ++v )
+            {
+                while ( pPlane[v] != 0 )
+                {
+                    const int u = static_cast<int>( Bits::countTrailingZeros( pPlane[v] ) );
+                    const uint16_t material = mSliceMask[ v * uSize + u ];
+                    const unsigned int occlusion = material >> 8;
+                    const bool canMerge = isOcclusionUniform( occlusion );
+
+                    int width = 1;
+
+                    while ( canMerge &&
+                            u + width < uSize &&
+                            ( pPlane[v] >> ( u + width ) ) & 1 &&
+                            mSliceMask[ v * uSize + u + width ] == material )
+                    {
+                        ++width;
+                    }
 
-                // Update faces optimized out
-                hidden++;
+                    const uint32_t run = static_cast<uint32_t>( Bits::rangeMask( u, width ) );
+                    int height = 1;
+
+                    for ( ; canMerge && v + height < vSize; ++height )
+                    {
+                        if ( ( pPlane[v + height] & run ) != run )
+                        {
+                            break;
+                        }
+
+                        const uint16_t * pRow = &mSliceMask[ ( v + height ) * uSize + u ];
+                        int i = 0;
+
+                        while ( i < width && pRow[i] == material )
+                        {
+                            ++i;
+                        }
+
+                        if ( i < width )
+                        {
+                            break;
+                        }
+                    }
+
+                    // Consume the merged faces so they aren't emitted twice
+                    for ( int j = 0; j < height; ++j )
+                    {
+                        pPlane[v + j] &= ~run;
+                    }
+
+                    int origin[3];
+                    origin[axis]  = d + lower[axis];
+                    origin[uAxis] = u + lower[uAxis];
+                    origin[vAxis] = v + lower[vAxis];
+
+                    addQuad( face, origin, width, height, material & 0xff, occlusion );
+                }
             }
         }
+    }
+
+    mStats.quadCount   = static_cast<unsigned int>( vertices.size() / 4 );
+    mStats.vertexCount = static_cast<unsigned int>( vertices.size() );
+    mStats.indexCount  = static_cast<unsigned int>( numIndices() );
+    mStats.translucentIndexCount = static_cast<unsigned int>( mTranslucentFaces.size() );
+}
 
-        // Was the cube fully optimized out?
-        if ( hidden == 6 ) { hiddenCubes++; }
-        
-        hiddenFaces += hidden;
+/**
+ * Expands the geometry created by the last call to build into a mesh using
+ * the full float vertex format. Texture coordinates are measured in cubes
+ * from the quad's A corner, so they repeat once per cube on merged quads.
+ */
+WorldChunkMesh WorldChunkBuilder::generateMesh() const
+{
+    WorldChunkMesh mesh;
+    generateMesh( mesh );
+
+    return mesh;
+}
+
+/**
+ * Copies the built geometry into an existing mesh, expanding the vertices
+ * unless the packed format is asked for. The mesh's vectors are cleared
+ * rather than freed, so a mesh that is used over and over stops allocating
+ * once it is big enough to hold the largest chunk it has seen.
+ */
+void WorldChunkBuilder::generateMesh( WorldChunkMesh& mesh, bool isPacked ) const
+{
+    mesh.isPacked = isPacked;
+    mesh.vertices.clear();
+    mesh.packedVertices.clear();
+
+    if ( isPacked )
+    {
+        mesh.packedVertices.assign( vertices.begin(), vertices.end() );
     }
+    else
+    {
+        mesh.vertices.reserve( vertices.size() );
 
-    std::cout << " ----- Chunk Statistics ---------------" << std::endl;
-    std::cout << "  Cubes: "   << m_cubes.size() << " ("
-              << hiddenCubes   << " hidden)"     << std::endl;
-    std::cout << "  Sides: "   << totalFaces     << " ("
-              << hiddenFaces   << " hidden, " << ( totalFaces-hiddenFaces )
-              << " total)"     << std::endl;
-    std::cout << "  Verts: "   << builder.numVerts()
-              << ", Indices: " << builder.numIndices() << std::endl;
+        for ( size_t i = 0; i < vertices.size(); ++i )
+        {
+            mesh.vertices.push_back( unpackVertex( vertices[i] ) );
+        }
+    }
 
-    return builder.createMesh();
+    mesh.indices.assign( faces.data(), faces.size(), vertices.size() );
+    mesh.translucentIndices.assign( mTranslucentFaces.data(),
+                                    mTranslucentFaces.size(),
+                                    vertices.size() );
 }
-*/
 
-void WorldChunkBuilder::addCube( const Vec3& )
+/**
+ * Expands the built geometry into an existing mesh, welding and reordering
+ * it for the GPU's post-transform vertex cache. Quads are built with four
+ * vertices of their own, so as built every triangle misses the cache at
+ * least twice no matter what order it is drawn in. Neighboring quads that
+ * share a corner with the same face direction and occlusion unpack into
+ * identical vertices though, so these are merged first. The triangles of
+ * each pass are then reordered with Forsyth's algorithm, and the vertices
+ * laid out in the order they are first used.
+ *
+ * All working memory is held by the builder, so this stops allocating once
+ * the builder and mesh have grown to fit.
+ */
+void WorldChunkBuilder::generateOptimizedMesh( WorldChunkMesh& mesh, bool isPacked )
+{
+    const size_t vertexCount = vertices.size();
+    const size_t opaqueCount = faces.size();
+
+    // Sort the vertices by what they unpack to, so equal ones are adjacent
+    mWeldKeys.resize( vertexCount );
+
+    for ( size_t i = 0; i < vertexCount; ++i )
+    {
+        mWeldKeys[i] = ( static_cast<uint64_t>( weldKey( vertices[i] ) ) << 32 ) | i;
+    }
+
+    std::sort( mWeldKeys.begin(), mWeldKeys.end() );
+
+    mWeldRemap.resize( vertexCount );
+    mWeldSource.clear();
+
+    for ( size_t i = 0; i < vertexCount; ++i )
+    {
+        const unsigned int vertex = static_cast<unsigned int>( mWeldKeys[i] );
+
+        if ( i == 0 || ( mWeldKeys[i] >> 32 ) != ( mWeldKeys[i - 1] >> 32 ) )
+        {
+            mWeldSource.push_back( vertex );
+        }
+
+        mWeldRemap[vertex] = static_cast<unsigned int>( mWeldSource.size() - 1 );
+    }
+
+    // Opaque indices followed by translucent ones, each reordered on its own
+    // since they are drawn in separate passes
+    mOptimizedFaces.resize( opaqueCount + mTranslucentFaces.size() );
+
+    for ( size_t i = 0; i < opaqueCount; ++i )
+    {
+        mOptimizedFaces[i] = mWeldRemap[ faces[i] ];
+    }
+
+    for ( size_t i = 0; i < mTranslucentFaces.size(); ++i )
+    {
+        mOptimizedFaces[opaqueCount + i] = mWeldRemap[ mTranslucentFaces[i] ];
+    }
+
+    mCacheOptimizer.optimize( mOptimizedFaces.data(),
+                              opaqueCount,
+                              mWeldSource.size() );
+    mCacheOptimizer.optimize( mOptimizedFaces.data() + opaqueCount,
+                              mTranslucentFaces.size(),
+                              mWeldSource.size() );
+
+    // Store the vertices in the order they're drawn
+    const unsigned int UNUSED = ~0u;
+    mVertexOrder.assign( mWeldSource.size(), UNUSED );
+
+    mesh.isPacked = isPacked;
+    mesh.vertices.clear();
+    mesh.packedVertices.clear();
+
+    if ( isPacked )
+    {
+        mesh.packedVertices.reserve( mWeldSource.size() );
+    }
+    else
+    {
+        mesh.vertices.reserve( mWeldSource.size() );
+    }
+
+    unsigned int usedCount = 0;
+
+    for ( size_t i = 0; i < mOptimizedFaces.size(); ++i )
+    {
+        unsigned int& order = mVertexOrder[ mOptimizedFaces[i] ];
+
+        if ( order == UNUSED )
+        {
+            order = usedCount++;
+
+            const PackedCubeVertex& v =
+                vertices[ mWeldSource[ mOptimizedFaces[i] ] ];
+
+            if ( isPacked )
+            {
+                mesh.packedVertices.push_back( v );
+            }
+            else
+            {
+                mesh.vertices.push_back( unpackVertex( v ) );
+            }
+        }
+
+        mOptimizedFaces[i] = order;
+    }
+
+    mesh.indices.assign( mOptimizedFaces.data(),
+                         opaqueCount,
+                         usedCount );
+    mesh.translucentIndices.assign( mOptimizedFaces.data() + opaqueCount,
+                                    mTranslucentFaces.size(),
+                                    usedCount );
+}
+
+/**
+ * Copies the geometry created by the last call to build into a mesh using
+ * the packed vertex format
+ */
+WorldChunkMesh WorldChunkBuilder::generatePackedMesh() const
 {
+    WorldChunkMesh mesh;
+    generateMesh( mesh, true );
+
+    return mesh;
+}
 
+const WorldChunkMeshStats& WorldChunkBuilder::stats() const
+{
+    return mStats;
 }
 
-WorldChunkMesh* WorldChunkBuilder::generateMesh() const
+void WorldChunkBuilder::reset()
 {
-    //
-    // Create a vertex and index buffer to store geometry
-    //
-//    const int vertexElementSize = 3*4 + 3*4 + 2*4; // f3f3f2 --> 32 bytes
-//    const int indexElementSize  = 3*4;             // i3     --> 12 bytes
+    faces.clear();
+    mTranslucentFaces.clear();
+    vertices.clear();
+    m_offset = 0;
+    mStats   = WorldChunkMeshStats();
+}
+
+/**
+ * Greedily merges the visible faces pointing in one direction. Each slice of
+ * the chunk along the face's axis is flattened into a 2d mask of materials,
+ * which is then swept for runs along u that are grown along v for as long as
+ * every face in the run matches.
+ *
+ * \param  face  Direction of the faces to merge
+ */
+void WorldChunkBuilder::mergeFaces( ECubeFace face )
+{
+    const int cols = static_cast<int>( WorldChunk::TOTAL_COLS );
+    const int rows = static_cast<int>( WorldChunk::TOTAL_ROWS );
+    const int strides[3] = { 1, cols, cols * rows };
+
+    // Only the cubes being built, which may be a single section
+    const int lower[3] = { 0, 0, mZBegin };
+    const int upper[3] = { cols, rows, mZEnd };
+
+    const int axis  = CubeFace::axis( face );
+    const int uAxis = FACE_U_AXIS[face];
+    const int vAxis = FACE_V_AXIS[face];
+    const int uSize = upper[uAxis] - lower[uAxis];
+    const int vSize = upper[vAxis] - lower[vAxis];
+
+    const std::vector<uint16_t>& materials = mFaceMaterials[face];
+    mSliceMask.resize( uSize * vSize );
+
+    for ( int d = lower[axis]; d < upper[axis]; ++d )
+    {
+        bool isSliceEmpty = true;
+
+        for ( int v = 0; v < vSize; ++v )
+        {
+            for ( int u = 0; u < uSize; ++u )
+            {
+                int index = d * strides[axis] +
+                            ( u + lower[uAxis] ) * strides[uAxis] +
+                            ( v + lower[vAxis] ) * strides[vAxis];
+
+                mSliceMask[ v * uSize + u ] = materials[index];
+                isSliceEmpty = isSliceEmpty && materials[index] == EMATERIAL_EMPTY;
+            }
+        }
+
+        if ( isSliceEmpty )
+        {
+            continue;
+        }
+
+        for ( int v = 0; v < vSize; ++v )
+        {
+            for ( int u = 0; u < uSize; )
+            {
+                const uint16_t material = mSliceMask[ v * uSize + u ];
+
+                if ( material == EMATERIAL_EMPTY )
+                {
+                    ++u;
+                    continue;
+                }
+
+                // Grow along u, then along v while the whole run matches.
+                // Faces with shading that varies across them stay on their own
+                const unsigned int occlusion = material >> 8;
+                const bool canMerge = isOcclusionUniform( occlusion );
+                int width = 1;
 
-//    int vbsize = vertexElementSize * vertices.size();
-//    int ibsize = indexElementSize  * faces.size();
+                while ( canMerge &&
+                        u + width < uSize &&
+                        mSliceMask[ v * uSize + u + width ] == material )
+                {
+                    ++width;
+                }
 
-//    uint32_t vbid = 0, ibid = 0;
-/*
-    // Get a buffer id
-    glGenBuffers( 1, &vbid );
-    glGenBuffers( 1, &ibid );
+                int height = 1;
 
-    assert( vbid > 0 );
-    assert( ibid > 0 );
+                for ( ; canMerge && v + height < vSize; ++height )
+                {
+                    const uint16_t * pRow = &mSliceMask[ ( v + height ) * uSize + u ];
+                    int i = 0;
 
-    // Set the buffer to be active, and copy the vertex buffer data in
-    glBindBuffer( GL_ARRAY_BUFFER, vbid );
-    glBufferData( GL_ARRAY_BUFFER, vbsize, &vertices[0], GL_STATIC_DRAW );
+                    while ( i < width && pRow[i] == material )
+                    {
+                        ++i;
+                    }
 
-    // Set the index buffer to be active
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibid );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, ibsize, &faces[0], GL_STATIC_DRAW );
-    */
+                    if ( i < width )
+                    {
+                        break;
+                    }
+                }
 
-//    return WorldChunkMesh( vbid, ibid, faces.size() );
-    return NULL;
+                // Consume the merged faces so they aren't emitted twice
+                for ( int j = 0; j < height; ++j )
+                {
+                    for ( int i = 0; i < width; ++i )
+                    {
+                        mSliceMask[ ( v + j ) * uSize + u + i ] = EMATERIAL_EMPTY;
+                    }
+                }
+
+                int origin[3];
+                origin[axis]  = d;
+                origin[uAxis] = u + lower[uAxis];
+                origin[vAxis] = v + lower[vAxis];
+
+                addQuad( face, origin, width, height, material & 0xff, occlusion );
+                u += width;
+            }
+        }
+    }
 }
 
 /**
- * A - D
- * | / |
- * B - C
+ * Adds a quad covering width by height cube faces, starting at the cube
+ * given by origin. Occlusion holds two bits per corner (see faceOcclusion),
+ * and thickness is the size of the cubes along the face's axis
+ */
+void WorldChunkBuilder::addQuad( ECubeFace face,
+                                 const int origin[3],
+                                 int width,
+                                 int height,
+                                 int material,
+                                 unsigned int occlusion,
+                                 int thickness )
+{
+    addFace( faceCorner( face, ECORNER_A, origin, 0,     height, material, occlusion, thickness ),
+             faceCorner( face, ECORNER_B, origin, 0,     0,      material, occlusion, thickness ),
+             faceCorner( face, ECORNER_C, origin, width, 0,      material, occlusion, thickness ),
+             faceCorner( face, ECORNER_D, origin, width, height, material, occlusion, thickness ) );
+}
+
+/**
+ * A - D      A - D
+ * | / |  or  | \ |
+ * B - C      B - C
+ *
+ * [BDA]      [ABC]
+ * [CDB]      [ACD]
+ *
+ * Occlusion is interpolated across each triangle, so the quad is split
+ * along the diagonal joining its two most occluded corners. That way a lone
+ * dark corner fades evenly into the face instead of along one triangle.
  *
- * [BDA]
- * [BDC]
+ * Faces of translucent materials are indexed in their own list.
  */
-void WorldChunkBuilder::addFace( const Vec3& pA, const Vec3& nA,
-                const Vec3& pB, const Vec3& nB,
-                const Vec3& pC, const Vec3& nC,
-                const Vec3& pD, const Vec3& nD )
-{
-    vertices.push_back(CubeVertex( pA, nA, Vec3( 0.0, 0.0, 0.0 ) ));
-    vertices.push_back(CubeVertex( pB, nB, Vec3( 0.0, 1.0, 0.0 ) ));
-    vertices.push_back(CubeVertex( pC, nC, Vec3( 1.0, 1.0, 0.0 ) ));
-    vertices.push_back(CubeVertex( pD, nD, Vec3( 1.0, 0.0, 0.0 ) ));
-
-    // [BDA] --> [130]
-    faces.push_back( m_offset + 1 );
-    faces.push_back( m_offset + 3 );
-    faces.push_back( m_offset + 0 );
-
-    // [CDB] --> [231]
-    faces.push_back( m_offset + 2 );
-    faces.push_back( m_offset + 3 );
-    faces.push_back( m_offset + 1 );
+void WorldChunkBuilder::addFace( const PackedCubeVertex& a,
+                                 const PackedCubeVertex& b,
+                                 const PackedCubeVertex& c,
+                                 const PackedCubeVertex& d )
+{
+    vertices.push_back( a );
+    vertices.push_back( b );
+    vertices.push_back( c );
+    vertices.push_back( d );
+
+    std::vector<int>& indices =
+        Util::IsTranslucent( static_cast<EMaterialType>( a.material ) ) ?
+            mTranslucentFaces : faces;
+
+    if ( a.ao + c.ao > b.ao + d.ao )
+    {
+        // [ABC] --> [012]
+        indices.push_back( m_offset + 0 );
+        indices.push_back( m_offset + 1 );
+        indices.push_back( m_offset + 2 );
+
+        // [ACD] --> [023]
+        indices.push_back( m_offset + 0 );
+        indices.push_back( m_offset + 2 );
+        indices.push_back( m_offset + 3 );
+    }
+    else
+    {
+        // [BDA] --> [130]
+        indices.push_back( m_offset + 1 );
+        indices.push_back( m_offset + 3 );
+        indices.push_back( m_offset + 0 );
+
+        // [CDB] --> [231]
+        indices.push_back( m_offset + 2 );
+        indices.push_back( m_offset + 3 );
+        indices.push_back( m_offset + 1 );
+    }
 
     m_offset += 4;
 }
 
-size_t WorldChunkBuilder::numIndices() const { return faces.size(); }
-size_t WorldChunkBuilder::numFaces()   const { return faces.size() / 3; }
-size_t WorldChunkBuilder::numVerts()   const { return faces.size(); }
+size_t WorldChunkBuilder::numIndices() const { return faces.size() + mTranslucentFaces.size(); }
+size_t WorldChunkBuilder::numFaces()   const { return numIndices() / 3; }
+size_t WorldChunkBuilder::numVerts()   const { return vertices.size(); }
@@ -5,32 +5,201 @@
 #include <cstddef>
 #include <vector>
 
-#include "math/vector.h"
-#include "graphics/cubevertex.h"
+#include "engine/cubeface.h"
+#include "engine/material.h"
+#include "graphics/packedcubevertex.h"
+#include "graphics/vertexcacheoptimizer.h"
+#include "graphics/worldchunkmesh.h"
 
-class WorldChunkMesh;
+class WorldChunk;
 
+/**
+ * How the builder turns visible cube faces into quads
+ */
+enum EMeshingMode
+{
+    EMESHING_CULLED,    // One quad per visible cube face
+    EMESHING_GREEDY,    // Merge touching coplanar faces of the same material
+    EMESHING_BINARY     // Same quads as greedy, found with row bit masks
+};
+
+/**
+ * A chunk that is about to be meshed, along with the six chunks that touch
+ * it. Neighbors are indexed by ECubeFace and are NULL when the neighboring
+ * chunk hasn't been created (or is outside the world), in which case it is
+ * treated as empty space.
+ */
+struct ChunkNeighborhood
+{
+    explicit ChunkNeighborhood( const WorldChunk& chunk )
+        : pChunk( &chunk )
+    {
+        for ( int i = 0; i < ECUBEFACE_COUNT; ++i )
+        {
+            pNeighbors[i] = NULL;
+        }
+    }
+
+    const WorldChunk * pChunk;
+    const WorldChunk * pNeighbors[ECUBEFACE_COUNT];
+};
+
+/**
+ * Statistics about the last mesh built by a WorldChunkBuilder
+ */
+struct WorldChunkMeshStats
+{
+    WorldChunkMeshStats()
+        : cubeCount( 0 ),
+          hiddenCubes( 0 ),
+          faceCount( 0 ),
+          hiddenFaces( 0 ),
+          quadCount( 0 ),
+          vertexCount( 0 ),
+          indexCount( 0 ),
+          translucentIndexCount( 0 )
+    {
+    }
+
+    unsigned int cubeCount;     // Non-empty cubes in the chunk
+    unsigned int hiddenCubes;   // Cubes with no visible faces
+    unsigned int faceCount;     // Cube faces considered (six per cube)
+    unsigned int hiddenFaces;   // Faces culled because they can't be seen
+    unsigned int quadCount;     // Quads emitted (visible faces after merging)
+    unsigned int vertexCount;   // Vertices emitted
+    unsigned int indexCount;    // Indices emitted, for both passes
+    unsigned int translucentIndexCount; // Indices for translucent faces
+};
+
+/**
+ * Converts a world chunk into renderable geometry. Only cube faces that
+ * border empty space or a translucent cube are emitted, including faces on
+ * the chunk's boundary which are tested against the neighboring chunks.
+ * Faces between two translucent cubes of the same material are culled.
+ * Vertex positions are relative to the chunk's origin, and translucent faces
+ * are indexed separately from opaque ones so they can be drawn afterwards.
+ *
+ * The builder's working buffers are reset rather than freed between builds,
+ * so a builder that is kept around (one per mesh worker) acts as a scratch
+ * arena that stops allocating once it has grown to fit the busiest chunk.
+ */
 class WorldChunkBuilder
 {
 public:
     WorldChunkBuilder();
 
-private:
-    void addCube( const Vec3& );
+    // Mesh the chunk, replacing any previously built geometry
+    void build( const ChunkNeighborhood& chunk,
+                EMeshingMode mode = EMESHING_CULLED );
+
+    // Mesh one section of the chunk, replacing any previously built geometry.
+    // Sections with a level of detail above zero are meshed from a grid
+    // downsampled by 2^lod along each axis
+    void buildSection( const ChunkNeighborhood& chunk,
+                       unsigned int section,
+                       EMeshingMode mode = EMESHING_CULLED,
+                       unsigned int lod = 0 );
+
+    // Material of the size^3 block of cubes starting at cell * size, picked
+    // by majority. Empty unless at least half of the block is filled
+    static EMaterialType downsample( const WorldChunk& chunk,
+                                     unsigned int size,
+                                     const int cell[3] );
+
+    // Coarsest level of detail, the chunk is meshed from 4x4x4 cells
+    const static unsigned int MAX_LOD;
+
+    // Copy the built geometry into a new mesh
+    WorldChunkMesh generateMesh() const;
+
+    // Replace the contents of mesh with the built geometry, reusing the
+    // memory the mesh already holds. Vertices are left packed if asked to
+    void generateMesh( WorldChunkMesh& mesh, bool isPacked = false ) const;
 
-    void addFace( const Vec3& pA, const Vec3& nA,
-                  const Vec3& pB, const Vec3& nB,
-                  const Vec3& pC, const Vec3& nC,
-                  const Vec3& pD, const Vec3& nD );
+    // Replace the contents of mesh with the built geometry, sharing vertices
+    // between quads where they match and ordering the triangles for the
+    // GPU's vertex cache. Draws the same triangles as generateMesh
+    void generateOptimizedMesh( WorldChunkMesh& mesh, bool isPacked = false );
+
+    // Copy the built geometry into a new mesh with packed vertices
+    WorldChunkMesh generatePackedMesh() const;
+
+    // Statistics about the last call to build
+    const WorldChunkMeshStats& stats() const;
 
     size_t numIndices() const;
     size_t numFaces()   const;
     size_t numVerts()   const;
 
+private:
+    void buildRange( const ChunkNeighborhood& chunk,
+                     EMeshingMode mode,
+                     unsigned int zBegin,
+                     unsigned int zEnd );
+
+    void buildBinary( const ChunkNeighborhood& chunk );
+
+    void buildDownsampled( const ChunkNeighborhood& chunk,
+                           unsigned int lod,
+                           unsigned int zBegin,
+                           unsigned int zEnd );
+
+    void reset();
+
+    void mergeFaces( ECubeFace face );
+
+    void addQuad( ECubeFace face,
+                  const int origin[3],
+                  int width,
+                  int height,
+                  int material,
+                  unsigned int occlusion = 0,
+                  int thickness = 1 );
+
+    void addFace( const PackedCubeVertex& a,
+                  const PackedCubeVertex& b,
+                  const PackedCubeVertex& c,
+                  const PackedCubeVertex& d );
+
 private:
     std::vector<int>        faces;
-    std::vector<CubeVertex> vertices;
+    std::vector<int>        mTranslucentFaces;
+    std::vector<PackedCubeVertex> vertices;
+
+    // Material of each visible face in the low byte and its corner
+    // occlusion in the high byte, or EMATERIAL_EMPTY when the face is
+    // hidden. Only filled in when greedy meshing
+    std::vector<uint16_t>   mFaceMaterials[ECUBEFACE_COUNT];
+    std::vector<uint16_t>   mSliceMask;
+
+    // Downsampled materials of the chunk, when building a level of detail
+    std::vector<uint8_t>    mCells;
+
+    // Visible faces of each row of cubes along x, one mask per face
+    // direction indexed by z * ROWS + y. Only filled in when binary meshing
+    std::vector<uint32_t>   mVisibleRows[ECUBEFACE_COUNT];
+
+    // Visible faces of one direction laid out by slice, then by row along v
+    // with one bit per face along u
+    std::vector<uint32_t>   mFacePlanes;
+
+    // Vertices sorted by what they look like in the final mesh (position,
+    // face and occlusion in the high word, vertex in the low word), the
+    // welded vertex each one maps to, and one source vertex per welded
+    // vertex. Only filled in when optimizing
+    std::vector<uint64_t>     mWeldKeys;
+    std::vector<unsigned int> mWeldRemap;
+    std::vector<unsigned int> mWeldSource;
+    std::vector<unsigned int> mOptimizedFaces;
+    std::vector<unsigned int> mVertexOrder;
+    VertexCacheOptimizer      mCacheOptimizer;
+
     int m_offset;
+    WorldChunkMeshStats mStats;
+
+    // Range of z being built, [mZBegin, mZEnd)
+    int mZBegin;
+    int mZEnd;
 };
 
 #endif
@@ -3,12 +3,48 @@
 
 #include <vector>
 
+#include "graphics/chunkindexbuffer.h"
 #include "graphics/cubevertex.h"
+#include "graphics/packedcubevertex.h"
 
+/**
+ * Renderable geometry for a chunk. Opaque and translucent faces share the
+ * vertex list but are split into two index lists, so the translucent faces
+ * can be drawn in a later pass. Indices are 16 bit whenever the vertex list
+ * is small enough.
+ *
+ * Vertices come in one of two formats: the full float CubeVertex, or the
+ * eight byte PackedCubeVertex at a quarter of the memory. Only the list
+ * named by isPacked is filled, the other one is left empty.
+ */
 struct WorldChunkMesh
 {
-    std::vector<CubeVertex> vertices;
-    std::vector<unsigned int> indices;
+    WorldChunkMesh()
+        : vertices(),
+          packedVertices(),
+          indices(),
+          translucentIndices(),
+          isPacked( false )
+    {
+    }
+
+    // Number of vertices in whichever list is in use
+    size_t vertexCount() const
+    {
+        return isPacked ? packedVertices.size() : vertices.size();
+    }
+
+    // Bytes taken by each vertex of the list in use
+    size_t vertexSize() const
+    {
+        return isPacked ? sizeof(PackedCubeVertex) : sizeof(CubeVertex);
+    }
+
+    std::vector<CubeVertex> vertices;               // Unless packed
+    std::vector<PackedCubeVertex> packedVertices;   // If packed
+    ChunkIndexBuffer indices;               // Opaque faces
+    ChunkIndexBuffer translucentIndices;    // Translucent faces
+    bool isPacked;
 };
 
 #endif
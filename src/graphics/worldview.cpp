@@ -1,29 +1,86 @@
 #include "graphics/worldview.h"
 #include "graphics/irenderer.h"
 #include "graphics/renderprimitives.h"
+#include "graphics/chunkconnectivity.h"
+#include "graphics/worldchunkmesh.h"
+#include "engine/world.h"
+#include "engine/cubeface.h"
+#include "engine/camera.h"
 #include "engine/point.h"
 #include "engine/worldchunk.h"
 #include <common/assert.h>
 #include <common/delete.h>
 #include <common/deref.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
 #include <vector>
 
-WorldView::WorldView( IRenderer * pRenderer )
+namespace
+{
+    // Enough for a few hundred typical section meshes
+    const size_t DEFAULT_MESH_CACHE_CAPACITY = 32 * 1024 * 1024;
+}
+
+WorldView::WorldView( IRenderer * pRenderer, unsigned int meshThreadCount )
     : mpRenderer( pRenderer ),
-      mChunks(),
-      mChunksToRebuild()
+      mpWorld( NULL ),
+      mRegistry(),
+      mChunksToRebuild(),
+      mVisibleChunks(),
+      mTranslucentOrder(),
+      mTranslucentChunks(),
+      mOcclusionCuller(),
+      mMeshCache( DEFAULT_MESH_CACHE_CAPACITY ),
+      mMeshPipeline( meshThreadCount, &mMeshCache ),
+      mMeshVersions(),
+      mConnectivityVersions(),
+      mIsTranslucent(),
+      mIsResident(),
+      mChunkLods(),
+      mMeshingMode( EMESHING_CULLED ),
+      mCamera(),
+      mFrameStats(),
+      mUpdateStats(),
+      mIsOcclusionCullingEnabled( true ),
+      mIsVertexCacheOptimizationEnabled( false ),
+      mIsUsingPackedVertices( true ),
+      mUpdateBudget( 0.0f ),
+      mUnloadDistance( 0.0f ),
+      mLodDistance( 0.0f ),
+      mLodCameraChunk(),
+      mIsLodScanNeeded( false )
+{
+}
+
+unsigned int WorldView::defaultMeshThreadCount()
 {
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
 }
 
 WorldView::~WorldView()
 {
-    // don't delete the renderer, it is owned by the game engine
+    // don't delete the renderer, it is owned by the game engine. Do give
+    // back the chunks we uploaded to it though
+    const std::vector<ChunkRenderId>& ids = mRegistry.renderIds();
+
+    for ( size_t i = 0; i < ids.size(); ++i )
+    {
+        mpRenderer->releaseChunk( ids[i] );
+    }
 }
 
 /**
  * Informs the worldview that the chunk has been updated, and that the view
- * should updated the stored mesh.
+ * should updated the stored mesh. Only the section holding the changed cube
+ * is rebuilt, along with the section next to it when the cube sits on the
+ * border between the two.
  *
  * \param  position  World view position of the cube (or one of) that was
  *                   changed in the chunk
@@ -33,48 +90,896 @@ void WorldView::chunkUpdated( const Point& position, WorldChunk *pChunk )
 {
     assert( pChunk != NULL && "Null chunks cannot exist" );
 
+    const unsigned int z       = position.z % WorldChunk::TOTAL_DEPTH;
+    const unsigned int section = WorldChunk::sectionForDepth( z );
+    const unsigned int offset  = z % WorldChunk::SECTION_DEPTH;
+
+    uint32_t sections = 1u << section;
+
+    if ( offset == 0 && section > 0 )
+    {
+        sections |= 1u << ( section - 1 );
+    }
+    else if ( offset == WorldChunk::SECTION_DEPTH - 1 &&
+              section + 1 < WorldChunk::SECTION_COUNT )
+    {
+        sections |= 1u << ( section + 1 );
+    }
+
+    queueRebuild( position, pChunk, sections );
+}
+
+/**
+ * Queues every section of a chunk to be rebuilt
+ *
+ * \param  position  Any cube position inside of the chunk
+ * \param  pChunk    The chunk that was replaced
+ */
+void WorldView::chunkReplaced( const Point& position, WorldChunk * pChunk )
+{
+    assert( pChunk != NULL && "Null chunks cannot exist" );
+    queueRebuild( position, pChunk, WorldChunk::ALL_SECTIONS );
+}
+
+/**
+ * Marks sections of a chunk as dirty and adds the chunk to the rebuild queue
+ * if it isn't already waiting in it
+ */
+void WorldView::queueRebuild( const Point& position,
+                              WorldChunk * pChunk,
+                              uint32_t sections )
+{
+    pChunk->markSectionsDirty( sections );
+
     // Has the chunk been marked dirty yet? If not, lets throw it
     // into the list of chunks that needs to be updated
     if (! pChunk->isRebuildingView() )
     {
         pChunk->setIsRebuildingView( true );
 
-        // Add to queue of chunks to rebuild
+        // Add to queue of chunks to rebuild. It gets prioritized on the
+        // next update
         ChunkBuildData build;
-        build.position = position;
-        build.pChunk   = pChunk;
+        build.position  = position;
+        build.pChunk    = pChunk;
+        build.isVisible = false;
+        build.distance  = 0.0f;
 
         mChunksToRebuild.push_back( build );
     }
 }
 
 /**
- * Called to let the world view do updating and chunk rebuilding
+ * Called once a frame to let the world view do updating. Chunks that changed
+ * since the last update are snapshotted and handed to the mesh pipeline, and
+ * any meshes that have finished building are uploaded to the renderer.
+ *
+ * Chunks that the camera can see are handled first, nearest to furthest,
+ * followed by the ones it can't. If an update budget is set, work stops once
+ * the budget is used up and the rest waits for the next frame. At least one
+ * chunk is submitted and one mesh uploaded per frame so the queue always
+ * drains eventually.
  */
 void WorldView::update()
 {
-    for ( unsigned int i = 0; i < mChunksToRebuild.size(); ++i )
+    mUpdateStats = WorldViewUpdateStats();
+
+    Clock::time_point deadline = Clock::now() +
+        std::chrono::microseconds( static_cast<long long>( mUpdateBudget * 1000.0f ) );
+    const Clock::time_point * pDeadline = ( mUpdateBudget > 0.0f ? &deadline : NULL );
+
+    streamChunks();
+    updateLods();
+    prioritizeRebuilds();
+    submitRebuilds( pDeadline );
+    uploadFinishedMeshes( pDeadline );
+
+    mUpdateStats.chunksDeferred =
+        static_cast<unsigned int>( mChunksToRebuild.size() );
+    mUpdateStats.meshesInFlight =
+        static_cast<unsigned int>( mMeshPipeline.inFlight() );
+}
+
+/**
+ * Waits for the mesh pipeline to build every queued chunk and uploads the
+ * results. Handy when loading, or when the caller needs the view to be up
+ * to date right now.
+ */
+void WorldView::finishMeshing()
+{
+    prioritizeRebuilds();
+    submitRebuilds( NULL );
+
+    while ( mMeshPipeline.inFlight() > 0 )
+    {
+        uploadFinishedMeshes( NULL );
+        std::this_thread::yield();
+    }
+
+    uploadFinishedMeshes( NULL );
+
+    mUpdateStats.chunksDeferred = 0;
+    mUpdateStats.meshesInFlight = 0;
+}
+
+unsigned int WorldView::meshThreadCount() const
+{
+    return mMeshPipeline.threadCount();
+}
+
+/**
+ * Releases chunks that have moved out of range of the camera, and queues
+ * chunks that have come back into range to be rebuilt. Does nothing unless
+ * an unload distance is set.
+ */
+void WorldView::streamChunks()
+{
+    if ( mUnloadDistance <= 0.0f || mpWorld == NULL )
+    {
+        return;
+    }
+
+    // Walk backwards, removing a chunk moves the last one into its place
+    const std::vector<Point>& coords = mRegistry.chunkCoords();
+
+    for ( size_t i = coords.size(); i > 0; --i )
+    {
+        Point chunkCoord = coords[i - 1];
+
+        if ( isInRange( chunkForSection( chunkCoord ) ) )
+        {
+            continue;
+        }
+
+        // Every section of the chunk goes at once. Bumping the versions
+        // throws away meshes of the chunk that are still being built, which
+        // would otherwise be uploaded after it was released
+        Point owner = chunkForSection( chunkCoord );
+        int index   = chunkIndex( owner );
+
+        for ( unsigned int s = 0; s < WorldChunk::SECTION_COUNT; ++s )
+        {
+            ChunkRenderId id = 0;
+
+            if ( mRegistry.remove( sectionCoord( owner, s ), &id ) )
+            {
+                mpRenderer->releaseChunk( id );
+            }
+
+            ++mMeshVersions[ index * WorldChunk::SECTION_COUNT + s ];
+        }
+
+        mIsResident[index] = false;
+        mUpdateStats.chunksUnloaded++;
+
+        // Several entries may have been swapped around
+        i = std::min( i, coords.size() + 1 );
+    }
+
+    // Only look at chunks inside of the box around the camera's range
+    const Vec3 eye  = mCamera.center();
+    const int size[3]    = { static_cast<int>( WorldChunk::TOTAL_COLS ),
+                             static_cast<int>( WorldChunk::TOTAL_ROWS ),
+                             static_cast<int>( WorldChunk::TOTAL_DEPTH ) };
+    const int extent[3]  = { static_cast<int>( mpWorld->chunkCols() ),
+                             static_cast<int>( mpWorld->chunkRows() ),
+                             static_cast<int>( mpWorld->chunkDepth() ) };
+    int first[3], last[3];
+
+    for ( int axis = 0; axis < 3; ++axis )
+    {
+        first[axis] = static_cast<int>( std::floor( ( eye[axis] - mUnloadDistance ) / size[axis] ) );
+        last[axis]  = static_cast<int>( std::floor( ( eye[axis] + mUnloadDistance ) / size[axis] ) );
+
+        first[axis] = std::max( first[axis], 0 );
+        last[axis]  = std::min( last[axis], extent[axis] - 1 );
+    }
+
+    for ( int z = first[2]; z <= last[2]; ++z )
+    {
+        for ( int y = first[1]; y <= last[1]; ++y )
+        {
+            for ( int x = first[0]; x <= last[0]; ++x )
+            {
+                Point chunkCoord( x, y, z );
+                WorldChunk * pChunk = mpWorld->chunkAt( chunkCoord );
+
+                if ( pChunk == NULL ||
+                     mIsResident[ chunkIndex( chunkCoord ) ] ||
+                     !isInRange( chunkCoord ) )
+                {
+                    continue;
+                }
+
+                Point origin( x * size[0], y * size[1], z * size[2] );
+                queueRebuild( origin, pChunk, WorldChunk::ALL_SECTIONS );
+
+                mUpdateStats.chunksLoaded++;
+            }
+        }
+    }
+}
+
+/**
+ * Checks if the center of a chunk is within the unload distance of the
+ * camera
+ */
+bool WorldView::isInRange( const Point& chunkCoord ) const
+{
+    if ( mUnloadDistance <= 0.0f )
+    {
+        return true;
+    }
+
+    Vec3 center( ( chunkCoord.x + 0.5f ) * WorldChunk::TOTAL_COLS,
+                 ( chunkCoord.y + 0.5f ) * WorldChunk::TOTAL_ROWS,
+                 ( chunkCoord.z + 0.5f ) * WorldChunk::TOTAL_DEPTH );
+    Vec3 delta = center - mCamera.center();
+
+    return dot( delta, delta ) <= mUnloadDistance * mUnloadDistance;
+}
+
+/**
+ * Picks the level of detail for a chunk. Chunks within the lod distance get
+ * every cube, and the resolution halves each time the distance doubles after
+ * that.
+ */
+unsigned int WorldView::lodForChunk( const Point& chunkCoord ) const
+{
+    if ( mLodDistance <= 0.0f )
+    {
+        return 0;
+    }
+
+    Vec3 center( ( chunkCoord.x + 0.5f ) * WorldChunk::TOTAL_COLS,
+                 ( chunkCoord.y + 0.5f ) * WorldChunk::TOTAL_ROWS,
+                 ( chunkCoord.z + 0.5f ) * WorldChunk::TOTAL_DEPTH );
+    Vec3 delta = center - mCamera.center();
+
+    const float distanceSquared = dot( delta, delta );
+    float limit = mLodDistance;
+    unsigned int lod = 0;
+
+    while ( lod < WorldChunkBuilder::MAX_LOD && distanceSquared > limit * limit )
+    {
+        lod++;
+        limit *= 2.0f;
+    }
+
+    return lod;
+}
+
+/**
+ * Moves chunks to the level of detail that suits their distance from the
+ * camera. A chunk that changes is rebuilt along with its neighbors, since
+ * the skirts between chunks depend on the detail of both sides.
+ *
+ * The whole grid is only looked at again once the camera moves into another
+ * chunk or the lod distance changes. With lod off, every chunk is already at
+ * full detail after the first scan and there is nothing to do.
+ */
+void WorldView::updateLods()
+{
+    if ( mpWorld == NULL )
+    {
+        return;
+    }
+
+    const int cols  = static_cast<int>( mpWorld->chunkCols() );
+    const int rows  = static_cast<int>( mpWorld->chunkRows() );
+    const int depth = static_cast<int>( mpWorld->chunkDepth() );
+    const int size[3] = { static_cast<int>( WorldChunk::TOTAL_COLS ),
+                          static_cast<int>( WorldChunk::TOTAL_ROWS ),
+                          static_cast<int>( WorldChunk::TOTAL_DEPTH ) };
+
+    const Vec3 eye = mCamera.center();
+    const Point cameraChunk(
+        static_cast<int>( std::floor( eye[0] / static_cast<float>( size[0] ) ) ),
+        static_cast<int>( std::floor( eye[1] / static_cast<float>( size[1] ) ) ),
+        static_cast<int>( std::floor( eye[2] / static_cast<float>( size[2] ) ) ) );
+
+    if (! mIsLodScanNeeded &&
+         ( mLodDistance <= 0.0f || cameraChunk == mLodCameraChunk ) )
+    {
+        return;
+    }
+
+    mLodCameraChunk  = cameraChunk;
+    mIsLodScanNeeded = false;
+
+    for ( int z = 0; z < depth; ++z )
+    {
+        for ( int y = 0; y < rows; ++y )
+        {
+            for ( int x = 0; x < cols; ++x )
+            {
+                const Point chunkCoord( x, y, z );
+                const int index = chunkIndex( chunkCoord );
+                const uint8_t lod = static_cast<uint8_t>( lodForChunk( chunkCoord ) );
+
+                if ( lod == mChunkLods[index] )
+                {
+                    continue;
+                }
+
+                mChunkLods[index] = lod;
+
+                // Chunks without a mesh pick up their detail when built
+                if (! mIsResident[index] )
+                {
+                    continue;
+                }
+
+                mUpdateStats.lodChanges++;
+
+                for ( int f = -1; f < ECUBEFACE_COUNT; ++f )
+                {
+                    int coord[3] = { x, y, z };
+
+                    if ( f >= 0 )
+                    {
+                        const ECubeFace face = static_cast<ECubeFace>( f );
+                        coord[ CubeFace::axis( face ) ] += CubeFace::direction( face );
+                    }
+
+                    const Point otherCoord( coord[0], coord[1], coord[2] );
+                    const int other = chunkIndex( otherCoord );
+                    WorldChunk * pChunk = ( other < 0 ? NULL : mpWorld->chunkAt( otherCoord ) );
+
+                    if ( pChunk != NULL && mIsResident[other] )
+                    {
+                        Point origin( coord[0] * size[0],
+                                      coord[1] * size[1],
+                                      coord[2] * size[2] );
+                        queueRebuild( origin, pChunk, WorldChunk::ALL_SECTIONS );
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Works out where each waiting chunk sits relative to the camera and orders
+ * the rebuild queue so the most important chunk is at the front. The camera
+ * moves between frames, so this is redone on every update.
+ *
+ * The camera doesn't have a field of view, so a chunk counts as visible if
+ * any of it is in front of the camera and the occlusion culler didn't reject
+ * it on the last draw.
+ */
+void WorldView::prioritizeRebuilds()
+{
+    const Vec3 eye       = mCamera.center();
+    const Vec3 direction = mCamera.direction();
+    const Vec3 halfSize( WorldChunk::TOTAL_COLS  * 0.5f,
+                         WorldChunk::TOTAL_ROWS  * 0.5f,
+                         WorldChunk::TOTAL_DEPTH * 0.5f );
+    const float radius   = length( halfSize );
+
+    for ( size_t i = 0; i < mChunksToRebuild.size(); ++i )
     {
         ChunkBuildData& build = mChunksToRebuild[i];
 
-        // Convert the cube position into the chunk's upper left corner
-        //  (basically, we need the chunk's origin in world space)
-        Point chunkPos = getChunkPosition( build.position );
+        Point origin = getChunkPosition( build.position );
+        Vec3 toChunk = Vec3( static_cast<float>( origin.x ),
+                             static_cast<float>( origin.y ),
+                             static_cast<float>( origin.z ) ) + halfSize - eye;
+
+        bool isInFront = dot( toChunk, direction ) >= -radius * length( direction );
+        bool isOccluded = mIsOcclusionCullingEnabled &&
+            !mOcclusionCuller.isVisible( getChunkCoord( build.position ) );
+
+        build.isVisible = isInFront && !isOccluded;
+        build.distance  = dot( toChunk, toChunk );
+    }
+
+    std::make_heap( mChunksToRebuild.begin(),
+                    mChunksToRebuild.end(),
+                    &WorldView::isLowerPriority );
+}
+
+/**
+ * Heap ordering for the rebuild queue. Visible chunks beat hidden ones, and
+ * after that the closest chunk wins.
+ */
+bool WorldView::isLowerPriority( const ChunkBuildData& a,
+                                 const ChunkBuildData& b )
+{
+    if ( a.isVisible != b.isVisible )
+    {
+        return b.isVisible;
+    }
+
+    return a.distance > b.distance;
+}
+
+/**
+ * Snapshots the chunks waiting to be rebuilt, along with their neighbors,
+ * and queues a mesh job for each in priority order. Chunks that are shared
+ * between several jobs are only copied once.
+ *
+ * \param  pDeadline  Stop once this time has passed (NULL for no limit)
+ */
+void WorldView::submitRebuilds( const Clock::time_point * pDeadline )
+{
+    typedef std::map<const WorldChunk*, std::shared_ptr<const WorldChunk> > SnapshotMap;
+    SnapshotMap snapshots;
+
+    while (! mChunksToRebuild.empty() )
+    {
+        if ( pDeadline != NULL &&
+             mUpdateStats.chunksProcessed > 0 &&
+             Clock::now() >= *pDeadline )
+        {
+            break;
+        }
+
+        std::pop_heap( mChunksToRebuild.begin(),
+                       mChunksToRebuild.end(),
+                       &WorldView::isLowerPriority );
+
+        ChunkBuildData build = mChunksToRebuild.back();
+        mChunksToRebuild.pop_back();
+
+        ChunkMeshJob job;
+        job.chunkCoord = getChunkCoord( build.position );
+        job.position   = getChunkPosition( build.position );
+        job.mode       = mMeshingMode;
+        job.isOptimizingVertexCache = mIsVertexCacheOptimizationEnabled;
+        job.isPacked = mIsUsingPackedVertices;
+
+        const uint32_t sections = build.pChunk->dirtySections();
+        build.pChunk->clearDirtySections();
+
+        // Chunks that were edited while out of range get built when the
+        // camera comes back to them
+        if (! isInRange( job.chunkCoord ) )
+        {
+            build.pChunk->setIsRebuildingView( false );
+            continue;
+        }
+
+        int index = chunkIndex( job.chunkCoord );
 
-        // Compile the world chunk into a graphics mesh and instruct the engine
-        // to upload it into the graphics card
-        ChunkRenderId obj = mpRenderer->uploadChunk( deref(build.pChunk) );
+        if ( index >= 0 )
+        {
+            mIsResident[index] = true;
+            job.lod = mChunkLods[index];
+        }
 
-        // Remove the old world chunk and replace it with the new one
-        //   TODO: actually remove it
-        ChunkViewData view { chunkPos, obj };
-        mChunks.push_back( view );
+        // Workers read from copies, the world is free to keep changing
+        for ( int f = -1; f < ECUBEFACE_COUNT; ++f )
+        {
+            const WorldChunk * pSource = build.pChunk;
 
-        // Mark as rebuilt
+            if ( f >= 0 )
+            {
+                pSource = ( mpWorld == NULL ? NULL :
+                    mpWorld->neighborOf( job.chunkCoord, static_cast<ECubeFace>( f ) ) );
+
+                // Leaving out a neighbor with a different level of detail
+                // puts a skirt along that side to cover the seam
+                if ( pSource != NULL && neighborLod( job.chunkCoord, f ) != job.lod )
+                {
+                    pSource = NULL;
+                }
+            }
+
+            if ( pSource == NULL )
+            {
+                continue;
+            }
+
+            std::shared_ptr<const WorldChunk>& pSnapshot = snapshots[pSource];
+
+            if (! pSnapshot )
+            {
+                pSnapshot.reset( new WorldChunk( *pSource ) );
+            }
+
+            if ( f < 0 )
+            {
+                job.pChunk = pSnapshot;
+            }
+            else
+            {
+                job.pNeighbors[f] = pSnapshot;
+            }
+        }
+
+        // One job per dirty section. Connectivity covers the whole chunk so
+        // only one of them needs to work it out. It gets its own version,
+        // the job carrying it may be for a different section each time
+        job.isBuildingConnectivity = true;
+
+        if ( index >= 0 )
+        {
+            job.connectivityVersion = ++mConnectivityVersions[index];
+        }
+
+        for ( unsigned int s = 0; s < WorldChunk::SECTION_COUNT; ++s )
+        {
+            if ( ( sections & ( 1u << s ) ) == 0 )
+            {
+                continue;
+            }
+
+            // Tag the job so that older meshes of the same section can be
+            // thrown away if they finish after this one
+            job.section = s;
+
+            if ( index >= 0 )
+            {
+                job.version = ++mMeshVersions[ index * WorldChunk::SECTION_COUNT + s ];
+            }
+
+            mMeshPipeline.submit( job );
+            mUpdateStats.sectionsProcessed++;
+
+            job.isBuildingConnectivity = false;
+        }
+
+        mUpdateStats.chunksProcessed++;
+
+        // The chunk can be marked dirty again now that it has been copied
         build.pChunk->setIsRebuildingView( false );
     }
+}
+
+/**
+ * Uploads the meshes that the pipeline has finished since the last call.
+ * Meshes built from a chunk that has since been resubmitted are dropped.
+ *
+ * \param  pDeadline  Stop once this time has passed (NULL for no limit)
+ */
+void WorldView::uploadFinishedMeshes( const Clock::time_point * pDeadline )
+{
+    ChunkMeshResult result;
+
+    for (;;)
+    {
+        if ( pDeadline != NULL &&
+             mUpdateStats.meshesUploaded > 0 &&
+             Clock::now() >= *pDeadline )
+        {
+            break;
+        }
+
+        if (! mMeshPipeline.popCompleted( result ) )
+        {
+            break;
+        }
+
+        int index = chunkIndex( result.chunkCoord );
+
+        if ( index >= 0 &&
+             result.version != mMeshVersions[ index * WorldChunk::SECTION_COUNT +
+                                              result.section ] )
+        {
+            mUpdateStats.meshesDiscarded++;
+            continue;
+        }
+
+        // Instruct the engine to upload the mesh into the graphics card
+        ChunkRenderId obj = mpRenderer->uploadChunkSection( result.position,
+                                                            result.section,
+                                                            *result.mesh );
+
+        // An older flood fill of the chunk that finishes late mustn't
+        // overwrite a newer one
+        if ( result.hasConnectivity &&
+             ( index < 0 ||
+               result.connectivityVersion == mConnectivityVersions[index] ) &&
+             mOcclusionCuller.contains( result.chunkCoord ) )
+        {
+            mOcclusionCuller.setConnectivity( result.chunkCoord,
+                                              result.connectivity );
+        }
+
+        // Swap the new mesh in, and free the one it replaces
+        Point section = sectionCoord( result.chunkCoord, result.section );
+
+        if ( mRegistry.isInGrid( section ) )
+        {
+            ChunkRenderId oldId = 0;
+
+            if ( mRegistry.replace( section, obj, &oldId ) )
+            {
+                mpRenderer->releaseChunk( oldId );
+            }
+        }
+
+        if ( index >= 0 )
+        {
+            mIsTranslucent[ index * WorldChunk::SECTION_COUNT + result.section ] =
+                !result.mesh->translucentIndices.empty();
+        }
+
+        mUpdateStats.meshesUploaded++;
+
+        if ( result.isFromCache )
+        {
+            mUpdateStats.meshesFromCache++;
+        }
+    }
+}
+
+/**
+ * Converts a chunk coordinate and one of its sections into the coordinate
+ * used for that section in the view registry
+ */
+Point WorldView::sectionCoord( const Point& chunkCoord, unsigned int section )
+{
+    return Point( chunkCoord.x,
+                  chunkCoord.y,
+                  chunkCoord.z * static_cast<int>( WorldChunk::SECTION_COUNT ) +
+                      static_cast<int>( section ) );
+}
+
+/**
+ * Converts a section's registry coordinate back into its chunk coordinate
+ */
+Point WorldView::chunkForSection( const Point& sectionCoord )
+{
+    return Point( sectionCoord.x,
+                  sectionCoord.y,
+                  sectionCoord.z / static_cast<int>( WorldChunk::SECTION_COUNT ) );
+}
+
+/**
+ * Returns the index of a chunk in the world's chunk grid, or -1 if the chunk
+ * is outside of the world
+ */
+int WorldView::chunkIndex( const Point& chunkCoord ) const
+{
+    if ( mpWorld == NULL || !mOcclusionCuller.contains( chunkCoord ) )
+    {
+        return -1;
+    }
+
+    return ( chunkCoord.z * static_cast<int>( mpWorld->chunkRows() ) + chunkCoord.y ) *
+             static_cast<int>( mpWorld->chunkCols() ) + chunkCoord.x;
+}
+
+/**
+ * Draws all of the chunks that are potentially visible from the camera. When
+ * occlusion culling is enabled, chunks that are sealed off from the camera's
+ * chunk by solid cubes are rejected before they reach the renderer. The
+ * translucent faces of the chunks are drawn afterwards in a second pass.
+ */
+void WorldView::draw()
+{
+    mFrameStats = WorldViewFrameStats();
+    mVisibleChunks.clear();
+
+    if ( mIsOcclusionCullingEnabled )
+    {
+        Vec3 center = mCamera.center();
+        Point cameraCube( static_cast<int>( std::floor( center.x() ) ),
+                          static_cast<int>( std::floor( center.y() ) ),
+                          static_cast<int>( std::floor( center.z() ) ) );
+
+        mOcclusionCuller.cull( getChunkCoord( cameraCube ) );
+    }
+
+    const std::vector<ChunkRenderId>& ids = mRegistry.renderIds();
+    mFrameStats.chunksConsidered = static_cast<unsigned int>( ids.size() );
+
+    // Without culling the registry's array can go straight to the renderer
+    if (! mIsOcclusionCullingEnabled )
+    {
+        mFrameStats.chunksDrawn = mFrameStats.chunksConsidered;
+        mpRenderer->renderChunks( ids );
+        drawTranslucentChunks();
+        return;
+    }
+
+    const std::vector<Point>& coords = mRegistry.chunkCoords();
+
+    for ( size_t i = 0; i < ids.size(); ++i )
+    {
+        if (! mOcclusionCuller.isVisible( chunkForSection( coords[i] ) ) )
+        {
+            mFrameStats.chunksOccluded++;
+            continue;
+        }
+
+        mVisibleChunks.push_back( ids[i] );
+    }
+
+    mFrameStats.chunksDrawn = static_cast<unsigned int>( mVisibleChunks.size() );
+    mpRenderer->renderChunks( mVisibleChunks );
+    drawTranslucentChunks();
+}
+
+/**
+ * Draws the translucent faces of the visible chunk sections that have any.
+ * Blending only looks right when the furthest faces are drawn first, so the
+ * sections are sorted back to front by the distance from the camera to their
+ * centers.
+ */
+void WorldView::drawTranslucentChunks()
+{
+    const std::vector<ChunkRenderId>& ids = mRegistry.renderIds();
+    const std::vector<Point>& coords      = mRegistry.chunkCoords();
+
+    const Vec3 eye = mCamera.center();
+    const int COLS          = static_cast<int>( WorldChunk::TOTAL_COLS );
+    const int ROWS          = static_cast<int>( WorldChunk::TOTAL_ROWS );
+    const int DEPTH         = static_cast<int>( WorldChunk::TOTAL_DEPTH );
+    const int SECTION_DEPTH = static_cast<int>( WorldChunk::SECTION_DEPTH );
+
+    mTranslucentOrder.clear();
+    mTranslucentChunks.clear();
+
+    for ( size_t i = 0; i < ids.size(); ++i )
+    {
+        const Point chunkCoord = chunkForSection( coords[i] );
+        const int section = coords[i].z - chunkCoord.z *
+                            static_cast<int>( WorldChunk::SECTION_COUNT );
+        const int index   = chunkIndex( chunkCoord );
+
+        if ( index < 0 ||
+             !mIsTranslucent[ index * WorldChunk::SECTION_COUNT + section ] )
+        {
+            continue;
+        }
+        else if ( mIsOcclusionCullingEnabled &&
+                  !mOcclusionCuller.isVisible( chunkCoord ) )
+        {
+            continue;
+        }
+
+        const Vec3 center( ( chunkCoord.x + 0.5f ) * COLS,
+                           ( chunkCoord.y + 0.5f ) * ROWS,
+                           chunkCoord.z * DEPTH + ( section + 0.5f ) * SECTION_DEPTH );
+        const Vec3 toSection = center - eye;
+
+        mTranslucentOrder.push_back( std::make_pair( dot( toSection, toSection ), ids[i] ) );
+    }
+
+    std::sort( mTranslucentOrder.begin(),
+               mTranslucentOrder.end(),
+               std::greater< std::pair<float, ChunkRenderId> >() );
+
+    for ( size_t i = 0; i < mTranslucentOrder.size(); ++i )
+    {
+        mTranslucentChunks.push_back( mTranslucentOrder[i].second );
+    }
+
+    mFrameStats.translucentChunksDrawn =
+        static_cast<unsigned int>( mTranslucentChunks.size() );
+    mpRenderer->renderTranslucentChunks( mTranslucentChunks );
+}
+
+/**
+ * Sets the world that is being viewed. This is called by the world when it
+ * is created.
+ */
+void WorldView::setWorld( World * pWorld )
+{
+    assert( pWorld != NULL );
+    mpWorld = pWorld;
+
+    mOcclusionCuller.resize( pWorld->chunkCols(),
+                             pWorld->chunkRows(),
+                             pWorld->chunkDepth() );
+
+    // Each chunk's sections are stacked along z in the registry
+    mRegistry.resize( pWorld->chunkCols(),
+                      pWorld->chunkRows(),
+                      pWorld->chunkDepth() * WorldChunk::SECTION_COUNT );
+
+    const size_t chunkCount =
+        pWorld->chunkCols() * pWorld->chunkRows() * pWorld->chunkDepth();
 
-    mChunksToRebuild.clear();
+    mMeshVersions.assign( chunkCount * WorldChunk::SECTION_COUNT, 0 );
+    mConnectivityVersions.assign( chunkCount, 0 );
+    mIsTranslucent.assign( chunkCount * WorldChunk::SECTION_COUNT, false );
+    mIsResident.assign( chunkCount, false );
+    mChunkLods.assign( chunkCount, 0 );
+    mIsLodScanNeeded = true;
+}
+
+void WorldView::setCamera( const Camera& camera )
+{
+    mCamera = camera;
+}
+
+void WorldView::setUpdateBudget( float milliseconds )
+{
+    mUpdateBudget = milliseconds;
+}
+
+void WorldView::setUnloadDistance( float distance )
+{
+    mUnloadDistance = distance;
+}
+
+void WorldView::setLodDistance( float distance )
+{
+    mLodDistance     = distance;
+    mIsLodScanNeeded = true;
+}
+
+unsigned int WorldView::chunkLod( const Point& chunkCoord ) const
+{
+    const int index = chunkIndex( chunkCoord );
+    return index < 0 ? 0 : mChunkLods[index];
+}
+
+/**
+ * Level of detail of the chunk next to the given one
+ */
+unsigned int WorldView::neighborLod( const Point& chunkCoord, int face ) const
+{
+    int coord[3] = { chunkCoord.x, chunkCoord.y, chunkCoord.z };
+    coord[ CubeFace::axis( static_cast<ECubeFace>( face ) ) ] +=
+        CubeFace::direction( static_cast<ECubeFace>( face ) );
+
+    return chunkLod( Point( coord[0], coord[1], coord[2] ) );
+}
+
+void WorldView::setMeshCacheCapacity( size_t bytes )
+{
+    mMeshCache.setCapacity( bytes );
+}
+
+ChunkMeshCacheStats WorldView::meshCacheStats() const
+{
+    return mMeshCache.stats();
+}
+
+size_t WorldView::loadedChunkCount() const
+{
+    // Registry entries are sections, count each owning chunk once
+    std::vector<bool> isCounted( mIsResident.size(), false );
+    const std::vector<Point>& coords = mRegistry.chunkCoords();
+    size_t count = 0;
+
+    for ( size_t i = 0; i < coords.size(); ++i )
+    {
+        int index = chunkIndex( chunkForSection( coords[i] ) );
+
+        if ( index >= 0 && !isCounted[index] )
+        {
+            isCounted[index] = true;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void WorldView::setMeshingMode( EMeshingMode mode )
+{
+    mMeshingMode = mode;
+}
+
+void WorldView::setOcclusionCullingEnabled( bool isEnabled )
+{
+    mIsOcclusionCullingEnabled = isEnabled;
+}
+
+void WorldView::setVertexCacheOptimizationEnabled( bool isEnabled )
+{
+    mIsVertexCacheOptimizationEnabled = isEnabled;
+}
+
+void WorldView::setPackedVerticesEnabled( bool isEnabled )
+{
+    mIsUsingPackedVertices = isEnabled;
+}
+
+const WorldViewFrameStats& WorldView::frameStats() const
+{
+    return mFrameStats;
+}
+
+const WorldViewUpdateStats& WorldView::updateStats() const
+{
+    return mUpdateStats;
 }
 
 Point WorldView::getChunkPosition( const Point& pos )
@@ -87,3 +992,16 @@ Point WorldView::getChunkPosition( const Point& pos )
                   y * WorldChunk::TOTAL_ROWS,
                   z * WorldChunk::TOTAL_DEPTH );
 }
+
+Point WorldView::getChunkCoord( const Point& pos )
+{
+    const int cols  = static_cast<int>( WorldChunk::TOTAL_COLS );
+    const int rows  = static_cast<int>( WorldChunk::TOTAL_ROWS );
+    const int depth = static_cast<int>( WorldChunk::TOTAL_DEPTH );
+
+    // Round towards negative infinity so that cubes just outside of the
+    // world don't get lumped in with chunk zero
+    return Point( ( pos.x >= 0 ? pos.x : pos.x - cols  + 1 ) / cols,
+                  ( pos.y >= 0 ? pos.y : pos.y - rows  + 1 ) / rows,
+                  ( pos.z >= 0 ? pos.z : pos.z - depth + 1 ) / depth );
+}
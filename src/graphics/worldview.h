@@ -17,13 +17,72 @@
 #define SCOTT_CUBEWORLD_WORLD_VIEW_H
 
 #include <boost/noncopyable.hpp>
+#include <chrono>
+#include <utility>
 #include <vector>
 #include "engine/point.h"
+#include "engine/camera.h"
 #include "graphics/renderprimitives.h"
+#include "graphics/occlusionculler.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/chunkmeshcache.h"
+#include "graphics/chunkmeshpipeline.h"
+#include "graphics/chunkviewregistry.h"
 
+class World;
 class WorldChunk;
 class IRenderer;
 
+/**
+ * Statistics gathered by the world view over the course of a single frame
+ */
+struct WorldViewFrameStats
+{
+    WorldViewFrameStats()
+        : chunksConsidered( 0 ),
+          chunksDrawn( 0 ),
+          chunksOccluded( 0 ),
+          translucentChunksDrawn( 0 )
+    {
+    }
+
+    unsigned int chunksConsidered;  // Chunks with a mesh to draw
+    unsigned int chunksDrawn;       // Chunks handed to the renderer
+    unsigned int chunksOccluded;    // Chunks rejected by cave culling
+    unsigned int translucentChunksDrawn;    // Drawn again for translucency
+};
+
+/**
+ * Statistics about chunk meshing gathered over a single call to update
+ */
+struct WorldViewUpdateStats
+{
+    WorldViewUpdateStats()
+        : chunksProcessed( 0 ),
+          sectionsProcessed( 0 ),
+          chunksDeferred( 0 ),
+          meshesUploaded( 0 ),
+          meshesDiscarded( 0 ),
+          meshesFromCache( 0 ),
+          meshesInFlight( 0 ),
+          chunksUnloaded( 0 ),
+          chunksLoaded( 0 ),
+          lodChanges( 0 )
+    {
+    }
+
+    unsigned int chunksProcessed;   // Chunks handed to the mesh pipeline
+    unsigned int sectionsProcessed; // Chunk sections handed to the pipeline
+    unsigned int chunksDeferred;    // Chunks left waiting for a later frame
+    unsigned int meshesUploaded;    // Finished meshes sent to the renderer
+    unsigned int meshesDiscarded;   // Finished meshes that were out of date
+    unsigned int meshesFromCache;   // Uploaded meshes that weren't rebuilt
+    unsigned int meshesInFlight;    // Meshes still being built afterwards
+    unsigned int chunksUnloaded;    // Chunks released for being too far away
+    unsigned int chunksLoaded;      // Chunks queued for coming back in range
+    unsigned int lodChanges;        // Chunks that switched level of detail
+};
+
 /**
  * Handles the platform independent drawing and event notifications for
  * the world
@@ -31,36 +90,155 @@ class IRenderer;
 class WorldView : boost::noncopyable
 {
 public:
-    WorldView( IRenderer * pRenderer );
+    // Chunks are meshed on meshThreadCount worker threads, or on the thread
+    // calling update() when it is zero
+    WorldView( IRenderer * pRenderer,
+               unsigned int meshThreadCount = defaultMeshThreadCount() );
     ~WorldView();
 
+    // One mesh worker per hardware thread other than the main one, and at
+    // least one so that meshing never stalls the frame
+    static unsigned int defaultMeshThreadCount();
+
     // Call this to inform the view that a worldchunk was been updated
     void chunkUpdated( const Point& position, WorldChunk * pChunk );
 
-    // Call once a frame to rebuild chunks
+    // Call this to inform the view that every cube in a worldchunk may have
+    // changed, such as when the chunk was generated
+    void chunkReplaced( const Point& position, WorldChunk * pChunk );
+
+    // Call once a frame to queue changed chunks for meshing and to upload
+    // the meshes that have finished, nearest and visible chunks first
     void update();
 
+    // Limit the time update spends per frame (zero means no limit)
+    void setUpdateBudget( float milliseconds );
+
+    // Block until every queued chunk has been meshed and uploaded
+    void finishMeshing();
+
+    // Number of mesh worker threads (zero if meshing on the update thread)
+    unsigned int meshThreadCount() const;
+
+    // Call once a frame to draw the visible chunks, opaque faces first and
+    // then translucent faces from back to front
+    void draw();
+
+    // Set the world that is being viewed
+    void setWorld( World * pWorld );
+
+    // Set the camera that the world is viewed from
+    void setCamera( const Camera& camera );
+
+    // Choose how chunk meshes are built (takes effect on the next rebuild)
+    void setMeshingMode( EMeshingMode mode );
+
+    // Release chunks further than this many cubes from the camera, and
+    // rebuild them when they come back (zero keeps every chunk loaded)
+    void setUnloadDistance( float distance );
+
+    // Number of chunks that currently have a mesh uploaded
+    size_t loadedChunkCount() const;
+
+    // Mesh chunks further than this many cubes from the camera with less
+    // detail, halving it again each time the distance doubles (zero meshes
+    // every chunk in full)
+    void setLodDistance( float distance );
+
+    // Level of detail a chunk is meshed at, zero being full detail
+    unsigned int chunkLod( const Point& chunkCoord ) const;
+
+    // Limit the memory used to remember built meshes (zero turns the mesh
+    // cache off)
+    void setMeshCacheCapacity( size_t bytes );
+
+    // Hit rate and memory use of the mesh cache
+    ChunkMeshCacheStats meshCacheStats() const;
+
+    // Enable or disable rejection of chunks hidden behind solid cubes
+    void setOcclusionCullingEnabled( bool isEnabled );
+
+    // Weld chunk mesh vertices and order triangles for the GPU's vertex
+    // cache, at some extra meshing cost (takes effect on the next rebuild)
+    void setVertexCacheOptimizationEnabled( bool isEnabled );
+
+    // Upload chunk meshes with eight byte packed vertices rather than full
+    // float ones, on by default (takes effect on the next rebuild)
+    void setPackedVerticesEnabled( bool isEnabled );
+
+    // Statistics from the last call to draw
+    const WorldViewFrameStats& frameStats() const;
+
+    // Statistics from the last call to update
+    const WorldViewUpdateStats& updateStats() const;
+
     // Convert a cube (in world coordinates) into a chunk's world space
     // origin
     static Point getChunkPosition( const Point& point );
 
-private:
-    struct ChunkViewData
-    {
-        Point position;
-        ChunkRenderId id;
-    };
+    // Convert a cube (in world coordinates) into a chunk grid coordinate
+    static Point getChunkCoord( const Point& point );
 
+private:
     struct ChunkBuildData
     {
         Point position;
         WorldChunk * pChunk;
+        bool isVisible;         // In front of the camera and not occluded
+        float distance;         // Squared distance from the camera
     };
 
+    static bool isLowerPriority( const ChunkBuildData& a,
+                                 const ChunkBuildData& b );
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void queueRebuild( const Point& position,
+                       WorldChunk * pChunk,
+                       uint32_t sections );
+    void streamChunks();
+    bool isInRange( const Point& chunkCoord ) const;
+    void updateLods();
+    unsigned int lodForChunk( const Point& chunkCoord ) const;
+    unsigned int neighborLod( const Point& chunkCoord, int face ) const;
+    void prioritizeRebuilds();
+    void submitRebuilds( const Clock::time_point * pDeadline );
+    void uploadFinishedMeshes( const Clock::time_point * pDeadline );
+    void drawTranslucentChunks();
+    int chunkIndex( const Point& chunkCoord ) const;
+
+    static Point sectionCoord( const Point& chunkCoord, unsigned int section );
+    static Point chunkForSection( const Point& sectionCoord );
+
 private:
     IRenderer * mpRenderer;
-    std::vector<ChunkViewData> mChunks;   // this is terrible
-    std::vector<ChunkBuildData> mChunksToRebuild;
+    World * mpWorld;
+    ChunkViewRegistry mRegistry;                // Keyed by section
+    std::vector<ChunkBuildData> mChunksToRebuild;   // Heap, see isLowerPriority
+    std::vector<ChunkRenderId> mVisibleChunks;
+    std::vector< std::pair<float, ChunkRenderId> > mTranslucentOrder;
+    std::vector<ChunkRenderId> mTranslucentChunks;
+    OcclusionCuller mOcclusionCuller;
+    ChunkMeshCache mMeshCache;          // Must be created before the pipeline
+    ChunkMeshPipeline mMeshPipeline;
+    std::vector<unsigned int> mMeshVersions;    // Latest job per section
+    std::vector<unsigned int> mConnectivityVersions;    // Latest per chunk
+    std::vector<bool> mIsTranslucent;           // Section has translucent faces
+    std::vector<bool> mIsResident;              // Uploaded or being built
+    std::vector<uint8_t> mChunkLods;            // Level of detail per chunk
+    EMeshingMode mMeshingMode;
+    Camera mCamera;
+    WorldViewFrameStats mFrameStats;
+    WorldViewUpdateStats mUpdateStats;
+    bool mIsOcclusionCullingEnabled;
+    bool mIsVertexCacheOptimizationEnabled;
+    bool mIsUsingPackedVertices;
+    float mUpdateBudget;                // Milliseconds, zero if unlimited
+    float mUnloadDistance;              // Cubes, zero if unlimited
+    float mLodDistance;                 // Cubes, zero for full detail
+    Point mLodCameraChunk;              // Chunk the camera was in at the last scan
+    bool mIsLodScanNeeded;              // Rescan even if the camera hasn't moved
 };
 
 #endif
@@ -54,7 +54,7 @@ struct TgaImage
 
     ~TgaImage()
     {
-        delete pixels;
+        delete[] pixels;
 
         // set everything to zero, sanity to ensure no double delete
         // goes undetected
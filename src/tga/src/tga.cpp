@@ -82,7 +82,7 @@ TgaImage TGA::loadTGA( const char * filename )
     //
     FILE * f = fopen( filename, "rb" );
 
-    if ( false == f )
+    if ( f == NULL )
     {
         raiseTgaError( "Failed to open TGA file for reading" );
         return TgaImage();
@@ -185,8 +185,8 @@ TgaImage TGA::loadTGA( const char * filename )
 		}
 
 		// Delete it and swap (refactor all this junk)
-		delete buffer;
-        delete colormap;
+		delete[] buffer;
+        delete[] colormap;
 	}
 
     //
@@ -255,7 +255,7 @@ bool TGA::saveTGA( const char * filename, const TgaImage& img )
     // Write the tga pixel data
     result = fwrite( (const void*) img.pixels, bytes, 1, file );
 
-    if ( result != bytes )
+    if ( result != 1 )
     {
         raiseTgaError( "Could not write TGA pixel data" );
         fclose( file );
@@ -265,6 +265,7 @@ bool TGA::saveTGA( const char * filename, const TgaImage& img )
 
     // All done
     fclose( file );
+    return true;
 }
 
 bool decompressRleStream( FILE * file, uint8_t * pixels, int length, int size )
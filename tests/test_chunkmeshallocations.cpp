@@ -0,0 +1,231 @@
+#include <googletest/googletest.h>
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubeface.h"
+#include "engine/point.h"
+#include "graphics/chunkmeshbuffer.h"
+#include "graphics/chunkmeshcache.h"
+#include "graphics/chunkmeshpipeline.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Every heap allocation made by the test program goes through here, so the
+// tests below can check that meshing doesn't allocate once it has warmed up
+namespace
+{
+    std::atomic<size_t> gAllocationCount( 0 );
+}
+
+void * operator new( std::size_t size )
+{
+    gAllocationCount++;
+    void * pMemory = std::malloc( size > 0 ? size : 1 );
+
+    if ( pMemory == NULL )
+    {
+        throw std::bad_alloc();
+    }
+
+    return pMemory;
+}
+
+void * operator new[]( std::size_t size )
+{
+    return operator new( size );
+}
+
+void operator delete( void * pMemory ) noexcept
+{
+    std::free( pMemory );
+}
+
+void operator delete[]( void * pMemory ) noexcept
+{
+    std::free( pMemory );
+}
+
+namespace
+{
+    // The noise chunk below meshes into far larger sections than terrain
+    // does, so the pools in these tests have to be allowed to keep them
+    const size_t NOISE_MESH_BYTES = 8 * 1024 * 1024;
+
+    /**
+     * Jobs covering every section of a chunk with caves, water and
+     * neighbors, in each meshing mode and at two levels of detail, with
+     * and without vertex cache optimization
+     */
+    std::vector<ChunkMeshJob> makeJobs()
+    {
+        std::shared_ptr<WorldChunk> pChunk( new WorldChunk );
+        std::shared_ptr<WorldChunk> pNeighbor( new WorldChunk );
+        unsigned int seed = 42;
+
+        for ( int i = 0; i < 20000; ++i )
+        {
+            seed = seed * 1103515245u + 12345u;
+            const unsigned int r = seed >> 8;
+            const Point p( r % 32, ( r / 32 ) % 32, ( r / 1024 ) % 32 );
+
+            pChunk->put( CubeData( r & 0x8000 ? EMATERIAL_ROCK : EMATERIAL_WATER ), p );
+            pNeighbor->put( CubeData( EMATERIAL_DIRT ), p );
+        }
+
+        const EMeshingMode modes[3] =
+        {
+            EMESHING_CULLED, EMESHING_GREEDY, EMESHING_BINARY
+        };
+
+        std::vector<ChunkMeshJob> jobs;
+
+        for ( int m = 0; m < 3; ++m )
+        {
+            for ( unsigned int lod = 0; lod < 2; ++lod )
+            {
+                for ( int optimize = 0; optimize < 2; ++optimize )
+                {
+                    for ( unsigned int s = 0; s < WorldChunk::SECTION_COUNT; ++s )
+                    {
+                        ChunkMeshJob job;
+                        job.pChunk  = pChunk;
+                        job.section = s;
+                        job.mode    = modes[m];
+                        job.lod     = lod;
+                        job.isOptimizingVertexCache = ( optimize == 1 );
+                        job.isBuildingConnectivity  = ( s == 0 );
+                        job.pNeighbors[ECUBEFACE_POS_X] = pNeighbor;
+                        job.pNeighbors[ECUBEFACE_NEG_Z] = pNeighbor;
+
+                        jobs.push_back( job );
+                    }
+                }
+            }
+        }
+
+        return jobs;
+    }
+
+    /**
+     * Builds every job once into a pooled buffer, and returns the number
+     * of heap allocations made while doing so
+     */
+    size_t buildAll( const std::vector<ChunkMeshJob>& jobs,
+                     ChunkMeshArena& arena,
+                     ChunkMeshBufferPool& pool,
+                     ChunkMeshCache * pCache )
+    {
+        const size_t before = gAllocationCount.load();
+
+        for ( size_t i = 0; i < jobs.size(); ++i )
+        {
+            ChunkMeshResult result;
+            result.mesh = pool.acquire();
+
+            ChunkMeshPipeline::build( jobs[i], arena, result, pCache );
+        }
+
+        return gAllocationCount.load() - before;
+    }
+}
+
+TEST(ChunkMeshAllocationTests,CountsAllocations)
+{
+    const size_t before = gAllocationCount.load();
+    std::unique_ptr<int> pValue( new int( 5 ) );
+
+    EXPECT_EQ( before + 1, gAllocationCount.load() );
+}
+
+TEST(ChunkMeshAllocationTests,SteadyStateMeshingDoesNotAllocate)
+{
+    const std::vector<ChunkMeshJob> jobs = makeJobs();
+    ChunkMeshArena arena;
+    ChunkMeshBufferPool pool( 1, NOISE_MESH_BYTES );
+
+    // The first pass grows the arena and the pooled mesh to fit
+    EXPECT_LT( 0u, buildAll( jobs, arena, pool, NULL ) );
+    EXPECT_EQ( 0u, buildAll( jobs, arena, pool, NULL ) );
+    EXPECT_EQ( 1u, pool.createdCount() );
+}
+
+TEST(ChunkMeshAllocationTests,CacheHitsDoNotAllocate)
+{
+    const std::vector<ChunkMeshJob> jobs = makeJobs();
+    ChunkMeshArena arena;
+    ChunkMeshBufferPool pool( 1, NOISE_MESH_BYTES );
+    ChunkMeshCache cache( 64 * 1024 * 1024 );
+
+    // Misses store a copy of the mesh, after that every job is a hit
+    buildAll( jobs, arena, pool, &cache );
+    EXPECT_EQ( 0u, buildAll( jobs, arena, pool, &cache ) );
+    EXPECT_EQ( jobs.size(), cache.stats().hits );
+}
+
+TEST(ChunkMeshAllocationTests,BuffersMoveWithoutCopying)
+{
+    ChunkMeshBufferPool pool;
+
+    ChunkMeshBuffer first = pool.acquire();
+    const std::vector<unsigned int> indices( 1000, 0 );
+    first->indices.assign( indices.data(), indices.size(), 1 );
+
+    const void * pIndices = first->indices.data();
+    const size_t before = gAllocationCount.load();
+
+    ChunkMeshResult result;
+    result.mesh = std::move( first );
+
+    ChunkMeshResult moved = std::move( result );
+
+    EXPECT_EQ( before, gAllocationCount.load() );
+    EXPECT_TRUE( first.isEmpty() );
+    EXPECT_TRUE( result.mesh.isEmpty() );
+    EXPECT_EQ( pIndices, moved.mesh->indices.data() );
+
+    // Dropping the buffer hands it back to the pool with its memory intact
+    moved.mesh.reset();
+    EXPECT_EQ( 1u, pool.freeCount() );
+    EXPECT_EQ( pIndices, pool.acquire()->indices.data() );
+}
+
+TEST(ChunkMeshAllocationTests,PoolStaysBoundedAfterLargeLoad)
+{
+    const std::vector<ChunkMeshJob> jobs = makeJobs();
+    ChunkMeshArena arena;
+    ChunkMeshBufferPool pool( 4, NOISE_MESH_BYTES );
+
+    // Every section is held at once, like a world loading faster than its
+    // meshes can be uploaded
+    {
+        std::vector<ChunkMeshResult> results( jobs.size() );
+
+        for ( size_t i = 0; i < jobs.size(); ++i )
+        {
+            results[i].mesh = pool.acquire();
+            ChunkMeshPipeline::build( jobs[i], arena, results[i] );
+        }
+
+        EXPECT_EQ( jobs.size(), pool.createdCount() );
+    }
+
+    EXPECT_EQ( 4u, pool.freeCount() );
+    EXPECT_EQ( jobs.size() - 4, pool.deletedCount() );
+
+    // Meshes that grew past the limit aren't kept either
+    ChunkMeshBufferPool smallPool( 4, 1024 );
+    ChunkMeshResult large;
+    large.mesh = smallPool.acquire();
+    ChunkMeshPipeline::build( jobs[0], arena, large );
+
+    ASSERT_LT( 1024u, large.mesh->vertexCount() * large.mesh->vertexSize() );
+    large.mesh.reset();
+
+    EXPECT_EQ( 0u, smallPool.freeCount() );
+    EXPECT_EQ( 1u, smallPool.deletedCount() );
+}
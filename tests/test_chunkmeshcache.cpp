@@ -0,0 +1,199 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubeface.h"
+#include "engine/constants.h"
+#include "graphics/chunkmeshcache.h"
+#include "graphics/chunkmeshpipeline.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <memory>
+
+namespace
+{
+    WorldChunkMesh meshWithIndices( size_t count )
+    {
+        const std::vector<unsigned int> indices( count, 0 );
+
+        WorldChunkMesh mesh;
+        mesh.indices.assign( indices.data(), count, 1 );
+        return mesh;
+    }
+}
+
+TEST(ChunkMeshCacheTests,KeyFollowsContent)
+{
+    WorldChunk a, b;
+    a.put( CubeData( EMATERIAL_ROCK ), Point( 1, 2, 3 ) );
+    b.put( CubeData( EMATERIAL_ROCK ), Point( 1, 2, 3 ) );
+
+    ChunkMeshKey key = ChunkMeshCache::makeKey( ChunkNeighborhood( a ), 0,
+                                                EMESHING_CULLED );
+
+    EXPECT_TRUE( key == ChunkMeshCache::makeKey( ChunkNeighborhood( b ), 0,
+                                                 EMESHING_CULLED ) );
+    EXPECT_FALSE( key == ChunkMeshCache::makeKey( ChunkNeighborhood( b ), 0,
+                                                  EMESHING_GREEDY ) );
+
+    // Far away sections don't matter, the slice just past the end does
+    b.put( CubeData( EMATERIAL_DIRT ), Point( 1, 2, 20 ) );
+    EXPECT_TRUE( key == ChunkMeshCache::makeKey( ChunkNeighborhood( b ), 0,
+                                                 EMESHING_CULLED ) );
+
+    b.put( CubeData( EMATERIAL_DIRT ), Point( 1, 2, 8 ) );
+    EXPECT_FALSE( key == ChunkMeshCache::makeKey( ChunkNeighborhood( b ), 0,
+                                                  EMESHING_CULLED ) );
+}
+
+TEST(ChunkMeshCacheTests,KeyFollowsNeighborBorder)
+{
+    WorldChunk chunk, neighbor;
+    ChunkNeighborhood neighborhood( chunk );
+
+    ChunkMeshKey missing = ChunkMeshCache::makeKey( neighborhood, 0,
+                                                    EMESHING_CULLED );
+
+    neighborhood.pNeighbors[ECUBEFACE_POS_X] = &neighbor;
+    ChunkMeshKey empty = ChunkMeshCache::makeKey( neighborhood, 0,
+                                                  EMESHING_CULLED );
+    EXPECT_FALSE( missing == empty );
+
+    // Only the neighbor's slice facing the chunk is hashed
+    neighbor.put( CubeData( EMATERIAL_ROCK ), Point( 5, 5, 5 ) );
+    EXPECT_TRUE( empty == ChunkMeshCache::makeKey( neighborhood, 0,
+                                                   EMESHING_CULLED ) );
+
+    neighbor.put( CubeData( EMATERIAL_ROCK ), Point( 0, 5, 5 ) );
+    EXPECT_FALSE( empty == ChunkMeshCache::makeKey( neighborhood, 0,
+                                                    EMESHING_CULLED ) );
+}
+
+TEST(ChunkMeshCacheTests,CachedMeshFollowsNeighborOcclusion)
+{
+    const unsigned int S    = WorldChunk::SECTION_DEPTH;
+    const unsigned int LAST = WorldChunk::TOTAL_COLS - 1;
+
+    std::shared_ptr<WorldChunk> pChunk( new WorldChunk );
+    std::shared_ptr<WorldChunk> pNeighbor( new WorldChunk );
+
+    // Cube on the first slice of section one, against the +x neighbor
+    pChunk->put( CubeData( EMATERIAL_ROCK ), Point( LAST, 5, S ) );
+
+    // Only packed vertices carry ambient occlusion
+    ChunkMeshJob job;
+    job.pChunk   = pChunk;
+    job.section  = 1;
+    job.isPacked = true;
+    job.pNeighbors[ECUBEFACE_POS_X] = pNeighbor;
+
+    ChunkMeshCache cache( 1 << 20 );
+    ChunkMeshArena arena;
+    ChunkMeshResult first;
+    ChunkMeshPipeline::build( job, arena, first, &cache );
+
+    // Darkens a corner of the cube's top face, from the slice just before
+    // the section
+    pNeighbor->put( CubeData( EMATERIAL_ROCK ), Point( 0, 6, S - 1 ) );
+
+    ChunkMeshResult cached, uncached;
+    ChunkMeshPipeline::build( job, arena, cached, &cache );
+    ChunkMeshPipeline::build( job, arena, uncached );
+
+    EXPECT_FALSE( cached.isFromCache );
+    ASSERT_EQ( uncached.mesh->packedVertices.size(), cached.mesh->packedVertices.size() );
+
+    bool isOccluded = false;
+
+    for ( size_t i = 0; i < uncached.mesh->packedVertices.size(); ++i )
+    {
+        EXPECT_EQ( uncached.mesh->packedVertices[i].ao,
+                   cached.mesh->packedVertices[i].ao );
+        isOccluded = isOccluded || uncached.mesh->packedVertices[i].ao > 0;
+    }
+
+    EXPECT_TRUE( isOccluded );
+}
+
+TEST(ChunkMeshCacheTests,EvictsLeastRecentlyUsed)
+{
+    const size_t entryBytes = ChunkMeshCache::meshBytes( meshWithIndices( 10 ) );
+    ChunkMeshCache cache( entryBytes * 2 );
+
+    ChunkMeshKey keys[3];
+
+    for ( int i = 0; i < 3; ++i )
+    {
+        keys[i].hash = i + 1;
+    }
+
+    cache.insert( keys[0], meshWithIndices( 10 ) );
+    cache.insert( keys[1], meshWithIndices( 10 ) );
+
+    // Touch the first mesh, so the second one is the oldest
+    EXPECT_TRUE( cache.find( keys[0] ) != NULL );
+    cache.insert( keys[2], meshWithIndices( 10 ) );
+
+    EXPECT_TRUE( cache.find( keys[0] ) != NULL );
+    EXPECT_TRUE( cache.find( keys[1] ) == NULL );
+    EXPECT_TRUE( cache.find( keys[2] ) != NULL );
+
+    ChunkMeshCacheStats stats = cache.stats();
+    EXPECT_EQ( 2u, stats.entryCount );
+    EXPECT_EQ( 2 * entryBytes, stats.byteCount );
+    EXPECT_EQ( 1u, stats.evictions );
+    EXPECT_EQ( 3u, stats.hits );
+    EXPECT_EQ( 1u, stats.misses );
+    EXPECT_FLOAT_EQ( 0.75f, stats.hitRate() );
+
+    cache.setCapacity( 0 );
+    EXPECT_EQ( 0u, cache.stats().entryCount );
+    EXPECT_EQ( 0u, cache.stats().byteCount );
+}
+
+TEST(ChunkMeshCacheTests,BothHashesMustMatch)
+{
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 1, 2, 3 ) );
+
+    ChunkMeshKey key = ChunkMeshCache::makeKey( ChunkNeighborhood( chunk ), 0,
+                                                EMESHING_CULLED );
+    EXPECT_NE( key.hash, key.check );
+
+    ChunkMeshCache cache( ChunkMeshCache::meshBytes( meshWithIndices( 10 ) ) );
+    cache.insert( key, meshWithIndices( 10 ) );
+
+    // A crc collision alone is a miss
+    ChunkMeshKey collision = key;
+    collision.check++;
+
+    EXPECT_TRUE( cache.find( key ) != NULL );
+    EXPECT_TRUE( cache.find( collision ) == NULL );
+}
+
+TEST(ChunkMeshCacheTests,UndoneEditReusesMesh)
+{
+    NullRenderer renderer;
+    WorldView * pView = new WorldView( &renderer, 0 );
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH,
+                 pView );
+
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 4, 4, 4 ) );
+    pView->update();
+    EXPECT_EQ( 0u, pView->updateStats().meshesFromCache );
+
+    // Add a cube and take it away again, the second mesh is the first one
+    world.put( CubeData( EMATERIAL_DIRT ), Point( 5, 4, 4 ) );
+    pView->update();
+    EXPECT_EQ( 0u, pView->updateStats().meshesFromCache );
+
+    world.put( CubeData(), Point( 5, 4, 4 ) );
+    pView->update();
+    EXPECT_EQ( 1u, pView->updateStats().meshesFromCache );
+    EXPECT_EQ( 1u, pView->meshCacheStats().hits );
+}
@@ -0,0 +1,216 @@
+#include <googletest/googletest.h>
+#include "engine/mpscqueue.h"
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "graphics/chunkmeshpipeline.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldview.h"
+#include "graphics/irenderer.h"
+
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    /**
+     * Renderer that remembers the size of every mesh it was asked to upload
+     */
+    class UploadCountingRenderer : public IRenderer
+    {
+    public:
+        virtual void clear() { }
+        virtual void present() { }
+        virtual void renderChunks( const std::vector<ChunkRenderId>& ) { }
+        virtual void renderTranslucentChunks( const std::vector<ChunkRenderId>& ) { }
+        virtual void releaseChunk( ChunkRenderId ) { }
+
+        virtual ChunkRenderId uploadChunkSection( const Point&,
+                                                  unsigned int,
+                                                  const WorldChunkMesh& mesh )
+        {
+            uploadedVertexCounts.push_back( mesh.vertexCount() );
+            return static_cast<ChunkRenderId>( uploadedVertexCounts.size() );
+        }
+
+        std::vector<size_t> uploadedVertexCounts;
+    };
+}
+
+TEST(MpscQueueTests,PopsInPushOrder)
+{
+    MpscQueue<int> queue;
+    int value = 0;
+
+    EXPECT_FALSE( queue.pop( value ) );
+
+    queue.push( 1 );
+    queue.push( 2 );
+    queue.push( 3 );
+
+    EXPECT_TRUE( queue.pop( value ) );
+    EXPECT_EQ( 1, value );
+    EXPECT_TRUE( queue.pop( value ) );
+    EXPECT_EQ( 2, value );
+    EXPECT_TRUE( queue.pop( value ) );
+    EXPECT_EQ( 3, value );
+    EXPECT_FALSE( queue.pop( value ) );
+}
+
+TEST(MpscQueueTests,ManyProducers)
+{
+    const int THREADS = 4, PER_THREAD = 5000;
+
+    MpscQueue<int> queue;
+    std::vector<std::thread> producers;
+
+    for ( int t = 0; t < THREADS; ++t )
+    {
+        producers.push_back( std::thread( [&queue, t]()
+        {
+            for ( int i = 0; i < PER_THREAD; ++i )
+            {
+                queue.push( t * PER_THREAD + i );
+            }
+        } ) );
+    }
+
+    // Drain while the producers are still running
+    std::set<int> seen;
+    int value = 0;
+
+    while ( seen.size() < static_cast<size_t>( THREADS * PER_THREAD ) )
+    {
+        if ( queue.pop( value ) )
+        {
+            EXPECT_TRUE( seen.insert( value ).second );
+        }
+    }
+
+    for ( size_t i = 0; i < producers.size(); ++i )
+    {
+        producers[i].join();
+    }
+
+    EXPECT_FALSE( queue.pop( value ) );
+}
+
+TEST(ChunkMeshPipelineTests,WorkersMatchInlineBuild)
+{
+    std::shared_ptr<WorldChunk> pChunk( new WorldChunk );
+
+    for ( int i = 0; i < 300; ++i )
+    {
+        pChunk->put( CubeData( EMATERIAL_DIRT ),
+                     Point( ( i * 7 ) % 32, ( i * 11 ) % 32, ( i * 13 ) % 32 ) );
+    }
+
+    ChunkMeshJob job;
+    job.pChunk  = pChunk;
+    job.version = 7;
+    job.section = 1;
+    job.isBuildingConnectivity = true;
+    job.connectivityVersion    = 3;
+
+    ChunkMeshResult expected;
+    ChunkMeshArena arena;
+    ChunkMeshPipeline::build( job, arena, expected );
+
+    ChunkMeshPipeline pipeline( 3 );
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        pipeline.submit( job );
+    }
+
+    int finished = 0;
+    ChunkMeshResult result;
+
+    while ( finished < 10 )
+    {
+        if ( pipeline.popCompleted( result ) )
+        {
+            EXPECT_EQ( 7u, result.version );
+            EXPECT_EQ( 1u, result.section );
+            EXPECT_EQ( 3u, result.connectivityVersion );
+            EXPECT_EQ( expected.mesh->indices, result.mesh->indices );
+            EXPECT_EQ( expected.connectivity, result.connectivity );
+            finished++;
+        }
+    }
+
+    EXPECT_EQ( 0u, pipeline.inFlight() );
+}
+
+TEST(ChunkMeshPipelineTests,WorldViewDiscardsStaleMeshes)
+{
+    UploadCountingRenderer renderer;
+    WorldView * pView = new WorldView( &renderer, 2 );
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH,
+                 pView );
+
+    // Queue the chunk with one cube, then again with two cubes before the
+    // first mesh has been picked up. Both cubes sit in the first section
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 4, 4, 4 ) );
+    pView->update();
+    unsigned int discarded = pView->updateStats().meshesDiscarded;
+
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 8, 8, 6 ) );
+    pView->update();
+    pView->finishMeshing();
+    discarded += pView->updateStats().meshesDiscarded;
+
+    // However the race plays out, the last upload must be the newest mesh
+    ASSERT_FALSE( renderer.uploadedVertexCounts.empty() );
+    EXPECT_EQ( 48u, renderer.uploadedVertexCounts.back() );
+    EXPECT_EQ( 2u, renderer.uploadedVertexCounts.size() + discarded );
+}
+
+TEST(ChunkMeshPipelineTests,WorldViewMeshesOnWorkersByDefault)
+{
+    UploadCountingRenderer renderer;
+    WorldView * pView = new WorldView( &renderer );
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH,
+                 pView );
+
+    EXPECT_LE( 1u, pView->meshThreadCount() );
+    EXPECT_EQ( WorldView::defaultMeshThreadCount(), pView->meshThreadCount() );
+
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 4, 4, 4 ) );
+    pView->finishMeshing();
+
+    ASSERT_EQ( 1u, renderer.uploadedVertexCounts.size() );
+    EXPECT_EQ( 24u, renderer.uploadedVertexCounts[0] );
+}
+
+TEST(ChunkMeshPipelineTests,FinishMeshingUploadsEverything)
+{
+    UploadCountingRenderer renderer;
+    WorldView * pView = new WorldView( &renderer, 4 );
+    World world( Constants::CHUNK_COLS * 4,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH * 4,
+                 pView );
+
+    for ( unsigned int z = 0; z < world.depth(); ++z )
+    {
+        for ( unsigned int x = 0; x < world.cols(); ++x )
+        {
+            world.put( CubeData( EMATERIAL_GRASS ), Point( x, 0, z ) );
+        }
+    }
+
+    pView->finishMeshing();
+
+    // Every cube column touches all sections of its chunk
+    EXPECT_EQ( 16u * WorldChunk::SECTION_COUNT,
+               renderer.uploadedVertexCounts.size() );
+    EXPECT_EQ( 0u, pView->updateStats().meshesInFlight );
+}
@@ -0,0 +1,73 @@
+#include <googletest/googletest.h>
+#include "graphics/chunkviewregistry.h"
+#include "engine/point.h"
+
+#include <algorithm>
+#include <vector>
+
+class ChunkViewRegistryTests : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        registry.resize( 4, 2, 3 );
+    }
+
+    bool hasId( ChunkRenderId id ) const
+    {
+        const std::vector<ChunkRenderId>& ids = registry.renderIds();
+        return std::find( ids.begin(), ids.end(), id ) != ids.end();
+    }
+
+    ChunkViewRegistry registry;
+};
+
+TEST_F(ChunkViewRegistryTests,StartsEmpty)
+{
+    EXPECT_EQ( 0u, registry.size() );
+    EXPECT_FALSE( registry.contains( Point( 0, 0, 0 ) ) );
+    EXPECT_TRUE( registry.isInGrid( Point( 3, 1, 2 ) ) );
+    EXPECT_FALSE( registry.isInGrid( Point( 4, 0, 0 ) ) );
+    EXPECT_FALSE( registry.isInGrid( Point( 0, -1, 0 ) ) );
+}
+
+TEST_F(ChunkViewRegistryTests,ReplaceReturnsOldId)
+{
+    ChunkRenderId oldId = 0;
+
+    EXPECT_FALSE( registry.replace( Point( 1, 1, 1 ), 10, &oldId ) );
+    EXPECT_TRUE( registry.replace( Point( 1, 1, 1 ), 11, &oldId ) );
+    EXPECT_EQ( 10u, oldId );
+
+    EXPECT_EQ( 1u, registry.size() );
+    EXPECT_TRUE( hasId( 11 ) );
+    EXPECT_FALSE( hasId( 10 ) );
+}
+
+TEST_F(ChunkViewRegistryTests,RemoveKeepsArraysPacked)
+{
+    registry.replace( Point( 0, 0, 0 ), 1, NULL );
+    registry.replace( Point( 1, 0, 0 ), 2, NULL );
+    registry.replace( Point( 2, 0, 0 ), 3, NULL );
+
+    ChunkRenderId oldId = 0;
+    EXPECT_TRUE( registry.remove( Point( 0, 0, 0 ), &oldId ) );
+    EXPECT_EQ( 1u, oldId );
+    EXPECT_FALSE( registry.remove( Point( 0, 0, 0 ), &oldId ) );
+
+    ASSERT_EQ( 2u, registry.size() );
+    EXPECT_TRUE( hasId( 2 ) );
+    EXPECT_TRUE( hasId( 3 ) );
+
+    // Coordinates still line up with their ids after the swap
+    for ( size_t i = 0; i < registry.size(); ++i )
+    {
+        EXPECT_EQ( static_cast<int>( registry.renderIds()[i] ) - 1,
+                   registry.chunkCoords()[i].x );
+    }
+
+    // The moved chunk can still be found and removed
+    EXPECT_TRUE( registry.remove( Point( 2, 0, 0 ), &oldId ) );
+    EXPECT_EQ( 3u, oldId );
+    EXPECT_TRUE( registry.contains( Point( 1, 0, 0 ) ) );
+}
@@ -0,0 +1,106 @@
+#include <googletest/googletest.h>
+#include "graphics/drawlistbuilder.h"
+
+namespace
+{
+    DrawListItem item( ChunkRenderId id,
+                       unsigned int vertexBuffer,
+                       unsigned int indexBuffer,
+                       unsigned int indexSize = 2 )
+    {
+        DrawListItem result = { id, vertexBuffer, indexBuffer, indexSize };
+        return result;
+    }
+
+    // Sections alternating between two arenas
+    void addInterleaved( DrawListBuilder& builder )
+    {
+        builder.add( item( 1, 1, 1 ) );
+        builder.add( item( 2, 2, 1 ) );
+        builder.add( item( 3, 1, 1 ) );
+        builder.add( item( 4, 2, 1 ) );
+    }
+}
+
+TEST(DrawListBuilderTests,SortsOpaqueItemsByState)
+{
+    DrawListBuilder builder;
+    builder.begin( EDRAWPASS_OPAQUE );
+    addInterleaved( builder );
+    builder.build();
+
+    // Grouped by vertex buffer, keeping the given order within a group
+    const std::vector<DrawListItem>& items = builder.items();
+    ASSERT_EQ( 4u, items.size() );
+    EXPECT_EQ( 1u, items[0].id );
+    EXPECT_EQ( 3u, items[1].id );
+    EXPECT_EQ( 2u, items[2].id );
+    EXPECT_EQ( 4u, items[3].id );
+
+    const std::vector<DrawListBatch>& batches = builder.batches();
+    ASSERT_EQ( 2u, batches.size() );
+    EXPECT_EQ( EDRAWPASS_OPAQUE, batches[0].pass );
+    EXPECT_EQ( 1u, batches[0].vertexBuffer );
+    EXPECT_EQ( 0u, batches[0].first );
+    EXPECT_EQ( 2u, batches[0].count );
+    EXPECT_EQ( 2u, batches[1].vertexBuffer );
+    EXPECT_EQ( 2u, batches[1].first );
+    EXPECT_EQ( 2u, batches[1].count );
+}
+
+TEST(DrawListBuilderTests,KeepsTranslucentOrder)
+{
+    DrawListBuilder builder;
+    builder.begin( EDRAWPASS_TRANSLUCENT );
+    addInterleaved( builder );
+    builder.add( item( 5, 2, 1 ) );
+    builder.build();
+
+    // Back to front order wins, only neighbors are merged
+    const std::vector<DrawListItem>& items = builder.items();
+    for ( size_t i = 0; i < items.size(); ++i )
+    {
+        EXPECT_EQ( i + 1, items[i].id );
+    }
+
+    const std::vector<DrawListBatch>& batches = builder.batches();
+    ASSERT_EQ( 4u, batches.size() );
+    EXPECT_EQ( EDRAWPASS_TRANSLUCENT, batches[3].pass );
+    EXPECT_EQ( 2u, batches[3].count );
+}
+
+TEST(DrawListBuilderTests,IndexFormatAndBuffersSplitBatches)
+{
+    DrawListBuilder builder;
+    builder.begin( EDRAWPASS_OPAQUE );
+    builder.add( item( 1, 1, 1, 4 ) );
+    builder.add( item( 2, 1, 1, 2 ) );
+    builder.add( item( 3, 1, 2, 2 ) );
+    builder.add( item( 4, 1, 1, 2 ) );
+    builder.build();
+
+    const std::vector<DrawListBatch>& batches = builder.batches();
+    ASSERT_EQ( 3u, batches.size() );
+    EXPECT_EQ( 1u, batches[0].indexBuffer );
+    EXPECT_EQ( 2u, batches[0].indexSize );
+    EXPECT_EQ( 2u, batches[0].count );
+    EXPECT_EQ( 4u, batches[1].indexSize );
+    EXPECT_EQ( 2u, batches[2].indexBuffer );
+}
+
+TEST(DrawListBuilderTests,SortingCanBeTurnedOff)
+{
+    DrawListBuilder builder;
+    builder.setSortingEnabled( false );
+    builder.begin( EDRAWPASS_OPAQUE );
+    addInterleaved( builder );
+    builder.build();
+
+    EXPECT_EQ( 4u, builder.batches().size() );
+
+    // Starting over forgets the last list
+    builder.begin( EDRAWPASS_OPAQUE );
+    builder.build();
+    EXPECT_TRUE( builder.items().empty() );
+    EXPECT_TRUE( builder.batches().empty() );
+}
@@ -1,13 +1,122 @@
 #include <googletest/googletest.h>
 #include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/constants.h"
 #include "graphics/null/nullrenderer.h"
 #include "graphics/worldview.h"
 #include "generation/flatworldgenerator.h"
 
+#include <algorithm>
+
+namespace
+{
+    World * generateFlat( unsigned int seed, unsigned int threadCount )
+    {
+        FlatWorldGenerator generator( seed, threadCount );
+        return generator.generate( 256, 64, 128,
+                                   new WorldView( new NullRenderer, 0 ) );
+    }
+
+    /**
+     * Checks that both worlds hold the same cubes in the same chunks
+     */
+    bool isSameWorld( const World& a, const World& b )
+    {
+        if ( a.chunkCount() != b.chunkCount() )
+        {
+            return false;
+        }
+
+        for ( unsigned int z = 0; z < a.chunkDepth(); ++z )
+        {
+            for ( unsigned int y = 0; y < a.chunkRows(); ++y )
+            {
+                for ( unsigned int x = 0; x < a.chunkCols(); ++x )
+                {
+                    const WorldChunk * pA = a.chunkAt( Point( x, y, z ) );
+                    const WorldChunk * pB = b.chunkAt( Point( x, y, z ) );
+
+                    if ( ( pA == NULL ) != ( pB == NULL ) ||
+                         ( pA != NULL &&
+                           !std::equal( pA->cubes(),
+                                        pA->cubes() + Constants::CHUNK_CUBES,
+                                        pB->cubes() ) ) )
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
 // This is a simple test case that exists simply to verify that our world
 // generator is acting correctly (not crashing, not leaking memory, etc)
 TEST(FlatWorldGeneration,Create)
 {
     FlatWorldGenerator gen;
-    gen.generate( 128, 256, 64, new NullWorldView  );
+    gen.generate( 128, 256, 64, new WorldView( new NullRenderer, 0 ));
+}
+
+TEST(FlatWorldGeneration,Layers)
+{
+    World * pWorld = generateFlat( 3, 1 );
+
+    for ( unsigned int z = 0; z < pWorld->depth(); z += 7 )
+    {
+        for ( unsigned int x = 0; x < pWorld->cols(); x += 5 )
+        {
+            EXPECT_EQ( EMATERIAL_BEDROCK,
+                       pWorld->at( Point( x, 0, z ) ).materialType() );
+            EXPECT_EQ( EMATERIAL_GRASS,
+                       pWorld->at( Point( x, 7, z ) ).materialType() );
+            EXPECT_TRUE( pWorld->isEmptyAt( Point( x, 8, z ) ) );
+        }
+    }
+
+    // Nothing above the first layer of chunks
+    EXPECT_EQ( pWorld->chunkCols() * pWorld->chunkDepth(),
+               pWorld->chunkCount() );
+
+    delete pWorld;
+}
+
+TEST(FlatWorldGeneration,ThreadCountDoesNotChangeWorld)
+{
+    World * pOneThread   = generateFlat( 42, 1 );
+    World * pFourThreads = generateFlat( 42, 4 );
+    World * pOtherSeed   = generateFlat( 43, 4 );
+
+    EXPECT_TRUE( isSameWorld( *pOneThread, *pFourThreads ) );
+    EXPECT_FALSE( isSameWorld( *pOneThread, *pOtherSeed ) );
+
+    delete pOneThread;
+    delete pFourThreads;
+    delete pOtherSeed;
+}
+
+TEST(FlatWorldGeneration,ColumnsGetDifferentSeeds)
+{
+    FlatWorldGenerator a( 1 ), b( 1 ), c( 2 );
+
+    EXPECT_EQ( a.columnSeed( 3, 4 ), b.columnSeed( 3, 4 ) );
+    EXPECT_NE( a.columnSeed( 3, 4 ), c.columnSeed( 3, 4 ) );
+    EXPECT_NE( a.columnSeed( 3, 4 ), a.columnSeed( 4, 3 ) );
+    EXPECT_NE( a.columnSeed( 0, 0 ), a.columnSeed( 0, 1 ) );
+}
+
+TEST(FlatWorldGeneration,GeneratedChunksAreMeshed)
+{
+    NullRenderer renderer;
+    WorldView * pView = new WorldView( &renderer, 0 );
+
+    FlatWorldGenerator generator( 8, 2 );
+    World * pWorld = generator.generate( 128, 64, 128, pView );
+
+    pView->finishMeshing();
+    EXPECT_EQ( pWorld->chunkCount(), pView->loadedChunkCount() );
+
+    delete pWorld;
 }
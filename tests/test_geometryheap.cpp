@@ -0,0 +1,126 @@
+#include <googletest/googletest.h>
+#include "graphics/geometryheap.h"
+
+#include <cstdlib>
+#include <vector>
+
+TEST(GeometryHeapTests,RoundsToTheGranularity)
+{
+    GeometryHeap heap( 1024, 32 );
+
+    const GeometryRange a = heap.allocate( 40 );
+    const GeometryRange b = heap.allocate( 32 );
+
+    EXPECT_EQ( 0u, a.offset );
+    EXPECT_EQ( 64u, a.size );
+    EXPECT_EQ( 64u, b.offset );
+    EXPECT_EQ( 32u, b.size );
+
+    // Nothing to allocate, nothing to free
+    const GeometryRange empty = heap.allocate( 0 );
+    EXPECT_EQ( 0u, empty.size );
+    heap.free( empty );
+
+    const GeometryHeapStats stats = heap.stats();
+    EXPECT_EQ( 1u, stats.arenas );
+    EXPECT_EQ( 2u, stats.allocations );
+    EXPECT_EQ( 1024u, stats.capacityBytes );
+    EXPECT_EQ( 96u, stats.usedBytes );
+    EXPECT_EQ( 1u, stats.freeBlocks );
+    EXPECT_DOUBLE_EQ( 0.0, stats.fragmentation() );
+}
+
+TEST(GeometryHeapTests,FreedRangesAreMergedAndReused)
+{
+    GeometryHeap heap( 2048, 16 );
+
+    const GeometryRange a = heap.allocate( 256 );
+    const GeometryRange b = heap.allocate( 256 );
+    const GeometryRange c = heap.allocate( 256 );
+
+    // A hole between a and c
+    heap.free( b );
+    EXPECT_EQ( 2u, heap.stats().freeBlocks );
+    EXPECT_EQ( 1280u, heap.stats().largestFreeBlock );
+    EXPECT_DOUBLE_EQ( 256.0 / 1536.0, heap.stats().fragmentation() );
+
+    // Best fit puts a smaller range in the hole rather than at the end
+    const GeometryRange d = heap.allocate( 128 );
+    EXPECT_EQ( b.offset, d.offset );
+
+    // Freeing everything merges back into a single block
+    heap.free( a );
+    heap.free( c );
+    heap.free( d );
+
+    const GeometryHeapStats stats = heap.stats();
+    EXPECT_EQ( 0u, stats.allocations );
+    EXPECT_EQ( 0u, stats.usedBytes );
+    EXPECT_EQ( 1u, stats.freeBlocks );
+    EXPECT_EQ( 2048u, stats.largestFreeBlock );
+}
+
+TEST(GeometryHeapTests,AddsArenasWhenFull)
+{
+    GeometryHeap heap( 1024, 16 );
+
+    const GeometryRange a = heap.allocate( 1000 );
+    const GeometryRange b = heap.allocate( 100 );
+    EXPECT_EQ( 0u, a.arena );
+    EXPECT_EQ( 1u, b.arena );
+    EXPECT_EQ( 0u, b.offset );
+
+    // Bigger than an arena gets an arena of its own, sized to fit
+    const GeometryRange c = heap.allocate( 5000 );
+    EXPECT_EQ( 2u, c.arena );
+    EXPECT_EQ( 5008u, heap.arenaSize( 2 ) );
+
+    // Small ranges still go into the space left in the first arenas
+    const GeometryRange d = heap.allocate( 16 );
+    EXPECT_EQ( 0u, d.arena );
+    EXPECT_EQ( 3u, heap.arenaCount() );
+}
+
+TEST(GeometryHeapTests,RandomChurnNeverOverlaps)
+{
+    GeometryHeap heap( 64 * 1024, 32 );
+    std::vector<GeometryRange> live;
+    std::srand( 7 );
+
+    for ( int step = 0; step < 5000; ++step )
+    {
+        if ( live.empty() || std::rand() % 3 != 0 )
+        {
+            live.push_back( heap.allocate( 32 + std::rand() % 4000 ) );
+        }
+        else
+        {
+            const size_t victim = std::rand() % live.size();
+            heap.free( live[victim] );
+            live[victim] = live.back();
+            live.pop_back();
+        }
+    }
+
+    size_t used = 0;
+
+    for ( size_t i = 0; i < live.size(); ++i )
+    {
+        used += live[i].size;
+        ASSERT_LE( live[i].offset + live[i].size, heap.arenaSize( live[i].arena ) );
+
+        for ( size_t j = i + 1; j < live.size(); ++j )
+        {
+            if ( live[i].arena == live[j].arena )
+            {
+                ASSERT_TRUE( live[i].offset + live[i].size <= live[j].offset ||
+                             live[j].offset + live[j].size <= live[i].offset );
+            }
+        }
+    }
+
+    const GeometryHeapStats stats = heap.stats();
+    EXPECT_EQ( live.size(), stats.allocations );
+    EXPECT_EQ( used, stats.usedBytes );
+    EXPECT_GT( stats.utilization(), 0.5 );
+}
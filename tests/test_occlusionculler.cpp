@@ -0,0 +1,144 @@
+#include <googletest/googletest.h>
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubeface.h"
+#include "engine/point.h"
+#include "graphics/chunkconnectivity.h"
+#include "graphics/occlusionculler.h"
+
+namespace
+{
+    // Fills every cube in the chunk with rock
+    void fillChunk( WorldChunk& chunk )
+    {
+        for ( unsigned int z = 0; z < WorldChunk::TOTAL_DEPTH; ++z )
+        {
+            for ( unsigned int y = 0; y < WorldChunk::TOTAL_ROWS; ++y )
+            {
+                for ( unsigned int x = 0; x < WorldChunk::TOTAL_COLS; ++x )
+                {
+                    chunk.put( CubeData( EMATERIAL_ROCK ), Point( x, y, z ) );
+                }
+            }
+        }
+    }
+}
+
+TEST(ChunkConnectivityTests,EmptyChunkIsFullyOpen)
+{
+    WorldChunk chunk;
+    ChunkConnectivity c = ChunkConnectivity::build( chunk );
+
+    EXPECT_TRUE( c.isFullyOpen() );
+    EXPECT_TRUE( c.isConnected( ECUBEFACE_POS_X, ECUBEFACE_NEG_Z ) );
+}
+
+TEST(ChunkConnectivityTests,SolidChunkIsFullyClosed)
+{
+    WorldChunk chunk;
+    fillChunk( chunk );
+
+    EXPECT_TRUE( ChunkConnectivity::build( chunk ).isFullyClosed() );
+}
+
+TEST(ChunkConnectivityTests,TunnelConnectsOnlyItsEnds)
+{
+    WorldChunk chunk;
+    fillChunk( chunk );
+
+    // Bore a tunnel straight along the x axis
+    for ( unsigned int x = 0; x < WorldChunk::TOTAL_COLS; ++x )
+    {
+        chunk.put( CubeData( EMATERIAL_EMPTY ), Point( x, 10, 10 ) );
+    }
+
+    ChunkConnectivity c = ChunkConnectivity::build( chunk );
+
+    EXPECT_TRUE( c.isConnected( ECUBEFACE_POS_X, ECUBEFACE_NEG_X ) );
+    EXPECT_TRUE( c.isConnected( ECUBEFACE_NEG_X, ECUBEFACE_POS_X ) );
+    EXPECT_FALSE( c.isConnected( ECUBEFACE_POS_X, ECUBEFACE_POS_Y ) );
+    EXPECT_FALSE( c.isConnected( ECUBEFACE_POS_Z, ECUBEFACE_NEG_Z ) );
+}
+
+TEST(ChunkConnectivityTests,SeparatePocketsDoNotConnect)
+{
+    WorldChunk chunk;
+    fillChunk( chunk );
+
+    // Two dead end pockets, one touching +x and one touching -y
+    chunk.put( CubeData(), Point( WorldChunk::TOTAL_COLS - 1, 5, 5 ) );
+    chunk.put( CubeData(), Point( 20, 0, 20 ) );
+
+    ChunkConnectivity c = ChunkConnectivity::build( chunk );
+    EXPECT_FALSE( c.isConnected( ECUBEFACE_POS_X, ECUBEFACE_NEG_Y ) );
+}
+
+TEST(ChunkConnectivityTests,WaterCanBeSeenThrough)
+{
+    WorldChunk chunk;
+    fillChunk( chunk );
+
+    // A flooded tunnel along the z axis
+    for ( unsigned int z = 0; z < WorldChunk::TOTAL_DEPTH; ++z )
+    {
+        chunk.put( CubeData( EMATERIAL_WATER ), Point( 10, 10, z ) );
+    }
+
+    ChunkConnectivity c = ChunkConnectivity::build( chunk );
+
+    EXPECT_TRUE( c.isConnected( ECUBEFACE_POS_Z, ECUBEFACE_NEG_Z ) );
+    EXPECT_FALSE( c.isConnected( ECUBEFACE_POS_X, ECUBEFACE_NEG_X ) );
+}
+
+TEST(OcclusionCullerTests,OpenWorldIsFullyVisible)
+{
+    OcclusionCuller culler;
+    culler.resize( 4, 3, 2 );
+
+    EXPECT_EQ( 24u, culler.cull( Point( 1, 1, 0 ) ) );
+    EXPECT_TRUE( culler.isVisible( Point( 3, 2, 1 ) ) );
+    EXPECT_TRUE( culler.isVisible( Point( 0, 0, 0 ) ) );
+}
+
+TEST(OcclusionCullerTests,SolidWallHidesChunksBehindIt)
+{
+    OcclusionCuller culler;
+    culler.resize( 5, 1, 1 );
+
+    // Chunk 2 is solid rock, nothing past it should be visible from 0
+    culler.setConnectivity( Point( 2, 0, 0 ), ChunkConnectivity::closed() );
+
+    EXPECT_EQ( 3u, culler.cull( Point( 0, 0, 0 ) ) );
+    EXPECT_TRUE( culler.isVisible( Point( 1, 0, 0 ) ) );
+    EXPECT_TRUE( culler.isVisible( Point( 2, 0, 0 ) ) );
+    EXPECT_FALSE( culler.isVisible( Point( 3, 0, 0 ) ) );
+    EXPECT_FALSE( culler.isVisible( Point( 4, 0, 0 ) ) );
+}
+
+TEST(OcclusionCullerTests,TunnelCanBeSeenThrough)
+{
+    OcclusionCuller culler;
+    culler.resize( 4, 1, 1 );
+
+    ChunkConnectivity tunnel = ChunkConnectivity::closed();
+    tunnel.connect( ECUBEFACE_POS_X, ECUBEFACE_NEG_X );
+
+    culler.setConnectivity( Point( 1, 0, 0 ), tunnel );
+    culler.setConnectivity( Point( 2, 0, 0 ), tunnel );
+
+    EXPECT_EQ( 4u, culler.cull( Point( 0, 0, 0 ) ) );
+}
+
+TEST(OcclusionCullerTests,SearchDoesNotDoubleBack)
+{
+    OcclusionCuller culler;
+    culler.resize( 3, 2, 1 );
+
+    // Block the direct route from (0,0) to (2,0). The only path left goes
+    // +y, +x, +x, -y which requires doubling back along the y axis
+    culler.setConnectivity( Point( 1, 0, 0 ), ChunkConnectivity::closed() );
+
+    culler.cull( Point( 0, 0, 0 ) );
+    EXPECT_TRUE( culler.isVisible( Point( 2, 1, 0 ) ) );
+    EXPECT_FALSE( culler.isVisible( Point( 2, 0, 0 ) ) );
+}
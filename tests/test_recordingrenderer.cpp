@@ -0,0 +1,253 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "engine/point.h"
+#include "engine/worldchunk.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/cubevertex.h"
+#include "graphics/worldchunkmesh.h"
+#include "graphics/worldview.h"
+#include "graphics/recording/recordingrenderer.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // One rock cube, and a water cube on top of it
+    WorldChunkMesh makeMesh()
+    {
+        WorldChunk chunk;
+        chunk.put( CubeData( EMATERIAL_ROCK ),  Point( 3, 4, 5 ) );
+        chunk.put( CubeData( EMATERIAL_WATER ), Point( 3, 4, 6 ) );
+
+        WorldChunkBuilder builder;
+        builder.build( ChunkNeighborhood( chunk ) );
+
+        return builder.generateMesh();
+    }
+}
+
+TEST(RecordingRendererTests,CountsDrawCallsAndTriangles)
+{
+    const WorldChunkMesh mesh = makeMesh();
+    RecordingRenderer renderer;
+
+    std::vector<ChunkRenderId> ids;
+    ids.push_back( renderer.uploadChunkSection( Point(), 0, mesh ) );
+    ids.push_back( renderer.uploadChunkSection( Point(), 1, mesh ) );
+
+    renderer.renderChunks( ids );
+    renderer.renderTranslucentChunks( ids );
+
+    const RecordingFrameStats& frame = renderer.currentFrame();
+    EXPECT_EQ( 4u, frame.drawCalls );
+    EXPECT_EQ( 2u, frame.translucentDrawCalls );
+    EXPECT_EQ( 2 * ( mesh.indices.size() + mesh.translucentIndices.size() ) / 3,
+               frame.triangles );
+    EXPECT_EQ( 0u, frame.skippedDraws );
+
+    // Counters start over each frame
+    renderer.present();
+    EXPECT_EQ( 1u, renderer.frames().size() );
+    EXPECT_EQ( 1u, renderer.currentFrame().frame );
+    EXPECT_EQ( 0u, renderer.currentFrame().drawCalls );
+}
+
+TEST(RecordingRendererTests,TracksLiveMemory)
+{
+    const WorldChunkMesh mesh = makeMesh();
+    const size_t bytes = RecordingRenderer::meshBytes( mesh );
+    RecordingRenderer renderer;
+
+    ChunkRenderId a = renderer.uploadChunkSection( Point(), 0, mesh );
+    ChunkRenderId b = renderer.uploadChunkSection( Point(), 1, mesh );
+    renderer.present();
+
+    renderer.releaseChunk( a );
+    EXPECT_EQ( 1u, renderer.currentFrame().liveBuffers );
+    EXPECT_EQ( bytes, renderer.currentFrame().liveBytes );
+    EXPECT_EQ( 0u, renderer.currentFrame().uploadedBytes );
+
+    // Released ids are handed out again
+    EXPECT_EQ( a, renderer.uploadChunkSection( Point(), 2, mesh ) );
+    EXPECT_NE( a, b );
+    EXPECT_EQ( 2 * bytes, renderer.currentFrame().liveBytes );
+    EXPECT_EQ( bytes, renderer.currentFrame().uploadedBytes );
+    EXPECT_EQ( 1u, renderer.currentFrame().releases );
+}
+
+TEST(RecordingRendererTests,BandwidthDelaysUploads)
+{
+    const WorldChunkMesh mesh = makeMesh();
+    const size_t bytes = RecordingRenderer::meshBytes( mesh );
+
+    RecordingRenderer renderer;
+    renderer.setUploadBandwidth( bytes / 2 + 1 );
+
+    std::vector<ChunkRenderId> ids( 1, renderer.uploadChunkSection( Point(), 0, mesh ) );
+    renderer.renderChunks( ids );
+
+    EXPECT_EQ( 0u, renderer.currentFrame().drawCalls );
+    EXPECT_EQ( 1u, renderer.currentFrame().skippedDraws );
+    EXPECT_EQ( bytes / 2 - 1, renderer.currentFrame().backlogBytes );
+
+    // The rest of the section arrives during the next frame
+    renderer.present();
+    renderer.renderChunks( ids );
+
+    EXPECT_EQ( 1u, renderer.currentFrame().drawCalls );
+    EXPECT_EQ( 0u, renderer.currentFrame().backlogBytes );
+    EXPECT_EQ( bytes / 2 - 1, renderer.currentFrame().transferredBytes );
+}
+
+TEST(RecordingRendererTests,WritesFramesAsJson)
+{
+    RecordingRenderer renderer;
+    renderer.uploadChunkSection( Point(), 0, makeMesh() );
+    renderer.present();
+    renderer.present();
+
+    EXPECT_EQ( 0u, renderer.frames()[0].toJson().find( "{\"frame\":0,\"drawCalls\":0," ) );
+
+    std::ostringstream ss;
+    renderer.writeJson( ss );
+    const std::string json = ss.str();
+
+    EXPECT_EQ( '[', json[0] );
+    EXPECT_NE( std::string::npos, json.find( "\"frame\":1," ) );
+    EXPECT_NE( std::string::npos, json.find( "\"uploads\":1," ) );
+    EXPECT_EQ( std::string::npos, json.find( "\"frame\":2," ) );
+    EXPECT_EQ( "]\n", json.substr( json.size() - 2 ) );
+}
+
+TEST(RecordingRendererTests,MeasuresWorldView)
+{
+    RecordingRenderer renderer;
+    WorldView * pView = new WorldView( &renderer, 0 );
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH * 2,
+                 pView );
+
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 5, 5, 5 ) );
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 5, 5, Constants::CHUNK_DEPTH + 5 ) );
+
+    pView->setOcclusionCullingEnabled( false );
+    pView->update();
+    pView->finishMeshing();
+    pView->draw();
+    renderer.present();
+
+    // Only the two sections holding a cube have anything to draw
+    const RecordingFrameStats& frame = renderer.frames().back();
+    EXPECT_EQ( pView->frameStats().chunksDrawn, frame.liveBuffers );
+    EXPECT_EQ( 2u, frame.drawCalls );
+    EXPECT_EQ( 24u, frame.triangles );
+    EXPECT_EQ( frame.uploadedBytes, frame.liveBytes );
+}
+
+TEST(RecordingRendererTests,GeometryHeapBatchesDraws)
+{
+    const WorldChunkMesh mesh = makeMesh();
+
+    RecordingRenderer separate;
+    RecordingRenderer pooled;
+    pooled.enableGeometryHeap( 64 * 1024 );
+
+    std::vector<ChunkRenderId> separateIds, pooledIds;
+
+    for ( unsigned int i = 0; i < 8; ++i )
+    {
+        separateIds.push_back( separate.uploadChunkSection( Point(), i, mesh ) );
+        pooledIds.push_back( pooled.uploadChunkSection( Point(), i, mesh ) );
+    }
+
+    separate.renderChunks( separateIds );
+    pooled.renderChunks( pooledIds );
+
+    // Every section draws the same either way, but with its own buffers
+    // each one is bound and submitted separately
+    EXPECT_EQ( 8u, separate.currentFrame().drawCalls );
+    EXPECT_EQ( 8u, separate.currentFrame().batches );
+    EXPECT_EQ( 8u, separate.currentFrame().bufferBinds );
+
+    EXPECT_EQ( 8u, pooled.currentFrame().drawCalls );
+    EXPECT_EQ( 1u, pooled.currentFrame().batches );
+    EXPECT_EQ( 1u, pooled.currentFrame().bufferBinds );
+    EXPECT_EQ( separate.currentFrame().triangles, pooled.currentFrame().triangles );
+
+    // The arenas are still bound for the translucent pass, but it is a batch
+    // of its own
+    pooled.renderTranslucentChunks( pooledIds );
+    EXPECT_EQ( 2u, pooled.currentFrame().batches );
+    EXPECT_EQ( 1u, pooled.currentFrame().bufferBinds );
+
+    EXPECT_EQ( 8u, pooled.vertexHeap().stats().allocations );
+    EXPECT_EQ( 8u, pooled.indexHeap().stats().allocations );
+    EXPECT_EQ( 8 * mesh.vertices.size() * sizeof(CubeVertex),
+               pooled.vertexHeap().stats().usedBytes );
+
+    // Releasing gives the ranges back
+    for ( size_t i = 0; i < pooledIds.size(); ++i )
+    {
+        pooled.releaseChunk( pooledIds[i] );
+    }
+
+    EXPECT_EQ( 0u, pooled.vertexHeap().stats().usedBytes );
+    EXPECT_EQ( 0u, pooled.indexHeap().stats().usedBytes );
+    EXPECT_EQ( 1u, pooled.vertexHeap().stats().freeBlocks );
+}
+
+TEST(RecordingRendererTests,SortingRemovesStateChanges)
+{
+    const WorldChunkMesh mesh = makeMesh();
+
+    // Arenas that only fit two sections each, so the sections are spread
+    // over several of them and drawn interleaved
+    RecordingRenderer sorted;
+    RecordingRenderer unsorted;
+    const size_t arenaBytes = 2 * mesh.vertices.size() * sizeof(CubeVertex);
+
+    sorted.enableGeometryHeap( arenaBytes );
+    unsorted.enableGeometryHeap( arenaBytes );
+    unsorted.setDrawSortingEnabled( false );
+
+    std::vector<ChunkRenderId> ids;
+
+    for ( unsigned int i = 0; i < 6; ++i )
+    {
+        ids.push_back( sorted.uploadChunkSection( Point(), i, mesh ) );
+        unsorted.uploadChunkSection( Point(), i, mesh );
+    }
+
+    ASSERT_EQ( 3u, sorted.vertexHeap().arenaCount() );
+
+    std::vector<ChunkRenderId> interleaved;
+    interleaved.push_back( ids[0] );
+    interleaved.push_back( ids[2] );
+    interleaved.push_back( ids[4] );
+    interleaved.push_back( ids[1] );
+    interleaved.push_back( ids[3] );
+    interleaved.push_back( ids[5] );
+
+    sorted.renderChunks( interleaved );
+    unsorted.renderChunks( interleaved );
+
+    // One batch per vertex arena, each needing its vertex buffer bound. The
+    // index arena is bound once and the pass state set once
+    EXPECT_EQ( 6u, sorted.currentFrame().drawCalls );
+    EXPECT_EQ( 3u, sorted.currentFrame().batches );
+    EXPECT_EQ( 3u, sorted.currentFrame().bufferBinds );
+    EXPECT_EQ( 1u + 3u + 1u, sorted.currentFrame().stateChanges );
+
+    EXPECT_EQ( 6u, unsorted.currentFrame().batches );
+    EXPECT_EQ( 1u + 6u + 1u, unsorted.currentFrame().stateChanges );
+
+    // Switching to the translucent pass is one more change, the buffers
+    // bound last are still bound
+    sorted.renderTranslucentChunks( std::vector<ChunkRenderId>( 1, ids[4] ) );
+    EXPECT_EQ( 1u + 3u + 1u + 1u, sorted.currentFrame().stateChanges );
+}
@@ -0,0 +1,182 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/software/softwarerasterizer.h"
+#include "graphics/software/softwarerenderer.h"
+#include "math/vector.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    ScreenVertex vertex( float x, float y, float z, float shade = 1.0f )
+    {
+        ScreenVertex v = { x, y, z, shade };
+        return v;
+    }
+
+    size_t countPixels( const SoftwareRasterizer& rasterizer, uint32_t color )
+    {
+        size_t count = 0;
+
+        for ( unsigned int y = 0; y < rasterizer.height(); ++y )
+        {
+            for ( unsigned int x = 0; x < rasterizer.width(); ++x )
+            {
+                count += ( rasterizer.pixel( x, y ) == color );
+            }
+        }
+
+        return count;
+    }
+
+    const uint32_t BLACK = 0xff000000;
+    const uint32_t RED   = 0xffff0000;
+    const uint32_t GREEN = 0xff00ff00;
+}
+
+TEST(SoftwareRendererTests,SharedEdgesAreDrawnOnce)
+{
+    SoftwareRasterizer rasterizer( 64, 64, 1 );
+    rasterizer.clear( BLACK );
+
+    // A translucent square split along its diagonal. Pixels on the diagonal
+    // would come out brighter if both halves drew them
+    rasterizer.addTriangle( vertex( 8, 8, 0.5f ), vertex( 24, 8, 0.5f ),
+                            vertex( 24, 24, 0.5f ), 0xfffefefe, true );
+    rasterizer.addTriangle( vertex( 8, 8, 0.5f ), vertex( 24, 24, 0.5f ),
+                            vertex( 8, 24, 0.5f ), 0xfffefefe, true );
+
+    // Wound the wrong way, so it's dropped
+    rasterizer.addTriangle( vertex( 30, 30, 0.5f ), vertex( 30, 60, 0.5f ),
+                            vertex( 60, 30, 0.5f ), RED, false );
+    rasterizer.draw();
+
+    EXPECT_EQ( 2u, rasterizer.stats().triangles );
+    EXPECT_EQ( 16u * 16u, countPixels( rasterizer, 0xff7f7f7f ) );
+    EXPECT_EQ( 64u * 64u - 16u * 16u, countPixels( rasterizer, BLACK ) );
+}
+
+TEST(SoftwareRendererTests,NearestTriangleWins)
+{
+    SoftwareRasterizer rasterizer( 64, 64, 1 );
+    rasterizer.clear( BLACK );
+
+    // A near green quad over the whole screen, then a far red one
+    rasterizer.addTriangle( vertex( 0, 0, 0.2f ), vertex( 64, 0, 0.2f ),
+                            vertex( 64, 64, 0.2f ), GREEN, false );
+    rasterizer.addTriangle( vertex( 0, 0, 0.2f ), vertex( 64, 64, 0.2f ),
+                            vertex( 0, 64, 0.2f ), GREEN, false );
+    rasterizer.addTriangle( vertex( 0, 0, 0.8f ), vertex( 64, 0, 0.8f ),
+                            vertex( 64, 64, 0.8f ), RED, false );
+    rasterizer.draw();
+
+    EXPECT_EQ( 64u * 64u, countPixels( rasterizer, GREEN ) );
+    EXPECT_FLOAT_EQ( 0.2f, rasterizer.depth( 40, 10 ) );
+
+    // Every block the red triangle touches was already covered by green
+    EXPECT_EQ( 0u, countPixels( rasterizer, RED ) );
+    EXPECT_LT( 0u, rasterizer.stats().blocksRejected );
+}
+
+TEST(SoftwareRendererTests,SizeNeedNotBeWholeBlocks)
+{
+    SoftwareRasterizer rasterizer( 500, 300, 2 );
+    rasterizer.clear( BLACK );
+
+    EXPECT_EQ( 504u, rasterizer.pitch() );
+
+    // Covers the whole image, so the last blocks of every edge are drawn
+    rasterizer.addTriangle( vertex( -10, -10, 0.5f ), vertex( 600, -10, 0.5f ),
+                            vertex( 600, 400, 0.5f ), RED, false );
+    rasterizer.addTriangle( vertex( -10, -10, 0.5f ), vertex( 600, 400, 0.5f ),
+                            vertex( -10, 400, 0.5f ), RED, false );
+    rasterizer.draw();
+
+    EXPECT_EQ( 500u * 300u, countPixels( rasterizer, RED ) );
+    EXPECT_FLOAT_EQ( 0.5f, rasterizer.depth( 499, 299 ) );
+}
+
+TEST(SoftwareRendererTests,ThreadsDrawTheSameImage)
+{
+    SoftwareRasterizer single( 256, 128, 1 );
+    SoftwareRasterizer threaded( 256, 128, 4 );
+    unsigned int seed = 99;
+
+    single.clear( BLACK );
+    threaded.clear( BLACK );
+
+    for ( int i = 0; i < 200; ++i )
+    {
+        ScreenVertex corners[3];
+
+        for ( int k = 0; k < 3; ++k )
+        {
+            seed = seed * 1103515245u + 12345u;
+            corners[k] = vertex( ( seed >> 8 ) % 300 - 20.0f,
+                                 ( seed >> 16 ) % 160 - 16.0f,
+                                 ( seed >> 4 ) % 1000 / 1000.0f,
+                                 ( seed >> 12 ) % 100 / 100.0f );
+        }
+
+        const uint32_t color = 0xff000000 | seed;
+        single.addTriangle( corners[0], corners[1], corners[2], color, i % 7 == 0 );
+        threaded.addTriangle( corners[0], corners[1], corners[2], color, i % 7 == 0 );
+    }
+
+    single.draw();
+    threaded.draw();
+
+    EXPECT_EQ( single.stats().blocksDrawn, threaded.stats().blocksDrawn );
+    EXPECT_TRUE( std::equal( single.pixels(),
+                             single.pixels() + 256 * 128,
+                             threaded.pixels() ) );
+}
+
+TEST(SoftwareRendererTests,DrawsWorldView)
+{
+    SoftwareRenderer renderer( 64, 64, 2 );
+    WorldView * pView = new WorldView( &renderer, 0 );
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH,
+                 pView );
+
+    // A cube below the camera, which looks straight down at its top
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 10, 10, 5 ) );
+
+    Camera camera( Vec3( 10.5f, 10.5f, 12.0f ) );
+    renderer.setCamera( camera );
+
+    pView->setOcclusionCullingEnabled( false );
+    pView->update();
+    pView->finishMeshing();
+
+    renderer.clear();
+    pView->draw();
+    renderer.present();
+
+    const SoftwareRasterizer& frame = renderer.rasterizer();
+    EXPECT_EQ( SoftwareRenderer::SKY_COLOR, frame.pixel( 0, 0 ) );
+    EXPECT_NE( SoftwareRenderer::SKY_COLOR, frame.pixel( 32, 32 ) );
+
+    // Only the top face can be seen, and it is lit the same everywhere
+    EXPECT_EQ( frame.pixel( 32, 32 ), frame.pixel( 30, 34 ) );
+    EXPECT_EQ( 2u, frame.stats().triangles );
+
+    // 18 byte header, then four bytes per pixel
+    const char * pFilename = "test_softwarerenderer.tga";
+    ASSERT_TRUE( renderer.saveFrame( pFilename ) );
+
+    FILE * pFile = std::fopen( pFilename, "rb" );
+    ASSERT_TRUE( pFile != NULL );
+    std::fseek( pFile, 0, SEEK_END );
+    EXPECT_EQ( 18 + 64 * 64 * 4, std::ftell( pFile ) );
+    std::fclose( pFile );
+    std::remove( pFilename );
+}
@@ -0,0 +1,181 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "engine/point.h"
+#include "graphics/null/nullrenderer.h"
+#include "graphics/worldview.h"
+#include "generation/terrainworldgenerator.h"
+
+namespace
+{
+    const unsigned int COLS  = 32 * 4;
+    const unsigned int ROWS  = 32 * 2;
+    const unsigned int DEPTH = 32 * 4;
+
+    World * generateTerrain( unsigned int seed,
+                             bool isUsingBulkWrites = true,
+                             unsigned int threadCount = 1 )
+    {
+        TerrainWorldGenerator generator( seed, threadCount );
+        generator.setBulkWritesEnabled( isUsingBulkWrites );
+
+        return generator.generate( COLS, ROWS, DEPTH,
+                                   new WorldView( new NullRenderer, 0 ) );
+    }
+
+    /**
+     * Checks that both worlds have created the same chunks, and that the
+     * chunks hold the same cubes
+     */
+    ::testing::AssertionResult AreSameWorld( const World& a, const World& b )
+    {
+        for ( unsigned int z = 0; z < a.chunkDepth(); ++z )
+        {
+            for ( unsigned int y = 0; y < a.chunkRows(); ++y )
+            {
+                for ( unsigned int x = 0; x < a.chunkCols(); ++x )
+                {
+                    const WorldChunk * pA = a.chunkAt( Point( x, y, z ) );
+                    const WorldChunk * pB = b.chunkAt( Point( x, y, z ) );
+
+                    if ( ( pA == NULL ) != ( pB == NULL ) )
+                    {
+                        return ::testing::AssertionFailure()
+                            << "Only one world created chunk "
+                            << Point( x, y, z );
+                    }
+
+                    if ( pA == NULL )
+                    {
+                        continue;
+                    }
+
+                    for ( unsigned int i = 0; i < Constants::CHUNK_CUBES; ++i )
+                    {
+                        if ( pA->cubes()[i] != pB->cubes()[i] )
+                        {
+                            return ::testing::AssertionFailure()
+                                << "Chunk " << Point( x, y, z )
+                                << " differs at cube " << i;
+                        }
+                    }
+                }
+            }
+        }
+
+        return ::testing::AssertionSuccess();
+    }
+}
+
+TEST(TerrainWorldGeneration,ColumnsAreLayered)
+{
+    TerrainWorldGenerator generator( 1234 );
+    World * pWorld = generator.generate( COLS, ROWS, DEPTH,
+                                         new WorldView( new NullRenderer, 0 ) );
+
+    const unsigned int seaLevel = generator.seaLevel();
+    unsigned int grassColumns = 0, waterColumns = 0;
+
+    for ( unsigned int z = 0; z < DEPTH; ++z )
+    {
+        for ( unsigned int x = 0; x < COLS; ++x )
+        {
+            ASSERT_EQ( EMATERIAL_BEDROCK,
+                       pWorld->at( Point( x, 0, z ) ).materialType() );
+
+            // Find the ground's surface, skipping air and water
+            unsigned int surface = ROWS - 1;
+
+            while ( pWorld->isEmptyAt( Point( x, surface, z ) ) ||
+                    pWorld->at( Point( x, surface, z ) ).materialType() ==
+                        EMATERIAL_WATER )
+            {
+                EMaterialType above =
+                    pWorld->isEmptyAt( Point( x, surface, z ) ) ?
+                    EMATERIAL_EMPTY :
+                    pWorld->at( Point( x, surface, z ) ).materialType();
+
+                ASSERT_EQ( surface <= seaLevel ? EMATERIAL_WATER :
+                                                 EMATERIAL_EMPTY,
+                           above );
+                --surface;
+            }
+
+            EMaterialType top =
+                pWorld->at( Point( x, surface, z ) ).materialType();
+
+            if ( top == EMATERIAL_GRASS )
+            {
+                EXPECT_GT( surface, seaLevel + 1 );
+                grassColumns++;
+            }
+            else if ( surface > 0 )
+            {
+                EXPECT_EQ( EMATERIAL_SAND, top );
+                EXPECT_LE( surface, seaLevel + 1 );
+            }
+
+            waterColumns += ( surface < seaLevel ? 1 : 0 );
+
+            // Dirt or sand just under the surface, then rock down to bedrock
+            for ( unsigned int y = 1; y < surface; ++y )
+            {
+                EMaterialType m = pWorld->at( Point( x, y, z ) ).materialType();
+
+                if ( y + 3 >= surface )
+                {
+                    EXPECT_TRUE( m == EMATERIAL_DIRT || m == EMATERIAL_SAND );
+                }
+                else
+                {
+                    EXPECT_EQ( EMATERIAL_ROCK, m );
+                }
+            }
+        }
+    }
+
+    // Hills and lakes, not a flat plain
+    EXPECT_GT( grassColumns, 0u );
+    EXPECT_GT( waterColumns, 0u );
+
+    delete pWorld;
+}
+
+TEST(TerrainWorldGeneration,SameSeedGeneratesSameWorld)
+{
+    World * pA = generateTerrain( 99 );
+    World * pB = generateTerrain( 99 );
+    World * pC = generateTerrain( 100 );
+
+    EXPECT_TRUE( AreSameWorld( *pA, *pB ) );
+    EXPECT_FALSE( AreSameWorld( *pA, *pC ) );
+
+    delete pA;
+    delete pB;
+    delete pC;
+}
+
+TEST(TerrainWorldGeneration,BulkWritesMatchPerCubeWrites)
+{
+    World * pBulk    = generateTerrain( 5, true );
+    World * pPerCube = generateTerrain( 5, false );
+
+    EXPECT_TRUE( AreSameWorld( *pBulk, *pPerCube ) );
+    EXPECT_EQ( pPerCube->cubeCount(), pBulk->cubeCount() );
+
+    delete pBulk;
+    delete pPerCube;
+}
+
+TEST(TerrainWorldGeneration,ThreadCountDoesNotChangeWorld)
+{
+    World * pOneThread    = generateTerrain( 17, true, 1 );
+    World * pThreeThreads = generateTerrain( 17, true, 3 );
+
+    EXPECT_TRUE( AreSameWorld( *pOneThread, *pThreeThreads ) );
+
+    delete pOneThread;
+    delete pThreeThreads;
+}
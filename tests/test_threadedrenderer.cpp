@@ -0,0 +1,268 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "engine/point.h"
+#include "engine/worldchunk.h"
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+#include "graphics/recording/recordingrenderer.h"
+#include "graphics/rendercommandbuffer.h"
+#include "graphics/threadedrenderer.h"
+#include "math/vector.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // One rock cube, and a water cube on top of it
+    WorldChunkMesh makeMesh()
+    {
+        WorldChunk chunk;
+        chunk.put( CubeData( EMATERIAL_ROCK ),  Point( 3, 4, 5 ) );
+        chunk.put( CubeData( EMATERIAL_WATER ), Point( 3, 4, 6 ) );
+
+        WorldChunkBuilder builder;
+        builder.build( ChunkNeighborhood( chunk ) );
+
+        return builder.generateMesh();
+    }
+
+    // Takes a while to present each frame
+    class SlowRenderer : public NullRenderer
+    {
+    public:
+        virtual void present()
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+        }
+    };
+
+    void fillWorld( World& world )
+    {
+        for ( unsigned int x = 0; x < world.cols(); x += 2 )
+        {
+            for ( unsigned int z = 0; z < world.depth(); z += 3 )
+            {
+                world.put( CubeData( ( x + z ) % 5 ? EMATERIAL_ROCK : EMATERIAL_WATER ),
+                           Point( x, x % 7, z ) );
+            }
+        }
+    }
+}
+
+TEST(ThreadedRendererTests,CommandBufferPlaysBackInOrder)
+{
+    const WorldChunkMesh mesh = makeMesh();
+    RenderCommandBuffer commands;
+
+    std::vector<ChunkRenderId> ids;
+    ids.push_back( 1 );
+    ids.push_back( 2 );
+
+    commands.recordClear();
+    commands.recordUploadChunkSection( 1, Point(), 0, mesh );
+    commands.recordUploadChunkSection( 2, Point(), 1, mesh );
+    commands.recordRenderChunks( ids );
+    commands.recordRenderTranslucentChunks( ids );
+    commands.recordReleaseChunk( 1 );
+
+    ASSERT_EQ( 6u, commands.commandCount() );
+    EXPECT_EQ( ERENDERCOMMAND_CLEAR, commands.commandAt( 0 ) );
+    EXPECT_EQ( ERENDERCOMMAND_UPLOAD_CHUNK_SECTION, commands.commandAt( 1 ) );
+    EXPECT_EQ( ERENDERCOMMAND_RENDER_TRANSLUCENT_CHUNKS, commands.commandAt( 4 ) );
+    EXPECT_EQ( ERENDERCOMMAND_RELEASE_CHUNK, commands.commandAt( 5 ) );
+
+    RecordingRenderer target;
+    std::vector<ChunkRenderId> targetIds;
+    commands.execute( target, targetIds );
+
+    const RecordingFrameStats& frame = target.currentFrame();
+    EXPECT_EQ( 2u, frame.uploads );
+    EXPECT_EQ( 1u, frame.releases );
+    EXPECT_EQ( 4u, frame.drawCalls );
+    EXPECT_EQ( 1u, frame.liveBuffers );
+
+    // The release forgot the first proxy's target id
+    ASSERT_EQ( 2u, targetIds.size() );
+    EXPECT_EQ( 0u, targetIds[0] );
+    EXPECT_NE( 0u, targetIds[1] );
+
+    commands.reset();
+    EXPECT_TRUE( commands.empty() );
+}
+
+TEST(ThreadedRendererTests,UploadsAreCopiedWhenRecorded)
+{
+    WorldChunkMesh mesh = makeMesh();
+    const size_t triangles = ( mesh.indices.size() + mesh.translucentIndices.size() ) / 3;
+
+    RecordingRenderer target;
+    {
+        ThreadedRenderer renderer( &target );
+
+        std::vector<ChunkRenderId> ids;
+        ids.push_back( renderer.uploadChunkSection( Point(), 0, mesh ) );
+
+        // The caller reuses its mesh before the frame is played back
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.translucentIndices.clear();
+
+        renderer.renderChunks( ids );
+        renderer.renderTranslucentChunks( ids );
+        renderer.present();
+        renderer.finish();
+    }
+
+    ASSERT_EQ( 1u, target.frames().size() );
+    EXPECT_EQ( triangles, target.frames()[0].triangles );
+}
+
+TEST(ThreadedRendererTests,ResetFreesMeshesPastTheCap)
+{
+    const WorldChunkMesh mesh = makeMesh();
+    const size_t cap = RenderCommandBuffer::MAX_RETAINED_MESHES;
+    RenderCommandBuffer commands;
+
+    // A load frame uploads far more sections than usual
+    for ( size_t i = 0; i < cap * 3; ++i )
+    {
+        commands.recordUploadChunkSection( static_cast<ChunkRenderId>( i + 1 ),
+                                           Point(), 0, mesh );
+    }
+
+    EXPECT_EQ( cap * 3, commands.retainedMeshCount() );
+    commands.reset();
+    EXPECT_EQ( cap, commands.retainedMeshCount() );
+
+    // Quieter frames keep the slots they can reuse
+    commands.recordUploadChunkSection( 1, Point(), 0, mesh );
+    commands.reset();
+    EXPECT_EQ( cap, commands.retainedMeshCount() );
+}
+
+TEST(ThreadedRendererTests,ProxyIdsAreReusedAfterRelease)
+{
+    const WorldChunkMesh mesh = makeMesh();
+    RecordingRenderer target;
+    ThreadedRenderer renderer( &target, 3 );
+
+    const ChunkRenderId first = renderer.uploadChunkSection( Point(), 0, mesh );
+    renderer.releaseChunk( first );
+
+    // Released and uploaded again within a single frame
+    const ChunkRenderId second = renderer.uploadChunkSection( Point(), 1, mesh );
+    EXPECT_EQ( first, second );
+
+    std::vector<ChunkRenderId> ids( 1, second );
+    renderer.renderChunks( ids );
+    renderer.present();
+    renderer.finish();
+
+    const RecordingFrameStats& frame = target.frames().back();
+    EXPECT_EQ( 2u, frame.uploads );
+    EXPECT_EQ( 1u, frame.releases );
+    EXPECT_EQ( 1u, frame.liveBuffers );
+    EXPECT_EQ( 1u, frame.drawCalls );
+    EXPECT_EQ( 0u, frame.skippedDraws );
+}
+
+TEST(ThreadedRendererTests,DrawsTheSameFramesAsTheTarget)
+{
+    const int FRAMES = 6;
+
+    // Straight to the renderer
+    RecordingRenderer direct;
+    std::vector<RecordingFrameStats> expected;
+    {
+        WorldView * pView = new WorldView( &direct, 0 );
+        World world( Constants::CHUNK_COLS * 2,
+                     Constants::CHUNK_ROWS,
+                     Constants::CHUNK_DEPTH * 2,
+                     pView );
+        fillWorld( world );
+
+        for ( int frame = 0; frame < FRAMES; ++frame )
+        {
+            pView->setCamera( Camera( Vec3( 10.0f * frame, 10.0f, 40.0f ) ) );
+            pView->update();
+            pView->finishMeshing();
+            direct.clear();
+            pView->draw();
+            direct.present();
+        }
+
+        expected = direct.frames();
+    }
+
+    // Through the render thread, triple buffered
+    RecordingRenderer target;
+    ThreadedRenderer threaded( &target, 3 );
+    {
+        WorldView * pView = new WorldView( &threaded, 0 );
+        World world( Constants::CHUNK_COLS * 2,
+                     Constants::CHUNK_ROWS,
+                     Constants::CHUNK_DEPTH * 2,
+                     pView );
+        fillWorld( world );
+
+        for ( int frame = 0; frame < FRAMES; ++frame )
+        {
+            pView->setCamera( Camera( Vec3( 10.0f * frame, 10.0f, 40.0f ) ) );
+            pView->update();
+            pView->finishMeshing();
+            threaded.clear();
+            pView->draw();
+            threaded.present();
+        }
+
+        threaded.finish();
+    }
+
+    const std::vector<RecordingFrameStats>& frames = target.frames();
+    ASSERT_EQ( expected.size(), frames.size() );
+
+    for ( size_t i = 0; i < frames.size(); ++i )
+    {
+        EXPECT_EQ( expected[i].drawCalls, frames[i].drawCalls );
+        EXPECT_EQ( expected[i].translucentDrawCalls, frames[i].translucentDrawCalls );
+        EXPECT_EQ( expected[i].triangles, frames[i].triangles );
+        EXPECT_EQ( expected[i].uploads, frames[i].uploads );
+        EXPECT_EQ( expected[i].liveBytes, frames[i].liveBytes );
+    }
+
+    EXPECT_GT( frames[0].drawCalls, 0u );
+
+    const ThreadedRendererStats stats = threaded.stats();
+    EXPECT_EQ( static_cast<size_t>( FRAMES ), stats.framesSubmitted );
+    EXPECT_EQ( static_cast<size_t>( FRAMES ), stats.framesExecuted );
+}
+
+TEST(ThreadedRendererTests,PresentWaitsForAFreeBuffer)
+{
+    SlowRenderer target;
+    ThreadedRenderer renderer( &target, 2 );
+    EXPECT_EQ( 2u, renderer.bufferCount() );
+
+    // Presenting far faster than the target can keep up with. The first
+    // frame finds a free buffer, after that each one waits on the target
+    for ( int frame = 0; frame < 5; ++frame )
+    {
+        renderer.clear();
+        renderer.present();
+    }
+
+    renderer.finish();
+
+    const ThreadedRendererStats stats = renderer.stats();
+    EXPECT_EQ( 5u, stats.framesExecuted );
+    EXPECT_GT( stats.totalWaitMilliseconds, 10.0 );
+    EXPECT_GE( stats.totalExecuteMilliseconds, 5 * 5.0 );
+    EXPECT_GE( stats.lastExecuteMilliseconds, 5.0 );
+}
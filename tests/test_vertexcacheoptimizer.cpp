@@ -0,0 +1,141 @@
+#include <googletest/googletest.h>
+#include "graphics/chunkindexbuffer.h"
+#include "graphics/vertexcacheoptimizer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    /**
+     * Triangle list for a grid of cells, two triangles per cell, with the
+     * triangles shuffled so that neighbors are drawn far apart
+     */
+    std::vector<unsigned int> shuffledGrid( unsigned int size )
+    {
+        std::vector<unsigned int> indices;
+        const unsigned int stride = size + 1;
+
+        for ( unsigned int y = 0; y < size; ++y )
+        {
+            for ( unsigned int x = 0; x < size; ++x )
+            {
+                const unsigned int a = y * stride + x;
+
+                indices.push_back( a );
+                indices.push_back( a + 1 );
+                indices.push_back( a + stride + 1 );
+
+                indices.push_back( a );
+                indices.push_back( a + stride + 1 );
+                indices.push_back( a + stride );
+            }
+        }
+
+        unsigned int seed = 7;
+
+        for ( size_t t = indices.size() / 3 - 1; t > 0; --t )
+        {
+            seed = seed * 1103515245u + 12345u;
+            const size_t other = ( seed >> 8 ) % ( t + 1 );
+
+            for ( int c = 0; c < 3; ++c )
+            {
+                std::swap( indices[t * 3 + c], indices[other * 3 + c] );
+            }
+        }
+
+        return indices;
+    }
+
+    /**
+     * Triangles rotated so the smallest index comes first, which keeps their
+     * winding, and then sorted
+     */
+    std::vector<std::vector<unsigned int> > sortedTriangles(
+            const std::vector<unsigned int>& indices )
+    {
+        std::vector<std::vector<unsigned int> > triangles;
+
+        for ( size_t i = 0; i < indices.size(); i += 3 )
+        {
+            std::vector<unsigned int> t( &indices[i], &indices[i] + 3 );
+            std::rotate( t.begin(), std::min_element( t.begin(), t.end() ), t.end() );
+            triangles.push_back( t );
+        }
+
+        std::sort( triangles.begin(), triangles.end() );
+        return triangles;
+    }
+
+    float acmr( const std::vector<unsigned int>& indices, size_t vertexCount )
+    {
+        ChunkIndexBuffer buffer;
+        buffer.assign( indices.data(), indices.size(), vertexCount );
+
+        return VertexCacheOptimizer::simulateAcmr( buffer, vertexCount );
+    }
+}
+
+TEST(VertexCacheOptimizerTests,IndexBufferNarrowsWhenItCan)
+{
+    const unsigned int indices[6] = { 0, 1, 2, 2, 1, 65535 };
+    ChunkIndexBuffer shortBuffer, longBuffer;
+
+    shortBuffer.assign( indices, 6, ChunkIndexBuffer::MAX_16BIT_VERTICES );
+    longBuffer.assign( indices, 6, ChunkIndexBuffer::MAX_16BIT_VERTICES + 1 );
+
+    EXPECT_TRUE( shortBuffer.is16Bit() );
+    EXPECT_EQ( 12u, shortBuffer.byteSize() );
+    EXPECT_EQ( 65535u, shortBuffer[5] );
+
+    EXPECT_FALSE( longBuffer.is16Bit() );
+    EXPECT_EQ( 24u, longBuffer.byteSize() );
+
+    // Width doesn't matter when comparing
+    EXPECT_TRUE( shortBuffer == longBuffer );
+
+    shortBuffer.clear();
+    EXPECT_TRUE( shortBuffer.empty() );
+    EXPECT_TRUE( shortBuffer != longBuffer );
+}
+
+TEST(VertexCacheOptimizerTests,SimulatesFifoCache)
+{
+    // Two triangles sharing an edge load four vertices
+    std::vector<unsigned int> quad;
+    const unsigned int quadIndices[6] = { 0, 1, 2, 0, 2, 3 };
+    quad.assign( quadIndices, quadIndices + 6 );
+
+    EXPECT_FLOAT_EQ( 2.0f, acmr( quad, 4 ) );
+
+    // Triangles that share nothing load every vertex
+    std::vector<unsigned int> separate;
+
+    for ( unsigned int i = 0; i < 30; ++i )
+    {
+        separate.push_back( i );
+    }
+
+    EXPECT_FLOAT_EQ( 3.0f, acmr( separate, 30 ) );
+}
+
+TEST(VertexCacheOptimizerTests,ReorderingKeepsTriangles)
+{
+    const unsigned int size = 24;
+    const size_t vertexCount = ( size + 1 ) * ( size + 1 );
+
+    std::vector<unsigned int> indices = shuffledGrid( size );
+    const std::vector<unsigned int> original = indices;
+
+    VertexCacheOptimizer optimizer;
+    optimizer.optimize( indices.data(), indices.size(), vertexCount );
+
+    EXPECT_TRUE( sortedTriangles( original ) == sortedTriangles( indices ) );
+
+    // A shuffled grid misses on nearly every vertex, an ordered one only
+    // loads each vertex about once
+    EXPECT_LT( 2.5f, acmr( original, vertexCount ) );
+    EXPECT_GT( 0.8f, acmr( indices, vertexCount ) );
+}
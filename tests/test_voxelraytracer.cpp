@@ -0,0 +1,254 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/camera.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "engine/point.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+#include "graphics/software/softwarerenderer.h"
+#include "graphics/software/voxelraytracer.h"
+#include "math/vector.h"
+
+#include <cstdio>
+
+namespace
+{
+    size_t countPixels( const VoxelRayTracer& tracer, uint32_t color )
+    {
+        size_t count = 0;
+
+        for ( unsigned int y = 0; y < tracer.height(); ++y )
+        {
+            for ( unsigned int x = 0; x < tracer.width(); ++x )
+            {
+                count += ( tracer.pixel( x, y ) == color );
+            }
+        }
+
+        return count;
+    }
+}
+
+TEST(VoxelRayTracerTests,EmptyWorldIsSky)
+{
+    NullRenderer renderer;
+    World world( Constants::CHUNK_COLS * 2,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH * 2,
+                 new WorldView( &renderer, 0 ) );
+
+    VoxelRayTracer tracer( 32, 32, 1 );
+    tracer.render( world, Camera( Vec3( 10.5f, 10.5f, 40.0f ) ) );
+
+    EXPECT_EQ( 32u * 32u, countPixels( tracer, VoxelRayTracer::SKY_COLOR ) );
+    EXPECT_EQ( 32u * 32u, tracer.stats().rays );
+    EXPECT_EQ( 0u, tracer.stats().hits );
+    EXPECT_EQ( 0u, tracer.stats().voxelsVisited );
+}
+
+TEST(VoxelRayTracerTests,HitsCubeInFrontOfCamera)
+{
+    NullRenderer renderer;
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH,
+                 new WorldView( &renderer, 0 ) );
+
+    // A cube below the camera, which looks straight down at its top
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 10, 10, 5 ) );
+
+    VoxelRayTracer tracer( 64, 64, 1 );
+    tracer.render( world, Camera( Vec3( 10.5f, 10.5f, 12.0f ) ) );
+
+    EXPECT_EQ( VoxelRayTracer::SKY_COLOR, tracer.pixel( 0, 0 ) );
+    EXPECT_NE( VoxelRayTracer::SKY_COLOR, tracer.pixel( 32, 32 ) );
+
+    // Only the top face can be seen, and it is lit the same everywhere
+    const uint32_t top = tracer.pixel( 32, 32 );
+    const size_t covered = countPixels( tracer, top );
+
+    EXPECT_EQ( 64u * 64u - countPixels( tracer, VoxelRayTracer::SKY_COLOR ), covered );
+    EXPECT_EQ( covered, tracer.stats().hits );
+
+    // Six cubes away a 60 degree view is 6.9 cubes across, so the cube is
+    // about 9 of the 64 pixels wide
+    EXPECT_NEAR( 9.2 * 9.2, static_cast<double>( covered ), 25.0 );
+}
+
+TEST(VoxelRayTracerTests,SkipsEmptyChunksAndBricks)
+{
+    NullRenderer renderer;
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH * 4,
+                 new WorldView( &renderer, 0 ) );
+
+    // Three empty chunks between the camera and the floor. The floor's chunk
+    // is mostly empty too
+    for ( unsigned int x = 0; x < world.cols(); ++x )
+    {
+        for ( unsigned int y = 0; y < world.rows(); ++y )
+        {
+            world.put( CubeData( EMATERIAL_ROCK ), Point( x, y, 0 ) );
+        }
+    }
+
+    // Narrow enough for the floor to fill the view
+    VoxelRayTracer tracer( 16, 16, 1 );
+    tracer.setFieldOfView( 10.0f );
+    tracer.render( world, Camera( Vec3( 16.0f, 16.0f, 120.0f ) ) );
+
+    const VoxelRayStats& stats = tracer.stats();
+    EXPECT_EQ( 16u * 16u, stats.hits );
+    EXPECT_EQ( 0u, countPixels( tracer, VoxelRayTracer::SKY_COLOR ) );
+    EXPECT_LE( stats.chunksSkipped, stats.rays * 3 );
+    EXPECT_GE( stats.chunksSkipped, stats.rays );
+    EXPECT_GT( stats.bricksSkipped, 0u );
+
+    // A brick above the floor and the floor itself is all a ray looks at
+    // one cube at a time, give or take a cube at brick corners
+    EXPECT_LE( stats.voxelsVisited, stats.rays * 8 );
+}
+
+TEST(VoxelRayTracerTests,SeesThroughWater)
+{
+    NullRenderer renderer;
+    World world( Constants::CHUNK_COLS,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH,
+                 new WorldView( &renderer, 0 ) );
+
+    world.put( CubeData( EMATERIAL_ROCK ), Point( 10, 10, 5 ) );
+
+    VoxelRayTracer tracer( 64, 64, 1 );
+    const Camera camera( Vec3( 10.5f, 10.5f, 12.0f ) );
+
+    tracer.render( world, camera );
+    const uint32_t rock = tracer.pixel( 32, 32 );
+
+    // Two layers of water above the rock only show up as one
+    world.put( CubeData( EMATERIAL_WATER ), Point( 10, 10, 6 ) );
+    world.put( CubeData( EMATERIAL_WATER ), Point( 10, 10, 7 ) );
+    tracer.render( world, camera );
+    const uint32_t water = tracer.pixel( 32, 32 );
+
+    EXPECT_NE( rock, water );
+    EXPECT_NE( VoxelRayTracer::SKY_COLOR, water );
+    EXPECT_GT( tracer.stats().hits, 0u );
+
+    // Water seen against the sky is blended with it
+    world.put( CubeData( EMATERIAL_EMPTY ), Point( 10, 10, 5 ) );
+    tracer.render( world, camera );
+
+    EXPECT_NE( water, tracer.pixel( 32, 32 ) );
+    EXPECT_NE( VoxelRayTracer::SKY_COLOR, tracer.pixel( 32, 32 ) );
+    EXPECT_EQ( 0u, tracer.stats().hits );
+}
+
+TEST(VoxelRayTracerTests,ThreadsRenderTheSameImage)
+{
+    NullRenderer renderer;
+    World world( Constants::CHUNK_COLS * 2,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH * 2,
+                 new WorldView( &renderer, 0 ) );
+
+    // Scattered pillars of different heights
+    for ( unsigned int x = 0; x < world.cols(); x += 3 )
+    {
+        for ( unsigned int y = 0; y < world.rows(); y += 5 )
+        {
+            for ( unsigned int z = 0; z < ( x * 7 + y * 3 ) % 40; ++z )
+            {
+                world.put( CubeData( z < 4 ? EMATERIAL_DIRT : EMATERIAL_ROCK ),
+                           Point( x, y, z ) );
+            }
+        }
+    }
+
+    Camera camera( Vec3( 5.0f, 5.0f, 60.0f ) );
+    camera.addMouseLookDelta( 30.0f, 20.0f );
+
+    VoxelRayTracer single( 96, 64, 1 );
+    VoxelRayTracer threaded( 96, 64, 4 );
+
+    single.render( world, camera );
+    threaded.render( world, camera );
+
+    for ( unsigned int y = 0; y < single.height(); ++y )
+    {
+        for ( unsigned int x = 0; x < single.width(); ++x )
+        {
+            ASSERT_EQ( single.pixel( x, y ), threaded.pixel( x, y ) );
+        }
+    }
+
+    EXPECT_EQ( single.stats().hits, threaded.stats().hits );
+    EXPECT_EQ( single.stats().voxelsVisited, threaded.stats().voxelsVisited );
+    EXPECT_GT( single.stats().hits, 0u );
+
+    // Saved frames are a TGA header and four bytes per pixel
+    const char * pFilename = "test_voxelraytracer.tga";
+    ASSERT_TRUE( threaded.saveFrame( pFilename ) );
+
+    FILE * pFile = std::fopen( pFilename, "rb" );
+    ASSERT_TRUE( pFile != NULL );
+    std::fseek( pFile, 0, SEEK_END );
+    EXPECT_EQ( 18 + 96 * 64 * 4, std::ftell( pFile ) );
+    std::fclose( pFile );
+    std::remove( pFilename );
+}
+
+TEST(VoxelRayTracerTests,CoversTheSamePixelsAsTheRasterizer)
+{
+    SoftwareRenderer rasterizer( 128, 96, 1 );
+    WorldView * pView = new WorldView( &rasterizer, 0 );
+    World world( Constants::CHUNK_COLS * 2,
+                 Constants::CHUNK_ROWS,
+                 Constants::CHUNK_DEPTH * 2,
+                 pView );
+
+    for ( unsigned int x = 0; x < world.cols(); x += 3 )
+    {
+        for ( unsigned int y = 0; y < world.rows(); y += 5 )
+        {
+            for ( unsigned int z = 0; z < ( x * 7 + y * 3 ) % 40; ++z )
+            {
+                world.put( CubeData( EMATERIAL_ROCK ), Point( x, y, z ) );
+            }
+        }
+    }
+
+    Camera camera( Vec3( 5.0f, 5.0f, 60.0f ) );
+    camera.addMouseLookDelta( 30.0f, 20.0f );
+
+    rasterizer.setCamera( camera );
+    pView->setOcclusionCullingEnabled( false );
+    pView->update();
+    pView->finishMeshing();
+    rasterizer.clear();
+    pView->draw();
+    rasterizer.present();
+
+    VoxelRayTracer tracer( 128, 96, 1 );
+    tracer.render( world, camera );
+
+    // Both sample pixel centers, so only pixels right on a silhouette edge
+    // may disagree about whether anything was hit
+    size_t mismatches = 0;
+
+    for ( unsigned int y = 0; y < tracer.height(); ++y )
+    {
+        for ( unsigned int x = 0; x < tracer.width(); ++x )
+        {
+            const bool isRasterSky = rasterizer.rasterizer().pixel( x, y ) ==
+                                     SoftwareRenderer::SKY_COLOR;
+            const bool isTracedSky = tracer.pixel( x, y ) == VoxelRayTracer::SKY_COLOR;
+            mismatches += ( isRasterSky != isTracedSky );
+        }
+    }
+
+    EXPECT_GT( tracer.stats().hits, 1000u );
+    EXPECT_LT( mismatches, 128u * 96u / 100u );
+}
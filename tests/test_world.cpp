@@ -5,6 +5,8 @@
 #include "graphics/worldview.h"
 #include "graphics/null/nullrenderer.h"
 
+#include <vector>
+
 class WorldTests : public ::testing::Test
 {
 protected:
@@ -13,7 +15,7 @@ protected:
         pWorld = new World( Constants::CHUNK_COLS * 4,
                             Constants::CHUNK_ROWS * 6,
                             Constants::CHUNK_DEPTH * 5,
-                            new WorldView( new NullRenderer ) );
+                            new WorldView( new NullRenderer, 0 ) );
     }
 
     virtual void TearDown()
@@ -77,3 +79,21 @@ TEST_F(WorldTests,PlacingCubesAcrossChunks)
     pWorld->put( db, pb );
     pWorld->put( dc, pc );
 }
+
+TEST_F(WorldTests,PutChunkReplacesEveryCube)
+{
+    std::vector<CubeData> cubes( Constants::CHUNK_CUBES,
+                                 CubeData( EMATERIAL_SAND ) );
+    cubes[0] = CubeData();
+
+    pWorld->put( CubeData( EMATERIAL_DIRT ), Point( 32, 64, 96 ) );
+    pWorld->putChunk( Point( 1, 2, 3 ), &cubes[0] );
+
+    EXPECT_TRUE( pWorld->isEmptyAt( Point( 32, 64, 96 ) ) );
+    EXPECT_EQ( CubeData( EMATERIAL_SAND ), pWorld->at( Point( 63, 95, 127 ) ) );
+    EXPECT_EQ( Constants::CHUNK_CUBES - 1, pWorld->cubeCount() );
+    EXPECT_EQ( 1u, pWorld->chunkCount() );
+
+    // Chunks that weren't touched are still not created
+    EXPECT_TRUE( pWorld->chunkAt( Point( 1, 2, 2 ) ) == NULL );
+}
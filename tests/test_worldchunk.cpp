@@ -4,6 +4,9 @@
 #include "engine/constants.h"
 #include "engine/point.h"
 
+#include <algorithm>
+#include <vector>
+
 class WorldChunkTests : public ::testing::Test
 {
 protected:
@@ -93,3 +96,121 @@ TEST_F(WorldChunkTests,PlacedCubeIsSaved)
     EXPECT_TRUE(  IsOfType( pChunk, EMATERIAL_ROCK, Point( 31, 0, 12 ) ) );
     EXPECT_TRUE(  IsOfType( pChunk, EMATERIAL_GRASS, Point( 2, 5, 6 ) ) );
 }
+
+TEST_F(WorldChunkTests,CubeCountTracksOverwrites)
+{
+    pChunk->put( CubeData( EMATERIAL_GRASS ), Point( 2, 5, 6 ) );
+    pChunk->put( CubeData( EMATERIAL_ROCK ), Point( 2, 5, 6 ) );
+    pChunk->put( CubeData( EMATERIAL_DIRT ), Point( 3, 5, 6 ) );
+    EXPECT_EQ( 2u, pChunk->cubeCount() );
+
+    pChunk->put( CubeData( EMATERIAL_EMPTY ), Point( 2, 5, 6 ) );
+    EXPECT_EQ( 1u, pChunk->cubeCount() );
+}
+
+TEST_F(WorldChunkTests,RowOccupancyMatchesCubes)
+{
+    pChunk->put( CubeData( EMATERIAL_GRASS ), Point( 0, 5, 6 ) );
+    pChunk->put( CubeData( EMATERIAL_ROCK ), Point( 31, 5, 6 ) );
+    pChunk->put( CubeData( EMATERIAL_ROCK ), Point( 4, 5, 7 ) );
+
+    EXPECT_EQ( 0x80000001u, pChunk->rowOccupancy( 5, 6 ) );
+    EXPECT_EQ( 0x00000010u, pChunk->rowOccupancy( 5, 7 ) );
+
+    pChunk->put( CubeData(), Point( 31, 5, 6 ) );
+    EXPECT_EQ( 0x00000001u, pChunk->rowOccupancy( 5, 6 ) );
+}
+
+TEST_F(WorldChunkTests,UniformChunks)
+{
+    EXPECT_TRUE( pChunk->isUniform() );
+    EXPECT_EQ( EMATERIAL_EMPTY, pChunk->uniformMaterial() );
+
+    pChunk->put( CubeData( EMATERIAL_GRASS ), Point( 0, 5, 6 ) );
+    EXPECT_FALSE( pChunk->isUniform() );
+}
+
+TEST_F(WorldChunkTests,CopiesAreIndependent)
+{
+    pChunk->put( CubeData( EMATERIAL_DIRT ), Point( 1, 2, 3 ) );
+
+    WorldChunk copy( *pChunk );
+    pChunk->put( CubeData( EMATERIAL_ROCK ), Point( 1, 2, 3 ) );
+    pChunk->put( CubeData( EMATERIAL_ROCK ), Point( 4, 5, 6 ) );
+
+    EXPECT_TRUE( IsOfType( &copy, EMATERIAL_DIRT, Point( 1, 2, 3 ) ) );
+    EXPECT_TRUE( IsEmpty( &copy, Point( 4, 5, 6 ) ) );
+    EXPECT_EQ( 1u, copy.cubeCount() );
+
+    EXPECT_TRUE( IsOfType( pChunk, EMATERIAL_ROCK, Point( 1, 2, 3 ) ) );
+    EXPECT_EQ( 2u, pChunk->cubeCount() );
+}
+
+TEST_F(WorldChunkTests,PutAllCubesMatchesPuttingEachCube)
+{
+    std::vector<CubeData> cubes( WorldChunk::TOTAL_CUBES );
+    WorldChunk expected;
+
+    for ( unsigned int i = 0; i < WorldChunk::TOTAL_CUBES; i += 7 )
+    {
+        EMaterialType material = ( i % 3 == 0 ? EMATERIAL_WATER :
+                                                EMATERIAL_ROCK );
+        cubes[i] = CubeData( material );
+
+        expected.put( cubes[i], Point( i % 32, ( i / 32 ) % 32, i / 1024 ) );
+    }
+
+    // Shared with a copy, which must keep the cubes it had
+    pChunk->put( CubeData( EMATERIAL_DIRT ), Point( 1, 0, 0 ) );
+    WorldChunk copy( *pChunk );
+
+    pChunk->putAllCubes( &cubes[0] );
+
+    EXPECT_EQ( expected.cubeCount(), pChunk->cubeCount() );
+    EXPECT_TRUE( IsEmpty( pChunk, Point( 1, 0, 0 ) ) );
+    EXPECT_TRUE( IsOfType( &copy, EMATERIAL_DIRT, Point( 1, 0, 0 ) ) );
+
+    for ( unsigned int row = 0; row < 32 * 32; ++row )
+    {
+        EXPECT_EQ( expected.occupancy()[row], pChunk->occupancy()[row] );
+        EXPECT_EQ( expected.opaqueOccupancy()[row],
+                   pChunk->opaqueOccupancy()[row] );
+    }
+
+    std::fill( cubes.begin(), cubes.end(), CubeData( EMATERIAL_ROCK ) );
+    pChunk->putAllCubes( &cubes[0] );
+
+    EXPECT_TRUE( pChunk->isUniform() );
+    EXPECT_EQ( EMATERIAL_ROCK, pChunk->uniformMaterial() );
+}
+
+TEST_F(WorldChunkTests,CopiedChunkNeverWritesSharedCubesInPlace)
+{
+    const CubeData * pBefore = pChunk->cubes();
+
+    // Even once the copy is gone another thread might still have been
+    // reading the shared cubes, so the next write takes a new array
+    {
+        WorldChunk copy( *pChunk );
+    }
+
+    pChunk->put( CubeData( EMATERIAL_ROCK ), Point( 1, 2, 3 ) );
+    const CubeData * pDetached = pChunk->cubes();
+
+    EXPECT_NE( pBefore, pDetached );
+
+    // ... after which the chunk writes in place again
+    pChunk->put( CubeData( EMATERIAL_DIRT ), Point( 4, 5, 6 ) );
+    EXPECT_EQ( pDetached, pChunk->cubes() );
+
+    // Assigning shares the cubes too
+    WorldChunk assigned;
+    assigned = *pChunk;
+
+    EXPECT_EQ( pChunk->cubes(), assigned.cubes() );
+    EXPECT_TRUE( IsOfType( &assigned, EMATERIAL_DIRT, Point( 4, 5, 6 ) ) );
+
+    pChunk->put( CubeData(), Point( 4, 5, 6 ) );
+    EXPECT_NE( pChunk->cubes(), assigned.cubes() );
+    EXPECT_TRUE( IsOfType( &assigned, EMATERIAL_DIRT, Point( 4, 5, 6 ) ) );
+}
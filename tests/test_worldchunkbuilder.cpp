@@ -0,0 +1,788 @@
+#include <googletest/googletest.h>
+#include "graphics/worldchunkbuilder.h"
+#include "graphics/worldchunkmesh.h"
+#include "graphics/vertexcacheoptimizer.h"
+#include "engine/worldchunk.h"
+#include "engine/cubedata.h"
+#include "engine/cubeface.h"
+#include "engine/point.h"
+
+#include "math/vector.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    void fill( WorldChunk& chunk, EMaterialType material )
+    {
+        for ( unsigned int z = 0; z < WorldChunk::TOTAL_DEPTH; ++z )
+        {
+            for ( unsigned int y = 0; y < WorldChunk::TOTAL_ROWS; ++y )
+            {
+                for ( unsigned int x = 0; x < WorldChunk::TOTAL_COLS; ++x )
+                {
+                    chunk.put( CubeData( material ), Point( x, y, z ) );
+                }
+            }
+        }
+    }
+}
+
+TEST(WorldChunkBuilderTests,EmptyChunkHasNoGeometry)
+{
+    WorldChunk chunk;
+    WorldChunkBuilder builder;
+
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    EXPECT_EQ( 0u, builder.numVerts() );
+    EXPECT_EQ( 0u, builder.numIndices() );
+    EXPECT_EQ( 0u, builder.stats().cubeCount );
+}
+
+TEST(WorldChunkBuilderTests,SingleCubeHasSixFaces)
+{
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 3, 4, 5 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    WorldChunkMesh mesh = builder.generateMesh();
+
+    EXPECT_EQ( 24u, mesh.vertices.size() );
+    EXPECT_EQ( 36u, mesh.indices.size() );
+    EXPECT_EQ( 12u, builder.numFaces() );
+    EXPECT_EQ( 1u,  builder.stats().cubeCount );
+    EXPECT_EQ( 0u,  builder.stats().hiddenFaces );
+    EXPECT_EQ( 24u, builder.stats().vertexCount );
+    EXPECT_EQ( 36u, builder.stats().indexCount );
+}
+
+TEST(WorldChunkBuilderTests,TrianglesFaceOutwards)
+{
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 0, 0, 0 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    WorldChunkMesh mesh = builder.generateMesh();
+
+    for ( size_t i = 0; i < mesh.indices.size(); i += 3 )
+    {
+        const CubeVertex& a = mesh.vertices[ mesh.indices[i] ];
+        const CubeVertex& b = mesh.vertices[ mesh.indices[i+1] ];
+        const CubeVertex& c = mesh.vertices[ mesh.indices[i+2] ];
+
+        Vec3 pA( a.pos[0], a.pos[1], a.pos[2] );
+        Vec3 ab = Vec3( b.pos[0], b.pos[1], b.pos[2] ) - pA;
+        Vec3 ac = Vec3( c.pos[0], c.pos[1], c.pos[2] ) - pA;
+        Vec3 n( a.normal[0], a.normal[1], a.normal[2] );
+
+        EXPECT_GT( dot( cross( ab, ac ), n ), 0.0f );
+    }
+}
+
+TEST(WorldChunkBuilderTests,TouchingCubesHideSharedFaces)
+{
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 3, 4, 5 ) );
+    chunk.put( CubeData( EMATERIAL_DIRT ), Point( 4, 4, 5 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    EXPECT_EQ( 10u * 4u, builder.numVerts() );
+    EXPECT_EQ( 2u, builder.stats().hiddenFaces );
+    EXPECT_EQ( 0u, builder.stats().hiddenCubes );
+}
+
+TEST(WorldChunkBuilderTests,NeighborChunkHidesSeam)
+{
+    WorldChunk chunk, neighbor;
+    const unsigned int LAST_COL = WorldChunk::TOTAL_COLS - 1;
+
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( LAST_COL, 7, 9 ) );
+    neighbor.put( CubeData( EMATERIAL_ROCK ), Point( 0, 7, 9 ) );
+
+    WorldChunkBuilder builder;
+    ChunkNeighborhood neighborhood( chunk );
+    builder.build( neighborhood );
+
+    EXPECT_EQ( 6u * 4u, builder.numVerts() );
+
+    // Only the +x neighbor touches the cube
+    neighborhood.pNeighbors[ECUBEFACE_NEG_X] = &neighbor;
+    builder.build( neighborhood );
+    EXPECT_EQ( 6u * 4u, builder.numVerts() );
+
+    neighborhood.pNeighbors[ECUBEFACE_NEG_X] = NULL;
+    neighborhood.pNeighbors[ECUBEFACE_POS_X] = &neighbor;
+    builder.build( neighborhood );
+    EXPECT_EQ( 5u * 4u, builder.numVerts() );
+    EXPECT_EQ( 1u, builder.stats().hiddenFaces );
+}
+
+TEST(WorldChunkBuilderTests,SolidChunkOnlyHasShell)
+{
+    WorldChunk chunk, solid;
+    fill( chunk, EMATERIAL_ROCK );
+    fill( solid, EMATERIAL_DIRT );
+
+    const unsigned int SIDE = WorldChunk::TOTAL_COLS;
+
+    WorldChunkBuilder builder;
+    ChunkNeighborhood neighborhood( chunk );
+    builder.build( neighborhood );
+
+    EXPECT_EQ( 6u * SIDE * SIDE * 4u, builder.numVerts() );
+    EXPECT_EQ( chunk.cubeCount(), builder.stats().cubeCount );
+
+    for ( int f = 0; f < ECUBEFACE_COUNT; ++f )
+    {
+        neighborhood.pNeighbors[f] = &solid;
+    }
+
+    builder.build( neighborhood );
+
+    EXPECT_EQ( 0u, builder.numVerts() );
+    EXPECT_EQ( chunk.cubeCount(), builder.stats().hiddenCubes );
+}
+
+TEST(WorldChunkBuilderTests,GreedySolidChunkIsSixQuads)
+{
+    WorldChunk chunk;
+    fill( chunk, EMATERIAL_ROCK );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ), EMESHING_GREEDY );
+
+    EXPECT_EQ( 6u, builder.stats().quadCount );
+    EXPECT_EQ( 6u * 4u, builder.numVerts() );
+    EXPECT_EQ( 6u * 6u, builder.numIndices() );
+}
+
+TEST(WorldChunkBuilderTests,GreedyKeepsMaterialsApart)
+{
+    WorldChunk chunk;
+
+    // A 4x1x2 slab, half rock and half dirt
+    for ( int x = 0; x < 4; ++x )
+    {
+        EMaterialType material = ( x < 2 ? EMATERIAL_ROCK : EMATERIAL_DIRT );
+
+        chunk.put( CubeData( material ), Point( x, 0, 0 ) );
+        chunk.put( CubeData( material ), Point( x, 0, 1 ) );
+    }
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ), EMESHING_GREEDY );
+
+    // +y, -y, +z, -z split in two by material. +x and -x are one quad each
+    EXPECT_EQ( 4u * 2u + 2u, builder.stats().quadCount );
+}
+
+TEST(WorldChunkBuilderTests,GreedyCoversSameArea)
+{
+    WorldChunk chunk;
+
+    for ( int i = 0; i < 200; ++i )
+    {
+        Point p( ( i * 7 ) % 13, ( i * 5 ) % 11, ( i * 3 ) % 9 );
+        chunk.put( CubeData( i % 3 ? EMATERIAL_ROCK : EMATERIAL_SAND ), p );
+    }
+
+    WorldChunkBuilder builder;
+
+    builder.build( ChunkNeighborhood( chunk ), EMESHING_CULLED );
+    const unsigned int visibleFaces = builder.stats().quadCount;
+    const unsigned int hiddenFaces  = builder.stats().hiddenFaces;
+
+    builder.build( ChunkNeighborhood( chunk ), EMESHING_GREEDY );
+    EXPECT_LT( builder.stats().quadCount, visibleFaces );
+    EXPECT_EQ( hiddenFaces, builder.stats().hiddenFaces );
+
+    // Texture coordinates advance by one per cube, so the coordinates of
+    // A and C span the quad's size in cube faces
+    WorldChunkMesh mesh = builder.generateMesh();
+    float area = 0.0f;
+
+    for ( size_t i = 0; i < mesh.vertices.size(); i += 4 )
+    {
+        const CubeVertex& a = mesh.vertices[i];
+        const CubeVertex& c = mesh.vertices[i + 2];
+
+        area += ( c.tex[0] - a.tex[0] ) * ( c.tex[1] - a.tex[1] );
+    }
+
+    EXPECT_EQ( static_cast<float>( visibleFaces ), area );
+}
+
+TEST(WorldChunkBuilderTests,PackedVertexRoundTrips)
+{
+    const int p[3] = { 32, 0, 17 };
+    PackedCubeVertex v( p, ECUBEFACE_NEG_Z, 3, EMATERIAL_LAVA, 2 );
+
+    EXPECT_EQ( 8u, sizeof(v) );
+    EXPECT_EQ( 32, v.pos[0] );
+    EXPECT_EQ( 0,  v.pos[1] );
+    EXPECT_EQ( 17, v.pos[2] );
+    EXPECT_EQ( ECUBEFACE_NEG_Z, v.face() );
+    EXPECT_EQ( 3, v.corner() );
+    EXPECT_EQ( EMATERIAL_LAVA, v.material );
+    EXPECT_EQ( 2, v.ao );
+}
+
+TEST(WorldChunkBuilderTests,PackedMeshMatchesFloatMesh)
+{
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 3, 4, 5 ) );
+    chunk.put( CubeData( EMATERIAL_SAND ), Point( 3, 5, 5 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    WorldChunkMesh mesh       = builder.generateMesh();
+    WorldChunkMesh packedMesh = builder.generatePackedMesh();
+
+    ASSERT_EQ( mesh.vertices.size(), packedMesh.packedVertices.size() );
+    EXPECT_EQ( mesh.indices, packedMesh.indices );
+
+    for ( size_t i = 0; i < mesh.vertices.size(); ++i )
+    {
+        const CubeVertex& v       = mesh.vertices[i];
+        const PackedCubeVertex& p = packedMesh.packedVertices[i];
+
+        EXPECT_EQ( v.pos[0], static_cast<float>( p.pos[0] ) );
+        EXPECT_EQ( v.pos[1], static_cast<float>( p.pos[1] ) );
+        EXPECT_EQ( v.pos[2], static_cast<float>( p.pos[2] ) );
+        EXPECT_EQ( static_cast<int>( i % 4 ), p.corner() );
+        EXPECT_EQ( packedMesh.packedVertices[ i - i % 4 ].face(), p.face() );
+    }
+
+    // Sand sits on top of rock, so any quad that dips below y=5 is rock
+    for ( size_t i = 0; i < packedMesh.packedVertices.size(); i += 4 )
+    {
+        int minY = packedMesh.packedVertices[i].pos[1];
+
+        for ( int c = 1; c < 4; ++c )
+        {
+            minY = std::min<int>( minY, packedMesh.packedVertices[ i + c ].pos[1] );
+        }
+
+        EXPECT_EQ( minY < 5 ? EMATERIAL_ROCK : EMATERIAL_SAND,
+                   packedMesh.packedVertices[i].material );
+    }
+}
+
+TEST(WorldChunkBuilderTests,SectionsAddUpToWholeChunk)
+{
+    WorldChunk chunk;
+
+    for ( int i = 0; i < 400; ++i )
+    {
+        chunk.put( CubeData( EMATERIAL_DIRT ),
+                   Point( ( i * 7 ) % 32, ( i * 11 ) % 32, ( i * 13 ) % 32 ) );
+    }
+
+    const EMeshingMode modes[2] = { EMESHING_CULLED, EMESHING_GREEDY };
+
+    for ( int m = 0; m < 2; ++m )
+    {
+        WorldChunkBuilder builder;
+        builder.build( ChunkNeighborhood( chunk ), modes[m] );
+
+        const size_t faces = builder.numFaces();
+        size_t sectionFaces = 0;
+
+        for ( unsigned int s = 0; s < WorldChunk::SECTION_COUNT; ++s )
+        {
+            builder.buildSection( ChunkNeighborhood( chunk ), s, modes[m] );
+            sectionFaces += builder.numFaces();
+        }
+
+        EXPECT_EQ( faces, sectionFaces );
+    }
+}
+
+TEST(WorldChunkBuilderTests,SectionBorderIsCulled)
+{
+    // Two cubes stacked across the border of sections zero and one
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 3, 3, 7 ) );
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 3, 3, 8 ) );
+
+    WorldChunkBuilder builder;
+
+    builder.buildSection( ChunkNeighborhood( chunk ), 0 );
+    EXPECT_EQ( 10u, builder.numFaces() );
+
+    builder.buildSection( ChunkNeighborhood( chunk ), 1 );
+    EXPECT_EQ( 10u, builder.numFaces() );
+
+    builder.buildSection( ChunkNeighborhood( chunk ), 2 );
+    EXPECT_EQ( 0u, builder.numFaces() );
+}
+
+TEST(WorldChunkBuilderTests,TranslucentFacesAreIndexedSeparately)
+{
+    // Water resting on rock. The rock's top face shows through the water,
+    // but the water's bottom face is hidden by the rock
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ),  Point( 3, 3, 3 ) );
+    chunk.put( CubeData( EMATERIAL_WATER ), Point( 3, 3, 4 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    WorldChunkMesh mesh = builder.generateMesh();
+
+    EXPECT_EQ( 44u, mesh.vertices.size() );
+    EXPECT_EQ( 36u, mesh.indices.size() );
+    EXPECT_EQ( 30u, mesh.translucentIndices.size() );
+    EXPECT_EQ( 66u, builder.stats().indexCount );
+    EXPECT_EQ( 30u, builder.stats().translucentIndexCount );
+
+    for ( size_t i = 0; i < mesh.translucentIndices.size(); ++i )
+    {
+        // Every translucent vertex belongs to the water cube
+        EXPECT_LE( 4.0f, mesh.vertices[ mesh.translucentIndices[i] ].pos[2] );
+    }
+}
+
+TEST(WorldChunkBuilderTests,TranslucentCubesHideOwnMaterial)
+{
+    // Two water cubes share a hidden face, while water and leaves can see
+    // each other through the face between them
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_WATER ), Point( 3, 3, 3 ) );
+    chunk.put( CubeData( EMATERIAL_WATER ), Point( 4, 3, 3 ) );
+    chunk.put( CubeData( EMATERIAL_LEAF ),  Point( 5, 3, 3 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    EXPECT_EQ( 2u, builder.stats().hiddenFaces );
+    EXPECT_EQ( 16u * 6u, builder.stats().translucentIndexCount );
+    EXPECT_EQ( 0u, builder.generateMesh().indices.size() );
+}
+
+TEST(WorldChunkBuilderTests,BinaryMatchesGreedy)
+{
+    // Random caves of opaque and translucent materials with neighbors on
+    // half of the sides, so culling, merging and occlusion all cross chunk
+    // edges
+    WorldChunk chunk, posX, negY, posZ;
+    WorldChunk * chunks[4] = { &chunk, &posX, &negY, &posZ };
+    unsigned int seed = 12345;
+
+    for ( int c = 0; c < 4; ++c )
+    {
+        for ( int i = 0; i < 20000; ++i )
+        {
+            seed = seed * 1103515245u + 12345u;
+            const unsigned int r = seed >> 8;
+
+            const EMaterialType MATERIALS[4] =
+            {
+                EMATERIAL_ROCK, EMATERIAL_DIRT, EMATERIAL_WATER, EMATERIAL_LEAF
+            };
+
+            chunks[c]->put( CubeData( MATERIALS[ ( r >> 15 ) & 3 ] ),
+                            Point( r % 32, ( r / 32 ) % 32, ( r / 1024 ) % 32 ) );
+        }
+    }
+
+    ChunkNeighborhood neighborhood( chunk );
+    neighborhood.pNeighbors[ECUBEFACE_POS_X] = &posX;
+    neighborhood.pNeighbors[ECUBEFACE_NEG_Y] = &negY;
+    neighborhood.pNeighbors[ECUBEFACE_POS_Z] = &posZ;
+
+    WorldChunkBuilder greedy, binary;
+
+    for ( int s = -1; s < static_cast<int>( WorldChunk::SECTION_COUNT ); ++s )
+    {
+        if ( s < 0 )
+        {
+            greedy.build( neighborhood, EMESHING_GREEDY );
+            binary.build( neighborhood, EMESHING_BINARY );
+        }
+        else
+        {
+            greedy.buildSection( neighborhood, s, EMESHING_GREEDY );
+            binary.buildSection( neighborhood, s, EMESHING_BINARY );
+        }
+
+        const WorldChunkMesh expected = greedy.generatePackedMesh();
+        const WorldChunkMesh actual   = binary.generatePackedMesh();
+
+        ASSERT_EQ( expected.packedVertices.size(), actual.packedVertices.size() );
+        EXPECT_EQ( expected.indices, actual.indices );
+        EXPECT_EQ( expected.translucentIndices, actual.translucentIndices );
+        EXPECT_FALSE( actual.translucentIndices.empty() );
+
+        for ( size_t i = 0; i < expected.packedVertices.size(); ++i )
+        {
+            const PackedCubeVertex& e = expected.packedVertices[i];
+            const PackedCubeVertex& a = actual.packedVertices[i];
+
+            ASSERT_EQ( e.pos[0], a.pos[0] );
+            ASSERT_EQ( e.pos[1], a.pos[1] );
+            ASSERT_EQ( e.pos[2], a.pos[2] );
+            ASSERT_EQ( e.faceCorner, a.faceCorner );
+            ASSERT_EQ( e.material, a.material );
+            ASSERT_EQ( e.ao, a.ao );
+        }
+
+        EXPECT_EQ( greedy.stats().cubeCount,   binary.stats().cubeCount );
+        EXPECT_EQ( greedy.stats().faceCount,   binary.stats().faceCount );
+        EXPECT_EQ( greedy.stats().hiddenFaces, binary.stats().hiddenFaces );
+        EXPECT_EQ( greedy.stats().hiddenCubes, binary.stats().hiddenCubes );
+        EXPECT_EQ( greedy.stats().quadCount,   binary.stats().quadCount );
+    }
+}
+
+TEST(WorldChunkBuilderTests,DownsampleUsesMajority)
+{
+    WorldChunk chunk;
+
+    // Five dirt and three rock in the first 2x2x2 cell
+    for ( int i = 0; i < 8; ++i )
+    {
+        EMaterialType material = ( i < 5 ? EMATERIAL_DIRT : EMATERIAL_ROCK );
+        chunk.put( CubeData( material ), Point( i & 1, ( i >> 1 ) & 1, i >> 2 ) );
+    }
+
+    // Only three cubes in the next one
+    for ( int i = 0; i < 3; ++i )
+    {
+        chunk.put( CubeData( EMATERIAL_ROCK ), Point( 2 + ( i & 1 ), i >> 1, 0 ) );
+    }
+
+    const int first[3]  = { 0, 0, 0 };
+    const int second[3] = { 1, 0, 0 };
+
+    EXPECT_EQ( EMATERIAL_DIRT,  WorldChunkBuilder::downsample( chunk, 2, first ) );
+    EXPECT_EQ( EMATERIAL_EMPTY, WorldChunkBuilder::downsample( chunk, 2, second ) );
+    EXPECT_EQ( EMATERIAL_EMPTY, WorldChunkBuilder::downsample( chunk, 4, first ) );
+}
+
+TEST(WorldChunkBuilderTests,LodDividesQuadCount)
+{
+    // Bottom half of the chunk is solid
+    WorldChunk chunk;
+
+    for ( unsigned int z = 0; z < WorldChunk::TOTAL_DEPTH; ++z )
+    {
+        for ( unsigned int y = 0; y < WorldChunk::TOTAL_ROWS / 2; ++y )
+        {
+            for ( unsigned int x = 0; x < WorldChunk::TOTAL_COLS; ++x )
+            {
+                chunk.put( CubeData( EMATERIAL_DIRT ), Point( x, y, z ) );
+            }
+        }
+    }
+
+    WorldChunkBuilder builder;
+    size_t quads[WorldChunkBuilder::MAX_LOD + 1] = { 0 };
+
+    for ( unsigned int lod = 0; lod <= WorldChunkBuilder::MAX_LOD; ++lod )
+    {
+        int highest = 0;
+
+        for ( unsigned int s = 0; s < WorldChunk::SECTION_COUNT; ++s )
+        {
+            builder.buildSection( ChunkNeighborhood( chunk ), s, EMESHING_CULLED, lod );
+            quads[lod] += builder.stats().quadCount;
+
+            WorldChunkMesh mesh = builder.generateMesh();
+
+            for ( size_t i = 0; i < mesh.vertices.size(); ++i )
+            {
+                highest = std::max( highest,
+                                    static_cast<int>( mesh.vertices[i].pos[1] ) );
+            }
+        }
+
+        // Every quad covers 4^lod faces and the surface stays put
+        EXPECT_EQ( quads[0], quads[lod] << ( 2 * lod ) );
+        EXPECT_EQ( 16, highest );
+    }
+}
+
+TEST(WorldChunkBuilderTests,LodNeighborHidesSkirt)
+{
+    WorldChunk chunk, neighbor;
+    fill( chunk, EMATERIAL_ROCK );
+    fill( neighbor, EMATERIAL_ROCK );
+
+    ChunkNeighborhood neighborhood( chunk );
+    WorldChunkBuilder builder;
+
+    // Without the neighbor the side facing it gets a skirt of 4x2 cells
+    builder.buildSection( neighborhood, 0, EMESHING_CULLED, 2 );
+    const size_t withSkirt = builder.stats().quadCount;
+
+    neighborhood.pNeighbors[ECUBEFACE_POS_X] = &neighbor;
+    builder.buildSection( neighborhood, 0, EMESHING_CULLED, 2 );
+
+    EXPECT_EQ( withSkirt - 8 * 2, builder.stats().quadCount );
+}
+
+namespace
+{
+    /**
+     * Finds the quad for the given face whose corners all sit at the given
+     * height along the face's axis, returning the index of its first vertex
+     */
+    size_t findQuad( const WorldChunkMesh& mesh, ECubeFace face, int depth )
+    {
+        const int axis = CubeFace::axis( face );
+
+        for ( size_t i = 0; i < mesh.packedVertices.size(); i += 4 )
+        {
+            if ( mesh.packedVertices[i].face() == face &&
+                 mesh.packedVertices[i].pos[axis] == depth )
+            {
+                return i;
+            }
+        }
+
+        return mesh.packedVertices.size();
+    }
+}
+
+TEST(WorldChunkBuilderTests,WallOccludesFloorCorners)
+{
+    // A floor cube with a wall cube sitting diagonally above it along +x
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_DIRT ), Point( 5, 5, 5 ) );
+    chunk.put( CubeData( EMATERIAL_DIRT ), Point( 6, 6, 5 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    WorldChunkMesh mesh = builder.generatePackedMesh();
+    size_t quad = findQuad( mesh, ECUBEFACE_POS_Y, 6 );
+    ASSERT_LT( quad, mesh.packedVertices.size() );
+
+    // Corners against the wall are darkened by it, the others are open
+    for ( int c = 0; c < 4; ++c )
+    {
+        const PackedCubeVertex& v = mesh.packedVertices[quad + c];
+        EXPECT_EQ( v.pos[0] == 6 ? 1 : 0, v.ao );
+    }
+
+    // The lone cube's other faces are untouched
+    quad = findQuad( mesh, ECUBEFACE_NEG_Y, 5 );
+    ASSERT_LT( quad, mesh.packedVertices.size() );
+
+    for ( int c = 0; c < 4; ++c )
+    {
+        EXPECT_EQ( 0, mesh.packedVertices[quad + c].ao );
+    }
+}
+
+TEST(WorldChunkBuilderTests,InnerCornerIsFullyOccluded)
+{
+    // Floor cube with walls on +x and +z above it
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_DIRT ), Point( 5, 5, 5 ) );
+    chunk.put( CubeData( EMATERIAL_DIRT ), Point( 6, 6, 5 ) );
+    chunk.put( CubeData( EMATERIAL_DIRT ), Point( 5, 6, 6 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    WorldChunkMesh mesh = builder.generatePackedMesh();
+    size_t quad = findQuad( mesh, ECUBEFACE_POS_Y, 6 );
+    ASSERT_LT( quad, mesh.packedVertices.size() );
+
+    for ( int c = 0; c < 4; ++c )
+    {
+        const PackedCubeVertex& v = mesh.packedVertices[quad + c];
+        const int walls = ( v.pos[0] == 6 ) + ( v.pos[2] == 6 );
+
+        EXPECT_EQ( walls == 2 ? 3 : walls, v.ao );
+    }
+}
+
+TEST(WorldChunkBuilderTests,QuadSplitsThroughOccludedCorner)
+{
+    // Only a diagonal cube touches the floor's top face, at one corner. The
+    // two positions darken corners on opposite diagonals of the quad
+    const int diagonalX[2] = { 6, 4 };
+
+    for ( int test = 0; test < 2; ++test )
+    {
+        WorldChunk chunk;
+        chunk.put( CubeData( EMATERIAL_DIRT ), Point( 5, 5, 5 ) );
+        chunk.put( CubeData( EMATERIAL_DIRT ), Point( diagonalX[test], 6, 6 ) );
+
+        WorldChunkBuilder builder;
+        builder.build( ChunkNeighborhood( chunk ) );
+
+        WorldChunkMesh mesh = builder.generatePackedMesh();
+        size_t quad = findQuad( mesh, ECUBEFACE_POS_Y, 6 );
+        ASSERT_LT( quad, mesh.packedVertices.size() );
+
+        // Find the dark corner, and check both triangles use it
+        size_t dark = 4;
+
+        for ( size_t c = 0; c < 4; ++c )
+        {
+            if ( mesh.packedVertices[quad + c].ao != 0 )
+            {
+                EXPECT_EQ( 4u, dark );
+                dark = c;
+            }
+        }
+
+        ASSERT_LT( dark, 4u );
+        EXPECT_EQ( 1, mesh.packedVertices[quad + dark].ao );
+
+        const size_t firstIndex = ( quad / 4 ) * 6;
+        int uses = 0;
+
+        for ( size_t i = 0; i < 6; ++i )
+        {
+            uses += ( mesh.indices[firstIndex + i] == quad + dark );
+        }
+
+        EXPECT_EQ( 2, uses );
+    }
+}
+
+namespace
+{
+    typedef std::vector<float> VertexAttributes;
+    typedef std::vector<VertexAttributes> Triangle;
+
+    /**
+     * Every triangle in an index list as the attributes of its corners,
+     * rotated so the smallest corner comes first (keeping the winding) and
+     * sorted, so meshes can be compared no matter how they are indexed
+     */
+    std::vector<Triangle> triangles( const WorldChunkMesh& mesh,
+                                     const ChunkIndexBuffer& indices )
+    {
+        std::vector<Triangle> result;
+
+        for ( size_t i = 0; i < indices.size(); i += 3 )
+        {
+            Triangle triangle;
+
+            for ( int c = 0; c < 3; ++c )
+            {
+                const CubeVertex& v = mesh.vertices[ indices[i + c] ];
+                const float attributes[8] =
+                {
+                    v.pos[0], v.pos[1], v.pos[2],
+                    v.normal[0], v.normal[1], v.normal[2],
+                    v.tex[0], v.tex[1]
+                };
+
+                triangle.push_back( VertexAttributes( attributes, attributes + 8 ) );
+            }
+
+            std::rotate( triangle.begin(),
+                         std::min_element( triangle.begin(), triangle.end() ),
+                         triangle.end() );
+            result.push_back( triangle );
+        }
+
+        std::sort( result.begin(), result.end() );
+        return result;
+    }
+}
+
+TEST(WorldChunkBuilderTests,SmallMeshesUse16BitIndices)
+{
+    WorldChunk chunk;
+    chunk.put( CubeData( EMATERIAL_ROCK ), Point( 3, 4, 5 ) );
+
+    WorldChunkBuilder builder;
+    builder.build( ChunkNeighborhood( chunk ) );
+
+    WorldChunkMesh mesh = builder.generateMesh();
+    EXPECT_TRUE( mesh.indices.is16Bit() );
+    EXPECT_EQ( 72u, mesh.indices.byteSize() );
+
+    // A checkerboard shows every face of every cube, which is more
+    // vertices than 16 bits can address
+    WorldChunk checkerboard;
+
+    for ( unsigned int z = 0; z < WorldChunk::TOTAL_DEPTH; ++z )
+    {
+        for ( unsigned int y = 0; y < WorldChunk::TOTAL_ROWS; ++y )
+        {
+            for ( unsigned int x = ( y + z ) % 2; x < WorldChunk::TOTAL_COLS; x += 2 )
+            {
+                checkerboard.put( CubeData( EMATERIAL_DIRT ), Point( x, y, z ) );
+            }
+        }
+    }
+
+    builder.build( ChunkNeighborhood( checkerboard ) );
+    builder.generateMesh( mesh );
+
+    EXPECT_LT( ChunkIndexBuffer::MAX_16BIT_VERTICES, mesh.vertices.size() );
+    EXPECT_FALSE( mesh.indices.is16Bit() );
+    EXPECT_EQ( builder.numIndices(), mesh.indices.size() );
+
+    // Reusing the mesh for a small chunk narrows the indices again
+    builder.build( ChunkNeighborhood( chunk ) );
+    builder.generateMesh( mesh );
+    EXPECT_TRUE( mesh.indices.is16Bit() );
+    EXPECT_EQ( 36u, mesh.indices.size() );
+}
+
+TEST(WorldChunkBuilderTests,OptimizedMeshDrawsSameTriangles)
+{
+    // Rolling hills of dirt with a pond on top
+    WorldChunk chunk;
+
+    for ( unsigned int y = 0; y < WorldChunk::TOTAL_ROWS; ++y )
+    {
+        for ( unsigned int x = 0; x < WorldChunk::TOTAL_COLS; ++x )
+        {
+            const unsigned int height = 4 + ( x * 7 + y * 3 ) % 5;
+
+            for ( unsigned int z = 0; z < height; ++z )
+            {
+                chunk.put( CubeData( EMATERIAL_DIRT ), Point( x, y, z ) );
+            }
+
+            if ( x > 10 && x < 20 && y > 10 && y < 20 )
+            {
+                chunk.put( CubeData( EMATERIAL_WATER ), Point( x, y, 12 ) );
+            }
+        }
+    }
+
+    WorldChunkBuilder builder;
+    WorldChunkMesh plain, optimized;
+
+    const EMeshingMode modes[2] = { EMESHING_CULLED, EMESHING_GREEDY };
+
+    for ( int m = 0; m < 2; ++m )
+    {
+        builder.build( ChunkNeighborhood( chunk ), modes[m] );
+        builder.generateMesh( plain );
+        builder.generateOptimizedMesh( optimized );
+
+        EXPECT_TRUE( triangles( plain, plain.indices ) ==
+                     triangles( optimized, optimized.indices ) );
+        EXPECT_TRUE( triangles( plain, plain.translucentIndices ) ==
+                     triangles( optimized, optimized.translucentIndices ) );
+
+        // Neighboring quads share corners, and the GPU gets to reuse them
+        EXPECT_GT( plain.vertices.size(), optimized.vertices.size() );
+        EXPECT_GT( VertexCacheOptimizer::simulateAcmr( plain.indices,
+                                                       plain.vertices.size() ),
+                   VertexCacheOptimizer::simulateAcmr( optimized.indices,
+                                                       optimized.vertices.size() ) );
+    }
+}
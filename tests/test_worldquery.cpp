@@ -0,0 +1,149 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/worldquery.h"
+#include "engine/cubevolume.h"
+#include "engine/cubedata.h"
+#include "engine/constants.h"
+#include "graphics/worldview.h"
+#include "graphics/null/nullrenderer.h"
+
+#include <algorithm>
+#include <vector>
+
+class WorldQueryTests : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        pWorld = new World( Constants::CHUNK_COLS * 4,
+                            Constants::CHUNK_ROWS * 2,
+                            Constants::CHUNK_DEPTH * 3,
+                            new WorldView( &renderer, 0 ) );
+
+        // A solid slab along the bottom of the world, plus a checkerboard
+        // of cubes near the middle
+        for ( unsigned int z = 0; z < pWorld->depth(); ++z )
+        {
+            for ( unsigned int x = 0; x < pWorld->cols(); ++x )
+            {
+                pWorld->put( CubeData( EMATERIAL_ROCK ), Point( x, 0, z ) );
+                pWorld->put( CubeData( EMATERIAL_DIRT ), Point( x, 1, z ) );
+            }
+        }
+
+        for ( unsigned int x = 20; x < 50; x += 2 )
+        {
+            pWorld->put( CubeData( EMATERIAL_GRASS ), Point( x, 40, 40 ) );
+        }
+    }
+
+    virtual void TearDown()
+    {
+        delete pWorld;
+    }
+
+    unsigned int bruteForceCount( const CubeVolume& volume ) const
+    {
+        Point min, max;
+        volume.bounds( min, max );
+
+        unsigned int count = 0;
+
+        for ( int z = std::max( 0, min.z ); z < std::min( max.z, (int) pWorld->depth() ); ++z )
+        {
+            for ( int y = std::max( 0, min.y ); y < std::min( max.y, (int) pWorld->rows() ); ++y )
+            {
+                int xMin = 0, xMax = 0;
+
+                if (! volume.rowExtent( y, z, xMin, xMax ) )
+                {
+                    continue;
+                }
+
+                for ( int x = std::max( 0, xMin ); x < std::min( xMax, (int) pWorld->cols() ); ++x )
+                {
+                    if (! pWorld->isEmptyAt( Point( x, y, z ) ) )
+                    {
+                        count++;
+                    }
+                }
+            }
+        }
+
+        return count;
+    }
+
+    NullRenderer renderer;
+    World * pWorld;
+};
+
+TEST_F(WorldQueryTests,BoxCountMatchesBruteForce)
+{
+    BoxVolume box( Point( 10, 0, 5 ), Point( 70, 41, 50 ) );
+
+    EXPECT_EQ( 60u * 2u * 45u + 15u, WorldQuery::countCubes( *pWorld, box ) );
+    EXPECT_EQ( bruteForceCount( box ), WorldQuery::countCubes( *pWorld, box ) );
+}
+
+TEST_F(WorldQueryTests,SphereCountMatchesBruteForce)
+{
+    SphereVolume sphere( Vec3( 33.0f, 2.0f, 47.5f ), 9.5f );
+    EXPECT_EQ( bruteForceCount( sphere ), WorldQuery::countCubes( *pWorld, sphere ) );
+}
+
+TEST_F(WorldQueryTests,SpansAreContiguousAndCarryCubeData)
+{
+    BoxVolume box( Point( 0, 40, 40 ), Point( 128, 41, 41 ) );
+    std::vector<CubeSpan> spans;
+
+    WorldQuery::findSpans( *pWorld, box, spans );
+
+    // Checkerboard row, every span is a single grass cube
+    ASSERT_EQ( 15u, spans.size() );
+
+    for ( size_t i = 0; i < spans.size(); ++i )
+    {
+        EXPECT_EQ( 1u, spans[i].length );
+        EXPECT_EQ( Point( 20 + 2 * (int) i, 40, 40 ), spans[i].start );
+        EXPECT_EQ( CubeData( EMATERIAL_GRASS ), spans[i].pCubes[0] );
+    }
+}
+
+TEST_F(WorldQueryTests,SolidRowsAreSplitOnlyAtChunkBorders)
+{
+    BoxVolume box( Point( 0, 0, 0 ), Point( 128, 1, 1 ) );
+    std::vector<CubeSpan> spans;
+
+    WorldQuery::findSpans( *pWorld, box, spans );
+
+    ASSERT_EQ( 4u, spans.size() );
+    EXPECT_EQ( 32u, spans[0].length );
+    EXPECT_EQ( Point( 96, 0, 0 ), spans[3].start );
+}
+
+TEST_F(WorldQueryTests,QueriesDoNotCreateChunks)
+{
+    unsigned int chunkCount = pWorld->chunkCount();
+    BoxVolume everything( Point( -5, -5, -5 ), Point( 500, 500, 500 ) );
+
+    WorldQuery::countCubes( *pWorld, everything );
+    EXPECT_EQ( chunkCount, pWorld->chunkCount() );
+}
+
+TEST_F(WorldQueryTests,ParallelQueryMatchesSerialQuery)
+{
+    SphereVolume sphere( Vec3( 64.0f, 10.0f, 48.0f ), 60.0f );
+    std::vector<CubeSpan> serial, parallel;
+
+    WorldQuery::findSpans( *pWorld, sphere, serial );
+    WorldQuery::findSpansParallel( *pWorld, sphere, parallel, 4 );
+
+    ASSERT_EQ( serial.size(), parallel.size() );
+
+    for ( size_t i = 0; i < serial.size(); ++i )
+    {
+        EXPECT_EQ( serial[i].start,  parallel[i].start );
+        EXPECT_EQ( serial[i].length, parallel[i].length );
+        EXPECT_EQ( serial[i].pCubes, parallel[i].pCubes );
+    }
+}
@@ -0,0 +1,351 @@
+#include <googletest/googletest.h>
+#include "engine/world.h"
+#include "engine/cubedata.h"
+#include "engine/camera.h"
+#include "engine/constants.h"
+#include "engine/worldchunk.h"
+#include "graphics/worldview.h"
+#include "graphics/irenderer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    /**
+     * Renderer that records the origin of every chunk section it uploads
+     */
+    class UploadOrderRenderer : public IRenderer
+    {
+    public:
+        virtual void clear() { }
+        virtual void present() { }
+        virtual void renderChunks( const std::vector<ChunkRenderId>& ) { }
+        virtual void renderTranslucentChunks( const std::vector<ChunkRenderId>& ids )
+        {
+            translucentDraws = ids;
+        }
+
+        virtual void releaseChunk( ChunkRenderId id )
+        {
+            releases.push_back( id );
+        }
+
+        virtual ChunkRenderId uploadChunkSection( const Point& origin,
+                                                  unsigned int section,
+                                                  const WorldChunkMesh& mesh )
+        {
+            uploads.push_back( origin );
+            sections.push_back( section );
+            packed.push_back( mesh.isPacked );
+            vertexBytes.push_back( mesh.vertexCount() * mesh.vertexSize() );
+            return static_cast<ChunkRenderId>( uploads.size() );
+        }
+
+        std::vector<Point> uploads;
+        std::vector<unsigned int> sections;
+        std::vector<bool> packed;
+        std::vector<size_t> vertexBytes;
+        std::vector<ChunkRenderId> releases;
+        std::vector<ChunkRenderId> translucentDraws;
+    };
+}
+
+class WorldViewTests : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        // A single column of six chunks running along z, each with a cube
+        pView  = new WorldView( &renderer, 0 );
+        pWorld = new World( Constants::CHUNK_COLS,
+                            Constants::CHUNK_ROWS,
+                            Constants::CHUNK_DEPTH * 6,
+                            pView );
+
+        for ( int z = 0; z < 6; ++z )
+        {
+            pWorld->put( CubeData( EMATERIAL_ROCK ),
+                         Point( 5, 5, z * Constants::CHUNK_DEPTH + 5 ) );
+        }
+
+        pView->setOcclusionCullingEnabled( false );
+    }
+
+    virtual void TearDown()
+    {
+        delete pWorld;
+    }
+
+    UploadOrderRenderer renderer;
+    WorldView * pView;
+    World * pWorld;
+};
+
+TEST_F(WorldViewTests,UnlimitedBudgetDrainsQueue)
+{
+    pView->update();
+
+    EXPECT_EQ( 6u, pView->updateStats().chunksProcessed );
+    EXPECT_EQ( 0u, pView->updateStats().chunksDeferred );
+    EXPECT_EQ( 6u, renderer.uploads.size() );
+}
+
+TEST_F(WorldViewTests,BudgetDefersChunks)
+{
+    // Small enough that only the guaranteed chunk fits each frame
+    pView->setUpdateBudget( 0.0001f );
+
+    for ( unsigned int frame = 1; frame <= 6; ++frame )
+    {
+        pView->update();
+
+        EXPECT_EQ( 1u, pView->updateStats().chunksProcessed );
+        EXPECT_EQ( 6u - frame, pView->updateStats().chunksDeferred );
+        EXPECT_EQ( frame, renderer.uploads.size() );
+    }
+
+    pView->update();
+    EXPECT_EQ( 0u, pView->updateStats().chunksProcessed );
+}
+
+TEST_F(WorldViewTests,VisibleAndNearChunksFirst)
+{
+    // Sit in the middle of chunk two, looking down -z
+    const float depth = static_cast<float>( Constants::CHUNK_DEPTH );
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 2.5f * depth ) ) );
+    pView->setUpdateBudget( 0.0001f );
+
+    for ( int frame = 0; frame < 6; ++frame )
+    {
+        pView->update();
+    }
+
+    // In front: 2, 1, 0. Behind: 3, 4, 5
+    const int expected[6] = { 2, 1, 0, 3, 4, 5 };
+    ASSERT_EQ( 6u, renderer.uploads.size() );
+
+    for ( int i = 0; i < 6; ++i )
+    {
+        EXPECT_EQ( expected[i] * static_cast<int>( Constants::CHUNK_DEPTH ),
+                   renderer.uploads[i].z );
+    }
+}
+
+TEST_F(WorldViewTests,RebuildReleasesOldMesh)
+{
+    pView->update();
+    EXPECT_EQ( 6u, pView->loadedChunkCount() );
+
+    // Edit the same section of one chunk again, the first mesh it had should
+    // be given back
+    pWorld->put( CubeData( EMATERIAL_DIRT ), Point( 9, 9, 6 ) );
+    pView->update();
+
+    EXPECT_EQ( 6u, pView->loadedChunkCount() );
+    ASSERT_EQ( 1u, renderer.releases.size() );
+    EXPECT_EQ( 1u, renderer.releases[0] );
+
+    pView->draw();
+    EXPECT_EQ( 6u, pView->frameStats().chunksDrawn );
+}
+
+TEST_F(WorldViewTests,UploadsPackedVerticesUnlessDisabled)
+{
+    pView->update();
+    ASSERT_EQ( 6u, renderer.uploads.size() );
+
+    // One cube is six faces of four vertices
+    for ( size_t i = 0; i < renderer.uploads.size(); ++i )
+    {
+        EXPECT_TRUE( renderer.packed[i] );
+        EXPECT_EQ( 24 * sizeof(PackedCubeVertex), renderer.vertexBytes[i] );
+    }
+
+    // Only meshes rebuilt afterwards change format
+    pView->setPackedVerticesEnabled( false );
+    pWorld->put( CubeData( EMATERIAL_DIRT ), Point( 9, 9, 6 ) );
+    pView->update();
+
+    ASSERT_EQ( 7u, renderer.uploads.size() );
+    EXPECT_FALSE( renderer.packed[6] );
+    EXPECT_EQ( 48 * sizeof(CubeVertex), renderer.vertexBytes[6] );
+}
+
+TEST_F(WorldViewTests,FarChunksAreUnloadedAndReloaded)
+{
+    const float depth = static_cast<float>( Constants::CHUNK_DEPTH );
+
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 0.5f * depth ) ) );
+    pView->setUnloadDistance( 1.5f * depth );
+    pView->update();
+
+    // Chunks zero and one are within range, streamed in with every section
+    const size_t loaded = 2 * WorldChunk::SECTION_COUNT;
+
+    EXPECT_EQ( 2u, pView->loadedChunkCount() );
+    EXPECT_EQ( loaded, renderer.uploads.size() );
+
+    // Move to the far end, the first two are released and the last two built
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 5.5f * depth ) ) );
+    pView->update();
+
+    const size_t reloaded = 2 * loaded;
+
+    EXPECT_EQ( 2u, pView->updateStats().chunksUnloaded );
+    EXPECT_EQ( 2u, pView->updateStats().chunksLoaded );
+    EXPECT_EQ( 2u, pView->loadedChunkCount() );
+    EXPECT_EQ( loaded, renderer.releases.size() );
+    ASSERT_EQ( reloaded, renderer.uploads.size() );
+    EXPECT_EQ( 5 * static_cast<int>( Constants::CHUNK_DEPTH ),
+               std::max_element( renderer.uploads.begin() + loaded,
+                                 renderer.uploads.end(),
+                                 []( const Point& a, const Point& b )
+                                 {
+                                     return a.z < b.z;
+                                 } )->z );
+
+    // Staying put doesn't do anything
+    pView->update();
+    EXPECT_EQ( 0u, pView->updateStats().chunksUnloaded );
+    EXPECT_EQ( 0u, pView->updateStats().chunksLoaded );
+    EXPECT_EQ( reloaded, renderer.uploads.size() );
+}
+
+TEST_F(WorldViewTests,UnloadDiscardsMeshesStillInFlight)
+{
+    const float depth = static_cast<float>( Constants::CHUNK_DEPTH );
+
+    // Only one section of the nearest chunk is uploaded, the rest of the
+    // chunk's meshes are left waiting
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 0.5f * depth ) ) );
+    pView->setUnloadDistance( 1.5f * depth );
+    pView->setUpdateBudget( 0.0001f );
+    pView->update();
+
+    ASSERT_EQ( 1u, renderer.uploads.size() );
+    EXPECT_EQ( 0, renderer.uploads[0].z );
+
+    // The chunk goes out of range before its other meshes are uploaded
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 5.5f * depth ) ) );
+    pView->setUpdateBudget( 0.0f );
+    pView->update();
+
+    EXPECT_GE( pView->updateStats().meshesDiscarded,
+               WorldChunk::SECTION_COUNT - 1 );
+
+    for ( size_t i = 1; i < renderer.uploads.size(); ++i )
+    {
+        EXPECT_NE( 0, renderer.uploads[i].z );
+    }
+
+    pView->update();
+    EXPECT_EQ( 2u, pView->loadedChunkCount() );
+}
+
+TEST_F(WorldViewTests,EditOnlyRebuildsItsSection)
+{
+    pView->update();
+    renderer.sections.clear();
+
+    // Inside section two of the first chunk
+    pWorld->put( CubeData( EMATERIAL_DIRT ), Point( 3, 3, 20 ) );
+    pView->update();
+
+    ASSERT_EQ( 1u, renderer.sections.size() );
+    EXPECT_EQ( 2u, renderer.sections[0] );
+    EXPECT_EQ( 1u, pView->updateStats().sectionsProcessed );
+
+    // On the border of sections one and two, both are rebuilt
+    renderer.sections.clear();
+    pWorld->put( CubeData( EMATERIAL_DIRT ), Point( 3, 3, 16 ) );
+    pView->update();
+
+    std::sort( renderer.sections.begin(), renderer.sections.end() );
+
+    ASSERT_EQ( 2u, renderer.sections.size() );
+    EXPECT_EQ( 1u, renderer.sections[0] );
+    EXPECT_EQ( 2u, renderer.sections[1] );
+}
+
+TEST_F(WorldViewTests,LodFollowsCameraDistance)
+{
+    const float depth = static_cast<float>( Constants::CHUNK_DEPTH );
+
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 0.5f * depth ) ) );
+    pView->setLodDistance( 1.25f * depth );
+    pView->update();
+
+    EXPECT_EQ( 0u, pView->chunkLod( Point( 0, 0, 0 ) ) );
+    EXPECT_EQ( 0u, pView->chunkLod( Point( 0, 0, 1 ) ) );
+    EXPECT_EQ( 1u, pView->chunkLod( Point( 0, 0, 2 ) ) );
+    EXPECT_EQ( 2u, pView->chunkLod( Point( 0, 0, 5 ) ) );
+
+    // Walking to the far end flips the detail around and rebuilds both
+    // ends along with their neighbors
+    const size_t uploaded = renderer.uploads.size();
+
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 5.5f * depth ) ) );
+    pView->update();
+
+    EXPECT_EQ( 2u, pView->chunkLod( Point( 0, 0, 0 ) ) );
+    EXPECT_EQ( 0u, pView->chunkLod( Point( 0, 0, 5 ) ) );
+    EXPECT_LT( 0u, pView->updateStats().lodChanges );
+    EXPECT_LT( uploaded, renderer.uploads.size() );
+}
+
+TEST_F(WorldViewTests,LodRescansWhenCameraChangesChunk)
+{
+    const float depth = static_cast<float>( Constants::CHUNK_DEPTH );
+
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 0.5f * depth ) ) );
+    pView->setLodDistance( 1.8f * depth );
+    pView->update();
+
+    EXPECT_EQ( 1u, pView->chunkLod( Point( 0, 0, 2 ) ) );
+
+    // Moving inside of the same chunk leaves the detail alone
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 0.9f * depth ) ) );
+    pView->update();
+    EXPECT_EQ( 1u, pView->chunkLod( Point( 0, 0, 2 ) ) );
+
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 1.1f * depth ) ) );
+    pView->update();
+    EXPECT_EQ( 0u, pView->chunkLod( Point( 0, 0, 2 ) ) );
+    EXPECT_EQ( 2u, pView->chunkLod( Point( 0, 0, 5 ) ) );
+
+    // Turning lod off puts everything back to full detail
+    pView->setLodDistance( 0.0f );
+    pView->update();
+    EXPECT_EQ( 0u, pView->chunkLod( Point( 0, 0, 5 ) ) );
+}
+
+TEST_F(WorldViewTests,TranslucentSectionsDrawnBackToFront)
+{
+    // Water in section two of chunks zero, two and four
+    const int depth = static_cast<int>( Constants::CHUNK_DEPTH );
+
+    for ( int z = 0; z < 6; z += 2 )
+    {
+        pWorld->put( CubeData( EMATERIAL_WATER ), Point( 7, 7, z * depth + 20 ) );
+    }
+
+    // Just in front of the water in chunk two
+    pView->setCamera( Camera( Vec3( 16.0f, 16.0f, 2.5f * depth ) ) );
+    pView->update();
+    pView->draw();
+
+    ASSERT_EQ( 3u, renderer.translucentDraws.size() );
+    EXPECT_EQ( 3u, pView->frameStats().translucentChunksDrawn );
+
+    // Sections are 68, 60 and 4 cubes away from the camera
+    const int expected[3] = { 4, 0, 2 };
+
+    for ( int i = 0; i < 3; ++i )
+    {
+        const ChunkRenderId id = renderer.translucentDraws[i];
+
+        EXPECT_EQ( expected[i] * depth, renderer.uploads[ id - 1 ].z );
+        EXPECT_EQ( 2u, renderer.sections[ id - 1 ] );
+    }
+}